@@ -53,6 +53,7 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void FreqMeter_IRQHandler(uint8_t channel);
 
 /* USER CODE END EFP */
 
@@ -76,6 +77,30 @@ void Error_Handler(void);
 #define GND_PIN_Pin GPIO_PIN_12
 #define GND_PIN_GPIO_Port GPIOB
 
+// Logic analyzer inputs: all on GPIOA, each on CH1 of its own timer
+#define LA_NUM_CHANNELS 4
+#define LA_CH0_Pin GPIO_PIN_8   // TIM1_CH1
+#define LA_CH0_GPIO_Port GPIOA
+#define LA_CH1_Pin GPIO_PIN_15  // TIM2_CH1
+#define LA_CH1_GPIO_Port GPIOA
+#define LA_CH2_Pin GPIO_PIN_6   // TIM3_CH1
+#define LA_CH2_GPIO_Port GPIOA
+#define LA_CH3_Pin GPIO_PIN_2   // TIM9_CH1
+#define LA_CH3_GPIO_Port GPIOA
+
+// Pattern generator outputs, driven by DMA through GPIOB->BSRR. For the
+// loopback self-test jumper PB0->PA8, PB1->PA15, PB8->PA6, PB9->PA2
+#define LA_GEN_GPIO_Port GPIOB
+#define LA_GEN0_Pin GPIO_PIN_0
+#define LA_GEN1_Pin GPIO_PIN_1
+#define LA_GEN2_Pin GPIO_PIN_8
+#define LA_GEN3_Pin GPIO_PIN_9
+
+// RTC (LSE, backup domain): this backup register holds RTC_SET_MARKER once
+// the clock was set over the console, and a reset then keeps the time
+#define RTC_SET_REGISTER RTC_BKP_DR0
+#define RTC_SET_MARKER 0x4C41
+
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
@@ -85,6 +85,9 @@ typedef struct {
     uint8_t address;
     uint8_t framebuffer[SH1106_WIDTH * SH1106_PAGES];      // 1024 bytes (128x64/8) - current buffer
     uint8_t prev_framebuffer[SH1106_WIDTH * SH1106_PAGES]; // 1024 bytes - previous buffer for delta detection
+    uint8_t dirty_first[SH1106_PAGES];  // First column changed by the last update, per page
+    uint8_t dirty_count[SH1106_PAGES];  // Columns changed from dirty_first (0 = page unchanged)
+    bool full_refresh;                  // Panel content unknown: next update sends every page
     bool initialized;
 } SH1106_t;
 
@@ -128,6 +131,8 @@ HAL_StatusTypeDef SH1106_Fill(SH1106_t *dev);
 
 /**
  * @brief Update display with framebuffer content
+ * @note Only the columns that differ from the last update are sent, one
+ *       span per page; the spans are left in dirty_first/dirty_count
  * @param dev Pointer to SH1106 device structure
  * @retval HAL_OK if successful, HAL_ERROR otherwise
  */
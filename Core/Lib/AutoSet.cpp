@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * @file           : AutoSet.cpp
+  * @brief          : Sample rate and zoom choice implementation
+  ******************************************************************************
+  */
+
+#include "AutoSet.hpp"
+
+namespace measure {
+
+float AutoSet::shortestPulse(const Probe& probe) {
+    if (probe.frequency_hz <= 0.0f) {
+        return 0.0f;
+    }
+    float period = 1.0f / probe.frequency_hz;
+    if (probe.duty_pct <= 0.0f || probe.duty_pct >= 100.0f) {
+        return period / 2.0f;
+    }
+    float high = period * probe.duty_pct / 100.0f;
+    float low = period - high;
+    return (high < low) ? high : low;
+}
+
+bool AutoSet::choose(const Probe* probes, uint8_t num_channels,
+                     const uint32_t* rates, uint8_t num_rates,
+                     const float* zooms, uint8_t num_zooms, Choice& choice) {
+    if (num_rates == 0 || num_zooms == 0) {
+        return false;
+    }
+
+    float pulse = 0.0f;
+    uint8_t channel = 0;
+    for (uint8_t ch = 0; ch < num_channels; ch++) {
+        float p = shortestPulse(probes[ch]);
+        if (p > 0.0f && (pulse == 0.0f || p < pulse)) {
+            pulse = p;
+            channel = ch;
+        }
+    }
+    if (pulse == 0.0f) {
+        return false;
+    }
+
+    uint8_t rate = 0;
+    while (rate < num_rates - 1 && pulse * (float)rates[rate] < MIN_SAMPLES) {
+        rate++;
+    }
+    float samples = pulse * (float)rates[rate];
+
+    uint8_t zoom = 0;
+    while (zoom < num_zooms - 1 && samples * zooms[zoom] < MIN_PIXELS) {
+        zoom++;
+    }
+
+    choice.channel = channel;
+    choice.pulse_s = pulse;
+    choice.rate_index = rate;
+    choice.zoom_index = zoom;
+    return true;
+}
+
+} // namespace measure
@@ -0,0 +1,64 @@
+/**
+  ******************************************************************************
+  * @file           : AutoSet.hpp
+  * @brief          : Sample rate and zoom choice from a probe measurement
+  ******************************************************************************
+  * The probe is one short frequency meter window per channel, so no
+  * samples are taken. Each active channel gives its shortest pulse:
+  * min(high, low) from the duty cycle, or half a period when duty was not
+  * measured. The shortest pulse of all channels then sets
+  *   - the sample rate: the lowest one with at least MIN_SAMPLES samples
+  *     per pulse (longest capture time for the buffer), or the highest
+  *     rate when none is fast enough;
+  *   - the zoom: the lowest level that draws the pulse at least
+  *     MIN_PIXELS wide (1 sample = 1 pixel at 1.0x).
+  ******************************************************************************
+  */
+
+#ifndef AUTO_SET_HPP
+#define AUTO_SET_HPP
+
+#include <cstdint>
+
+namespace measure {
+
+class AutoSet {
+public:
+    static constexpr float MIN_SAMPLES = 4.0f;
+    static constexpr float MIN_PIXELS = 4.0f;
+
+    /**
+     * @brief Probe result of one channel
+     */
+    struct Probe {
+        float frequency_hz;   ///< 0 when the channel had no edges
+        float duty_pct;       ///< Negative when not measured
+    };
+
+    struct Choice {
+        uint8_t channel;      ///< Channel with the shortest pulse
+        float pulse_s;        ///< Its shortest pulse
+        uint8_t rate_index;
+        uint8_t zoom_index;
+    };
+
+    /**
+     * @brief Shortest pulse of one channel in seconds (0 if inactive)
+     */
+    static float shortestPulse(const Probe& probe);
+
+    /**
+     * @brief Pick the sample rate and zoom
+     * @param probes One entry per channel
+     * @param rates Sample rates in Hz, ascending
+     * @param zooms Zoom levels, ascending
+     * @return false when no channel was active (choice unchanged)
+     */
+    static bool choose(const Probe* probes, uint8_t num_channels,
+                       const uint32_t* rates, uint8_t num_rates,
+                       const float* zooms, uint8_t num_zooms, Choice& choice);
+};
+
+} // namespace measure
+
+#endif /* AUTO_SET_HPP */
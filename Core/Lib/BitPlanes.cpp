@@ -0,0 +1,188 @@
+/**
+  ******************************************************************************
+  * @file           : BitPlanes.cpp
+  * @brief          : Bit-plane transposition implementation
+  ******************************************************************************
+  */
+
+#include "BitPlanes.hpp"
+#include <cstring>
+
+namespace capture {
+
+#if defined(__ARM_FEATURE_DSP)
+
+// a[15:0] | b[15:0] << 16
+static inline uint32_t packLow(uint32_t a, uint32_t b) {
+    uint32_t r;
+    __asm("pkhbt %0, %1, %2, lsl #16" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+
+// a[31:16] | b[31:16] << 16
+static inline uint32_t packHigh(uint32_t a, uint32_t b) {
+    uint32_t r;
+    __asm("pkhtb %0, %1, %2, asr #16" : "=r"(r) : "r"(b), "r"(a));
+    return r;
+}
+
+// GE = 0101: SEL takes bytes 0 and 2 from its first operand. Only SIMD
+// instructions touch GE (and exceptions save it), and the asm statements
+// are volatile so they keep their order.
+static inline void selectEvenBytes() {
+    uint32_t unused;
+    __asm volatile("uadd8 %0, %1, %2" : "=r"(unused) : "r"(0x00FF00FFu), "r"(0x00010001u));
+}
+
+// 8-bit block swap: odd bytes of a <-> even bytes of b
+static inline void swapBytes(uint32_t& a, uint32_t& b) {
+    uint32_t new_a;
+    uint32_t new_b;
+    __asm volatile("sel %0, %1, %2" : "=r"(new_a) : "r"(a), "r"(b << 8));
+    __asm volatile("sel %0, %1, %2" : "=r"(new_b) : "r"(a >> 8), "r"(b));
+    a = new_a;
+    b = new_b;
+}
+
+#else
+
+static inline uint32_t packLow(uint32_t a, uint32_t b) {
+    return (a & 0xFFFF) | (b << 16);
+}
+
+static inline uint32_t packHigh(uint32_t a, uint32_t b) {
+    return (a >> 16) | (b & 0xFFFF0000u);
+}
+
+static inline void selectEvenBytes() {
+}
+
+static inline void swapBytes(uint32_t& a, uint32_t& b) {
+    uint32_t t = ((a >> 8) ^ b) & 0x00FF00FFu;
+    b ^= t;
+    a ^= t << 8;
+}
+
+#endif
+
+// k-bit block swap between rows r and r + k of both 16x16 halves: bit c + k
+// of row r trades places with bit c of row r + k (mask = those bits c)
+template <uint8_t K, uint32_t MASK>
+static inline void swapStage(uint32_t* w) {
+    for (uint8_t r = 0; r < BitPlanes::PORT_BITS; r++) {
+        if (r & K) {
+            continue;
+        }
+        uint32_t t = ((w[r] >> K) ^ w[r + K]) & MASK;
+        w[r + K] ^= t;
+        w[r] ^= t << K;
+    }
+}
+
+void BitPlanes::transpose(const uint16_t* samples, uint32_t* planes) {
+    // Rows j and j + 16 share a word; two 32-bit loads give two words
+    for (uint8_t j = 0; j < PORT_BITS; j += 2) {
+        uint32_t first;
+        uint32_t second;
+        memcpy(&first, samples + j, sizeof(first));
+        memcpy(&second, samples + j + PORT_BITS, sizeof(second));
+        planes[j] = packLow(first, second);
+        planes[j + 1] = packHigh(first, second);
+    }
+
+    selectEvenBytes();
+    for (uint8_t r = 0; r < 8; r++) {
+        swapBytes(planes[r], planes[r + 8]);
+    }
+    swapStage<4, 0x0F0F0F0Fu>(planes);
+    swapStage<2, 0x33333333u>(planes);
+    swapStage<1, 0x55555555u>(planes);
+}
+
+void BitPlanes::transposeReference(const uint16_t* samples, uint32_t* planes) {
+    for (uint8_t bit = 0; bit < PORT_BITS; bit++) {
+        uint32_t plane = 0;
+        for (uint8_t i = 0; i < BLOCK_SAMPLES; i++) {
+            plane |= (uint32_t)((samples[i] >> bit) & 1) << i;
+        }
+        planes[bit] = plane;
+    }
+}
+
+void BitPlanes::transposeChannels(const uint16_t* samples, uint32_t blocks, const uint8_t* bits,
+                                  uint8_t num_channels, uint32_t* const* streams) {
+    uint32_t planes[PORT_BITS];
+    for (uint32_t block = 0; block < blocks; block++) {
+        transpose(samples + block * BLOCK_SAMPLES, planes);
+        for (uint8_t ch = 0; ch < num_channels; ch++) {
+            streams[ch][block] = planes[bits[ch]];
+        }
+    }
+}
+
+uint32_t BitPlanes::countHigh(const uint32_t* stream, uint32_t words) {
+    uint32_t high = 0;
+    for (uint32_t k = 0; k < words; k++) {
+        high += (uint32_t)__builtin_popcount(stream[k]);
+    }
+    return high;
+}
+
+uint32_t BitPlanes::countEdges(const uint32_t* stream, uint32_t words) {
+    if (words == 0) {
+        return 0;
+    }
+    // Each sample against the one before it; the first has no predecessor
+    uint32_t edges = 0;
+    uint32_t previous = stream[0] & 1;
+    for (uint32_t k = 0; k < words; k++) {
+        uint32_t w = stream[k];
+        edges += (uint32_t)__builtin_popcount(w ^ ((w << 1) | previous));
+        previous = w >> 31;
+    }
+    return edges;
+}
+
+static bool emitRun(uint8_t level, uint32_t duration, uint8_t* out, uint32_t capacity, uint32_t& length) {
+    while (duration > 0) {
+        if (length >= capacity) {
+            return false;
+        }
+        uint32_t part = (duration > 0x7F) ? 0x7F : duration;
+        out[length++] = (uint8_t)(level << 7) | (uint8_t)part;
+        duration -= part;
+    }
+    return true;
+}
+
+bool BitPlanes::toTransitions(const uint32_t* stream, uint32_t words, uint8_t* out,
+                              uint32_t capacity, uint32_t& length) {
+    length = 0;
+    if (words == 0) {
+        return true;
+    }
+
+    // Whole words at one level cost one compare; otherwise each change is
+    // found with a count of trailing zeros
+    uint8_t level = stream[0] & 1;
+    uint32_t run = 0;
+    for (uint32_t k = 0; k < words; k++) {
+        uint32_t differ = stream[k] ^ (level ? 0xFFFFFFFFu : 0);
+        uint32_t pos = 0;
+        while (differ != 0) {
+            uint32_t change = (uint32_t)__builtin_ctz(differ);
+            run += change - pos;
+            if (!emitRun(level, run, out, capacity, length)) {
+                return false;
+            }
+            level ^= 1;
+            run = 0;
+            pos = change;
+            differ = ~differ & (0xFFFFFFFFu << change);
+        }
+        run += BLOCK_SAMPLES - pos;
+    }
+    return emitRun(level, run, out, capacity, length);
+}
+
+} // namespace capture
@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file           : BitPlanes.hpp
+  * @brief          : Port-word to per-channel bit-plane transposition
+  ******************************************************************************
+  * Captures come in as packed port words (one 16-bit IDR read per sample).
+  * Per-channel work - runs, edges, levels - is cheaper on bit planes: one
+  * 32-bit word per port bit holding 32 consecutive samples (bit i = sample
+  * i). transpose() turns 32 port words into the 16 planes of the port:
+  *   1. pack pairs: word j = sample j | sample j+16 << 16 (PKHBT / PKHTB
+  *      on two 32-bit loads on the M4),
+  *   2. transpose both 16x16 halves at once with block swaps of 8, 4, 2
+  *      and 1 bits; the 8-bit stage is two SEL byte selects (GE flags set
+  *      once by UADD8), the others a masked XOR swap each.
+  * Without the DSP extension (host builds) every step is plain C.
+  * transposeReference() is the bit-by-bit definition the fast one must
+  * match.
+  *
+  * Layouts: transposeChannels() writes one plane stream per channel
+  * (stream[k] = samples 32k..32k+31), which is what decoders and the
+  * renderer read; code that wants levels of all channels at one sample
+  * keeps using the port words.
+  ******************************************************************************
+  */
+
+#ifndef BIT_PLANES_HPP
+#define BIT_PLANES_HPP
+
+#include <cstdint>
+
+namespace capture {
+
+class BitPlanes {
+public:
+    static constexpr uint8_t BLOCK_SAMPLES = 32;
+    static constexpr uint8_t PORT_BITS = 16;
+
+    /**
+     * @brief 32 port words to 16 planes (planes[b] bit i = samples[i] bit b)
+     */
+    static void transpose(const uint16_t* samples, uint32_t* planes);
+
+    /**
+     * @brief Same result, one bit at a time
+     */
+    static void transposeReference(const uint16_t* samples, uint32_t* planes);
+
+    /**
+     * @brief Plane stream of each channel for blocks * 32 samples
+     * @param bits Port bit of each channel
+     * @param streams streams[ch] holds blocks words
+     */
+    static void transposeChannels(const uint16_t* samples, uint32_t blocks, const uint8_t* bits,
+                                  uint8_t num_channels, uint32_t* const* streams);
+
+    /**
+     * @brief Level of a plane stream at a sample
+     */
+    static uint8_t level(const uint32_t* stream, uint32_t sample) {
+        return (stream[sample / BLOCK_SAMPLES] >> (sample % BLOCK_SAMPLES)) & 1;
+    }
+
+    /**
+     * @brief Samples at high level
+     */
+    static uint32_t countHigh(const uint32_t* stream, uint32_t words);
+
+    /**
+     * @brief Level changes between consecutive samples
+     */
+    static uint32_t countEdges(const uint32_t* stream, uint32_t words);
+
+    /**
+     * @brief Runs of a plane stream in the display transition format
+     *        (bit 7 = level, bits 6-0 = duration, long runs split)
+     * @param length Entries written
+     * @return false if the buffer filled up before the end
+     */
+    static bool toTransitions(const uint32_t* stream, uint32_t words, uint8_t* out,
+                              uint32_t capacity, uint32_t& length);
+};
+
+} // namespace capture
+
+#endif /* BIT_PLANES_HPP */
@@ -0,0 +1,120 @@
+/**
+  ******************************************************************************
+  * @file           : BlockCompressor.cpp
+  * @brief          : Run-length coding of capture blocks implementation
+  ******************************************************************************
+  */
+
+#include "BlockCompressor.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace capture {
+
+BlockCompressor::BlockCompressor() : mask_(0), state_low_{}, state_high_{}, state_words_{} {
+}
+
+BlockCompressor::BlockCompressor(const uint8_t* channel_bits) {
+    setChannels(channel_bits);
+}
+
+void BlockCompressor::setChannels(const uint8_t* channel_bits) {
+    mask_ = 0;
+    for (uint16_t v = 0; v < 256; v++) {
+        state_low_[v] = 0;
+        state_high_[v] = 0;
+    }
+    for (uint8_t s = 0; s < NUM_STATES; s++) {
+        state_words_[s] = 0;
+    }
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        uint8_t bit = channel_bits[ch];
+        mask_ |= (uint16_t)(1u << bit);
+        for (uint16_t v = 0; v < 256; v++) {
+            uint8_t* table = (bit < 8) ? state_low_ : state_high_;
+            if ((v >> (bit & 7)) & 1) {
+                table[v] |= (uint8_t)(1u << ch);
+            }
+        }
+        for (uint8_t s = 0; s < NUM_STATES; s++) {
+            if (s & (1u << ch)) {
+                state_words_[s] |= (uint16_t)(1u << bit);
+            }
+        }
+    }
+}
+
+uint32_t BlockCompressor::compress(const uint16_t* words, uint32_t count, uint8_t* out) const {
+    const uint32_t mask = mask_;
+    uint8_t* p = out;
+    uint32_t i = 0;
+    while (i < count) {
+        uint32_t first = words[i];
+        uint32_t start = i++;
+        while (i < count && ((words[i] ^ first) & mask) == 0) {
+            i++;
+        }
+
+        uint32_t run = i - start;
+        uint8_t state = stateOf((uint16_t)first);
+        if (run < 16) {
+            *p++ = (uint8_t)(run << 4) | state;
+        } else {
+            *p++ = state;
+            run -= 16;
+            while (run >= 0x80) {
+                *p++ = (uint8_t)(run | 0x80);
+                run >>= 7;
+            }
+            *p++ = (uint8_t)run;
+        }
+    }
+    return (uint32_t)(p - out);
+}
+
+uint32_t BlockCompressor::decompress(const uint8_t* in, uint32_t length, uint16_t* out, uint32_t capacity) const {
+    const uint8_t* end = in + length;
+    uint32_t n = 0;
+    while (in < end) {
+        uint8_t token = *in++;
+        uint32_t run = token >> 4;
+        if (run == 0) {
+            uint32_t extra = 0;
+            uint8_t shift = 0;
+            uint8_t byte;
+            do {
+                if (in == end || shift > 28) {
+                    return 0;
+                }
+                byte = *in++;
+                extra |= (uint32_t)(byte & 0x7F) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            run = 16 + extra;
+        }
+        if (run > capacity - n) {
+            return 0;
+        }
+
+        uint16_t word = state_words_[token & 0x0F];
+        uint16_t* p = out + n;
+#if defined(__SSE2__)
+        // Short runs - the busy case - are a single store
+        __m128i v = _mm_set1_epi16((short)word);
+        _mm_storeu_si128((__m128i*)p, v);
+        for (uint32_t k = 8; k < run; k += 8) {
+            _mm_storeu_si128((__m128i*)(p + k), v);
+        }
+#else
+        for (uint32_t k = 0; k < run; k++) {
+            p[k] = word;
+        }
+#endif
+        n += run;
+    }
+    return n;
+}
+
+} // namespace capture
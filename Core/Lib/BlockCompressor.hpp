@@ -0,0 +1,88 @@
+/**
+  ******************************************************************************
+  * @file           : BlockCompressor.hpp
+  * @brief          : Run-length coding of capture blocks for the USB link
+  ******************************************************************************
+  * Only the channel bits of a port word matter, and they change far less
+  * often than they are sampled - the same observation the transition
+  * format is built on. A block of port words becomes a sequence of runs of
+  * the 4-bit channel state (bit n = CH n), one token per run:
+  *   byte (r << 4) | state            run of r = 1..15 samples
+  *   byte state, varint (r - 16)      run of r >= 16 (LEB128, 7 bits/byte)
+  * Blocks are coded independently, so a token never covers more than a
+  * block and the output never exceeds one byte per sample (half the raw
+  * size even for a channel toggling every sample).
+  *
+  * compress() compares whole port words under the channel mask and looks
+  * up the state only at the end of a run: a load, an EOR/TST and a branch
+  * per sample on the M4. decompress() is the host side: with SSE2 every
+  * token is one 8-sample store (longer runs loop), plain C otherwise; the
+  * rebuilt words have the channel bits at their port positions and the
+  * other bits clear.
+  ******************************************************************************
+  */
+
+#ifndef BLOCK_COMPRESSOR_HPP
+#define BLOCK_COMPRESSOR_HPP
+
+#include <cstdint>
+
+namespace capture {
+
+class BlockCompressor {
+public:
+    static constexpr uint8_t NUM_CHANNELS = 4;
+    static constexpr uint8_t NUM_STATES = 1 << NUM_CHANNELS;
+
+    /**
+     * @brief Samples decompress() may write past the end of its output
+     */
+    static constexpr uint8_t DECODE_SLACK = 8;
+
+    BlockCompressor();
+
+    /**
+     * @param channel_bits Port bit of each channel
+     */
+    explicit BlockCompressor(const uint8_t* channel_bits);
+
+    /**
+     * @brief Rebuild the lookup tables for another channel mapping
+     */
+    void setChannels(const uint8_t* channel_bits);
+
+    /**
+     * @brief Largest output of compress() for count samples
+     */
+    static constexpr uint32_t maxCompressed(uint32_t count) { return count; }
+
+    /**
+     * @brief Code count port words
+     * @return Bytes written to out (at most maxCompressed(count))
+     */
+    uint32_t compress(const uint16_t* words, uint32_t count, uint8_t* out) const;
+
+    /**
+     * @brief Rebuild port words from one coded block
+     * @param out Room for capacity + DECODE_SLACK words
+     * @return Samples written, 0 if the block is corrupt or longer than capacity
+     */
+    uint32_t decompress(const uint8_t* in, uint32_t length, uint16_t* out, uint32_t capacity) const;
+
+    /**
+     * @brief Port word of a channel state (channel bits set, others clear)
+     */
+    uint16_t stateWord(uint8_t state) const { return state_words_[state]; }
+
+private:
+    uint8_t stateOf(uint16_t word) const { return state_low_[word & 0xFF] | state_high_[word >> 8]; }
+
+    uint16_t mask_;
+    uint8_t state_low_[256];
+    uint8_t state_high_[256];
+    uint16_t state_words_[NUM_STATES];
+};
+
+} // namespace capture
+
+#endif /* BLOCK_COMPRESSOR_HPP */
@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file           : BurstSampler.cpp
+  * @brief          : Unrolled GPIO burst capture implementation
+  ******************************************************************************
+  */
+
+#include "BurstSampler.hpp"
+
+namespace capture {
+
+// Copied to RAM by the startup code with .data; aligned so the first
+// instructions of the run share a fetch line
+#define RAM_FUNC __attribute__((section(".RamFunc"), noinline, aligned(16)))
+
+// One burst: SAMPLES load/store pairs, no branches. STRH.W takes the
+// offset as a 12-bit immediate, so one base register covers the buffer.
+// Returns the DWT cycles it took; interrupts must be off.
+static RAM_FUNC uint32_t burst(volatile uint32_t* idr, uint16_t* buffer) {
+    static_assert(BurstSampler::SAMPLES * 2 <= 4096, "STRH.W offset is 12 bits");
+    uint32_t start = DWT->CYCCNT;
+    __asm volatile(
+        ".set .Lburst_offset, 0\n"
+        ".rept %c[count]\n"
+        "ldrh r3, [%[idr]]\n"
+        "strh.w r3, [%[buffer], #.Lburst_offset]\n"
+        ".set .Lburst_offset, .Lburst_offset + 2\n"
+        ".endr\n"
+        :
+        : [idr] "r"(idr), [buffer] "r"(buffer), [count] "i"(BurstSampler::SAMPLES)
+        : "r3", "memory");
+    return DWT->CYCCNT - start;
+}
+
+// Cycles between the two DWT reads around an empty burst
+static RAM_FUNC uint32_t timingOverhead() {
+    uint32_t start = DWT->CYCCNT;
+    __asm volatile("" ::: "memory");
+    return DWT->CYCCNT - start;
+}
+
+BurstSampler::BurstSampler(GPIO_TypeDef* port, uint32_t core_hz)
+    : port_(port), core_hz_(core_hz), overhead_(0), calibration_{false, false, 0, 0, 0} {
+}
+
+uint32_t BurstSampler::capture(uint16_t* buffer) {
+    CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t cycles = burst(&port_->IDR, buffer);
+    __set_PRIMASK(primask);
+    return (cycles > overhead_) ? cycles - overhead_ : 0;
+}
+
+const BurstSampler::Calibration& BurstSampler::calibrate(uint16_t* scratch) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    overhead_ = timingOverhead();
+    __set_PRIMASK(primask);
+
+    // One warm-up run, then CALIBRATION_RUNS that should all agree
+    capture(scratch);
+    uint32_t cycles = capture(scratch);
+    bool stable = true;
+    for (uint8_t run = 1; run < CALIBRATION_RUNS; run++) {
+        if (capture(scratch) != cycles) {
+            stable = false;
+        }
+    }
+
+    calibration_.valid = (cycles != 0);
+    calibration_.stable = stable;
+    calibration_.cycles = cycles;
+    calibration_.cycles_per_sample = (cycles + SAMPLES / 2) / SAMPLES;
+    calibration_.rate_hz = (calibration_.cycles_per_sample != 0)
+                               ? core_hz_ / calibration_.cycles_per_sample : 0;
+    return calibration_;
+}
+
+} // namespace capture
@@ -0,0 +1,73 @@
+/**
+  ******************************************************************************
+  * @file           : BurstSampler.hpp
+  * @brief          : CPU burst capture of a GPIO port at the highest rate
+  ******************************************************************************
+  * A fixed-length burst is read by a fully unrolled run of
+  *     LDRH r3, [IDR]
+  *     STRH r3, [buffer, #2*i]
+  * with interrupts disabled. The loop runs from RAM (.RamFunc, copied at
+  * startup), so there are no flash wait states or branches; every sample
+  * takes the same whole number of core cycles, set by the load from the
+  * GPIO port through the bus matrix.
+  *
+  * That interval is not assumed but measured: calibrate() times a few
+  * bursts with the DWT cycle counter, and the rate is core clock / cycles
+  * per sample. A burst is ~SAMPLES * interval cycles with interrupts off
+  * (about 50 us at 84 MHz).
+  *
+  * Independent of the DMA engine (PortDma): no timer, no DMA stream.
+  ******************************************************************************
+  */
+
+#ifndef BURST_SAMPLER_HPP
+#define BURST_SAMPLER_HPP
+
+#include "stm32f4xx_hal.h"
+#include <cstdint>
+
+namespace capture {
+
+class BurstSampler {
+public:
+    static constexpr uint16_t SAMPLES = 1024;      // Unrolled: fixed length
+    static constexpr uint8_t CALIBRATION_RUNS = 4;
+
+    struct Calibration {
+        bool valid;
+        bool stable;                  ///< Every run took the same cycles
+        uint32_t cycles;              ///< Cycles of one burst
+        uint32_t cycles_per_sample;   ///< Whole-cycle sample interval
+        uint32_t rate_hz;             ///< core_hz / cycles_per_sample
+    };
+
+    /**
+     * @param port Sampled port (all channels on it)
+     * @param core_hz Core clock (DWT counts at this rate)
+     */
+    BurstSampler(GPIO_TypeDef* port, uint32_t core_hz);
+
+    /**
+     * @brief Time a few bursts and derive the sample interval
+     * @param scratch SAMPLES words, overwritten
+     */
+    const Calibration& calibrate(uint16_t* scratch);
+
+    /**
+     * @brief Capture SAMPLES port words (interrupts off for the burst)
+     * @return Cycles the burst took
+     */
+    uint32_t capture(uint16_t* buffer);
+
+    const Calibration& calibration() const { return calibration_; }
+
+private:
+    GPIO_TypeDef* port_;
+    uint32_t core_hz_;
+    uint32_t overhead_;               // Cycles of the timing itself
+    Calibration calibration_;
+};
+
+} // namespace capture
+
+#endif /* BURST_SAMPLER_HPP */
@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * @file           : CanDecoder.cpp
+  * @brief          : Bit-level CAN 2.0A/B decoder implementation
+  ******************************************************************************
+  */
+
+#include "CanDecoder.hpp"
+
+namespace decode {
+
+namespace {
+
+constexpr uint16_t CAN_CRC15_POLY = 0x4599;
+constexpr uint8_t CAN_IDLE_BITS = 11;  // Recessive bits for bus integration
+constexpr uint8_t CAN_MAX_DATA = 8;
+constexpr uint32_t FIELD_START_UNSET = 0xFFFFFFFF;
+
+} // namespace
+
+CanDecoder::CanDecoder(EventSink& sink, const Config& config)
+    : sink_(sink), stats_{},
+      bit_q8_((uint32_t)(((uint64_t)config.sample_rate_hz << 8) / config.bitrate)),
+      sample_q8_(bit_q8_ / 100 * config.sample_point_pct),
+      sjw_q8_(bit_q8_ / 100 * config.sjw_pct),
+      next_sample_q8_(0), last_edge_(0), level_(1), channel_(config.channel),
+      field_(Field::WaitIdle), remaining_(0), acc_(0),
+      id_(0), flags_(0), dlc_(0), bytes_left_(0), field_start_(0), frame_start_(0),
+      stuffing_(false), last_bit_(1), same_count_(0), crc_(0) {
+}
+
+void CanDecoder::begin(uint32_t t, uint8_t level) {
+    level_ = level;
+    last_edge_ = t;
+    field_ = Field::WaitIdle;
+    stuffing_ = false;
+}
+
+void CanDecoder::edge(uint32_t t, uint8_t level) {
+    if (level == level_) {
+        return;
+    }
+
+    // Sample every bit that ended before this edge with the old level
+    sampleUntil(t);
+
+    // Only recessive-to-dominant edges are used for synchronisation
+    if (level_ == 1 && level == 0) {
+        uint64_t tq = (uint64_t)t << 8;
+        uint64_t recessive_q8 = (uint64_t)(t - last_edge_) << 8;
+
+        if (field_ == Field::Idle ||
+            (field_ == Field::WaitIdle && recessive_q8 >= (uint64_t)CAN_IDLE_BITS * bit_q8_)) {
+            // Hard sync on start of frame
+            next_sample_q8_ = tq + sample_q8_;
+            frame_start_ = t;
+            stuffing_ = true;
+            last_bit_ = 1;
+            same_count_ = 0;
+            crc_ = 0;
+            flags_ = 0;
+            enter(Field::Sof, 1);
+        } else if (field_ > Field::Idle) {
+            // Resync: move the sample point towards the edge, at most SJW
+            int64_t phase = (int64_t)(tq - (next_sample_q8_ - sample_q8_));
+            if (phase > (int64_t)sjw_q8_) {
+                phase = sjw_q8_;
+            } else if (phase < -(int64_t)sjw_q8_) {
+                phase = -(int64_t)sjw_q8_;
+            }
+            next_sample_q8_ += phase;
+        }
+    }
+
+    level_ = level;
+    last_edge_ = t;
+}
+
+void CanDecoder::end(uint32_t t) {
+    sampleUntil(t);
+}
+
+void CanDecoder::sampleUntil(uint32_t t) {
+    uint64_t tq = (uint64_t)t << 8;
+
+    while (field_ > Field::Idle && next_sample_q8_ < tq) {
+        uint32_t bit_start = (uint32_t)((next_sample_q8_ - sample_q8_) >> 8);
+        next_sample_q8_ += bit_q8_;
+        bit(level_, bit_start);
+    }
+}
+
+void CanDecoder::bit(uint8_t b, uint32_t t) {
+    if (stuffing_) {
+        if (same_count_ == 5) {
+            // This position must hold a stuff bit of opposite polarity
+            if (b == last_bit_) {
+                error(EventType::CanStuffError, t);
+                return;
+            }
+            last_bit_ = b;
+            same_count_ = 1;
+            return;
+        }
+        if (b == last_bit_) {
+            same_count_++;
+        } else {
+            last_bit_ = b;
+            same_count_ = 1;
+        }
+    }
+
+    // CRC covers SOF, arbitration, control and data fields
+    if (field_ < Field::Crc) {
+        uint16_t next = b ^ ((crc_ >> 14) & 1);
+        crc_ = (uint16_t)((crc_ << 1) & 0x7FFF);
+        if (next) {
+            crc_ ^= CAN_CRC15_POLY;
+        }
+    }
+
+    field(b, t);
+}
+
+void CanDecoder::field(uint8_t b, uint32_t t) {
+    if (field_start_ == FIELD_START_UNSET) {
+        field_start_ = t;
+    }
+    acc_ = (acc_ << 1) | b;
+    if (--remaining_ != 0) {
+        return;
+    }
+
+    switch (field_) {
+    case Field::Sof:
+        if (b != 0) {
+            // Glitch rather than a start of frame
+            stuffing_ = false;
+            field_ = Field::Idle;
+            return;
+        }
+        enter(Field::IdA, 11);
+        break;
+
+    case Field::IdA:
+        id_ = acc_;
+        enter(Field::SrrRtr, 1);
+        break;
+
+    case Field::SrrRtr:
+        flags_ = acc_ ? EVENT_FLAG_RTR : 0;
+        enter(Field::Ide, 1);
+        break;
+
+    case Field::Ide:
+        if (acc_) {
+            // SRR bit was not an RTR, the real one follows the 18-bit ID
+            flags_ = EVENT_FLAG_EXTENDED;
+            enter(Field::IdB, 18);
+        } else {
+            enter(Field::Reserved, 1);  // r0
+        }
+        break;
+
+    case Field::IdB:
+        id_ = (id_ << 18) | acc_;
+        enter(Field::RtrExt, 1);
+        break;
+
+    case Field::RtrExt:
+        if (acc_) {
+            flags_ |= EVENT_FLAG_RTR;
+        }
+        enter(Field::Reserved, 2);  // r1, r0
+        break;
+
+    case Field::Reserved:
+        enter(Field::Dlc, 4);
+        break;
+
+    case Field::Dlc:
+        dlc_ = (uint8_t)acc_;
+        emit(EventType::CanId, frame_start_, id_, flags_, dlc_);
+        bytes_left_ = (flags_ & EVENT_FLAG_RTR) ? 0 : (dlc_ > CAN_MAX_DATA ? CAN_MAX_DATA : dlc_);
+        if (bytes_left_ != 0) {
+            enter(Field::Data, 8);
+        } else {
+            enter(Field::Crc, 15);
+        }
+        break;
+
+    case Field::Data:
+        emit(EventType::CanData, field_start_, acc_);
+        if (--bytes_left_ != 0) {
+            enter(Field::Data, 8);
+        } else {
+            enter(Field::Crc, 15);
+        }
+        break;
+
+    case Field::Crc:
+        if ((uint16_t)acc_ != crc_) {
+            error(EventType::CanCrcError, field_start_, ((uint32_t)crc_ << 16) | acc_);
+            return;
+        }
+        enter(Field::CrcDelim, 1);
+        break;
+
+    case Field::CrcDelim:
+        // Stuffing covers the CRC sequence, so a stuff bit may still have
+        // been removed in front of the delimiter; it ends here
+        stuffing_ = false;
+        if (b == 0) {
+            error(EventType::CanFormError, t);
+            return;
+        }
+        enter(Field::AckSlot, 1);
+        break;
+
+    case Field::AckSlot:
+        if (b != 0) {
+            stats_.ack_missing++;
+            emit(EventType::CanAckMissing, t, id_, flags_);
+        }
+        enter(Field::AckDelim, 1);
+        break;
+
+    case Field::AckDelim:
+        if (b == 0) {
+            error(EventType::CanFormError, t);
+            return;
+        }
+        enter(Field::Eof, 7);
+        break;
+
+    case Field::Eof:
+        if (acc_ != 0x7F) {
+            error(EventType::CanFormError, t);
+            return;
+        }
+        stats_.frames++;
+        field_ = Field::Idle;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void CanDecoder::enter(Field f, uint8_t bits) {
+    field_ = f;
+    remaining_ = bits;
+    acc_ = 0;
+    field_start_ = FIELD_START_UNSET;
+}
+
+void CanDecoder::error(EventType type, uint32_t t, uint32_t value) {
+    switch (type) {
+    case EventType::CanStuffError: stats_.stuff_errors++; break;
+    case EventType::CanCrcError:   stats_.crc_errors++;   break;
+    default:                       stats_.form_errors++;  break;
+    }
+    emit(type, t, value, flags_);
+
+    // Error frames follow; resume after the bus has been idle again
+    stuffing_ = false;
+    field_ = Field::WaitIdle;
+}
+
+void CanDecoder::emit(EventType type, uint32_t t, uint32_t value,
+                      uint8_t flags, uint8_t length) {
+    Event event;
+    event.timestamp = t;
+    event.value = value;
+    event.type = type;
+    event.channel = channel_;
+    event.flags = flags;
+    event.length = length;
+    sink_.onEvent(event);
+}
+
+} // namespace decode
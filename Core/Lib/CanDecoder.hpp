@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file           : CanDecoder.hpp
+  * @brief          : Bit-level CAN 2.0A/B decoder for one RX channel
+  ******************************************************************************
+  * Recovers bit timing from the edge list (hard sync on SOF, resync with a
+  * limited jump width on every recessive-to-dominant edge), removes stuff
+  * bits, parses standard and extended frames and checks CRC-15 and ACK.
+  * Bits are sampled at computed sample points between edges, so the cost is
+  * per bit of a frame and never per capture sample.
+  ******************************************************************************
+  */
+
+#ifndef CAN_DECODER_HPP
+#define CAN_DECODER_HPP
+
+#include "Decoder.hpp"
+#include <cstdint>
+
+namespace decode {
+
+/**
+ * @brief CAN decoder working on a single RX (or bus) channel
+ *
+ * Level 1 is recessive, level 0 dominant.
+ */
+class CanDecoder {
+public:
+    struct Config {
+        uint32_t sample_rate_hz;        ///< Capture tick rate
+        uint32_t bitrate;               ///< Nominal bit rate (e.g. 500000)
+        uint8_t sample_point_pct = 75;  ///< Sample point inside the bit
+        uint8_t sjw_pct = 20;           ///< Max phase correction per resync
+        uint8_t channel = 0;            ///< Reported in events
+    };
+
+    struct Stats {
+        uint32_t frames;
+        uint32_t stuff_errors;
+        uint32_t crc_errors;
+        uint32_t form_errors;
+        uint32_t ack_missing;
+    };
+
+    CanDecoder(EventSink& sink, const Config& config);
+
+    /**
+     * @brief Restart decoding
+     * @param t Timestamp of the first tick
+     * @param level Line level at t
+     */
+    void begin(uint32_t t, uint8_t level);
+
+    /**
+     * @brief Line changed to level at tick t
+     */
+    void edge(uint32_t t, uint8_t level);
+
+    /**
+     * @brief No more edges until tick t (flushes a trailing frame)
+     */
+    void end(uint32_t t);
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    enum class Field : uint8_t {
+        WaitIdle,   // Bus integration: need 11 recessive bits
+        Idle,       // Waiting for SOF
+        Sof,
+        IdA,
+        SrrRtr,
+        Ide,
+        IdB,
+        RtrExt,
+        Reserved,
+        Dlc,
+        Data,
+        Crc,
+        CrcDelim,
+        AckSlot,
+        AckDelim,
+        Eof,
+    };
+
+    void sampleUntil(uint32_t t);
+    void bit(uint8_t b, uint32_t t);
+    void field(uint8_t b, uint32_t t);
+    void enter(Field f, uint8_t bits);
+    void error(EventType type, uint32_t t, uint32_t value = 0);
+    void emit(EventType type, uint32_t t, uint32_t value,
+              uint8_t flags = 0, uint8_t length = 0);
+
+    EventSink& sink_;
+    Stats stats_;
+
+    uint32_t bit_q8_;          // Bit time, ticks in Q24.8
+    uint32_t sample_q8_;       // Sample point offset from bit start
+    uint32_t sjw_q8_;          // Resync limit
+    uint64_t next_sample_q8_;  // Absolute time of the next sample point
+    uint32_t last_edge_;
+    uint8_t level_;
+    uint8_t channel_;
+
+    // Frame state
+    Field field_;
+    uint8_t remaining_;        // Bits left in the current field
+    uint32_t acc_;             // Field accumulator
+    uint32_t id_;
+    uint8_t flags_;
+    uint8_t dlc_;
+    uint8_t bytes_left_;
+    uint32_t field_start_;
+    uint32_t frame_start_;
+
+    // Stuffing and CRC
+    bool stuffing_;
+    uint8_t last_bit_;
+    uint8_t same_count_;
+    uint16_t crc_;
+};
+
+} // namespace decode
+
+#endif /* CAN_DECODER_HPP */
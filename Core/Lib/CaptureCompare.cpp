@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file           : CaptureCompare.cpp
+  * @brief          : Capture pass / fail comparison implementation
+  ******************************************************************************
+  */
+
+#include "CaptureCompare.hpp"
+#include "Decoder.hpp"
+
+namespace measure {
+
+// Timestamp after the last entry of a transition list
+static uint32_t endTime(const uint8_t* data, uint16_t length) {
+    uint32_t t = 0;
+    for (uint16_t i = 0; i < length; i++) {
+        t += data[i] & 0x7F;
+    }
+    return t;
+}
+
+CaptureCompare::CaptureCompare()
+    : reference_(nullptr), reference_lengths_(nullptr), num_channels_(0),
+      tolerance_(0), mismatch_{Deviation::None, 0, 0, NO_EDGE, NO_EDGE},
+      passes_(0), fails_(0) {
+}
+
+void CaptureCompare::setReference(const uint8_t* const* data, const uint16_t* lengths,
+                                  uint8_t num_channels) {
+    reference_ = data;
+    reference_lengths_ = lengths;
+    num_channels_ = (num_channels > MAX_CHANNELS) ? MAX_CHANNELS : num_channels;
+}
+
+bool CaptureCompare::compare(const uint8_t* const* data, const uint16_t* lengths) {
+    bool pass = true;
+    Mismatch channel_mismatch;
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        if (compareChannel(reference_[ch], reference_lengths_[ch], data[ch], lengths[ch],
+                           tolerance_, channel_mismatch)) {
+            continue;
+        }
+        channel_mismatch.channel = ch;
+        if (pass || channel_mismatch.time < mismatch_.time) {
+            mismatch_ = channel_mismatch;
+        }
+        pass = false;
+    }
+
+    if (pass) {
+        passes_++;
+    } else {
+        fails_++;
+    }
+    return pass;
+}
+
+bool CaptureCompare::compareChannel(const uint8_t* reference, uint16_t reference_length,
+                                    const uint8_t* capture, uint16_t capture_length,
+                                    uint32_t tolerance, Mismatch& mismatch) {
+    if (reference == nullptr || capture == nullptr) {
+        reference_length = (reference != nullptr) ? reference_length : 0;
+        capture_length = (capture != nullptr) ? capture_length : 0;
+    }
+    if (reference_length == 0 || capture_length == 0 || (reference[0] >> 7) != (capture[0] >> 7)) {
+        if (reference_length == 0 && capture_length == 0) {
+            return true;
+        }
+        mismatch = {Deviation::Level, 0, 0, NO_EDGE, NO_EDGE};
+        return false;
+    }
+
+    // Edges past the end of the shorter capture are not compared
+    uint32_t end = endTime(reference, reference_length);
+    uint32_t capture_end = endTime(capture, capture_length);
+    if (capture_end < end) {
+        end = capture_end;
+    }
+
+    decode::EdgeWalker ref;
+    decode::EdgeWalker cap;
+    ref.init(reference, reference_length);
+    cap.init(capture, capture_length);
+    for (;;) {
+        uint32_t expected = (!ref.done && ref.time < end) ? ref.time : NO_EDGE;
+        uint32_t actual = (!cap.done && cap.time < end) ? cap.time : NO_EDGE;
+        if (expected == NO_EDGE && actual == NO_EDGE) {
+            return true;
+        }
+
+        if (expected != NO_EDGE && actual != NO_EDGE) {
+            uint32_t difference = (actual > expected) ? actual - expected : expected - actual;
+            if (difference <= tolerance) {
+                ref.next();
+                cap.next();
+                continue;
+            }
+        } else if ((expected != NO_EDGE ? expected : actual) + tolerance >= end) {
+            // Its partner may lie just past the end of the shorter capture
+            return true;
+        }
+
+        // The earlier of the two edges is the one without a partner
+        if (actual < expected) {
+            mismatch = {Deviation::Early, 0, actual, expected, actual};
+        } else {
+            mismatch = {Deviation::Late, 0, expected, expected, actual};
+        }
+        return false;
+    }
+}
+
+const char* CaptureCompare::deviationName(Deviation kind) {
+    switch (kind) {
+    case Deviation::None:  return "NONE";
+    case Deviation::Level: return "LEVEL";
+    case Deviation::Early: return "EARLY";
+    case Deviation::Late:  return "LATE";
+    default:               return "?";
+    }
+}
+
+} // namespace measure
@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file           : CaptureCompare.hpp
+  * @brief          : Pass / fail comparison of captures against a reference
+  ******************************************************************************
+  * Each channel of a new capture is checked against the same channel of a
+  * stored golden capture. The two edge lists are walked in lock-step, edge
+  * i of one against edge i of the other, and a pair passes when the times
+  * differ by at most the tolerance. The first pair that does not is the
+  * deviation on that channel:
+  *   - Level: the channel starts at the other level
+  *   - Early: the capture has an edge tolerance+ ticks before the expected one
+  *     (an extra pulse, or the edge moved early)
+  *   - Late:  the expected edge passed without one in the capture
+  *     (a missing pulse, or the edge moved late)
+  * Edges after the end of the shorter capture are not compared, so the
+  * two lengths may differ slightly. The cost is linear in the edge count
+  * and stops at the first deviation, cheap enough to run on every trigger.
+  *
+  * The comparator also keeps pass / fail counters for soak runs.
+  ******************************************************************************
+  */
+
+#ifndef CAPTURE_COMPARE_HPP
+#define CAPTURE_COMPARE_HPP
+
+#include <cstdint>
+
+namespace measure {
+
+class CaptureCompare {
+public:
+    static constexpr uint8_t MAX_CHANNELS = 8;
+    static constexpr uint32_t NO_EDGE = UINT32_MAX;
+
+    enum class Deviation : uint8_t { None, Level, Early, Late };
+
+    struct Mismatch {
+        Deviation kind;
+        uint8_t channel;
+        uint32_t time;       ///< Where the captures start to differ
+        uint32_t expected;   ///< Reference edge (NO_EDGE if none)
+        uint32_t actual;     ///< Capture edge (NO_EDGE if none)
+    };
+
+    CaptureCompare();
+
+    /**
+     * @brief Golden capture (kept by reference, not copied)
+     */
+    void setReference(const uint8_t* const* data, const uint16_t* lengths, uint8_t num_channels);
+
+    /**
+     * @brief Largest allowed difference between matching edges, in ticks
+     */
+    void setTolerance(uint32_t ticks) { tolerance_ = ticks; }
+    uint32_t tolerance() const { return tolerance_; }
+
+    /**
+     * @brief Compare a capture with the reference and count the result
+     * @return true on pass; on fail mismatch() is the earliest deviation
+     *         of all channels
+     */
+    bool compare(const uint8_t* const* data, const uint16_t* lengths);
+
+    const Mismatch& mismatch() const { return mismatch_; }
+
+    uint64_t passes() const { return passes_; }
+    uint64_t fails() const { return fails_; }
+    void clearCounters() { passes_ = 0; fails_ = 0; }
+
+    /**
+     * @brief Compare one channel
+     * @return true when the channel matches (mismatch untouched)
+     */
+    static bool compareChannel(const uint8_t* reference, uint16_t reference_length,
+                               const uint8_t* capture, uint16_t capture_length,
+                               uint32_t tolerance, Mismatch& mismatch);
+
+    static const char* deviationName(Deviation kind);
+
+private:
+    const uint8_t* const* reference_;
+    const uint16_t* reference_lengths_;
+    uint8_t num_channels_;
+    uint32_t tolerance_;
+    Mismatch mismatch_;
+    uint64_t passes_;
+    uint64_t fails_;
+};
+
+} // namespace measure
+
+#endif /* CAPTURE_COMPARE_HPP */
@@ -0,0 +1,365 @@
+/**
+  ******************************************************************************
+  * @file           : CommandParser.cpp
+  * @brief          : Console command parser implementation
+  ******************************************************************************
+  */
+
+#include "CommandParser.hpp"
+
+namespace shell {
+
+static const uint8_t MAX_WORDS = 6;
+static const char* const BUFFER_NAMES[] = {"events", "burst", "selftest"};
+// Same order and names as decode::Protocol / decode::protocolName()
+static const char* const PROTOCOL_NAMES[] = {"off", "can", "manch", "bmc", "1wire", "ws2812", "nec"};
+static_assert(sizeof(PROTOCOL_NAMES) / sizeof(PROTOCOL_NAMES[0]) == CommandParser::PROTOCOL_COUNT,
+              "one name per protocol");
+
+static const char* const ERROR_UNKNOWN = "unknown command, try help";
+static const char* const ERROR_ARGUMENT = "bad argument";
+static const char* const ERROR_LONG = "line too long";
+static const char* const ERROR_CHECKSUM = "bad frame checksum";
+static const char* const ERROR_FRAME = "bad frame";
+
+static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool equals(const char* word, const char* keyword) {
+    while (*word != '\0' && lower(*word) == *keyword) {
+        word++;
+        keyword++;
+    }
+    return *word == '\0' && *keyword == '\0';
+}
+
+// Decimal digits up to end or stop; false on anything else or overflow
+static bool parseDecimal(const char*& p, char stop, uint32_t& value) {
+    const char* start = p;
+    uint64_t v = 0;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (uint32_t)(*p - '0');
+        if (v > 0xFFFFFFFFu) {
+            return false;
+        }
+        p++;
+    }
+    if (p == start || *p != stop) {
+        return false;
+    }
+    if (stop != '\0') {
+        p++;
+    }
+    value = (uint32_t)v;
+    return true;
+}
+
+static bool parseNumber(const char* word, uint32_t& value) {
+    return parseDecimal(word, '\0', value);
+}
+
+// 500, 500k, 2M
+static bool parseRate(const char* word, uint32_t& hz) {
+    const char* p = word;
+    uint64_t v = 0;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (uint32_t)(*p - '0');
+        if (v > 0xFFFFFFFFu) {
+            return false;
+        }
+        p++;
+    }
+    if (p == word) {
+        return false;
+    }
+    if (*p == 'k' || *p == 'K') {
+        v *= 1000;
+        p++;
+    } else if (*p == 'M') {
+        v *= 1000000;
+        p++;
+    }
+    if (*p != '\0' || v == 0 || v > 0xFFFFFFFFu) {
+        return false;
+    }
+    hz = (uint32_t)v;
+    return true;
+}
+
+static bool validTime(const uint32_t* args) {
+    static const uint8_t DAYS[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    uint32_t year = args[0];
+    uint32_t month = args[1];
+    uint32_t day = args[2];
+    if (year < 2000 || year > 2099 || month < 1 || month > 12 || day < 1 || day > DAYS[month - 1]) {
+        return false;
+    }
+    if (month == 2 && day == 29 && year % 4 != 0) {
+        return false;
+    }
+    return args[3] < 24 && args[4] < 60 && args[5] < 60;
+}
+
+// Ops and argument counts are the same for text and frames
+static bool validArguments(const Command& command) {
+    switch (command.op) {
+    case Op::Help:
+    case Op::Stats:
+        return command.argc == 0;
+    case Op::Rate:
+        return command.argc == 0 || (command.argc == 1 && command.args[0] != 0);
+    case Op::Dump:
+        return command.argc >= 1 && command.argc <= 3 && command.args[0] < (uint32_t)DumpBuffer::Count;
+    case Op::Time:
+        return command.argc == 0 || (command.argc == 6 && validTime(command.args));
+    case Op::Decode:
+        return command.argc == 0 ||
+               ((command.argc == 2 || command.argc == 3) && command.args[1] < CommandParser::PROTOCOL_COUNT);
+    default:
+        return false;
+    }
+}
+
+static bool fail(Command& command, const char* error) {
+    command.op = Op::Error;
+    command.argc = 0;
+    command.error = error;
+    return true;
+}
+
+CommandParser::CommandParser()
+    : line_{}, line_length_(0), overflow_(false), frame_{}, frame_length_(0), in_frame_(false) {
+}
+
+void CommandParser::reset() {
+    line_length_ = 0;
+    overflow_ = false;
+    frame_length_ = 0;
+    in_frame_ = false;
+}
+
+bool CommandParser::feed(uint8_t byte, Command& command) {
+    if (in_frame_) {
+        frame_[frame_length_++] = byte;
+        // op, count, arguments, checksum
+        if (frame_length_ == 2 && frame_[1] > Command::MAX_ARGS) {
+            in_frame_ = false;
+            command.binary = true;
+            return fail(command, ERROR_FRAME);
+        }
+        if (frame_length_ >= 2 && frame_length_ == 3u + frame_[1] * 4u) {
+            in_frame_ = false;
+            return parseFrame(command);
+        }
+        return false;
+    }
+
+    if (byte == '\r' || byte == '\n') {
+        if (overflow_) {
+            overflow_ = false;
+            line_length_ = 0;
+            command.binary = false;
+            return fail(command, ERROR_LONG);
+        }
+        if (line_length_ == 0) {
+            return false;   // Empty line, or the LF of a CR LF
+        }
+        line_[line_length_] = '\0';
+        line_length_ = 0;
+        return parseLine(command);
+    }
+    if (byte == SYNC && line_length_ == 0 && !overflow_) {
+        in_frame_ = true;
+        frame_length_ = 0;
+        return false;
+    }
+    if (byte == 0x08 || byte == 0x7F) {
+        if (line_length_ > 0) {
+            line_length_--;
+        }
+        return false;
+    }
+    if (byte < 0x20 || byte > 0x7E) {
+        return false;
+    }
+    if (line_length_ == LINE_MAX) {
+        overflow_ = true;
+        return false;
+    }
+    line_[line_length_++] = (char)byte;
+    return false;
+}
+
+bool CommandParser::parseLine(Command& command) {
+    command.binary = false;
+    command.argc = 0;
+    command.error = nullptr;
+
+    char* words[MAX_WORDS];
+    uint8_t count = 0;
+    char* p = line_;
+    while (*p != '\0') {
+        while (*p == ' ') {
+            *p++ = '\0';
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (count == MAX_WORDS) {
+            return fail(command, ERROR_ARGUMENT);
+        }
+        words[count++] = p;
+        while (*p != ' ' && *p != '\0') {
+            p++;
+        }
+    }
+    if (count == 0) {
+        return false;   // Spaces only
+    }
+
+    const char* name = words[0];
+    if (equals(name, "help") || equals(name, "?")) {
+        command.op = Op::Help;
+        if (count != 1) {
+            return fail(command, ERROR_ARGUMENT);
+        }
+    } else if (equals(name, "stats")) {
+        command.op = Op::Stats;
+        if (count != 1) {
+            return fail(command, ERROR_ARGUMENT);
+        }
+    } else if (equals(name, "rate")) {
+        command.op = Op::Rate;
+        if (count > 2 || (count == 2 && !parseRate(words[1], command.args[0]))) {
+            return fail(command, ERROR_ARGUMENT);
+        }
+        command.argc = (uint8_t)(count - 1);
+    } else if (equals(name, "dump")) {
+        command.op = Op::Dump;
+        if (count < 2 || count > 4) {
+            return fail(command, ERROR_ARGUMENT);
+        }
+        uint8_t buffer = 0;
+        while (buffer < (uint8_t)DumpBuffer::Count && !equals(words[1], BUFFER_NAMES[buffer])) {
+            buffer++;
+        }
+        command.args[0] = buffer;
+        command.argc = 1;
+        for (uint8_t k = 2; k < count; k++) {
+            if (!parseNumber(words[k], command.args[command.argc++])) {
+                return fail(command, ERROR_ARGUMENT);
+            }
+        }
+    } else if (equals(name, "time")) {
+        command.op = Op::Time;
+        if (count == 3) {
+            const char* date = words[1];
+            const char* time = words[2];
+            uint32_t* a = command.args;
+            if (!parseDecimal(date, '-', a[0]) || !parseDecimal(date, '-', a[1]) ||
+                !parseDecimal(date, '\0', a[2]) || !parseDecimal(time, ':', a[3]) ||
+                !parseDecimal(time, ':', a[4]) || !parseDecimal(time, '\0', a[5])) {
+                return fail(command, ERROR_ARGUMENT);
+            }
+            command.argc = 6;
+        } else if (count != 1) {
+            return fail(command, ERROR_ARGUMENT);
+        }
+    } else if (equals(name, "decode")) {
+        command.op = Op::Decode;
+        if (count == 3 || count == 4) {
+            uint8_t protocol = 0;
+            while (protocol < PROTOCOL_COUNT && !equals(words[2], PROTOCOL_NAMES[protocol])) {
+                protocol++;
+            }
+            command.args[1] = protocol;
+            command.args[2] = 0;
+            if (!parseNumber(words[1], command.args[0]) ||
+                (count == 4 && !equals(words[3], "0") && !parseRate(words[3], command.args[2]))) {
+                return fail(command, ERROR_ARGUMENT);
+            }
+            command.argc = (uint8_t)(count - 1);
+        } else if (count != 1) {
+            return fail(command, ERROR_ARGUMENT);
+        }
+    } else {
+        return fail(command, ERROR_UNKNOWN);
+    }
+
+    if (!validArguments(command)) {
+        return fail(command, ERROR_ARGUMENT);
+    }
+    return true;
+}
+
+bool CommandParser::parseFrame(Command& command) {
+    command.binary = true;
+    command.error = nullptr;
+
+    uint8_t sum = 0;
+    for (uint8_t k = 0; k < frame_length_; k++) {
+        sum = (uint8_t)(sum + frame_[k]);
+    }
+    if (sum != 0) {
+        return fail(command, ERROR_CHECKSUM);
+    }
+
+    command.op = (Op)frame_[0];
+    command.argc = frame_[1];
+    for (uint8_t k = 0; k < command.argc; k++) {
+        const uint8_t* p = frame_ + 2 + k * 4;
+        command.args[k] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    if (command.op == Op::None || command.op == Op::Error || command.op > Op::Decode) {
+        return fail(command, ERROR_UNKNOWN);
+    }
+    if (!validArguments(command)) {
+        return fail(command, ERROR_ARGUMENT);
+    }
+    return true;
+}
+
+size_t CommandParser::encodeFrame(Op op, const uint32_t* args, uint8_t argc, uint8_t* out) {
+    if (argc > Command::MAX_ARGS) {
+        return 0;
+    }
+    size_t n = 0;
+    out[n++] = SYNC;
+    out[n++] = (uint8_t)op;
+    out[n++] = argc;
+    for (uint8_t k = 0; k < argc; k++) {
+        out[n++] = (uint8_t)args[k];
+        out[n++] = (uint8_t)(args[k] >> 8);
+        out[n++] = (uint8_t)(args[k] >> 16);
+        out[n++] = (uint8_t)(args[k] >> 24);
+    }
+    uint8_t sum = 0;
+    for (size_t k = 1; k < n; k++) {
+        sum = (uint8_t)(sum + out[k]);
+    }
+    out[n++] = (uint8_t)(0u - sum);
+    return n;
+}
+
+const char* CommandParser::opName(Op op) {
+    switch (op) {
+    case Op::Help:   return "help";
+    case Op::Stats:  return "stats";
+    case Op::Rate:   return "rate";
+    case Op::Dump:   return "dump";
+    case Op::Time:   return "time";
+    case Op::Decode: return "decode";
+    default:         return "?";
+    }
+}
+
+const char* CommandParser::bufferName(DumpBuffer buffer) {
+    return (buffer < DumpBuffer::Count) ? BUFFER_NAMES[(uint8_t)buffer] : "?";
+}
+
+const char* CommandParser::protocolName(uint32_t protocol) {
+    return (protocol < PROTOCOL_COUNT) ? PROTOCOL_NAMES[protocol] : "?";
+}
+
+} // namespace shell
@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file           : CommandParser.hpp
+  * @brief          : Console command parser (text lines and binary frames)
+  ******************************************************************************
+  * Fed one byte at a time from the CDC receive ring by the shell task; no
+  * HAL, no allocation, so hosts build it as is (host/la_shell).
+  *
+  * Text: one command per line (CR, LF or both), words separated by
+  * spaces, case-insensitive; backspace edits, other control bytes are
+  * ignored.
+  *   help
+  *   stats
+  *   rate [HZ]                         HZ may end in k or M (500k, 1M)
+  *   dump events|burst|selftest [FIRST [COUNT]]
+  *   time [YYYY-MM-DD HH:MM:SS]
+  *   decode [CH off|can|manch|bmc|1wire|ws2812|nec [BITRATE]]
+  *                                     BITRATE as HZ, 0 or none: default
+  *
+  * Binary: a frame starts with SYNC where a line would start (text is
+  * 7-bit, so it never does):
+  *   SYNC, u8 op, u8 argument count (<= MAX_ARGS), u32 arguments (little
+  *   endian), u8 checksum (all bytes after SYNC sum to 0 mod 256)
+  * with the same ops and arguments as text (dump: buffer, first, count;
+  * time: year, month, day, hours, minutes, seconds; decode: channel,
+  * protocol index in the order above, bit rate). Replies are text either
+  * way.
+  ******************************************************************************
+  */
+
+#ifndef COMMAND_PARSER_HPP
+#define COMMAND_PARSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace shell {
+
+enum class Op : uint8_t {
+    None = 0,
+    Help = 1,
+    Stats = 2,
+    Rate = 3,     ///< args: [hz]
+    Dump = 4,     ///< args: buffer [first [count]]
+    Time = 5,     ///< args: [year month day hours minutes seconds]
+    Decode = 6,   ///< args: [channel protocol [bitrate]]
+    Error = 0xFF, ///< Not a command; error says why
+};
+
+enum class DumpBuffer : uint8_t { Events = 0, Burst = 1, Selftest = 2, Count };
+
+struct Command {
+    static constexpr uint8_t MAX_ARGS = 6;
+
+    Op op;
+    bool binary;             ///< Came as a frame
+    uint8_t argc;            ///< Arguments given
+    uint32_t args[MAX_ARGS];
+    const char* error;       ///< Op::Error: what was wrong
+};
+
+class CommandParser {
+public:
+    static constexpr uint8_t SYNC = 0xA5;
+    static constexpr uint8_t LINE_MAX = 64;
+    static constexpr uint8_t FRAME_MAX = 3 + Command::MAX_ARGS * 4 + 1;
+    static constexpr uint8_t PROTOCOL_COUNT = 7;   ///< decode::Protocol::COUNT
+
+    CommandParser();
+
+    /**
+     * @brief Take the next received byte
+     * @return true when it completed a command (or an error) in command
+     */
+    bool feed(uint8_t byte, Command& command);
+
+    /**
+     * @brief A binary frame is partly received
+     */
+    bool inFrame() const { return in_frame_; }
+
+    /**
+     * @brief Drop a partial line or frame (e.g. a frame cut off by the host)
+     */
+    void reset();
+
+    /**
+     * @brief Build a binary frame (hosts, and for checking the parser)
+     * @param out Room for FRAME_MAX bytes
+     * @return Frame length, 0 if argc is too large
+     */
+    static size_t encodeFrame(Op op, const uint32_t* args, uint8_t argc, uint8_t* out);
+
+    /**
+     * @brief Keyword of an op ("rate"), "?" if unknown
+     */
+    static const char* opName(Op op);
+
+    /**
+     * @brief Keyword of a dump buffer ("events")
+     */
+    static const char* bufferName(DumpBuffer buffer);
+
+    /**
+     * @brief Keyword of a decode protocol index ("can")
+     */
+    static const char* protocolName(uint32_t protocol);
+
+private:
+    bool parseLine(Command& command);
+    bool parseFrame(Command& command);
+
+    char line_[LINE_MAX + 1];
+    uint8_t line_length_;
+    bool overflow_;
+    uint8_t frame_[FRAME_MAX];
+    uint8_t frame_length_;
+    bool in_frame_;
+};
+
+} // namespace shell
+
+#endif /* COMMAND_PARSER_HPP */
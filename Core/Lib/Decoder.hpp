@@ -0,0 +1,163 @@
+/**
+  ******************************************************************************
+  * @file           : Decoder.hpp
+  * @brief          : Common types shared by the protocol decoders
+  ******************************************************************************
+  * Decoders are driven edge by edge from a channel's transition list and
+  * report what they find as fixed-size events. They never build per-bit or
+  * per-sample arrays, so they can run on stored captures and on a live
+  * transition stream alike.
+  ******************************************************************************
+  */
+
+#ifndef DECODER_HPP
+#define DECODER_HPP
+
+#include <cstdint>
+
+namespace decode {
+
+/**
+ * @brief Kind of a decoded event
+ */
+enum class EventType : uint8_t {
+    CanId,          ///< Arbitration field decoded, value = identifier
+    CanData,        ///< Data byte, value = byte
+    CanStuffError,  ///< Six equal consecutive bits inside a stuffed field
+    CanCrcError,    ///< value = (computed CRC << 16) | received CRC
+    CanAckMissing,  ///< Nobody drove the ACK slot dominant
+    CanFormError,   ///< Fixed-form bit (delimiter, EOF) had the wrong level
+    TimingError,    ///< Pulse outside every symbol window, value = ticks
+    OneWireReset,   ///< Reset pulse, value = 1 if a presence pulse followed
+    OneWireByte,    ///< Byte (LSB first), value = byte
+    Ws2812Rgb,      ///< One LED, value = 0xRRGGBB, length = LED index
+    Ws2812Latch,    ///< Reset/latch gap, value = LEDs in the chain
+    IrNecCommand,   ///< value = (address << 8) | command
+    IrNecRepeat,    ///< Repeat code
+    IrCheckError,   ///< Inverted byte mismatch, value = raw 32-bit frame
+    ClockLock,      ///< Clock recovered, value = bit period in ticks
+    ClockUnlock,    ///< Clock lost, value = offending interval in ticks
+    BitData,        ///< Recovered bits (MSB first), length = bit count
+};
+
+/**
+ * @brief Event flag bits (meaning depends on the event type)
+ */
+enum EventFlags : uint8_t {
+    EVENT_FLAG_EXTENDED = 0x01,  ///< CAN: 29-bit identifier, NEC: 16-bit address
+    EVENT_FLAG_RTR      = 0x02,  ///< CAN: remote transmission request
+    EVENT_FLAG_HIGH     = 0x04,  ///< Timing errors: the pulse was high
+};
+
+/**
+ * @brief One decoded event (12 bytes)
+ */
+struct Event {
+    uint32_t timestamp;  ///< Sample tick where the symbol starts
+    uint32_t value;      ///< Decoded value, see EventType
+    EventType type;      ///< Event kind
+    uint8_t channel;     ///< Input channel the decoder listens to
+    uint8_t flags;       ///< EventFlags
+    uint8_t length;      ///< Type specific (e.g. CAN DLC)
+};
+
+/**
+ * @brief Receiver for decoded events
+ */
+class EventSink {
+public:
+    virtual void onEvent(const Event& event) = 0;
+
+protected:
+    ~EventSink() = default;
+};
+
+/**
+ * @brief Feed a transition list into a decoder
+ *
+ * Walks data in the display transition format (bit 7 = level,
+ * bits 6-0 = duration in ticks) and calls decoder.begin() once,
+ * decoder.edge() on every level change and decoder.end() at the end.
+ * Consecutive entries with the same level are merged.
+ *
+ * @param decoder Any decoder with begin/edge/end(uint32_t, ...) members
+ * @param data Transition data
+ * @param length Number of bytes in data
+ * @param start Timestamp of the first entry
+ * @return Timestamp after the last entry
+ */
+template <typename DecoderT>
+uint32_t feedTransitions(DecoderT& decoder, const uint8_t* data, uint16_t length,
+                         uint32_t start = 0) {
+    uint32_t t = start;
+    if (data == nullptr || length == 0) {
+        return t;
+    }
+
+    uint8_t level = data[0] >> 7;
+    decoder.begin(t, level);
+
+    for (uint16_t i = 0; i < length; i++) {
+        uint8_t value = data[i] >> 7;
+        if (value != level) {
+            level = value;
+            decoder.edge(t, level);
+        }
+        t += data[i] & 0x7F;
+    }
+
+    decoder.end(t);
+    return t;
+}
+
+/**
+ * @brief Steps through the edges of one transition list
+ *
+ * For walking several channels together (merge order, lock-step
+ * comparison) where the push model of feedTransitions() does not fit.
+ * time and level are those of the current edge; done is set after the
+ * last one. The first entry only gives the initial level.
+ */
+struct EdgeWalker {
+    const uint8_t* data;
+    uint16_t length;
+    uint16_t index;
+    uint32_t time;
+    uint8_t level;
+    bool done;
+
+    void init(const uint8_t* d, uint16_t n, uint32_t start = 0) {
+        data = d;
+        length = (d != nullptr) ? n : 0;
+        index = 0;
+        time = start;
+        level = (length != 0) ? (data[0] >> 7) : 0;
+        seek();
+    }
+
+    /**
+     * @brief Move past the current edge
+     */
+    void next() {
+        time += data[index] & 0x7F;
+        index++;
+        seek();
+    }
+
+private:
+    // Skip to the next entry whose level differs from the current one
+    void seek() {
+        while (index < length && (data[index] >> 7) == level) {
+            time += data[index] & 0x7F;
+            index++;
+        }
+        done = (index >= length);
+        if (!done) {
+            level = data[index] >> 7;
+        }
+    }
+};
+
+} // namespace decode
+
+#endif /* DECODER_HPP */
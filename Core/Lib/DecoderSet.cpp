@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file           : DecoderSet.cpp
+  * @brief          : Per-channel protocol decoder set implementation
+  ******************************************************************************
+  */
+
+#include "DecoderSet.hpp"
+#include "CanDecoder.hpp"
+#include "ManchesterDecoder.hpp"
+#include "PulseDecoders.hpp"
+
+namespace decode {
+
+const char* protocolName(Protocol protocol) {
+    switch (protocol) {
+    case Protocol::None:        return "off";
+    case Protocol::Can:         return "can";
+    case Protocol::Manchester:  return "manch";
+    case Protocol::BiphaseMark: return "bmc";
+    case Protocol::OneWire:     return "1wire";
+    case Protocol::Ws2812:      return "ws2812";
+    case Protocol::Nec:         return "nec";
+    case Protocol::COUNT:       break;
+    }
+    return "?";
+}
+
+void DecoderSet::set(uint8_t channel, Protocol protocol, uint32_t bitrate) {
+    if (channel >= MAX_CHANNELS || protocol >= Protocol::COUNT) {
+        return;
+    }
+    channels_[channel].protocol = protocol;
+    channels_[channel].bitrate = bitrate;
+}
+
+bool DecoderSet::any() const {
+    for (const Channel& channel : channels_) {
+        if (channel.protocol != Protocol::None) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DecoderSet::run(EventSink& sink, const uint8_t* const* data, const uint16_t* lengths,
+                     uint8_t num_channels, uint32_t sample_rate_hz) const {
+    if (num_channels > MAX_CHANNELS) {
+        num_channels = MAX_CHANNELS;
+    }
+    for (uint8_t ch = 0; ch < num_channels; ch++) {
+        const Channel& channel = channels_[ch];
+        switch (channel.protocol) {
+        case Protocol::None:
+        case Protocol::COUNT:
+            break;
+        case Protocol::Can: {
+            CanDecoder::Config config;
+            config.sample_rate_hz = sample_rate_hz;
+            config.bitrate = (channel.bitrate != 0) ? channel.bitrate : DEFAULT_CAN_BITRATE;
+            config.channel = ch;
+            CanDecoder decoder(sink, config);
+            feedTransitions(decoder, data[ch], lengths[ch]);
+            break;
+        }
+        case Protocol::Manchester:
+        case Protocol::BiphaseMark: {
+            ManchesterDecoder::Config config;
+            config.sample_rate_hz = sample_rate_hz;
+            config.bitrate = (channel.bitrate != 0) ? channel.bitrate : DEFAULT_LINE_BITRATE;
+            config.coding = (channel.protocol == Protocol::Manchester) ? ManchesterDecoder::Coding::Manchester
+                                                                       : ManchesterDecoder::Coding::BiphaseMark;
+            config.channel = ch;
+            ManchesterDecoder decoder(sink, config);
+            feedTransitions(decoder, data[ch], lengths[ch]);
+            break;
+        }
+        case Protocol::OneWire:
+        case Protocol::Ws2812:
+        case Protocol::Nec: {
+            PulseDecoder::Config config;
+            config.sample_rate_hz = sample_rate_hz;
+            config.channel = ch;
+            if (channel.protocol == Protocol::OneWire) {
+                OneWireDecoder decoder(sink, config);
+                feedTransitions(decoder, data[ch], lengths[ch]);
+            } else if (channel.protocol == Protocol::Ws2812) {
+                Ws2812Decoder decoder(sink, config);
+                feedTransitions(decoder, data[ch], lengths[ch]);
+            } else {
+                NecDecoder decoder(sink, config);
+                feedTransitions(decoder, data[ch], lengths[ch]);
+            }
+            break;
+        }
+        }
+    }
+}
+
+} // namespace decode
@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * @file           : DecoderSet.hpp
+  * @brief          : Protocol decoder chosen per channel, run over a capture
+  ******************************************************************************
+  * Holds which decoder listens to each channel and runs them over a
+  * capture's transition lists into one event sink, channel by channel.
+  * Only one decoder exists at a time, on the caller's stack, so a set
+  * costs a few bytes per channel however many protocols there are.
+  ******************************************************************************
+  */
+
+#ifndef DECODER_SET_HPP
+#define DECODER_SET_HPP
+
+#include "Decoder.hpp"
+#include <cstdint>
+
+namespace decode {
+
+/**
+ * @brief Decoder of a channel
+ */
+enum class Protocol : uint8_t {
+    None,
+    Can,            ///< Bit rate from the channel setting (default 500k)
+    Manchester,     ///< IEEE 802.3 polarity, bit rate as for CAN (default 100k)
+    BiphaseMark,    ///< Bit rate as for CAN (default 100k)
+    OneWire,        ///< Standard speed
+    Ws2812,
+    Nec,            ///< Active-low receiver output
+    COUNT,
+};
+
+/**
+ * @brief Short lower-case name of a protocol (max 6 chars)
+ */
+const char* protocolName(Protocol protocol);
+
+class DecoderSet {
+public:
+    static constexpr uint8_t MAX_CHANNELS = 4;
+    static constexpr uint32_t DEFAULT_CAN_BITRATE = 500000;
+    static constexpr uint32_t DEFAULT_LINE_BITRATE = 100000;
+
+    struct Channel {
+        Protocol protocol = Protocol::None;
+        uint32_t bitrate = 0;       ///< 0: the protocol's default
+    };
+
+    /**
+     * @brief Choose the decoder of a channel
+     * @param bitrate CAN / Manchester / biphase-mark bit rate, 0 for the default
+     */
+    void set(uint8_t channel, Protocol protocol, uint32_t bitrate = 0);
+
+    const Channel& channel(uint8_t channel) const { return channels_[channel]; }
+
+    /**
+     * @brief At least one channel has a decoder
+     */
+    bool any() const;
+
+    /**
+     * @brief Decode a capture
+     * @param sink Receives the events, each channel's in time order
+     * @param data Transition list of each channel (display format)
+     * @param lengths Bytes in each list
+     * @param num_channels Channels in the capture (at most MAX_CHANNELS used)
+     * @param sample_rate_hz Tick rate of the capture
+     */
+    void run(EventSink& sink, const uint8_t* const* data, const uint16_t* lengths,
+             uint8_t num_channels, uint32_t sample_rate_hz) const;
+
+private:
+    Channel channels_[MAX_CHANNELS];
+};
+
+} // namespace decode
+
+#endif /* DECODER_SET_HPP */
@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * @file           : EdgeIndex.cpp
+  * @brief          : Seek index over transition data implementation
+  ******************************************************************************
+  */
+
+#include "EdgeIndex.hpp"
+
+namespace decode {
+
+// Smallest block; fewer entries per checkpoint would just waste memory
+static const uint32_t MIN_BLOCK = 8;
+
+EdgeIndex::EdgeIndex(Checkpoint* storage, uint32_t capacity)
+    : checkpoints_(storage), capacity_(capacity), count_(0), block_(MIN_BLOCK),
+      data_(nullptr), length_(0), start_(0), end_(0), edge_count_(0) {
+}
+
+void EdgeIndex::build(const uint8_t* data, uint32_t length, uint32_t start) {
+    data_ = data;
+    length_ = (data != nullptr) ? length : 0;
+    start_ = start;
+    end_ = start;
+    edge_count_ = 0;
+    count_ = 1;
+    checkpoints_[0] = {start, 0, 0, 0};
+    if (length_ == 0) {
+        return;
+    }
+
+    // Smallest power-of-two block whose checkpoints fit the storage
+    block_ = MIN_BLOCK;
+    while ((length_ + block_ - 1) / block_ > capacity_) {
+        block_ <<= 1;
+    }
+
+    uint32_t t = start;
+    uint32_t edges = 0;
+    uint8_t level = data[0] >> 7;
+    count_ = 0;
+    for (uint32_t i = 0; i < length_; i++) {
+        if ((i & (block_ - 1)) == 0) {
+            checkpoints_[count_++] = {t, edges, i, level};
+        }
+        uint8_t value = data[i] >> 7;
+        if (value != level) {
+            edges++;
+            level = value;
+        }
+        t += data[i] & 0x7F;
+    }
+    end_ = t;
+    edge_count_ = edges;
+}
+
+const EdgeIndex::Checkpoint& EdgeIndex::checkpointBefore(uint32_t t) const {
+    // Last checkpoint with time < t (or the first one)
+    uint32_t lo = 0;
+    uint32_t hi = count_;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (checkpoints_[mid].time < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return checkpoints_[(lo != 0) ? lo - 1 : 0];
+}
+
+const EdgeIndex::Checkpoint& EdgeIndex::checkpointForEdge(uint32_t index) const {
+    // Last checkpoint with at most index edges before it
+    uint32_t lo = 0;
+    uint32_t hi = count_;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (checkpoints_[mid].edges <= index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return checkpoints_[(lo != 0) ? lo - 1 : 0];
+}
+
+uint32_t EdgeIndex::edgesBefore(uint32_t t) const {
+    const Checkpoint& cp = checkpointBefore(t);
+    uint32_t time = cp.time;
+    uint32_t edges = cp.edges;
+    uint8_t level = cp.level;
+    if (time >= t) {
+        return edges;
+    }
+
+    for (uint32_t i = cp.offset; i < length_; i++) {
+        uint8_t value = data_[i] >> 7;
+        if (value != level) {
+            edges++;
+            level = value;
+        }
+        time += data_[i] & 0x7F;
+        if (time >= t) {
+            break;
+        }
+    }
+    return edges;
+}
+
+uint32_t EdgeIndex::edgeTime(uint32_t index) const {
+    const Checkpoint& cp = checkpointForEdge(index);
+    uint32_t time = cp.time;
+    uint32_t edges = cp.edges;
+    uint8_t level = cp.level;
+
+    for (uint32_t i = cp.offset; i < length_; i++) {
+        uint8_t value = data_[i] >> 7;
+        if (value != level) {
+            if (edges == index) {
+                return time;
+            }
+            edges++;
+            level = value;
+        }
+        time += data_[i] & 0x7F;
+    }
+    return end_;
+}
+
+bool EdgeIndex::nextEdge(uint32_t t, uint32_t& edge) const {
+    if (t >= end_) {
+        return false;
+    }
+    uint32_t index = edgesBefore(t + 1);
+    if (index >= edge_count_) {
+        return false;
+    }
+    edge = edgeTime(index);
+    return true;
+}
+
+bool EdgeIndex::prevEdge(uint32_t t, uint32_t& edge) const {
+    uint32_t index = edgesBefore(t);
+    if (index == 0) {
+        return false;
+    }
+    edge = edgeTime(index - 1);
+    return true;
+}
+
+bool EdgeIndex::nearestEdge(uint32_t t, uint32_t& edge) const {
+    if (edge_count_ == 0) {
+        return false;
+    }
+    uint32_t index = edgesBefore(t);
+    if (index == 0) {
+        edge = edgeTime(0);
+    } else if (index == edge_count_) {
+        edge = edgeTime(index - 1);
+    } else {
+        uint32_t before = edgeTime(index - 1);
+        uint32_t after = edgeTime(index);
+        edge = (t - before <= after - t) ? before : after;
+    }
+    return true;
+}
+
+} // namespace decode
@@ -0,0 +1,98 @@
+/**
+  ******************************************************************************
+  * @file           : EdgeIndex.hpp
+  * @brief          : Seek index over a channel's transition data
+  ******************************************************************************
+  * Transition data (bit 7 = level, bits 6-0 = duration) can only be walked
+  * from the start. EdgeIndex stores a checkpoint every `block` entries with
+  * the running time, level and edge count, so a time or edge-number query
+  * is a binary search over the checkpoints plus a scan of at most one
+  * block. The block size is picked at build time so the checkpoints fit
+  * the caller's array; a capture of N entries with C checkpoints costs
+  * O(log C + N / C) per query, whatever the capture depth.
+  ******************************************************************************
+  */
+
+#ifndef EDGE_INDEX_HPP
+#define EDGE_INDEX_HPP
+
+#include <cstdint>
+
+namespace decode {
+
+class EdgeIndex {
+public:
+    struct Checkpoint {
+        uint32_t time;     ///< Start time of the entry at offset
+        uint32_t edges;    ///< Edges strictly before time
+        uint32_t offset;   ///< Entry index
+        uint8_t level;     ///< Level before the entry at offset
+    };
+
+    /**
+     * @param storage Checkpoint array
+     * @param capacity Number of elements in storage (at least 1)
+     */
+    EdgeIndex(Checkpoint* storage, uint32_t capacity);
+
+    /**
+     * @brief Index a transition buffer (kept by reference, not copied)
+     * @param data Transition data
+     * @param length Number of entries
+     * @param start Timestamp of the first entry
+     */
+    void build(const uint8_t* data, uint32_t length, uint32_t start = 0);
+
+    uint32_t edgeCount() const { return edge_count_; }
+    uint32_t startTime() const { return start_; }
+    uint32_t endTime() const { return end_; }
+
+    /**
+     * @brief Number of edges at timestamps < t
+     */
+    uint32_t edgesBefore(uint32_t t) const;
+
+    /**
+     * @brief Number of edges in [from, to)
+     */
+    uint32_t countEdges(uint32_t from, uint32_t to) const {
+        return (to > from) ? edgesBefore(to) - edgesBefore(from) : 0;
+    }
+
+    /**
+     * @brief Timestamp of edge number index (0-based, index < edgeCount())
+     */
+    uint32_t edgeTime(uint32_t index) const;
+
+    /**
+     * @brief First edge after t / last edge before t
+     * @return false if there is none
+     */
+    bool nextEdge(uint32_t t, uint32_t& edge) const;
+    bool prevEdge(uint32_t t, uint32_t& edge) const;
+
+    /**
+     * @brief Edge closest to t (earlier one on a tie)
+     * @return false if the data has no edges
+     */
+    bool nearestEdge(uint32_t t, uint32_t& edge) const;
+
+private:
+    const Checkpoint& checkpointBefore(uint32_t t) const;
+    const Checkpoint& checkpointForEdge(uint32_t index) const;
+
+    Checkpoint* checkpoints_;
+    uint32_t capacity_;
+    uint32_t count_;
+    uint32_t block_;
+
+    const uint8_t* data_;
+    uint32_t length_;
+    uint32_t start_;
+    uint32_t end_;
+    uint32_t edge_count_;
+};
+
+} // namespace decode
+
+#endif /* EDGE_INDEX_HPP */
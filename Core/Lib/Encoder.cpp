@@ -9,7 +9,17 @@ Encoder::Encoder(GPIO_TypeDef* portA, uint16_t pinA,
       last_a_state(0), encoder_pos(0), delta(0), position(0), direction(false),
       button_state(1), last_button_state(1),
       last_debounce_time(0), press_start_time(0),
-      last_logged_button_state(1), long_press_detected(false) {
+      last_logged_button_state(1), long_press_detected(false),
+      last_click_time(0), double_click(false), double_click_enabled(true) {
+}
+
+void Encoder::setDoubleClickEnabled(bool enabled) {
+    double_click_enabled = enabled;
+    if (!enabled) {
+        // A press made elsewhere must not pair with the next one
+        last_click_time = 0;
+        double_click = false;
+    }
 }
 
 void Encoder::init() {
@@ -48,6 +58,17 @@ void Encoder::update() {
             if (button_state != last_logged_button_state) {
                 last_logged_button_state = button_state;
                 long_press_detected = false;
+
+                // Second press soon after the first one; a third press
+                // starts a new pair
+                if (button_state == 0 && double_click_enabled) {
+                    if (last_click_time != 0 && (HAL_GetTick() - last_click_time) <= DOUBLE_CLICK_TIME) {
+                        double_click = true;
+                        last_click_time = 0;
+                    } else {
+                        last_click_time = HAL_GetTick();
+                    }
+                }
             }
         }
 
@@ -22,6 +22,9 @@ public:
     bool isButtonPressed() const { return button_state == 0; }
     bool isButtonReleased() const { return button_state == 1; }
     bool isLongPress() const { return long_press_detected; }
+    bool getDoubleClick() { bool d = double_click; double_click = false; return d; }
+    // Only presses made while enabled count towards a double click
+    void setDoubleClickEnabled(bool enabled);
 
 private:
     // GPIO pins
@@ -46,10 +49,14 @@ private:
     uint32_t press_start_time;
     bool last_logged_button_state;
     bool long_press_detected;
+    uint32_t last_click_time;
+    bool double_click;
+    bool double_click_enabled;
 
     // Constants
     static const uint32_t DEBOUNCE_DELAY = 20;
     static const uint32_t LONG_PRESS_DURATION = 1000;
+    static const uint32_t DOUBLE_CLICK_TIME = 400;
 };
 
 #endif // ENCODER_H
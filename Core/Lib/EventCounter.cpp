@@ -0,0 +1,118 @@
+/**
+  ******************************************************************************
+  * @file           : EventCounter.cpp
+  * @brief          : Long-window edge counters implementation
+  ******************************************************************************
+  */
+
+#include "EventCounter.hpp"
+
+namespace measure {
+
+EventCounter::EventCounter(FreqMeter* const* meters, uint8_t num_channels)
+    : meters_(meters), num_channels_(num_channels > MAX_CHANNELS ? MAX_CHANNELS : num_channels),
+      gate_channel_(NO_GATE), running_(false), gate_open_(false),
+      open_count_{}, gated_{}, ticks_(0) {
+}
+
+void EventCounter::start(uint8_t gate_channel) {
+    stop();
+    gate_channel_ = (gate_channel < num_channels_) ? gate_channel : NO_GATE;
+    ticks_ = 0;
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        open_count_[ch] = 0;
+        gated_[ch] = 0;
+        windows_[ch].clear();
+        if (isCounted(ch)) {
+            meters_[ch]->startTotalizer();
+        }
+    }
+
+    // Gate handler first, then the current level: an edge in between is
+    // handled by the interrupt and the check below sees it as no change
+    gate_open_ = (gate_channel_ == NO_GATE);
+    if (gate_channel_ != NO_GATE) {
+        meters_[gate_channel_]->startGate(onGate, this);
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        gate(meters_[gate_channel_]->pinLevel());
+        __set_PRIMASK(primask);
+    }
+    running_ = true;
+    tick();
+}
+
+void EventCounter::stop() {
+    if (!running_) {
+        return;
+    }
+    // Fold an open gate period into the totals before the timers stop
+    if (gate_channel_ != NO_GATE) {
+        meters_[gate_channel_]->stop();
+        gate(0);
+    }
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        if (isCounted(ch)) {
+            gated_[ch] = total(ch);
+            meters_[ch]->stop();
+        }
+    }
+    gate_channel_ = NO_GATE;
+    gate_open_ = false;
+    running_ = false;
+}
+
+void EventCounter::onGate(void* context, uint8_t level) {
+    static_cast<EventCounter*>(context)->gate(level);
+}
+
+void EventCounter::gate(uint8_t level) {
+    if ((level != 0) == gate_open_) {
+        return;
+    }
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        if (!isCounted(ch)) {
+            continue;
+        }
+        uint64_t count = meters_[ch]->edgeCount();
+        if (level) {
+            open_count_[ch] = count;
+        } else {
+            gated_[ch] += count - open_count_[ch];
+        }
+    }
+    gate_open_ = (level != 0);
+}
+
+uint64_t EventCounter::total(uint8_t channel) const {
+    if (!isCounted(channel)) {
+        return 0;
+    }
+    if (!running_) {
+        return gated_[channel];
+    }
+    if (gate_channel_ == NO_GATE) {
+        return meters_[channel]->edgeCount();
+    }
+
+    // Consistent with the gate interrupt
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t count = gated_[channel];
+    if (gate_open_) {
+        count += meters_[channel]->edgeCount() - open_count_[channel];
+    }
+    __set_PRIMASK(primask);
+    return count;
+}
+
+void EventCounter::tick() {
+    ticks_++;
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        if (isCounted(ch)) {
+            windows_[ch].sample(total(ch));
+        }
+    }
+}
+
+} // namespace measure
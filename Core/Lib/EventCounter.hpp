@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file           : EventCounter.hpp
+  * @brief          : Long-window edge counters with optional level gate
+  ******************************************************************************
+  * Every counted channel runs its timer as a totalizer (external clock
+  * mode 1, see FreqMeter), so edges are counted in hardware and the CPU
+  * only sees one overflow interrupt per 65536 edges (per 2^32 on TIM2).
+  * Totals are 64-bit.
+  *
+  * With a gate channel, the others are counted only while the gate is
+  * high. The gate timer interrupts on both gate edges, and the handler
+  * snapshots all totals: on the rising edge it stores them, on the falling
+  * edge it adds the difference. Edges during the interrupt latency (well
+  * under a microsecond) can land on the wrong side of a gate edge. The
+  * gate channel itself is not counted.
+  *
+  * tick() is called once per second and feeds the 1 s / 1 min / 1 h rate
+  * windows of every channel.
+  ******************************************************************************
+  */
+
+#ifndef EVENT_COUNTER_HPP
+#define EVENT_COUNTER_HPP
+
+#include "FreqMeter.hpp"
+#include "RateWindows.hpp"
+#include <cstdint>
+
+namespace measure {
+
+class EventCounter {
+public:
+    static constexpr uint8_t MAX_CHANNELS = 4;
+    static constexpr uint8_t NO_GATE = 0xFF;
+
+    /**
+     * @param meters Timer of each channel (read when start() is called)
+     * @param num_channels Number of channels (max MAX_CHANNELS)
+     */
+    EventCounter(FreqMeter* const* meters, uint8_t num_channels);
+
+    /**
+     * @brief Clear the totals and start counting
+     * @param gate_channel Channel whose high level enables counting, or NO_GATE
+     */
+    void start(uint8_t gate_channel = NO_GATE);
+
+    /**
+     * @brief Stop all timers (totals are kept until the next start)
+     */
+    void stop();
+
+    bool isRunning() const { return running_; }
+    uint8_t gateChannel() const { return gate_channel_; }
+    bool gateOpen() const { return gate_open_; }
+    bool isCounted(uint8_t channel) const { return channel < num_channels_ && channel != gate_channel_; }
+
+    /**
+     * @brief Counted edges of a channel since start()
+     */
+    uint64_t total(uint8_t channel) const;
+
+    /**
+     * @brief Sample the totals into the rate windows; call once per second
+     */
+    void tick();
+
+    const RateWindows& rates(uint8_t channel) const { return windows_[channel]; }
+
+    /**
+     * @brief Whole seconds since start() (tick() calls after the first)
+     */
+    uint32_t seconds() const { return (ticks_ != 0) ? ticks_ - 1 : 0; }
+
+    /**
+     * @brief Gate edge handler (FreqMeter::GateHandler)
+     */
+    static void onGate(void* context, uint8_t level);
+
+private:
+    void gate(uint8_t level);
+
+    FreqMeter* const* meters_;
+    uint8_t num_channels_;
+    uint8_t gate_channel_;
+    bool running_;
+
+    // Written by the gate interrupt
+    volatile bool gate_open_;
+    uint64_t open_count_[MAX_CHANNELS];   // Raw count when the gate opened
+    uint64_t gated_[MAX_CHANNELS];        // Edges of the closed gate periods
+
+    RateWindows windows_[MAX_CHANNELS];
+    uint32_t ticks_;
+};
+
+} // namespace measure
+
+#endif /* EVENT_COUNTER_HPP */
@@ -0,0 +1,146 @@
+/**
+  ******************************************************************************
+  * @file           : EventStore.cpp
+  * @brief          : Indexed store of decoded events implementation
+  ******************************************************************************
+  */
+
+#include "EventStore.hpp"
+#include <algorithm>
+
+namespace decode {
+
+const char* eventTypeName(EventType type) {
+    switch (type) {
+    case EventType::CanId:         return "CAN ID";
+    case EventType::CanData:       return "CAN DAT";
+    case EventType::CanStuffError: return "CAN STF";
+    case EventType::CanCrcError:   return "CAN CRC";
+    case EventType::CanAckMissing: return "CAN ACK";
+    case EventType::CanFormError:  return "CAN FRM";
+    case EventType::TimingError:   return "TIMING";
+    case EventType::OneWireReset:  return "1W RST";
+    case EventType::OneWireByte:   return "1W BYTE";
+    case EventType::Ws2812Rgb:     return "WS RGB";
+    case EventType::Ws2812Latch:   return "WS LATCH";
+    case EventType::IrNecCommand:  return "NEC";
+    case EventType::IrNecRepeat:   return "NEC RPT";
+    case EventType::IrCheckError:  return "NEC ERR";
+    case EventType::ClockLock:     return "LOCK";
+    case EventType::ClockUnlock:   return "UNLOCK";
+    case EventType::BitData:       return "BITS";
+    }
+    return "?";
+}
+
+EventStore::Query EventStore::Query::errors() {
+    Query query;
+    query.type_mask = eventTypeBit(EventType::CanStuffError) |
+                      eventTypeBit(EventType::CanCrcError) |
+                      eventTypeBit(EventType::CanAckMissing) |
+                      eventTypeBit(EventType::CanFormError) |
+                      eventTypeBit(EventType::TimingError) |
+                      eventTypeBit(EventType::IrCheckError) |
+                      eventTypeBit(EventType::ClockUnlock);
+    return query;
+}
+
+EventStore::EventStore(Event* storage, uint32_t capacity)
+    : events_(storage), capacity_(capacity), size_(0), dropped_(0), sorted_(true) {
+}
+
+void EventStore::clear() {
+    size_ = 0;
+    dropped_ = 0;
+    sorted_ = true;
+}
+
+void EventStore::onEvent(const Event& event) {
+    if (size_ >= capacity_) {
+        dropped_++;
+        return;
+    }
+    if (size_ != 0 && event.timestamp < events_[size_ - 1].timestamp) {
+        sorted_ = false;
+    }
+    events_[size_++] = event;
+}
+
+void EventStore::sort() {
+    if (sorted_) {
+        return;
+    }
+    // Decoders emit in time order per channel; a stable sort keeps two
+    // events of one channel at the same tick (e.g. ClockLock and the first
+    // BitData) in the order they were reported. Without room for a
+    // temporary buffer stable_sort merges in place, slower but correct.
+    std::stable_sort(events_, events_ + size_, [](const Event& a, const Event& b) {
+        return a.timestamp != b.timestamp ? a.timestamp < b.timestamp : a.channel < b.channel;
+    });
+    sorted_ = true;
+}
+
+uint32_t EventStore::lowerBound(uint32_t timestamp) const {
+    uint32_t lo = 0;
+    uint32_t hi = size_;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (events_[mid].timestamp < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int32_t EventStore::scanForward(const Query& query, uint32_t from) const {
+    for (uint32_t i = from; i < size_; i++) {
+        if (query.matches(events_[i])) {
+            return (int32_t)i;
+        }
+    }
+    return NOT_FOUND;
+}
+
+int32_t EventStore::scanBackward(const Query& query, uint32_t end) const {
+    uint32_t i = (end < size_) ? end : size_;
+    while (i-- > 0) {
+        if (query.matches(events_[i])) {
+            return (int32_t)i;
+        }
+    }
+    return NOT_FOUND;
+}
+
+int32_t EventStore::findNext(const Query& query, uint32_t timestamp) const {
+    return scanForward(query, (timestamp == 0xFFFFFFFF) ? size_ : lowerBound(timestamp + 1));
+}
+
+int32_t EventStore::findPrev(const Query& query, uint32_t timestamp) const {
+    return scanBackward(query, lowerBound(timestamp));
+}
+
+int32_t EventStore::nextMatch(const Query& query, uint32_t index) const {
+    return scanForward(query, index + 1);
+}
+
+int32_t EventStore::prevMatch(const Query& query, uint32_t index) const {
+    return scanBackward(query, index);
+}
+
+uint32_t EventStore::count(const Query& query) const {
+    return rank(query, size_);
+}
+
+uint32_t EventStore::rank(const Query& query, uint32_t index) const {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < index && i < size_; i++) {
+        if (query.matches(events_[i])) {
+            n++;
+        }
+    }
+    return n;
+}
+
+} // namespace decode
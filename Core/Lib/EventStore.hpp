@@ -0,0 +1,138 @@
+/**
+  ******************************************************************************
+  * @file           : EventStore.hpp
+  * @brief          : Indexed store of decoded events with value/mask search
+  ******************************************************************************
+  * Events live in a caller-provided fixed array (12 bytes each). Once the
+  * decoders are done the array is sorted by timestamp, so a search first
+  * binary-searches the time position and then scans forward or backward
+  * with a type/channel/value mask test, a handful of cycles per event.
+  ******************************************************************************
+  */
+
+#ifndef EVENT_STORE_HPP
+#define EVENT_STORE_HPP
+
+#include "Decoder.hpp"
+#include <cstdint>
+
+namespace decode {
+
+/**
+ * @brief Bit for an event type in a Query type mask
+ */
+constexpr uint32_t eventTypeBit(EventType type) {
+    return 1u << (uint8_t)type;
+}
+
+/**
+ * @brief Short display name of an event type (max 8 chars)
+ */
+const char* eventTypeName(EventType type);
+
+class EventStore : public EventSink {
+public:
+    static constexpr int32_t NOT_FOUND = -1;
+
+    /**
+     * @brief Search criteria
+     *
+     * An event matches when its type bit is in type_mask, its channel bit
+     * is in channel_mask and (value ^ query value) & value_mask == 0.
+     */
+    struct Query {
+        uint32_t type_mask = 0xFFFFFFFF;
+        uint32_t value = 0;
+        uint32_t value_mask = 0;
+        uint8_t channel_mask = 0xFF;
+
+        bool matches(const Event& event) const {
+            return (type_mask & eventTypeBit(event.type)) != 0 &&
+                   (channel_mask & (1u << event.channel)) != 0 &&
+                   ((event.value ^ value) & value_mask) == 0;
+        }
+
+        /** @brief Every protocol, timing and clock error */
+        static Query errors();
+    };
+
+    /**
+     * @brief Construct a store over existing memory
+     * @param storage Event array (e.g. part of the capture arena)
+     * @param capacity Number of elements in storage
+     */
+    EventStore(Event* storage, uint32_t capacity);
+
+    void clear();
+
+    /**
+     * @brief Append an event (dropped and counted when full)
+     */
+    void onEvent(const Event& event) override;
+
+    /**
+     * @brief Sort by timestamp; call after all decoders have run
+     */
+    void sort();
+
+    uint32_t size() const { return size_; }
+    uint32_t capacity() const { return capacity_; }
+    uint32_t dropped() const { return dropped_; }
+    const Event& operator[](uint32_t index) const { return events_[index]; }
+
+    /**
+     * @brief Index of the first event at or after timestamp
+     */
+    uint32_t lowerBound(uint32_t timestamp) const;
+
+    /**
+     * @brief First matching event strictly after timestamp
+     * @return Index or NOT_FOUND
+     */
+    int32_t findNext(const Query& query, uint32_t timestamp) const;
+
+    /**
+     * @brief Last matching event strictly before timestamp
+     * @return Index or NOT_FOUND
+     */
+    int32_t findPrev(const Query& query, uint32_t timestamp) const;
+
+    /**
+     * @brief First matching event after the one at index
+     *
+     * Steps by position, so events sharing a timestamp (several channels,
+     * or a decoder reporting two things at once) are each visited once.
+     * @return Index or NOT_FOUND
+     */
+    int32_t nextMatch(const Query& query, uint32_t index) const;
+
+    /**
+     * @brief Last matching event before the one at index
+     * @return Index or NOT_FOUND
+     */
+    int32_t prevMatch(const Query& query, uint32_t index) const;
+
+    /**
+     * @brief Number of matching events
+     */
+    uint32_t count(const Query& query) const;
+
+    /**
+     * @brief Number of matching events before index (for "n of N")
+     */
+    uint32_t rank(const Query& query, uint32_t index) const;
+
+private:
+    int32_t scanForward(const Query& query, uint32_t from) const;
+    int32_t scanBackward(const Query& query, uint32_t end) const;
+
+    Event* events_;
+    uint32_t capacity_;
+    uint32_t size_;
+    uint32_t dropped_;
+    bool sorted_;
+};
+
+} // namespace decode
+
+#endif /* EVENT_STORE_HPP */
@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file           : FrameMirror.cpp
+  * @brief          : OLED frame mirroring implementation
+  ******************************************************************************
+  */
+
+#include "FrameMirror.hpp"
+#include "usbd_bulk_if.h"
+#include <cstring>
+
+namespace display {
+
+static const uint8_t COMMAND_BYTES = 16;
+static const char COMMAND[8] = {'L', 'A', 'M', 'I', 'R', 'R', 'O', 'R'};
+static const char FRAME_MAGIC[8] = {'L', 'A', 'F', 'R', 'A', 'M', 'E', '!'};
+
+static void putWord(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+FrameMirror::Request FrameMirror::parseCommand(const uint8_t* packet, uint32_t length) {
+    if (length < COMMAND_BYTES || memcmp(packet, COMMAND, 8) != 0) {
+        return Request::None;
+    }
+    return (packet[8] | packet[9] | packet[10] | packet[11]) ? Request::On : Request::Off;
+}
+
+FrameMirror::FrameMirror() : buffers_{}, next_(0), resync_(true), sequence_(0), sent_(0), dropped_(0) {
+}
+
+bool FrameMirror::present(const uint8_t* framebuffer, const uint8_t* first, const uint8_t* count) {
+    bool key = resync_;
+    uint8_t spans = 0;
+    for (uint8_t page = 0; page < SH1106_PAGES; page++) {
+        if (key || count[page] != 0) {
+            spans++;
+        }
+    }
+    if (spans == 0) {
+        return true;
+    }
+    uint32_t sequence = sequence_++;
+
+    // With two buffers alternating, the one queued earlier is free again
+    // once fewer than two transfers are pending
+    if (BULK_TxPending_FS() >= BULK_TX_QUEUE_DEPTH) {
+        dropped_++;
+        resync_ = true;
+        return false;
+    }
+
+    uint8_t* frame = buffers_[next_];
+    uint8_t* p = frame + HEADER_BYTES;
+    for (uint8_t page = 0; page < SH1106_PAGES; page++) {
+        uint8_t from = key ? 0 : first[page];
+        uint8_t columns = key ? SH1106_WIDTH : count[page];
+        if (columns == 0) {
+            continue;
+        }
+        p[0] = page;
+        p[1] = from;
+        p[2] = columns;
+        memcpy(p + SPAN_HEADER_BYTES, framebuffer + page * SH1106_WIDTH + from, columns);
+        p += SPAN_HEADER_BYTES + columns;
+    }
+    uint16_t span_bytes = (uint16_t)(p - frame - HEADER_BYTES);
+    memcpy(frame, FRAME_MAGIC, 8);
+    putWord(frame + 8, sequence);
+    putWord(frame + 12, HAL_GetTick());
+    frame[16] = (uint8_t)span_bytes;
+    frame[17] = (uint8_t)(span_bytes >> 8);
+    frame[18] = spans;
+    frame[19] = key ? FLAG_KEY : 0;
+
+    if (BULK_Transmit_FS(frame, HEADER_BYTES + span_bytes) != USBD_OK) {
+        dropped_++;
+        resync_ = true;
+        return false;
+    }
+    next_ ^= 1;
+    resync_ = false;
+    sent_++;
+    return true;
+}
+
+} // namespace display
@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file           : FrameMirror.hpp
+  * @brief          : Presented OLED frames mirrored over the vendor bulk pipe
+  ******************************************************************************
+  * Oled::update() hands every presented frame to the mirror with the spans
+  * the panel flush has just sent (SH1106_t dirty_first/dirty_count), and
+  * the mirror sends the same spans to the host. Nothing waits: a frame is
+  * built into one of two buffers and queued only while the bulk pipe has
+  * room; otherwise it is dropped and the next one carries every page.
+  *
+  * Commands (host -> bulk OUT, little endian):
+  *   "LAMIRROR", u32 1 = on / 0 = off, u32 reserved (16 bytes)
+  * Frames (device -> bulk IN, one transfer each, little endian):
+  *   "LAFRAME!", u32 sequence (dropped frames count too), u32 tick ms,
+  *   u16 span bytes, u8 span count, u8 flags (bit 0: key frame, every page
+  *   whole) (20 bytes), then per span u8 page, u8 first column, u8 column
+  *   count and the page bytes (bit n of a byte = row page * 8 + n)
+  * A frame with no changes is not sent. Turning the mirror on sends a key
+  * frame of what is on the panel.
+  ******************************************************************************
+  */
+
+#ifndef FRAME_MIRROR_HPP
+#define FRAME_MIRROR_HPP
+
+#include "sh1106.h"
+#include <cstdint>
+
+namespace display {
+
+class FrameMirror {
+public:
+    static constexpr uint8_t HEADER_BYTES = 20;
+    static constexpr uint8_t SPAN_HEADER_BYTES = 3;
+    static constexpr uint16_t FRAME_MAX = HEADER_BYTES + SH1106_PAGES * (SPAN_HEADER_BYTES + SH1106_WIDTH);
+    static constexpr uint8_t FLAG_KEY = 1u << 0;
+
+    enum class Request : uint8_t { None, On, Off };
+
+    /**
+     * @brief Decode a bulk OUT packet
+     */
+    static Request parseCommand(const uint8_t* packet, uint32_t length);
+
+    FrameMirror();
+
+    /**
+     * @brief Make the next frame a key frame
+     */
+    void resync() { resync_ = true; }
+
+    /**
+     * @brief Queue the spans of a presented frame (never waits)
+     * @param framebuffer Panel framebuffer, page by page
+     * @param first First changed column of each page
+     * @param count Changed columns of each page (0 = unchanged)
+     * @return false if the pipe was busy and the frame was dropped
+     */
+    bool present(const uint8_t* framebuffer, const uint8_t* first, const uint8_t* count);
+
+    uint32_t sent() const { return sent_; }
+    uint32_t dropped() const { return dropped_; }
+
+private:
+    uint8_t buffers_[2][FRAME_MAX];   ///< Sent in place, alternately
+    uint8_t next_;
+    bool resync_;
+    uint32_t sequence_;
+    uint32_t sent_;
+    uint32_t dropped_;
+};
+
+} // namespace display
+
+#endif /* FRAME_MIRROR_HPP */
@@ -0,0 +1,351 @@
+/**
+  ******************************************************************************
+  * @file           : FreqMeter.cpp
+  * @brief          : Hardware frequency / duty-cycle meter implementation
+  ******************************************************************************
+  */
+
+#include "FreqMeter.hpp"
+
+namespace measure {
+
+// Hysteresis around switch_hz, in percent
+static const uint32_t SWITCH_UP_PCT = 125;
+static const uint32_t SWITCH_DOWN_PCT = 80;
+
+static void enableTimerClock(TIM_TypeDef* tim) {
+    if (tim == TIM1) {
+        __HAL_RCC_TIM1_CLK_ENABLE();
+    } else if (tim == TIM2) {
+        __HAL_RCC_TIM2_CLK_ENABLE();
+    } else if (tim == TIM3) {
+        __HAL_RCC_TIM3_CLK_ENABLE();
+    } else if (tim == TIM4) {
+        __HAL_RCC_TIM4_CLK_ENABLE();
+    } else if (tim == TIM5) {
+        __HAL_RCC_TIM5_CLK_ENABLE();
+    } else if (tim == TIM9) {
+        __HAL_RCC_TIM9_CLK_ENABLE();
+    }
+}
+
+FreqMeter::FreqMeter(const Hardware& hw, uint32_t switch_hz)
+    : hw_(hw), switch_hz_(switch_hz),
+      arr_(IS_TIM_32B_COUNTER_INSTANCE(hw.tim) ? 0xFFFFFFFF : 0xFFFF),
+      mode_(Mode::Off), wraps_(0), periods_(0), sum_period_(0), sum_high_(0),
+      high_(0), synced_(false), gate_count_(0), gate_cycles_(0), last_period_(0),
+      gate_handler_(nullptr), gate_context_(nullptr) {
+}
+
+void FreqMeter::start() {
+    claim();
+    // Start counting: an unknown input may be far too fast for per-edge IRQs
+    configureCounting();
+}
+
+void FreqMeter::startTotalizer() {
+    claim();
+    configureCounting();
+    mode_ = Mode::Totalizer;
+}
+
+void FreqMeter::startGate(GateHandler handler, void* context) {
+    claim();
+    resetTimer();
+    gate_handler_ = handler;
+    gate_context_ = context;
+    TIM_TypeDef* tim = hw_.tim;
+    // IC1 from TI1 on both edges; only the interrupt is used
+    tim->CCMR1 = TIM_CCMR1_CC1S_0;
+    tim->CCER = TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP;
+    tim->DIER = TIM_DIER_CC1IE;
+    tim->CR1 = TIM_CR1_URS | TIM_CR1_CEN;
+    mode_ = Mode::Gate;
+}
+
+void FreqMeter::claim() {
+    enableTimerClock(hw_.tim);
+
+    // Window timing uses the cycle counter
+    CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Pin = hw_.pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = hw_.alternate;
+    HAL_GPIO_Init(hw_.port, &GPIO_InitStruct);
+
+    reading_ = Reading();
+    last_period_ = 0;
+
+    // The ISR never calls the RTOS; a shared update line keeps its priority
+    HAL_NVIC_SetPriority(hw_.irq, 5, 0);
+    HAL_NVIC_EnableIRQ(hw_.irq);
+    if (hw_.update_irq != hw_.irq) {
+        HAL_NVIC_EnableIRQ(hw_.update_irq);
+    }
+}
+
+void FreqMeter::stop() {
+    resetTimer();
+    mode_ = Mode::Off;
+
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Pin = hw_.pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(hw_.port, &GPIO_InitStruct);
+}
+
+void FreqMeter::resetTimer() {
+    TIM_TypeDef* tim = hw_.tim;
+    tim->DIER = 0;
+    tim->CR1 = 0;
+    tim->SMCR = 0;
+    tim->CCER = 0;
+    tim->CCMR1 = 0;
+    tim->PSC = 0;
+    tim->ARR = arr_;
+    tim->CNT = 0;
+    // URS: only overflows set UIF, not the slave-mode counter resets
+    tim->CR1 = TIM_CR1_URS;
+    tim->EGR = TIM_EGR_UG;
+    tim->SR = 0;
+
+    wraps_ = 0;
+    periods_ = 0;
+    sum_period_ = 0;
+    sum_high_ = 0;
+    high_ = 0;
+    synced_ = false;
+}
+
+void FreqMeter::configurePwmInput(bool interrupts) {
+    TIM_TypeDef* tim = hw_.tim;
+    resetTimer();
+    // IC1 and IC2 both from TI1: IC1 on rising edges, IC2 on falling edges
+    tim->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_1;
+    tim->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC2P;
+    // Slave reset mode triggered by TI1FP1: CCR1 = period, CCR2 = high time
+    tim->SMCR = TIM_SMCR_TS_2 | TIM_SMCR_TS_0 | TIM_SMCR_SMS_2;
+    if (interrupts) {
+        tim->DIER = TIM_DIER_UIE | TIM_DIER_CC1IE | TIM_DIER_CC2IE;
+    }
+    tim->CR1 = TIM_CR1_URS | TIM_CR1_CEN;
+    mode_ = Mode::Reciprocal;
+}
+
+void FreqMeter::configureCounting() {
+    TIM_TypeDef* tim = hw_.tim;
+    resetTimer();
+    // External clock mode 1: every rising edge on TI1FP1 clocks the counter
+    tim->CCMR1 = TIM_CCMR1_CC1S_0;
+    tim->SMCR = TIM_SMCR_TS_2 | TIM_SMCR_TS_0 | TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1 | TIM_SMCR_SMS_0;
+    tim->DIER = TIM_DIER_UIE;
+    tim->CR1 = TIM_CR1_URS | TIM_CR1_CEN;
+    gate_count_ = 0;
+    gate_cycles_ = DWT->CYCCNT;
+    mode_ = Mode::Counting;
+}
+
+void FreqMeter::handleInterrupt() {
+    TIM_TypeDef* tim = hw_.tim;
+    uint32_t sr = tim->SR & tim->DIER;
+    if (sr == 0) {
+        return;
+    }
+    tim->SR = ~sr;
+
+    if (mode_ == Mode::Gate) {
+        if ((sr & TIM_SR_CC1IF) && gate_handler_ != nullptr) {
+            (void)tim->CCR1;
+            gate_handler_(gate_context_, pinLevel());
+        }
+        return;
+    }
+
+    bool wrapped = (sr & TIM_SR_UIF) != 0;
+    if (mode_ != Mode::Reciprocal) {
+        if (wrapped) {
+            wraps_ = wraps_ + 1;
+        }
+        return;
+    }
+
+    // A pending overflow belongs before a capture only if the captured
+    // value is small (the counter wrapped shortly before the edge)
+    uint64_t range = (uint64_t)arr_ + 1;
+    if (sr & TIM_SR_CC2IF) {
+        uint32_t value = tim->CCR2;
+        uint32_t wraps = wraps_ + ((wrapped && value < counterHalf()) ? 1 : 0);
+        high_ = wraps * range + value;
+    }
+    if (sr & TIM_SR_CC1IF) {
+        uint32_t value = tim->CCR1;
+        uint32_t wraps = wraps_ + (wrapped ? 1 : 0);
+        if (synced_) {
+            periods_ = periods_ + 1;
+            sum_period_ = sum_period_ + wraps * range + value;
+            sum_high_ = sum_high_ + high_;
+            // Runaway input: fall back to counting until the next update()
+            if (periods_ >= 2 * switch_hz_) {
+                tim->DIER = TIM_DIER_UIE;
+            }
+        }
+        synced_ = true;
+        high_ = 0;
+        wraps_ = 0;
+    } else if (wrapped) {
+        wraps_ = wraps_ + 1;
+    }
+}
+
+void FreqMeter::update() {
+    if (mode_ == Mode::Reciprocal) {
+        updateReciprocal();
+    } else if (mode_ == Mode::Counting) {
+        updateCounting();
+    }
+}
+
+void FreqMeter::updateReciprocal() {
+    TIM_TypeDef* tim = hw_.tim;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t periods = periods_;
+    uint64_t sum_period = sum_period_;
+    uint64_t sum_high = sum_high_;
+    periods_ = 0;
+    sum_period_ = 0;
+    sum_high_ = 0;
+    uint32_t count = tim->CNT;
+    uint32_t wraps = wraps_;
+    if ((tim->SR & TIM_SR_UIF) && count < counterHalf()) {
+        wraps++;
+    }
+    bool runaway = (tim->DIER & TIM_DIER_CC1IE) == 0;
+    __set_PRIMASK(primask);
+
+    reading_.counting = false;
+    reading_.level = (hw_.port->IDR & hw_.pin) ? 1 : 0;
+    reading_.pulses = periods;
+    reading_.total += periods;
+
+    if (periods != 0) {
+        double seconds = (double)sum_period / hw_.clock_hz;
+        last_period_ = sum_period / periods;
+        reading_.valid = true;
+        reading_.frequency_hz = (float)(periods / seconds);
+        reading_.period_s = (float)(seconds / periods);
+        reading_.duty_pct = (float)(100.0 * (double)sum_high / (double)sum_period);
+    } else {
+        // Slow signal: hold the last reading until the next edge is overdue
+        uint64_t since_edge = (uint64_t)wraps * ((uint64_t)arr_ + 1) + count;
+        if (last_period_ == 0 || since_edge > 2 * last_period_) {
+            reading_.valid = false;
+        }
+    }
+
+    if (runaway || (periods != 0 &&
+                    reading_.frequency_hz * 100 > (float)switch_hz_ * SWITCH_UP_PCT)) {
+        configureCounting();
+    }
+}
+
+uint64_t FreqMeter::edgeCount() const {
+    TIM_TypeDef* tim = hw_.tim;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t count = tim->CNT;
+    uint32_t wraps = wraps_;
+    // Overflow not yet taken by the ISR
+    if ((tim->SR & TIM_SR_UIF) && count < counterHalf()) {
+        wraps++;
+    }
+    __set_PRIMASK(primask);
+
+    return (uint64_t)wraps * ((uint64_t)arr_ + 1) + count;
+}
+
+void FreqMeter::updateCounting() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t count = edgeCount();
+    uint32_t cycles = DWT->CYCCNT;
+    __set_PRIMASK(primask);
+
+    uint64_t edges = count - gate_count_;
+    uint32_t elapsed = cycles - gate_cycles_;
+
+    reading_.counting = true;
+    reading_.level = (hw_.port->IDR & hw_.pin) ? 1 : 0;
+    reading_.pulses = (uint32_t)edges;
+    reading_.total += edges;
+
+    if (edges == 0 || elapsed == 0) {
+        // Nothing to count: wait for edges in reciprocal mode
+        reading_.valid = false;
+        configurePwmInput(true);
+        return;
+    }
+
+    double seconds = (double)elapsed / SystemCoreClock;
+    reading_.valid = true;
+    reading_.frequency_hz = (float)(edges / seconds);
+    reading_.period_s = (float)(seconds / edges);
+    last_period_ = 0;
+
+    if (reading_.frequency_hz * 100 < (float)switch_hz_ * SWITCH_DOWN_PCT) {
+        configurePwmInput(true);
+        return;
+    }
+
+    // Edges during the duty capture are not counted; the next gate
+    // starts when counting resumes
+    float duty;
+    reading_.duty_pct = captureDuty(duty) ? duty : -1.0f;
+    configureCounting();
+}
+
+bool FreqMeter::captureDuty(float& duty_pct) {
+    TIM_TypeDef* tim = hw_.tim;
+    configurePwmInput(false);
+
+    // Above switch_hz * 0.8 a period is well under a millisecond
+    uint32_t start = DWT->CYCCNT;
+    uint32_t timeout = SystemCoreClock / 500;
+
+    // First rising edge resets the counter; after that one fall and one
+    // more rise give a matching high time and period
+    while ((tim->SR & TIM_SR_CC1IF) == 0) {
+        if (DWT->CYCCNT - start > timeout) {
+            return false;
+        }
+    }
+    tim->SR = 0;
+    while ((tim->SR & (TIM_SR_CC1IF | TIM_SR_CC2IF)) != (TIM_SR_CC1IF | TIM_SR_CC2IF)) {
+        if (DWT->CYCCNT - start > timeout) {
+            return false;
+        }
+    }
+
+    // Freeze both captures before reading them
+    tim->CCER = 0;
+    uint32_t period = tim->CCR1;
+    uint32_t high = tim->CCR2;
+    if (period == 0) {
+        return false;
+    }
+    if (high > period) {
+        high = period;
+    }
+    duty_pct = 100.0f * (float)high / (float)period;
+    return true;
+}
+
+} // namespace measure
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file           : FreqMeter.hpp
+  * @brief          : Hardware frequency / duty-cycle meter for one channel
+  ******************************************************************************
+  * The meter measures with the channel's timer and never samples the pin.
+  * Two hardware modes are used, and the meter switches between them with
+  * hysteresis around switch_hz:
+  *
+  * - Reciprocal (low frequencies): PWM-input capture. CH1 latches the
+  *   period on every rising edge and resets the counter, CH2 latches the
+  *   high time on the falling edge. A short ISR adds both to running sums,
+  *   and counter overflows extend 16-bit timers to any period length. Each
+  *   window then gives f = n / sum(periods), with a resolution of one timer
+  *   clock over the whole window.
+  * - Counting (high frequencies): the counter is clocked by the input
+  *   (external clock mode 1), and the only interrupt is one overflow per
+  *   65536 edges. Each window divides the edge count by the elapsed DWT
+  *   cycles. Duty is taken from one PWM-input period captured by polling
+  *   between two windows.
+  *
+  * update() is called a few times per second from a task and turns the
+  * window into a Reading. That is the only CPU work besides the ISR.
+  *
+  * Two more modes serve the event counter:
+  * - Totalizer: counting without windows or mode switches. edgeCount()
+  *   extends the counter to 64 bits with the overflow count.
+  * - Gate: CH1 captures both edges and the ISR reports the new level to a
+  *   handler, so other channels can be counted only while it is high.
+  ******************************************************************************
+  */
+
+#ifndef FREQ_METER_HPP
+#define FREQ_METER_HPP
+
+#include "stm32f4xx_hal.h"
+#include <cstdint>
+
+namespace measure {
+
+class FreqMeter {
+public:
+    /**
+     * @brief Timer input wired to an analyzer channel
+     */
+    struct Hardware {
+        TIM_TypeDef* tim;        ///< Timer with the pin on its CH1
+        GPIO_TypeDef* port;
+        uint16_t pin;
+        uint8_t alternate;       ///< GPIO_AFx_TIMy of the pin
+        IRQn_Type irq;           ///< Capture/compare interrupt
+        IRQn_Type update_irq;    ///< Update interrupt (same as irq on TIM2..5, TIM9)
+        uint32_t clock_hz;       ///< Timer kernel clock
+    };
+
+    struct Reading {
+        bool valid = false;      ///< A period was measured recently
+        bool counting = false;   ///< Measured by gated counting
+        uint8_t level = 0;       ///< Pin level, useful when !valid
+        float frequency_hz = 0.0f;
+        float period_s = 0.0f;
+        float duty_pct = -1.0f;  ///< Negative when not measured
+        uint32_t pulses = 0;     ///< Periods in the last window
+        uint64_t total = 0;      ///< Periods since start()
+    };
+
+    /**
+     * @param hw Timer and pin of the channel
+     * @param switch_hz Frequency where reciprocal and counting modes meet.
+     *                  The ISR runs twice per period below it.
+     */
+    explicit FreqMeter(const Hardware& hw, uint32_t switch_hz = 5000);
+
+    /**
+     * @brief Called from the timer ISR on every gate edge
+     */
+    typedef void (*GateHandler)(void* context, uint8_t level);
+
+    /**
+     * @brief Take over the timer and pin and start measuring
+     */
+    void start();
+
+    /**
+     * @brief Stop the timer and hand the pin back as a plain input
+     */
+    void stop();
+
+    /**
+     * @brief Count rising edges from now on, with no windows (see edgeCount())
+     */
+    void startTotalizer();
+
+    /**
+     * @brief Report the level of the pin to handler on both edges
+     */
+    void startGate(GateHandler handler, void* context);
+
+    bool isRunning() const { return mode_ != Mode::Off; }
+
+    /**
+     * @brief Rising edges since startTotalizer(), safe to call from an ISR
+     */
+    uint64_t edgeCount() const;
+
+    uint8_t pinLevel() const { return (hw_.port->IDR & hw_.pin) ? 1 : 0; }
+
+    /**
+     * @brief Close the current window and refresh reading()
+     */
+    void update();
+
+    const Reading& reading() const { return reading_; }
+
+    /**
+     * @brief Call from the timer IRQ handler(s)
+     */
+    void handleInterrupt();
+
+private:
+    enum class Mode : uint8_t { Off, Reciprocal, Counting, Totalizer, Gate };
+
+    void claim();
+    void resetTimer();
+    void configurePwmInput(bool interrupts);
+    void configureCounting();
+    void updateReciprocal();
+    void updateCounting();
+    bool captureDuty(float& duty_pct);
+    uint32_t counterHalf() const { return arr_ / 2; }
+
+    Hardware hw_;
+    uint32_t switch_hz_;
+    uint32_t arr_;               // 0xFFFF or 0xFFFFFFFF on 32-bit timers
+    Mode mode_;
+    Reading reading_;
+
+    // Shared with the ISR
+    volatile uint32_t wraps_;    // Overflows since the last edge / gate start
+    volatile uint32_t periods_;
+    volatile uint64_t sum_period_;
+    volatile uint64_t sum_high_;
+    uint64_t high_;              // High time of the period in progress
+    bool synced_;                // First rising edge seen
+
+    // Counting gate
+    uint64_t gate_count_;
+    uint32_t gate_cycles_;
+    uint64_t last_period_;       // For holding slow readings between edges
+
+    GateHandler gate_handler_;
+    void* gate_context_;
+};
+
+} // namespace measure
+
+#endif /* FREQ_METER_HPP */
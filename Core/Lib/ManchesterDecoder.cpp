@@ -0,0 +1,134 @@
+/**
+  ******************************************************************************
+  * @file           : ManchesterDecoder.cpp
+  * @brief          : Manchester / biphase-mark decoder implementation
+  ******************************************************************************
+  */
+
+#include "ManchesterDecoder.hpp"
+
+namespace decode {
+
+ManchesterDecoder::ManchesterDecoder(EventSink& sink, const Config& config)
+    : sink_(sink), coding_(config.coding), one_level_(config.rising_is_one ? 1 : 0),
+      loop_shift_(config.loop_shift), channel_(config.channel),
+      nominal_q8_((uint32_t)(((uint64_t)config.sample_rate_hz << 8) / config.bitrate)),
+      min_q8_(0), max_q8_(0), period_q8_(0), last_edge_(0),
+      locked_(false), aligned_(false), byte_start_(0), bit_count_(0),
+      byte_(0), byte_bits_(0) {
+    uint32_t range = nominal_q8_ / 100 * config.track_range_pct;
+    min_q8_ = nominal_q8_ - range;
+    max_q8_ = nominal_q8_ + range;
+    period_q8_ = nominal_q8_;
+}
+
+void ManchesterDecoder::begin(uint32_t t, uint8_t level) {
+    (void)level;
+    last_edge_ = t;
+    locked_ = false;
+    aligned_ = false;
+    period_q8_ = nominal_q8_;
+    byte_ = 0;
+    byte_bits_ = 0;
+}
+
+void ManchesterDecoder::edge(uint32_t t, uint8_t level) {
+    uint32_t interval = t - last_edge_;
+    last_edge_ = t;
+
+    // Half-bit intervals fall in [P/4, 3P/4), whole-bit ones in [3P/4, 5P/4]
+    uint64_t i4 = (uint64_t)interval << 10;
+    uint64_t p = period_q8_;
+    bool is_short = i4 >= p && i4 < 3 * p;
+    bool is_long = i4 >= 3 * p && i4 <= 5 * p;
+
+    // Data value carried by this edge if it turns out to be a data edge
+    uint8_t value = (coding_ == Coding::Manchester) ? (level == one_level_) : (is_short ? 1 : 0);
+
+    if (!locked_) {
+        // A whole-bit interval always ends on a data edge
+        if (is_long) {
+            lock(t);
+            aligned_ = true;
+            bit(value, t);
+        }
+        return;
+    }
+
+    // Edges between two data edges only feed the loop
+    uint32_t measured_q8;
+    if (is_short) {
+        aligned_ = !aligned_;
+        measured_q8 = interval << 9;
+    } else if (is_long && aligned_) {
+        measured_q8 = interval << 8;
+    } else {
+        unlock(t, interval);
+        return;
+    }
+
+    // First-order loop: move the period estimate towards the measurement
+    int32_t error = (int32_t)(measured_q8 - period_q8_);
+    uint32_t period = (uint32_t)((int32_t)period_q8_ + (error >> loop_shift_));
+    if (period < min_q8_) {
+        period = min_q8_;
+    } else if (period > max_q8_) {
+        period = max_q8_;
+    }
+    period_q8_ = period;
+
+    if (aligned_) {
+        bit(value, t);
+    }
+}
+
+void ManchesterDecoder::end(uint32_t t) {
+    (void)t;
+    flush();
+}
+
+void ManchesterDecoder::bit(uint8_t value, uint32_t t) {
+    if (byte_bits_ == 0) {
+        // Manchester data edges sit mid-bit, biphase ones at the bit end
+        uint32_t back = (coding_ == Coding::Manchester) ? (period_q8_ >> 9) : (period_q8_ >> 8);
+        byte_start_ = t - back;
+    }
+    byte_ = (uint8_t)((byte_ << 1) | value);
+    bit_count_++;
+    if (++byte_bits_ == 8) {
+        flush();
+    }
+}
+
+void ManchesterDecoder::lock(uint32_t t) {
+    locked_ = true;
+    emit(EventType::ClockLock, t, period_q8_ >> 8);
+}
+
+void ManchesterDecoder::unlock(uint32_t t, uint32_t interval) {
+    flush();
+    locked_ = false;
+    aligned_ = false;
+    emit(EventType::ClockUnlock, t, interval);
+}
+
+void ManchesterDecoder::flush() {
+    if (byte_bits_ != 0) {
+        emit(EventType::BitData, byte_start_, byte_, byte_bits_);
+        byte_ = 0;
+        byte_bits_ = 0;
+    }
+}
+
+void ManchesterDecoder::emit(EventType type, uint32_t t, uint32_t value, uint8_t length) {
+    Event event;
+    event.timestamp = t;
+    event.value = value;
+    event.type = type;
+    event.channel = channel_;
+    event.flags = 0;
+    event.length = length;
+    sink_.onEvent(event);
+}
+
+} // namespace decode
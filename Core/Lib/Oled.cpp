@@ -9,10 +9,11 @@
 
 namespace display {
 
-Oled::Oled(I2C_HandleTypeDef* hi2c) {
+Oled::Oled(I2C_HandleTypeDef* hi2c) : mirror_(nullptr) {
     device_.hi2c = hi2c;
     device_.address = SH1106_I2C_ADDR;
     device_.initialized = false;
+    device_.full_refresh = true;
     std::memset(device_.framebuffer, 0, sizeof(device_.framebuffer));
     std::memset(device_.prev_framebuffer, 0, sizeof(device_.prev_framebuffer));
 }
@@ -30,7 +31,9 @@ bool Oled::displayOff() {
 }
 
 bool Oled::clear() {
-    return SH1106_Clear(&device_) == HAL_OK;
+    // Not flushed: with the diff, clear-draw-update sends only what changed
+    std::memset(device_.framebuffer, 0, sizeof(device_.framebuffer));
+    return true;
 }
 
 bool Oled::fill() {
@@ -38,7 +41,19 @@ bool Oled::fill() {
 }
 
 bool Oled::update() {
-    return SH1106_UpdateScreen(&device_) == HAL_OK;
+    bool ok = SH1106_UpdateScreen(&device_) == HAL_OK;
+    if (mirror_ != nullptr) {
+        mirror_->present(device_.framebuffer, device_.dirty_first, device_.dirty_count);
+    }
+    return ok;
+}
+
+void Oled::setMirror(FrameMirror* mirror) {
+    mirror_ = mirror;
+    if (mirror_ != nullptr) {
+        mirror_->resync();
+        mirror_->present(device_.framebuffer, device_.dirty_first, device_.dirty_count);
+    }
 }
 
 void Oled::setPixel(uint8_t x, uint8_t y, uint8_t color) {
@@ -175,4 +190,51 @@ void Oled::drawLogicChannels(const uint8_t** channel_data, const uint16_t* data_
     }
 }
 
+void Oled::drawBarGraph(uint8_t x, uint8_t y, uint8_t width, uint8_t height,
+                        const uint32_t* values, uint16_t count, uint8_t color) {
+    if (values == nullptr || count == 0 || width == 0 || height == 0) {
+        return;
+    }
+
+    uint32_t peak = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (values[i] > peak) {
+            peak = values[i];
+        }
+    }
+    if (peak == 0) {
+        return;
+    }
+
+    // Leave a one pixel gap between bars when they are wide enough
+    bool gaps = width >= 3 * count;
+
+    for (uint8_t col = 0; col < width && (x + col) < SH1106_WIDTH; col++) {
+        uint16_t from = (uint32_t)col * count / width;
+        uint16_t to = (uint32_t)(col + 1) * count / width;
+        if (gaps && to != from) {
+            continue;  // Last column of a bar
+        }
+        if (to <= from) {
+            to = from + 1;
+        }
+
+        uint32_t value = 0;
+        for (uint16_t i = from; i < to; i++) {
+            if (values[i] > value) {
+                value = values[i];
+            }
+        }
+
+        // Non-empty bins stay visible as a single pixel
+        uint8_t bar = (uint8_t)((uint64_t)value * height / peak);
+        if (value != 0 && bar == 0) {
+            bar = 1;
+        }
+        for (uint8_t i = 0; i < bar; i++) {
+            setPixel(x + col, y + height - 1 - i, color);
+        }
+    }
+}
+
 } // namespace display
@@ -13,6 +13,7 @@
 
 #include "stm32f4xx_hal.h"
 #include "sh1106.h"
+#include "FrameMirror.hpp"
 #include <cstdint>
 #include <cstring>
 
@@ -64,8 +65,8 @@ public:
     bool displayOff();
 
     /**
-     * @brief Clear entire display (all pixels OFF)
-     * @return true if successful, false otherwise
+     * @brief Clear the framebuffer (all pixels OFF); shown by the next update()
+     * @return true
      */
     bool clear();
 
@@ -77,10 +78,23 @@ public:
 
     /**
      * @brief Update display with framebuffer content
+     * @note Sends only what changed since the last update, then the same
+     *       spans to the mirror if one is attached
      * @return true if successful, false otherwise
      */
     bool update();
 
+    /**
+     * @brief Mirror every presented frame to the host (nullptr stops)
+     * @param mirror Mirror to attach; it sends what is shown right away
+     */
+    void setMirror(FrameMirror* mirror);
+
+    /**
+     * @brief Attached mirror, nullptr if none
+     */
+    FrameMirror* mirror() const { return mirror_; }
+
     /**
      * @brief Set a single pixel
      * @param x X coordinate (0-127)
@@ -185,8 +199,23 @@ public:
                           uint8_t channel_height = 16, uint16_t x_offset = 0,
                           float zoom_factor = 1.0f, uint8_t color = 1);
 
+    /**
+     * @brief Draw a bar graph scaled to the largest value
+     * @param x X coordinate (left edge)
+     * @param y Y coordinate (top edge)
+     * @param width Width in pixels; values share it equally, and when there
+     *              are more values than columns a column shows their maximum
+     * @param height Height of the tallest bar in pixels
+     * @param values Bar values
+     * @param count Number of values
+     * @param color 1=white, 0=black
+     */
+    void drawBarGraph(uint8_t x, uint8_t y, uint8_t width, uint8_t height,
+                      const uint32_t* values, uint16_t count, uint8_t color = 1);
+
 private:
     SH1106_t device_;  ///< Low-level device structure
+    FrameMirror* mirror_;  ///< Gets every presented frame, may be nullptr
 };
 
 } // namespace display
@@ -0,0 +1,155 @@
+/**
+  ******************************************************************************
+  * @file           : PatternBuilder.cpp
+  * @brief          : Test pattern builder and loopback check implementation
+  ******************************************************************************
+  */
+
+#include "PatternBuilder.hpp"
+
+namespace capture {
+
+// UART frame: start bit, 8 data bits (LSB first), stop bit, 2 idle bits
+static const uint8_t UART_FRAME_BITS = 12;
+
+// PRBS-15 phases of the channels (any non-zero 15-bit state)
+static const uint16_t PRBS_SEEDS[PatternBuilder::MAX_CHANNELS] = {
+    0x0001, 0x1234, 0x2AAA, 0x4321, 0x5555, 0x6789, 0x7001, 0x7FFF
+};
+
+const char* PatternBuilder::patternName(Pattern pattern) {
+    switch (pattern) {
+    case Pattern::Counter: return "COUNTER";
+    case Pattern::Prbs:    return "PRBS15";
+    case Pattern::Uart:    return "UART";
+    default:               return "?";
+    }
+}
+
+// Level of a UART line at a sample: channel c sends bytes c * 0x40, +1, ...
+static uint8_t uartLevel(uint32_t sample, uint8_t channel) {
+    uint32_t bit = sample / PatternBuilder::UART_BIT_SAMPLES;
+    uint32_t frame = bit / UART_FRAME_BITS;
+    uint32_t position = bit % UART_FRAME_BITS;
+    if (position == 0) {
+        return 0;  // Start bit
+    }
+    if (position > 8) {
+        return 1;  // Stop bit and idle
+    }
+    uint8_t byte = (uint8_t)(channel * 0x40 + frame);
+    return (byte >> (position - 1)) & 1;
+}
+
+void PatternBuilder::buildLevels(Pattern pattern, uint8_t* levels, uint32_t count, uint8_t num_channels) {
+    if (num_channels > MAX_CHANNELS) {
+        num_channels = MAX_CHANNELS;
+    }
+
+    uint16_t lfsr[MAX_CHANNELS];
+    for (uint8_t ch = 0; ch < num_channels; ch++) {
+        lfsr[ch] = PRBS_SEEDS[ch];
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t value = 0;
+        switch (pattern) {
+        case Pattern::Counter:
+            value = (uint8_t)i;
+            break;
+        case Pattern::Prbs:
+            for (uint8_t ch = 0; ch < num_channels; ch++) {
+                uint16_t state = lfsr[ch];
+                uint16_t feedback = ((state >> 14) ^ (state >> 13)) & 1;
+                lfsr[ch] = (uint16_t)(((state << 1) | feedback) & 0x7FFF);
+                value |= (uint8_t)(feedback << ch);
+            }
+            break;
+        case Pattern::Uart:
+            for (uint8_t ch = 0; ch < num_channels; ch++) {
+                value |= (uint8_t)(uartLevel(i, ch) << ch);
+            }
+            break;
+        default:
+            break;
+        }
+        levels[i] = (num_channels < 8) ? (uint8_t)(value & ((1u << num_channels) - 1)) : value;
+    }
+}
+
+void PatternBuilder::buildBsrr(const uint8_t* levels, uint32_t count, const uint8_t* pin_bits,
+                               uint8_t num_channels, uint32_t* words) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t word = 0;
+        for (uint8_t ch = 0; ch < num_channels; ch++) {
+            uint32_t pin = 1u << pin_bits[ch];
+            // BSy sets the pin, BRy (16 bits up) resets it
+            word |= ((levels[i] >> ch) & 1) ? pin : (pin << 16);
+        }
+        words[i] = word;
+    }
+}
+
+void PatternBuilder::buildPortWords(const uint8_t* levels, uint32_t count, const uint8_t* pin_bits,
+                                    uint8_t num_channels, uint16_t* words) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t word = 0;
+        for (uint8_t ch = 0; ch < num_channels; ch++) {
+            if ((levels[i] >> ch) & 1) {
+                word |= (uint16_t)(1u << pin_bits[ch]);
+            }
+        }
+        words[i] = word;
+    }
+}
+
+PatternBuilder::Verification PatternBuilder::verify(const uint16_t* expected, uint32_t period,
+                                                    const uint16_t* samples, uint32_t count,
+                                                    uint16_t mask) {
+    Verification result = {false, 0, count, 0};
+    if (period == 0 || count == 0) {
+        return result;
+    }
+
+    // Alignment: the offset with the fewest errors over one period of the
+    // capture (a whole period makes it unambiguous up to the pattern's own
+    // symmetry, where any of the candidates is equally right)
+    uint32_t window = (count < period) ? count : period;
+    uint32_t best_errors = window + 1;
+    for (uint32_t offset = 0; offset < period && best_errors != 0; offset++) {
+        uint32_t errors = 0;
+        uint32_t index = offset;
+        for (uint32_t i = 0; i < window && errors < best_errors; i++) {
+            if ((samples[i] & mask) != expected[index]) {
+                errors++;
+            }
+            if (++index == period) {
+                index = 0;
+            }
+        }
+        if (errors < best_errors) {
+            best_errors = errors;
+            result.offset = offset;
+        }
+    }
+    // Noise or a stuck input gets most samples wrong at every offset; a
+    // dropped sample in the first period costs at most half of them
+    result.locked = (best_errors <= window / 2);
+
+    result.errors = 0;
+    uint32_t index = result.offset;
+    for (uint32_t i = 0; i < count; i++) {
+        if ((samples[i] & mask) != expected[index]) {
+            if (result.errors == 0) {
+                result.first_error = i;
+            }
+            result.errors++;
+        }
+        if (++index == period) {
+            index = 0;
+        }
+    }
+    return result;
+}
+
+} // namespace capture
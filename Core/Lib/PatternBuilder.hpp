@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file           : PatternBuilder.hpp
+  * @brief          : Test patterns for the DMA pattern generator and their check
+  ******************************************************************************
+  * A pattern is one period of channel levels (bit c = channel c), built
+  * once and then replayed by DMA from a table of GPIO BSRR words, one word
+  * per sample clock:
+  *   - Counter: binary count, channel 0 toggles on every sample
+  *   - PRBS:    PRBS-15 (x^15 + x^14 + 1), a different phase per channel
+  *   - UART:    8N1 frames of counting bytes, UART_BIT_SAMPLES per bit
+  * A BSRR word sets the high channels and resets the low ones, so each
+  * word fully defines the outputs and the table can loop.
+  *
+  * For the loopback self-test the same levels are turned into expected
+  * input port words. verify() finds where in the period a capture starts
+  * and then compares every sample bit for bit.
+  ******************************************************************************
+  */
+
+#ifndef PATTERN_BUILDER_HPP
+#define PATTERN_BUILDER_HPP
+
+#include <cstdint>
+
+namespace capture {
+
+class PatternBuilder {
+public:
+    enum class Pattern : uint8_t { Counter, Prbs, Uart, COUNT };
+
+    static constexpr uint8_t MAX_CHANNELS = 8;
+    static constexpr uint8_t UART_BIT_SAMPLES = 4;
+
+    struct Verification {
+        bool locked;            ///< The capture start was found in the period
+        uint32_t offset;        ///< Period index of the first sample
+        uint32_t errors;        ///< Samples that differ
+        uint32_t first_error;   ///< Index of the first one (if errors != 0)
+    };
+
+    static const char* patternName(Pattern pattern);
+
+    /**
+     * @brief One period of channel levels (bit c = channel c)
+     */
+    static void buildLevels(Pattern pattern, uint8_t* levels, uint32_t count, uint8_t num_channels);
+
+    /**
+     * @brief BSRR words that drive the levels onto output port bits
+     */
+    static void buildBsrr(const uint8_t* levels, uint32_t count, const uint8_t* pin_bits,
+                          uint8_t num_channels, uint32_t* words);
+
+    /**
+     * @brief Input port words expected for the levels (other bits zero)
+     */
+    static void buildPortWords(const uint8_t* levels, uint32_t count, const uint8_t* pin_bits,
+                               uint8_t num_channels, uint16_t* words);
+
+    /**
+     * @brief Compare captured port words with one period of expected words
+     * @param mask Port bits that carry the channels
+     */
+    static Verification verify(const uint16_t* expected, uint32_t period,
+                               const uint16_t* samples, uint32_t count, uint16_t mask);
+};
+
+} // namespace capture
+
+#endif /* PATTERN_BUILDER_HPP */
@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file           : PortDma.cpp
+  * @brief          : Timer-paced GPIO port DMA implementation
+  ******************************************************************************
+  */
+
+#include "PortDma.hpp"
+
+namespace capture {
+
+// Status flags of stream n: LISR/LIFCR for 0-3, HISR/HIFCR for 4-7
+static const uint8_t STREAM_FLAG_SHIFT[4] = {0, 6, 16, 22};
+static const uint32_t STREAM_FLAG_MASK = 0x3D;  // FEIF, DMEIF, TEIF, HTIF, TCIF
+
+static uint32_t streamIndex(DMA_Stream_TypeDef* stream) {
+    uint32_t base = (stream >= DMA2_Stream0) ? (uint32_t)DMA2_Stream0 : (uint32_t)DMA1_Stream0;
+    return ((uint32_t)stream - base) / 0x18;
+}
+
+static DMA_TypeDef* streamController(DMA_Stream_TypeDef* stream) {
+    return (stream >= DMA2_Stream0) ? DMA2 : DMA1;
+}
+
+PortDma::PortDma(const Hardware& hw)
+    : hw_(hw), divider_(2), capture_count_(0), output_enabled_(false), running_(false) {
+}
+
+void PortDma::disableStream(DMA_Stream_TypeDef* stream) {
+    stream->CR = stream->CR & ~DMA_SxCR_EN;
+    while (stream->CR & DMA_SxCR_EN) {
+    }
+    clearStreamFlags(stream);
+}
+
+void PortDma::clearStreamFlags(DMA_Stream_TypeDef* stream) {
+    uint32_t index = streamIndex(stream);
+    uint32_t flags = STREAM_FLAG_MASK << STREAM_FLAG_SHIFT[index & 3];
+    DMA_TypeDef* dma = streamController(stream);
+    if (index < 4) {
+        dma->LIFCR = flags;
+    } else {
+        dma->HIFCR = flags;
+    }
+}
+
+void PortDma::configure(uint32_t divider) {
+    stop();
+    __HAL_RCC_TIM1_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    // ARR is 16 bits: slow clocks divide by the prescaler first
+    divider_ = (divider < 2) ? 2 : divider;
+    uint32_t prescaler = (divider_ + 0xFFFF) / 0x10000;
+    uint32_t period = (divider_ + prescaler / 2) / prescaler;
+    divider_ = prescaler * period;
+
+    TIM_TypeDef* tim = hw_.tim;
+    tim->SMCR = 0;
+    tim->CCER = 0;
+    tim->CCMR1 = 0;       // CC1 as a frozen output compare: events only, pin untouched
+    tim->PSC = prescaler - 1;
+    tim->ARR = period - 1;
+    tim->CCR1 = period / 2;
+    tim->RCR = 0;
+    tim->CNT = 0;
+    tim->EGR = TIM_EGR_UG;
+    tim->SR = 0;
+}
+
+void PortDma::startOutput(const uint32_t* words, uint16_t count) {
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Pin = hw_.output_pins;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    HAL_GPIO_Init(hw_.output_port, &GPIO_InitStruct);
+
+    // Start from the first word so the pins are defined before the clock runs
+    hw_.output_port->BSRR = words[0];
+
+    DMA_Stream_TypeDef* stream = hw_.output_stream;
+    disableStream(stream);
+    stream->PAR = (uint32_t)&hw_.output_port->BSRR;
+    stream->M0AR = (uint32_t)words;
+    stream->NDTR = count;
+    stream->FCR = 0;
+    stream->CR = hw_.output_channel | DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 |
+                 DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_0 | DMA_SxCR_EN;
+    hw_.tim->DIER = hw_.tim->DIER | TIM_DIER_CC1DE;
+    output_enabled_ = true;
+}
+
+void PortDma::startCapture(uint16_t* buffer, uint16_t count, bool circular) {
+    DMA_Stream_TypeDef* stream = hw_.input_stream;
+    disableStream(stream);
+    capture_count_ = count;
+    stream->PAR = (uint32_t)&hw_.input_port->IDR;
+    stream->M0AR = (uint32_t)buffer;
+    stream->NDTR = count;
+    stream->FCR = 0;
+    // Sampling gets the higher priority: a late sample is an error, a
+    // late output write only moves an edge
+    stream->CR = hw_.input_channel | DMA_SxCR_PL_1 | DMA_SxCR_PL_0 | DMA_SxCR_MSIZE_0 |
+                 DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | (circular ? DMA_SxCR_CIRC : 0) | DMA_SxCR_EN;
+    hw_.tim->DIER = hw_.tim->DIER | TIM_DIER_UDE;
+}
+
+uint16_t PortDma::capturePosition() const {
+    // NDTR reloads to count right after the last transfer of a lap
+    uint16_t remaining = (uint16_t)hw_.input_stream->NDTR;
+    return (remaining == 0) ? 0 : (uint16_t)(capture_count_ - remaining);
+}
+
+void PortDma::run() {
+    hw_.tim->CR1 = TIM_CR1_CEN;
+    running_ = true;
+}
+
+bool PortDma::captureDone() const {
+    return hw_.input_stream->NDTR == 0 || (hw_.input_stream->CR & DMA_SxCR_EN) == 0;
+}
+
+void PortDma::stop() {
+    if (hw_.tim->CR1 & TIM_CR1_CEN) {
+        hw_.tim->CR1 = 0;
+    }
+    hw_.tim->DIER = 0;
+    disableStream(hw_.output_stream);
+    disableStream(hw_.input_stream);
+    running_ = false;
+
+    if (output_enabled_) {
+        GPIO_InitTypeDef GPIO_InitStruct = {0};
+        GPIO_InitStruct.Pin = hw_.output_pins;
+        GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+        GPIO_InitStruct.Pull = GPIO_NOPULL;
+        HAL_GPIO_Init(hw_.output_port, &GPIO_InitStruct);
+        output_enabled_ = false;
+    }
+}
+
+} // namespace capture
@@ -0,0 +1,102 @@
+/**
+  ******************************************************************************
+  * @file           : PortDma.hpp
+  * @brief          : Timer-paced DMA between memory and whole GPIO ports
+  ******************************************************************************
+  * One timer sets the sample clock for two DMA streams:
+  *   - output: on every CC1 event a word from a looping table is written
+  *     to the output port's BSRR (pattern generator);
+  *   - input:  on every update event the input port's IDR is stored into
+  *     a buffer until it is full (sampler).
+  * CC1 sits half a period after the update, so outputs change between two
+  * samples. Only DMA2 can reach the GPIO ports, and on the F401 only TIM1
+  * requests DMA2, so the timer is TIM1 and the channels are fixed by the
+  * request table (TIM1_CH1: stream 1/3, TIM1_UP: stream 5, channel 6).
+  *
+  * The CPU only sets things up; the rate limit is the DMA itself (two
+  * streams sharing DMA2 and the bus matrix), which the loopback self-test
+  * measures.
+  ******************************************************************************
+  */
+
+#ifndef PORT_DMA_HPP
+#define PORT_DMA_HPP
+
+#include "stm32f4xx_hal.h"
+#include <cstdint>
+
+namespace capture {
+
+class PortDma {
+public:
+    struct Hardware {
+        TIM_TypeDef* tim;                    ///< Sample clock timer
+        uint32_t clock_hz;                   ///< Timer kernel clock
+        DMA_Stream_TypeDef* output_stream;   ///< Stream of the CC1 request
+        uint32_t output_channel;             ///< DMA_CHANNEL_x of it
+        DMA_Stream_TypeDef* input_stream;    ///< Stream of the update request
+        uint32_t input_channel;
+        GPIO_TypeDef* output_port;
+        uint16_t output_pins;                ///< Pins driven by the pattern
+        GPIO_TypeDef* input_port;
+    };
+
+    explicit PortDma(const Hardware& hw);
+
+    /**
+     * @brief Stop everything and set the sample clock to clock_hz / divider
+     * @param divider At least 2; above 65536 the prescaler takes part of
+     *        it and an odd split rounds it (divider() has the one in use)
+     */
+    void configure(uint32_t divider);
+
+    /**
+     * @brief Drive the output pins from a table of BSRR words, looping
+     */
+    void startOutput(const uint32_t* words, uint16_t count);
+
+    /**
+     * @brief Fill a buffer with input port words
+     * @param circular Keep refilling it from the start (streaming); the
+     *        write position is capturePosition()
+     */
+    void startCapture(uint16_t* buffer, uint16_t count, bool circular = false);
+
+    /**
+     * @brief Index the capture DMA writes next (0 .. count - 1)
+     */
+    uint16_t capturePosition() const;
+
+    /**
+     * @brief Start the sample clock
+     */
+    void run();
+
+    /**
+     * @brief The capture buffer is full
+     */
+    bool captureDone() const;
+
+    /**
+     * @brief Stop the clock and both streams, release the output pins
+     */
+    void stop();
+
+    uint32_t rate() const { return hw_.clock_hz / divider_; }
+    uint32_t divider() const { return divider_; }
+    bool isRunning() const { return running_; }
+
+private:
+    static void disableStream(DMA_Stream_TypeDef* stream);
+    static void clearStreamFlags(DMA_Stream_TypeDef* stream);
+
+    Hardware hw_;
+    uint32_t divider_;
+    uint16_t capture_count_;
+    bool output_enabled_;
+    bool running_;
+};
+
+} // namespace capture
+
+#endif /* PORT_DMA_HPP */
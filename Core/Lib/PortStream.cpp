@@ -0,0 +1,367 @@
+/**
+  ******************************************************************************
+  * @file           : PortStream.cpp
+  * @brief          : Continuous port capture streaming implementation
+  ******************************************************************************
+  */
+
+#include "PortStream.hpp"
+#include "SampleClock.hpp"
+#include "cmsis_os.h"
+#include "usbd_bulk_if.h"
+#include <cstring>
+
+namespace capture {
+
+static const uint8_t START_FRAME_BYTES = 24;
+static const uint8_t END_FRAME_BYTES = 32;
+static const uint8_t SYNC_FRAME_BYTES = 24;
+static const uint8_t COMMAND_BYTES = 16;
+static const uint8_t FLAGS_COMMAND_BYTES = 20;
+static const uint8_t RECORD_HEADER_BYTES = 2;
+static const uint16_t RECORD_BYTES = RECORD_HEADER_BYTES + BlockCompressor::maxCompressed(PortStream::BLOCK_SAMPLES);
+// Two transfers queued while the third fills
+static const uint8_t OUT_BUFFERS = 3;
+static const uint16_t OUT_BYTES = 1024;
+static const char START_COMMAND[8] = {'L', 'A', 'S', 'T', 'A', 'R', 'T', '!'};
+static const char STOP_COMMAND[8] = {'L', 'A', 'S', 'T', 'O', 'P', '!', '!'};
+static const char START_MAGIC[8] = {'L', 'A', 'S', 'T', 'R', 'E', 'A', 'M'};
+static const char END_MAGIC[8] = {'L', 'A', 'S', 'T', 'E', 'N', 'D', '!'};
+static const char SYNC_MAGIC[8] = {'L', 'A', 'S', 'Y', 'N', 'C', '!', '!'};
+
+// Sent in place by the bulk pipe, so static
+static uint16_t ring[PortStream::RING_SAMPLES];
+static uint8_t start_frame[START_FRAME_BYTES];
+static uint8_t end_frame[END_FRAME_BYTES];
+static uint8_t out_buffers[OUT_BUFFERS][OUT_BYTES];
+// Raw streams send sync frames as transfers of their own, alternately
+static uint8_t sync_frames[2][SYNC_FRAME_BYTES];
+static BlockCompressor compressor;
+
+static void putWord(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t getWord(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Queue a frame and wait until everything queued has left
+static bool sendFrame(uint8_t* frame, uint32_t length) {
+    uint32_t start = HAL_GetTick();
+    while (BULK_Transmit_FS(frame, length) != USBD_OK) {
+        if (HAL_GetTick() - start >= PortStream::IDLE_TIMEOUT_MS) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    while (BULK_TxPending_FS() != 0) {
+        if (HAL_GetTick() - start >= PortStream::IDLE_TIMEOUT_MS) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return true;
+}
+
+// Sample positions of the SOF stamps of the bulk interface (DWT cycles,
+// converted with SampleClock: the samples come on TIM1 update events)
+class SyncClock {
+public:
+    // Right before the sample clock starts
+    void start(uint32_t divider) {
+        BULK_EnableSof_FS(1U);
+        divider_ = divider;
+        elapsed_ = 0;
+        last_cycles_ = DWT->CYCCNT;
+        last_count_ = 0;
+        last_tick_ = HAL_GetTick() - PortStream::SYNC_INTERVAL_MS;
+    }
+
+    void stop() { BULK_EnableSof_FS(0U); }
+
+    // Every pass: the cycle counter wraps every 51 s
+    void update() {
+        uint32_t now = DWT->CYCCNT;
+        elapsed_ += now - last_cycles_;
+        last_cycles_ = now;
+    }
+
+    // Fill a sync frame if one is due and a new stamp has arrived
+    bool take(uint8_t* frame) {
+        if (HAL_GetTick() - last_tick_ < PortStream::SYNC_INTERVAL_MS) {
+            return false;
+        }
+        BULK_SofTypeDef sof;
+        BULK_GetSof_FS(&sof);
+        update();   // After the snapshot, so the stamp is not newer
+        uint32_t age = last_cycles_ - sof.cycles;
+        uint64_t position;
+        if (sof.count == last_count_ || age > elapsed_ ||
+            !SampleClock::position(elapsed_ - age, divider_, position)) {
+            return false;   // Nothing new, or from before the first sample
+        }
+        memcpy(frame, SYNC_MAGIC, 8);
+        putWord(frame + 8, (uint32_t)position);
+        putWord(frame + 12, (uint32_t)(position >> 32));
+        putWord(frame + 16, sof.frame);
+        putWord(frame + 20, 0);
+        last_count_ = sof.count;
+        last_tick_ = HAL_GetTick();
+        return true;
+    }
+
+private:
+    uint32_t divider_;
+    uint64_t elapsed_;       // Cycles since the sample clock started
+    uint32_t last_cycles_;
+    uint32_t last_count_;    // SOF count of the last sync frame
+    uint32_t last_tick_;
+};
+
+static SyncClock sync_clock;
+
+static void sendEnd(PortStream::Status status, uint64_t samples, uint32_t elapsed_ms, uint32_t cycles_per_kb) {
+    memcpy(end_frame, END_MAGIC, 8);
+    putWord(end_frame + 8, (uint32_t)samples);
+    putWord(end_frame + 12, (uint32_t)(samples >> 32));
+    putWord(end_frame + 16, (uint32_t)status);
+    putWord(end_frame + 20, elapsed_ms);
+    putWord(end_frame + 24, cycles_per_kb);
+    putWord(end_frame + 28, 0);
+    sendFrame(end_frame, END_FRAME_BYTES);
+}
+
+PortStream::Command PortStream::parseCommand(const uint8_t* packet, uint32_t length) {
+    Command command = {Command::Type::None, 0, 0, 0};
+    if (length < COMMAND_BYTES) {
+        return command;
+    }
+    if (memcmp(packet, START_COMMAND, 8) == 0) {
+        command.type = Command::Type::Start;
+        command.divider = getWord(packet + 8);
+        command.samples = getWord(packet + 12);
+        // Older hosts send no flags
+        command.flags = (length >= FLAGS_COMMAND_BYTES) ? getWord(packet + 16) : 0;
+    } else if (memcmp(packet, STOP_COMMAND, 8) == 0) {
+        command.type = Command::Type::Stop;
+    }
+    return command;
+}
+
+void PortStream::refuse(Status status) {
+    sendEnd(status, 0, 0, 0);
+}
+
+void PortStream::run(PortDma& dma, const Command& start, const uint8_t* channel_bits, Result& result) {
+    bool compressed = (start.flags & FLAG_COMPRESS) != 0;
+    bool sync = (start.flags & FLAG_SYNC) != 0;
+    result = {Status::Done, compressed ? Encoding::Compressed : Encoding::Raw, 0, 0, 0, 0, 0, 0};
+    // Anything still queued from an earlier stream would be overwritten
+    uint32_t t0 = HAL_GetTick();
+    while (BULK_TxPending_FS() != 0) {
+        if (HAL_GetTick() - t0 >= IDLE_TIMEOUT_MS) {
+            result.status = Status::Timeout;
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    dma.configure(start.divider);
+    result.rate_hz = dma.rate();
+    memcpy(start_frame, START_MAGIC, 8);
+    putWord(start_frame + 8, result.rate_hz);
+    start_frame[12] = (uint8_t)(BLOCK_SAMPLES * 2);
+    start_frame[13] = (uint8_t)((BLOCK_SAMPLES * 2) >> 8);
+    start_frame[14] = 2;
+    start_frame[15] = 0;
+    memcpy(start_frame + 16, channel_bits, NUM_CHANNELS);
+    putWord(start_frame + 20, (uint32_t)result.encoding);
+    if (!sendFrame(start_frame, START_FRAME_BYTES)) {
+        result.status = Status::Timeout;
+        return;
+    }
+    if (compressed) {
+        compressor.setChannels(channel_bits);
+        CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    uint64_t target_blocks = ((uint64_t)start.samples + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES;
+    uint64_t written = 0;        // Samples stored by the DMA
+    uint64_t queued = 0;         // Raw: blocks handed to the bulk pipe
+    uint64_t completed = 0;      // Raw: blocks that have left
+    uint64_t consumed = 0;       // Blocks whose ring slot is free again
+    uint64_t sent_blocks = 0;    // Compressed: blocks handed to the bulk pipe
+    uint64_t cycles = 0;         // Compressed: DWT cycles spent coding
+    uint8_t pending = 0;         // Transfers queued at the last poll
+    uint8_t block_history = 0;   // Raw: bit n set = the nth last transfer was a block
+    uint8_t sync_next = 0;       // Raw: sync frame buffer to use next
+    uint8_t fill = 0;            // Compressed: out buffer being filled
+    uint16_t fill_bytes = 0;
+    uint16_t fill_blocks = 0;
+    uint16_t fill_sync_bytes = 0;
+    uint16_t last_position = 0;
+    uint32_t last_progress = HAL_GetTick();
+
+    t0 = HAL_GetTick();
+    dma.startCapture(ring, RING_SAMPLES, true);
+    if (sync) {
+        sync_clock.start(dma.divider());
+    }
+    dma.run();
+
+    // Polled: one pass takes far less than a lap of the ring at any rate
+    // the pipe can carry, so position deltas are never ambiguous
+    uint8_t packet[BULK_FS_MAX_PACKET_SIZE];
+    bool sampling = true;
+    for (;;) {
+        if (sampling) {
+            uint16_t position = dma.capturePosition();
+            written += (uint16_t)(position - last_position + RING_SAMPLES) % RING_SAMPLES;
+            last_position = position;
+        }
+        if (sync) {
+            sync_clock.update();
+        }
+
+        uint8_t now_pending = BULK_TxPending_FS();
+        if (now_pending < pending) {
+            last_progress = HAL_GetTick();
+        }
+        pending = now_pending;
+        if (!compressed) {
+            // The transfers in flight are the last ones queued; sync frames
+            // among them are no blocks
+            uint8_t blocks_in_flight = 0;
+            for (uint8_t k = 0; k < pending; k++) {
+                blocks_in_flight += (block_history >> k) & 1u;
+            }
+            completed = queued - blocks_in_flight;
+            consumed = completed;
+        }
+        if (written > (consumed + BLOCKS) * BLOCK_SAMPLES) {
+            result.status = Status::Overrun;
+            break;
+        }
+
+        uint8_t sent = USBD_OK;
+        if (!compressed) {
+            if (target_blocks != 0 && completed == target_blocks) {
+                break;
+            }
+            // With two transfers queued at most, the sync buffer used two
+            // sync frames back has left
+            if (sync && sampling && pending < BULK_TX_QUEUE_DEPTH && sync_clock.take(sync_frames[sync_next])) {
+                sent = BULK_Transmit_FS(sync_frames[sync_next], SYNC_FRAME_BYTES);
+                if (sent == USBD_OK) {
+                    sync_next ^= 1;
+                    block_history = (uint8_t)(block_history << 1);
+                    result.sync_frames++;
+                }
+            } else if ((target_blocks == 0 || queued < target_blocks) && written >= (queued + 1) * BLOCK_SAMPLES) {
+                uint16_t* block = ring + (queued % BLOCKS) * BLOCK_SAMPLES;
+                sent = BULK_Transmit_FS((uint8_t*)block, BLOCK_SAMPLES * 2);
+                if (sent == USBD_OK) {
+                    block_history = (uint8_t)((block_history << 1) | 1u);
+                    queued++;
+                    last_progress = HAL_GetTick();
+                    if (queued == target_blocks) {
+                        // The rest would only overwrite blocks still in flight
+                        dma.stop();
+                        sampling = false;
+                    }
+                }
+            }
+        } else {
+            bool all_coded = (target_blocks != 0 && consumed == target_blocks);
+            if (all_coded && fill_bytes == 0) {
+                break;
+            }
+            if (sync && sampling && fill_bytes + SYNC_FRAME_BYTES <= OUT_BYTES &&
+                sync_clock.take(out_buffers[fill] + fill_bytes)) {
+                fill_bytes += SYNC_FRAME_BYTES;
+                fill_sync_bytes += SYNC_FRAME_BYTES;
+                result.sync_frames++;
+            }
+            // Code the next block as soon as it is complete; its ring slot
+            // is free again right away
+            if (!all_coded && written >= (consumed + 1) * BLOCK_SAMPLES && fill_bytes + RECORD_BYTES <= OUT_BYTES) {
+                const uint16_t* block = ring + (consumed % BLOCKS) * BLOCK_SAMPLES;
+                uint8_t* record = out_buffers[fill] + fill_bytes;
+                uint32_t begin = DWT->CYCCNT;
+                uint32_t length = compressor.compress(block, BLOCK_SAMPLES, record + RECORD_HEADER_BYTES);
+                cycles += DWT->CYCCNT - begin;
+                record[0] = (uint8_t)length;
+                record[1] = (uint8_t)(length >> 8);
+                fill_bytes += (uint16_t)(RECORD_HEADER_BYTES + length);
+                fill_blocks++;
+                consumed++;
+                if (consumed == target_blocks) {
+                    dma.stop();
+                    sampling = false;
+                    all_coded = true;
+                }
+            }
+            // Batch records while a transfer is in flight; send when the
+            // pipe runs dry, the buffer is full or nothing more will come
+            bool full = (fill_bytes + RECORD_BYTES > OUT_BYTES);
+            if (fill_bytes != 0 && pending < BULK_TX_QUEUE_DEPTH && (pending == 0 || full || all_coded)) {
+                sent = BULK_Transmit_FS(out_buffers[fill], fill_bytes);
+                if (sent == USBD_OK) {
+                    result.wire_bytes += fill_bytes - fill_sync_bytes;
+                    sent_blocks += fill_blocks;
+                    // Two transfers at most are queued, so the buffer three
+                    // sends back has left
+                    fill = (uint8_t)((fill + 1) % OUT_BUFFERS);
+                    fill_bytes = 0;
+                    fill_blocks = 0;
+                    fill_sync_bytes = 0;
+                    last_progress = HAL_GetTick();
+                }
+            }
+        }
+        if (sent == USBD_FAIL) {
+            result.status = Status::Timeout;   // Unplugged or reset
+            break;
+        }
+
+        if (parseCommand(packet, BULK_ReadPacket_FS(packet)).type == Command::Type::Stop) {
+            result.status = Status::Stopped;
+            break;
+        }
+        // Slow rates leave the pipe idle for long; only a stuck block counts
+        if (BULK_TxPending_FS() != 0 && HAL_GetTick() - last_progress >= IDLE_TIMEOUT_MS) {
+            result.status = Status::Timeout;
+            break;
+        }
+        taskYIELD();
+    }
+    dma.stop();
+    if (sync) {
+        sync_clock.stop();
+    }
+
+    // Blocks already queued still go out, coded ones not yet sent follow
+    // them; the end frame comes last
+    if (compressed) {
+        if (fill_bytes != 0 && result.status != Status::Timeout && sendFrame(out_buffers[fill], fill_bytes)) {
+            result.wire_bytes += fill_bytes - fill_sync_bytes;
+            sent_blocks += fill_blocks;
+        }
+        result.samples = sent_blocks * BLOCK_SAMPLES;
+        if (consumed != 0) {
+            result.cycles_per_kb = (uint32_t)(cycles * 1024 / (consumed * BLOCK_SAMPLES * 2));
+        }
+    } else {
+        result.samples = queued * BLOCK_SAMPLES;
+        result.wire_bytes = result.samples * 2;
+    }
+    result.elapsed_ms = HAL_GetTick() - t0;
+    sendEnd(result.status, result.samples, result.elapsed_ms, result.cycles_per_kb);
+}
+
+} // namespace capture
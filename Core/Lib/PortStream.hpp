@@ -0,0 +1,120 @@
+/**
+  ******************************************************************************
+  * @file           : PortStream.hpp
+  * @brief          : Continuous port capture streamed over the vendor bulk pipe
+  ******************************************************************************
+  * PortDma samples the input port into a circular ring of BLOCKS blocks;
+  * every block the DMA has finished is sent as one bulk transfer straight
+  * from the ring (no copy). Up to two blocks are in flight while the DMA
+  * fills the others, so the ring may lag the DMA by BLOCKS - 1 blocks
+  * before a block is overwritten before it has left: that is an overrun
+  * and ends the stream.
+  *
+  * Commands (host -> bulk OUT, little endian):
+  *   "LASTART!", u32 divider (84 MHz / divider), u32 samples (0 = until
+  *               stop), optional u32 flags (bit 0: compress, bit 1: sync)
+  *   "LASTOP!!", 8 bytes ignored
+  * Stream (device -> bulk IN, little endian):
+  *   start  "LASTREAM", u32 rate Hz, u16 block bytes, u16 sample bytes,
+  *          u8 port bit of CH0..CH3, u32 encoding (24 bytes)
+  *   data   encoding 0: u16 port words, whole blocks (a sample count is
+  *          rounded up)
+  *          encoding 1: per block a record of u16 length + BlockCompressor
+  *          output (length <= block samples, so never the bytes "LA")
+  *   sync   "LASYNC!!", u64 sample position of a USB start of frame in
+  *          1/256 samples, u32 its frame number (11 bits), u32 reserved
+  *          (24 bytes); only with the sync flag, about every
+  *          SYNC_INTERVAL_MS, between blocks or records
+  *   end    "LASTEND!", u64 samples sent, u32 status, u32 elapsed ms,
+  *          u32 compressor cycles per KB of port words (0 if raw),
+  *          u32 reserved (32 bytes)
+  * Sync and end frames always start at a block or record boundary of the
+  * data, which is how a reader of a recorded byte stream finds them.
+  *
+  * Every device on one host controller sees the same SOF frame numbers,
+  * so sync frames tie each device's sample clock to a common 1 ms
+  * timeline (host/la_merge). The SOF interrupt is stamped with the DWT
+  * cycle counter, which runs from the same 84 MHz as the sample timer;
+  * the jitter is the USB interrupt latency, a few microseconds.
+  *
+  * Raw 16-bit port words: full-speed bulk (~1.2 MB/s) carries about
+  * 600 kS/s before the ring overruns. Compressed blocks free their ring
+  * slot as soon as they are coded and are packed several to a transfer
+  * (whenever the pipe is idle or the buffer is full), so the rate that
+  * fits grows with the ratio - up to what the CPU codes per second.
+  ******************************************************************************
+  */
+
+#ifndef PORT_STREAM_HPP
+#define PORT_STREAM_HPP
+
+#include "BlockCompressor.hpp"
+#include "PortDma.hpp"
+#include <cstdint>
+
+namespace capture {
+
+class PortStream {
+public:
+    static constexpr uint16_t BLOCK_SAMPLES = 512;
+    static constexpr uint8_t BLOCKS = 4;
+    static constexpr uint16_t RING_SAMPLES = BLOCK_SAMPLES * BLOCKS;
+    static constexpr uint8_t NUM_CHANNELS = 4;
+    static constexpr uint32_t IDLE_TIMEOUT_MS = 1000;   ///< A queued block did not leave
+    static constexpr uint32_t SYNC_INTERVAL_MS = 100;
+
+    enum class Status : uint32_t {
+        Done = 0,       ///< Requested samples sent
+        Stopped = 1,    ///< Stop command
+        Overrun = 2,    ///< Ring overwritten before it was sent
+        Busy = 3,       ///< Another mode owns the DMA, not started
+        Timeout = 4,    ///< Host stopped reading
+    };
+
+    enum class Encoding : uint32_t {
+        Raw = 0,
+        Compressed = 1,   ///< BlockCompressor records
+    };
+
+    static constexpr uint32_t FLAG_COMPRESS = 1u << 0;
+    static constexpr uint32_t FLAG_SYNC = 1u << 1;
+
+    struct Command {
+        enum class Type : uint8_t { None, Start, Stop };
+        Type type;
+        uint32_t divider;
+        uint32_t samples;
+        uint32_t flags;
+    };
+
+    struct Result {
+        Status status;
+        Encoding encoding;
+        uint32_t rate_hz;
+        uint64_t samples;
+        uint32_t elapsed_ms;
+        uint64_t wire_bytes;       ///< Data bytes sent, frames excluded
+        uint32_t cycles_per_kb;    ///< Compressor cycles per 1024 port word bytes
+        uint32_t sync_frames;      ///< Sync frames sent
+    };
+
+    /**
+     * @brief Decode a bulk OUT packet
+     */
+    static Command parseCommand(const uint8_t* packet, uint32_t length);
+
+    /**
+     * @brief Stream until done, stopped, overrun or timeout (blocks)
+     * @param channel_bits Input port bit of each channel (for the host)
+     */
+    static void run(PortDma& dma, const Command& start, const uint8_t* channel_bits, Result& result);
+
+    /**
+     * @brief Answer a start command with an end frame only
+     */
+    static void refuse(Status status);
+};
+
+} // namespace capture
+
+#endif /* PORT_STREAM_HPP */
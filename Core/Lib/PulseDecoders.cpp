@@ -0,0 +1,366 @@
+/**
+  ******************************************************************************
+  * @file           : PulseDecoders.cpp
+  * @brief          : Pulse-width protocol decoders implementation
+  ******************************************************************************
+  */
+
+#include "PulseDecoders.hpp"
+
+namespace decode {
+
+namespace {
+
+// 1-Wire standard speed low-pulse classes
+constexpr int8_t OW_SLOT_1 = 0;  // Write 1 / read 1
+constexpr int8_t OW_SLOT_0 = 1;  // Write 0 / read 0 (slave stretched)
+constexpr int8_t OW_RESET  = 2;
+
+// WS2812 classes: high time selects the bit, low time separates or latches
+constexpr int8_t WS_BIT_GAP = 0;
+constexpr int8_t WS_LATCH   = 1;
+
+// NEC mark and space classes
+constexpr int8_t NEC_LEADER   = 0;
+constexpr int8_t NEC_BIT_MARK = 1;
+constexpr int8_t NEC_START    = 0;
+constexpr int8_t NEC_REPEAT   = 1;
+constexpr int8_t NEC_ZERO     = 0;
+constexpr int8_t NEC_ONE      = 1;
+
+constexpr uint32_t NO_LIMIT = 0xFFFFFFFF;
+
+} // namespace
+
+/* ==================== PulseClassifier ==================== */
+
+PulseClassifier::PulseClassifier(uint32_t sample_rate_hz)
+    : sample_rate_hz_(sample_rate_hz), min_{}, max_{}, count_(0) {
+}
+
+uint32_t PulseClassifier::toTicks(uint32_t ns) const {
+    if (ns == NO_LIMIT) {
+        return NO_LIMIT;
+    }
+    return (uint32_t)(((uint64_t)ns * sample_rate_hz_ + 500000000ULL) / 1000000000ULL);
+}
+
+void PulseClassifier::setWindow(uint8_t index, uint32_t min_ns, uint32_t max_ns) {
+    if (index >= MAX_CLASSES) {
+        return;
+    }
+    min_[index] = toTicks(min_ns);
+    max_[index] = toTicks(max_ns);
+    if (index >= count_) {
+        count_ = index + 1;
+    }
+}
+
+void PulseClassifier::setNominal(uint8_t index, uint32_t nominal_ns, uint8_t tolerance_pct) {
+    uint32_t delta = (uint32_t)((uint64_t)nominal_ns * tolerance_pct / 100);
+    setWindow(index, nominal_ns - delta, nominal_ns + delta);
+}
+
+/* ==================== PulseDecoder ==================== */
+
+PulseDecoder::PulseDecoder(EventSink& sink, const Config& config)
+    : sink_(sink), classes_(config.sample_rate_hz), last_edge_(0), timing_errors_(0),
+      level_(1), channel_(config.channel), tolerance_pct_(config.tolerance_pct) {
+}
+
+void PulseDecoder::emit(EventType type, uint32_t t, uint32_t value,
+                        uint8_t flags, uint8_t length) {
+    Event event;
+    event.timestamp = t;
+    event.value = value;
+    event.type = type;
+    event.channel = channel_;
+    event.flags = flags;
+    event.length = length;
+    sink_.onEvent(event);
+}
+
+void PulseDecoder::timingError(uint32_t t, uint32_t ticks, uint8_t level) {
+    timing_errors_++;
+    emit(EventType::TimingError, t, ticks, level ? EVENT_FLAG_HIGH : 0);
+}
+
+/* ==================== OneWireDecoder ==================== */
+
+OneWireDecoder::OneWireDecoder(EventSink& sink, const Config& config)
+    : PulseDecoder(sink, config), presence_(config.sample_rate_hz),
+      presence_gap_(0), reset_start_(0), reset_end_(0), byte_start_(0),
+      byte_(0), bits_(0), reset_pending_(false) {
+    // Windows straight from the 1-Wire standard speed timing
+    classes_.setWindow(OW_SLOT_1, 500, 15000);
+    classes_.setWindow(OW_SLOT_0, 15001, 120000);
+    classes_.setWindow(OW_RESET, 480000, 960000);
+    presence_.setWindow(0, 60000, 240000);
+    presence_gap_ = presence_.toTicks(60000);
+}
+
+void OneWireDecoder::begin(uint32_t t, uint8_t level) {
+    PulseDecoder::begin(t, level);
+    reset_pending_ = false;
+    bits_ = 0;
+    byte_ = 0;
+}
+
+void OneWireDecoder::edge(uint32_t t, uint8_t level) {
+    uint32_t ticks = t - last_edge_;
+    uint32_t start = last_edge_;
+    last_edge_ = t;
+    level_ = level;
+
+    // Only rising edges complete a (low) slot
+    if (level == 0) {
+        return;
+    }
+
+    if (reset_pending_) {
+        if (start - reset_end_ <= presence_gap_ && presence_.classify(ticks) == 0) {
+            flushReset(true);
+            return;
+        }
+        flushReset(false);
+    }
+
+    int8_t slot = classes_.classify(ticks);
+    switch (slot) {
+    case OW_SLOT_1:
+    case OW_SLOT_0:
+        if (bits_ == 0) {
+            byte_start_ = start;
+        }
+        if (slot == OW_SLOT_1) {
+            byte_ |= (uint8_t)(1u << bits_);
+        }
+        if (++bits_ == 8) {
+            emit(EventType::OneWireByte, byte_start_, byte_);
+            bits_ = 0;
+            byte_ = 0;
+        }
+        break;
+
+    case OW_RESET:
+        reset_pending_ = true;
+        reset_start_ = start;
+        reset_end_ = t;
+        bits_ = 0;
+        byte_ = 0;
+        break;
+
+    default:
+        timingError(start, ticks, 0);
+        bits_ = 0;
+        byte_ = 0;
+        break;
+    }
+}
+
+void OneWireDecoder::end(uint32_t t) {
+    (void)t;
+    if (reset_pending_) {
+        flushReset(false);
+    }
+}
+
+void OneWireDecoder::flushReset(bool presence) {
+    reset_pending_ = false;
+    emit(EventType::OneWireReset, reset_start_, presence ? 1 : 0);
+}
+
+/* ==================== Ws2812Decoder ==================== */
+
+Ws2812Decoder::Ws2812Decoder(EventSink& sink, const Config& config)
+    : PulseDecoder(sink, config), low_(config.sample_rate_hz),
+      grb_(0), led_start_(0), leds_(0), bits_(0) {
+    // T0H = 0.40 us, T1H = 0.80 us, both +-150 ns
+    classes_.setWindow(0, 250, 550);
+    classes_.setWindow(1, 650, 950);
+    // Drivers may stretch the low phase; anything from 50 us latches
+    low_.setWindow(WS_BIT_GAP, 300, 5000);
+    low_.setWindow(WS_LATCH, 50000, NO_LIMIT);
+}
+
+void Ws2812Decoder::begin(uint32_t t, uint8_t level) {
+    PulseDecoder::begin(t, level);
+    grb_ = 0;
+    bits_ = 0;
+    leds_ = 0;
+}
+
+void Ws2812Decoder::edge(uint32_t t, uint8_t level) {
+    uint32_t ticks = t - last_edge_;
+    uint32_t start = last_edge_;
+    last_edge_ = t;
+    level_ = level;
+
+    if (level == 0) {
+        // High phase ended: its width is the bit value
+        int8_t bit = classes_.classify(ticks);
+        if (bit == PulseClassifier::NO_CLASS) {
+            timingError(start, ticks, 1);
+            grb_ = 0;
+            bits_ = 0;
+            return;
+        }
+        if (bits_ == 0) {
+            led_start_ = start;
+        }
+        grb_ = (grb_ << 1) | (uint32_t)bit;
+        if (++bits_ == 24) {
+            uint32_t rgb = ((grb_ & 0x00FF00) << 8) | ((grb_ & 0xFF0000) >> 8) | (grb_ & 0xFF);
+            emit(EventType::Ws2812Rgb, led_start_, rgb, 0, (uint8_t)leds_);
+            leds_++;
+            grb_ = 0;
+            bits_ = 0;
+        }
+    } else {
+        int8_t gap = low_.classify(ticks);
+        if (gap == WS_LATCH) {
+            latch(start);
+        } else if (gap == PulseClassifier::NO_CLASS) {
+            timingError(start, ticks, 0);
+            grb_ = 0;
+            bits_ = 0;
+        }
+    }
+}
+
+void Ws2812Decoder::end(uint32_t t) {
+    if (level_ == 0 && low_.classify(t - last_edge_) == WS_LATCH) {
+        latch(last_edge_);
+    }
+}
+
+void Ws2812Decoder::latch(uint32_t t) {
+    if (leds_ != 0) {
+        emit(EventType::Ws2812Latch, t, leds_);
+    }
+    leds_ = 0;
+    grb_ = 0;
+    bits_ = 0;
+}
+
+/* ==================== NecDecoder ==================== */
+
+NecDecoder::NecDecoder(EventSink& sink, const Config& config, bool active_low)
+    : PulseDecoder(sink, config), leader_spaces_(config.sample_rate_hz),
+      bit_spaces_(config.sample_rate_hz),
+      frame_start_(0), data_(0), bits_(0), active_(active_low ? 0 : 1),
+      state_(State::Idle) {
+    // Receivers distort marks and spaces, so all windows use the tolerance
+    classes_.setNominal(NEC_LEADER, 9000000, tolerance_pct_);
+    classes_.setNominal(NEC_BIT_MARK, 562500, tolerance_pct_);
+    leader_spaces_.setNominal(NEC_START, 4500000, tolerance_pct_);
+    leader_spaces_.setNominal(NEC_REPEAT, 2250000, tolerance_pct_);
+    bit_spaces_.setNominal(NEC_ZERO, 562500, tolerance_pct_);
+    bit_spaces_.setNominal(NEC_ONE, 1687500, tolerance_pct_);
+}
+
+void NecDecoder::begin(uint32_t t, uint8_t level) {
+    PulseDecoder::begin(t, level);
+    state_ = State::Idle;
+}
+
+void NecDecoder::edge(uint32_t t, uint8_t level) {
+    uint32_t ticks = t - last_edge_;
+    uint32_t start = last_edge_;
+
+    if (level_ == active_) {
+        mark(start, ticks);
+    } else {
+        space(start, ticks);
+    }
+
+    last_edge_ = t;
+    level_ = level;
+}
+
+void NecDecoder::mark(uint32_t t, uint32_t ticks) {
+    int8_t c = classes_.classify(ticks);
+
+    if (c == NEC_LEADER) {
+        frame_start_ = t;
+        state_ = State::Leader;
+        return;
+    }
+
+    if (c == NEC_BIT_MARK) {
+        if (state_ == State::Mark) {
+            if (bits_ == 32) {
+                frame();
+                state_ = State::Idle;
+            } else {
+                state_ = State::Space;
+            }
+            return;
+        }
+        if (state_ == State::Repeat) {
+            emit(EventType::IrNecRepeat, frame_start_, 0);
+            state_ = State::Idle;
+            return;
+        }
+    }
+
+    if (state_ != State::Idle) {
+        timingError(t, ticks, active_);
+    }
+    state_ = State::Idle;
+}
+
+void NecDecoder::space(uint32_t t, uint32_t ticks) {
+    if (state_ == State::Idle) {
+        return;
+    }
+
+    if (state_ == State::Leader) {
+        int8_t c = leader_spaces_.classify(ticks);
+        if (c == NEC_START) {
+            data_ = 0;
+            bits_ = 0;
+            state_ = State::Mark;
+            return;
+        }
+        if (c == NEC_REPEAT) {
+            state_ = State::Repeat;
+            return;
+        }
+    } else if (state_ == State::Space) {
+        int8_t c = bit_spaces_.classify(ticks);
+        if (c != PulseClassifier::NO_CLASS) {
+            if (c == NEC_ONE) {
+                data_ |= 1u << bits_;
+            }
+            bits_++;
+            state_ = State::Mark;
+            return;
+        }
+    }
+
+    timingError(t, ticks, active_ ^ 1);
+    state_ = State::Idle;
+}
+
+void NecDecoder::frame() {
+    uint8_t address = data_ & 0xFF;
+    uint8_t address_inv = (data_ >> 8) & 0xFF;
+    uint8_t command = (data_ >> 16) & 0xFF;
+    uint8_t command_inv = (data_ >> 24) & 0xFF;
+
+    if ((uint8_t)(command ^ command_inv) != 0xFF) {
+        emit(EventType::IrCheckError, frame_start_, data_);
+        return;
+    }
+
+    if ((uint8_t)(address ^ address_inv) == 0xFF) {
+        emit(EventType::IrNecCommand, frame_start_, ((uint32_t)address << 8) | command);
+    } else {
+        // Extended NEC: the second byte is the high address byte
+        emit(EventType::IrNecCommand, frame_start_, ((data_ & 0xFFFF) << 8) | command,
+             EVENT_FLAG_EXTENDED);
+    }
+}
+
+} // namespace decode
@@ -0,0 +1,193 @@
+/**
+  ******************************************************************************
+  * @file           : PulseDecoders.hpp
+  * @brief          : Pulse-width protocol decoders (1-Wire, WS2812, NEC IR)
+  ******************************************************************************
+  * These protocols carry their data in pulse durations. Each decoder maps
+  * the duration between two edges to a symbol class through a small window
+  * table and reassembles bytes, RGB triplets or IR commands from the
+  * classes. Work per edge is a subtraction and a few compares.
+  ******************************************************************************
+  */
+
+#ifndef PULSE_DECODERS_HPP
+#define PULSE_DECODERS_HPP
+
+#include "Decoder.hpp"
+#include <cstdint>
+
+namespace decode {
+
+/**
+ * @brief Maps a pulse duration to one of a few symbol classes
+ */
+class PulseClassifier {
+public:
+    static constexpr uint8_t MAX_CLASSES = 4;
+    static constexpr int8_t NO_CLASS = -1;
+
+    explicit PulseClassifier(uint32_t sample_rate_hz);
+
+    /**
+     * @brief Define a class by its allowed window
+     * @param index Class index (0..MAX_CLASSES-1)
+     * @param min_ns Shortest accepted duration
+     * @param max_ns Longest accepted duration
+     */
+    void setWindow(uint8_t index, uint32_t min_ns, uint32_t max_ns);
+
+    /**
+     * @brief Define a class by its nominal duration and a tolerance
+     * @param index Class index (0..MAX_CLASSES-1)
+     * @param nominal_ns Nominal duration
+     * @param tolerance_pct Accepted deviation in percent
+     */
+    void setNominal(uint8_t index, uint32_t nominal_ns, uint8_t tolerance_pct);
+
+    /**
+     * @brief Classify a duration
+     * @param ticks Pulse duration in sample ticks
+     * @return Class index or NO_CLASS
+     */
+    int8_t classify(uint32_t ticks) const {
+        for (uint8_t i = 0; i < count_; i++) {
+            if (ticks >= min_[i] && ticks <= max_[i]) {
+                return (int8_t)i;
+            }
+        }
+        return NO_CLASS;
+    }
+
+    uint32_t toTicks(uint32_t ns) const;
+
+private:
+    uint32_t sample_rate_hz_;
+    uint32_t min_[MAX_CLASSES];
+    uint32_t max_[MAX_CLASSES];
+    uint8_t count_;
+};
+
+/**
+ * @brief State shared by the pulse decoders
+ */
+class PulseDecoder {
+public:
+    struct Config {
+        uint32_t sample_rate_hz;        ///< Capture tick rate
+        uint8_t tolerance_pct = 20;     ///< Timing tolerance (where the spec gives none)
+        uint8_t channel = 0;            ///< Reported in events
+    };
+
+    void begin(uint32_t t, uint8_t level) {
+        last_edge_ = t;
+        level_ = level;
+    }
+
+    uint32_t timingErrors() const { return timing_errors_; }
+
+protected:
+    PulseDecoder(EventSink& sink, const Config& config);
+
+    void emit(EventType type, uint32_t t, uint32_t value,
+              uint8_t flags = 0, uint8_t length = 0);
+    void timingError(uint32_t t, uint32_t ticks, uint8_t level);
+
+    EventSink& sink_;
+    PulseClassifier classes_;
+    uint32_t last_edge_;
+    uint32_t timing_errors_;
+    uint8_t level_;
+    uint8_t channel_;
+    uint8_t tolerance_pct_;
+};
+
+/**
+ * @brief 1-Wire (standard speed) decoder
+ *
+ * Classifies low pulses into write-1/read-1 slots, write-0/read-0 slots
+ * and reset pulses; detects the presence pulse after a reset.
+ */
+class OneWireDecoder : public PulseDecoder {
+public:
+    OneWireDecoder(EventSink& sink, const Config& config);
+
+    void begin(uint32_t t, uint8_t level);
+    void edge(uint32_t t, uint8_t level);
+    void end(uint32_t t);
+
+private:
+    void flushReset(bool presence);
+
+    PulseClassifier presence_;
+    uint32_t presence_gap_;   // Latest presence start after reset, ticks
+    uint32_t reset_start_;
+    uint32_t reset_end_;
+    uint32_t byte_start_;
+    uint8_t byte_;
+    uint8_t bits_;
+    bool reset_pending_;
+};
+
+/**
+ * @brief WS2812 / WS2812B LED chain decoder (800 kHz)
+ *
+ * The high time of each bit period selects 0 or 1; a long low gap
+ * latches the chain. Bits are sent G-R-B, MSB first.
+ */
+class Ws2812Decoder : public PulseDecoder {
+public:
+    Ws2812Decoder(EventSink& sink, const Config& config);
+
+    void begin(uint32_t t, uint8_t level);
+    void edge(uint32_t t, uint8_t level);
+    void end(uint32_t t);
+
+private:
+    void latch(uint32_t t);
+
+    PulseClassifier low_;
+    uint32_t grb_;
+    uint32_t led_start_;
+    uint16_t leds_;
+    uint8_t bits_;
+};
+
+/**
+ * @brief NEC infrared remote decoder (demodulated receiver output)
+ *
+ * Marks are the active level (low for the usual TSOP receivers).
+ * Handles 8-bit and extended 16-bit addresses and repeat codes.
+ */
+class NecDecoder : public PulseDecoder {
+public:
+    NecDecoder(EventSink& sink, const Config& config, bool active_low = true);
+
+    void begin(uint32_t t, uint8_t level);
+    void edge(uint32_t t, uint8_t level);
+    void end(uint32_t) {}
+
+private:
+    enum class State : uint8_t {
+        Idle,    // Waiting for a leader mark
+        Leader,  // Leader seen, next space selects frame or repeat
+        Mark,    // Waiting for a bit mark
+        Space,   // Waiting for a bit space
+        Repeat,  // Repeat space seen, waiting for the closing mark
+    };
+
+    void mark(uint32_t t, uint32_t ticks);
+    void space(uint32_t t, uint32_t ticks);
+    void frame();
+
+    PulseClassifier leader_spaces_;  // Start / repeat (overlap the bit spaces)
+    PulseClassifier bit_spaces_;
+    uint32_t frame_start_;
+    uint32_t data_;
+    uint8_t bits_;
+    uint8_t active_;
+    State state_;
+};
+
+} // namespace decode
+
+#endif /* PULSE_DECODERS_HPP */
@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * @file           : PulseStats.cpp
+  * @brief          : Streaming pulse-width / period statistics implementation
+  ******************************************************************************
+  */
+
+#include "PulseStats.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace measure {
+
+void LogHistogram::clear() {
+    memset(bins_, 0, sizeof(bins_));
+}
+
+uint32_t LogHistogram::binLower(uint16_t bin) {
+    uint32_t octave = bin >> SUB_BITS;
+    uint32_t sub = bin & ((1u << SUB_BITS) - 1);
+    return (uint32_t)((((uint64_t)1 << SUB_BITS) + sub) << octave >> SUB_BITS);
+}
+
+bool LogHistogram::range(uint16_t& first, uint16_t& last) const {
+    uint16_t i = 0;
+    while (i < BINS && bins_[i] == 0) {
+        i++;
+    }
+    if (i == BINS) {
+        return false;
+    }
+    first = i;
+    last = BINS - 1;
+    while (bins_[last] == 0) {
+        last--;
+    }
+    return true;
+}
+
+void Welford::clear() {
+    count_ = 0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+    block_count_ = 0;
+    block_sum_ = 0;
+    block_squares_ = 0;
+    min_ = UINT32_MAX;
+    max_ = 0;
+}
+
+void Welford::merged(uint64_t& count, double& mean, double& m2) const {
+    count = count_;
+    mean = mean_;
+    m2 = m2_;
+    if (block_count_ == 0) {
+        return;
+    }
+
+    // Block statistics from exact integer sums: n * M2 = n * sum(x^2) - sum(x)^2
+    double n_b = block_count_;
+    double mean_b = (double)block_sum_ / n_b;
+    uint64_t scaled_m2 = block_count_ * block_squares_ - block_sum_ * block_sum_;
+    double m2_b = (double)scaled_m2 / n_b;
+
+    // Chan et al. pairwise combination
+    double n_a = (double)count;
+    double n = n_a + n_b;
+    double delta = mean_b - mean;
+    mean += delta * n_b / n;
+    m2 += m2_b + delta * delta * n_a * n_b / n;
+    count += block_count_;
+}
+
+void Welford::flush() {
+    merged(count_, mean_, m2_);
+    block_count_ = 0;
+    block_sum_ = 0;
+    block_squares_ = 0;
+}
+
+void Welford::addSlow(uint32_t value) {
+    count_++;
+    double delta = value - mean_;
+    mean_ += delta / (double)count_;
+    m2_ += delta * (value - mean_);
+}
+
+double Welford::mean() const {
+    uint64_t count;
+    double mean, m2;
+    merged(count, mean, m2);
+    return mean;
+}
+
+double Welford::variance() const {
+    uint64_t count;
+    double mean, m2;
+    merged(count, mean, m2);
+    return (count != 0) ? m2 / (double)count : 0.0;
+}
+
+double Welford::stddev() const {
+    return std::sqrt(variance());
+}
+
+void PulseStats::clear() {
+    for (uint8_t i = 0; i < SERIES_COUNT; i++) {
+        histograms_[i].clear();
+        stats_[i].clear();
+    }
+    have_edge_ = false;
+    have_rise_ = false;
+}
+
+void PulseStats::begin(uint32_t t, uint8_t level) {
+    (void)level;
+    // The stream may start mid-pulse, so the first pulse is not measured
+    last_edge_ = t;
+    have_edge_ = false;
+    have_rise_ = false;
+}
+
+const char* PulseStats::seriesName(Series series) {
+    switch (series) {
+    case High:   return "HIGH";
+    case Low:    return "LOW";
+    case Period: return "PERIOD";
+    default:     return "?";
+    }
+}
+
+} // namespace measure
@@ -0,0 +1,173 @@
+/**
+  ******************************************************************************
+  * @file           : PulseStats.hpp
+  * @brief          : Streaming pulse-width / period histograms and statistics
+  ******************************************************************************
+  * PulseStats follows a channel's edges and keeps three series: high time,
+  * low time and period (rising edge to rising edge). Each series has a
+  * fixed logarithmic histogram (8 bins per octave over the full 32-bit
+  * range) and a Welford accumulator for min / max / mean / stddev.
+  *
+  * Per-sample cost is a CLZ and an increment for the histogram, plus an
+  * integer add and multiply-accumulate into a block of up to 256 samples.
+  * The blocks are merged into the running Welford state with Chan's
+  * formula, so the floating point work is amortised and the result stays
+  * numerically stable over unbounded streams.
+  ******************************************************************************
+  */
+
+#ifndef PULSE_STATS_HPP
+#define PULSE_STATS_HPP
+
+#include <cstdint>
+
+namespace measure {
+
+/**
+ * @brief Fixed-size histogram with 2^SUB_BITS bins per octave
+ */
+class LogHistogram {
+public:
+    static constexpr uint8_t SUB_BITS = 3;
+    static constexpr uint16_t BINS = 32u << SUB_BITS;
+
+    LogHistogram() { clear(); }
+
+    void clear();
+
+    void add(uint32_t value) { bins_[binOf(value)]++; }
+
+    /**
+     * @brief Bin of a value: octave in the high bits, the next SUB_BITS
+     *        mantissa bits below it (0 and 1 share bin 0)
+     */
+    static uint16_t binOf(uint32_t value) {
+        uint32_t octave = 31 - __builtin_clz(value | 1);
+        uint32_t sub = (uint32_t)(((uint64_t)value << SUB_BITS) >> octave) & ((1u << SUB_BITS) - 1);
+        return (uint16_t)((octave << SUB_BITS) | sub);
+    }
+
+    /**
+     * @brief Smallest value that falls into a bin
+     */
+    static uint32_t binLower(uint16_t bin);
+
+    uint32_t operator[](uint16_t bin) const { return bins_[bin]; }
+    const uint32_t* bins() const { return bins_; }
+
+    /**
+     * @brief First and last non-empty bins
+     * @return false when the histogram is empty
+     */
+    bool range(uint16_t& first, uint16_t& last) const;
+
+private:
+    uint32_t bins_[BINS];
+};
+
+/**
+ * @brief Single-pass min / max / mean / variance
+ */
+class Welford {
+public:
+    Welford() { clear(); }
+
+    void clear();
+
+    void add(uint32_t value) {
+        if (value < min_) {
+            min_ = value;
+        }
+        if (value > max_) {
+            max_ = value;
+        }
+        if (value >= FAST_LIMIT) {
+            addSlow(value);
+            return;
+        }
+        block_sum_ += value;
+        block_squares_ += (uint64_t)value * value;
+        if (++block_count_ == BLOCK) {
+            flush();
+        }
+    }
+
+    uint64_t count() const { return count_ + block_count_; }
+    uint32_t min() const { return min_; }
+    uint32_t max() const { return max_; }
+    double mean() const;
+    double variance() const;  ///< Population variance
+    double stddev() const;
+
+private:
+    // Keeps block sums exact in 64 bits: 256 * (2^20)^2 * 256 < 2^64
+    static constexpr uint32_t BLOCK = 256;
+    static constexpr uint32_t FAST_LIMIT = 1u << 20;
+
+    void flush();
+    void addSlow(uint32_t value);
+    void merged(uint64_t& count, double& mean, double& m2) const;
+
+    uint64_t count_;
+    double mean_;
+    double m2_;                // Sum of squared deviations
+    uint32_t block_count_;
+    uint64_t block_sum_;
+    uint64_t block_squares_;
+    uint32_t min_;
+    uint32_t max_;
+};
+
+/**
+ * @brief High / low / period statistics of one channel
+ *
+ * Implements the decoder interface (begin / edge / end), so it can be fed
+ * from stored transitions with decode::feedTransitions() or directly from
+ * a live edge stream. The partial pulses at both ends are ignored.
+ */
+class PulseStats {
+public:
+    enum Series : uint8_t { High, Low, Period, SERIES_COUNT };
+
+    void clear();
+
+    void begin(uint32_t t, uint8_t level);
+    void edge(uint32_t t, uint8_t level) {
+        if (have_edge_) {
+            // A rising edge ends a low pulse and vice versa
+            Series series = level ? Low : High;
+            uint32_t width = t - last_edge_;
+            histograms_[series].add(width);
+            stats_[series].add(width);
+        }
+        if (level) {
+            if (have_rise_) {
+                uint32_t period = t - last_rise_;
+                histograms_[Period].add(period);
+                stats_[Period].add(period);
+            }
+            last_rise_ = t;
+            have_rise_ = true;
+        }
+        last_edge_ = t;
+        have_edge_ = true;
+    }
+    void end(uint32_t t) { (void)t; }
+
+    const LogHistogram& histogram(Series series) const { return histograms_[series]; }
+    const Welford& stats(Series series) const { return stats_[series]; }
+
+    static const char* seriesName(Series series);
+
+private:
+    LogHistogram histograms_[SERIES_COUNT];
+    Welford stats_[SERIES_COUNT];
+    uint32_t last_edge_ = 0;
+    uint32_t last_rise_ = 0;
+    bool have_edge_ = false;
+    bool have_rise_ = false;
+};
+
+} // namespace measure
+
+#endif /* PULSE_STATS_HPP */
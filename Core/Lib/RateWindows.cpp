@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file           : RateWindows.cpp
+  * @brief          : Sliding-window event rates implementation
+  ******************************************************************************
+  */
+
+#include "RateWindows.hpp"
+
+namespace measure {
+
+void RateWindows::sample(uint64_t total) {
+    seconds_[count_ % SLOTS] = total;
+    if (count_ % 60 == 0) {
+        minutes_[(count_ / 60) % SLOTS] = total;
+    }
+    count_++;
+}
+
+bool RateWindows::rate(Window window, float& per_second) const {
+    if (count_ < 2) {
+        return false;
+    }
+    uint32_t now = count_ - 1;
+    uint64_t total = seconds_[now % SLOTS];
+    uint64_t before;
+    uint32_t span;
+
+    if (window == Hour) {
+        // Oldest minute sample inside the last hour
+        uint32_t from = (now > 3600) ? now - 3600 : 0;
+        uint32_t minute = (from + 59) / 60;
+        span = now - minute * 60;
+        before = minutes_[minute % SLOTS];
+    } else {
+        uint32_t length = (window == Second) ? 1 : 60;
+        span = (now < length) ? now : length;
+        before = seconds_[(now - span) % SLOTS];
+    }
+
+    per_second = (float)(total - before) / (float)span;
+    return true;
+}
+
+const char* RateWindows::windowName(Window window) {
+    switch (window) {
+    case Second: return "1s";
+    case Minute: return "1m";
+    case Hour:   return "1h";
+    default:     return "?";
+    }
+}
+
+} // namespace measure
@@ -0,0 +1,57 @@
+/**
+  ******************************************************************************
+  * @file           : RateWindows.hpp
+  * @brief          : Event rates over sliding 1 s / 1 min / 1 h windows
+  ******************************************************************************
+  * A running 64-bit total is sampled once per second. The last 61 samples
+  * give the 1 s and 1 min rates exactly; every 60th sample is also kept
+  * for 61 minutes, which gives the 1 h rate with a window that slides in
+  * one-minute steps (3541..3600 s long). Until a window has filled, the
+  * rate is taken over the time counted so far.
+  ******************************************************************************
+  */
+
+#ifndef RATE_WINDOWS_HPP
+#define RATE_WINDOWS_HPP
+
+#include <cstdint>
+
+namespace measure {
+
+class RateWindows {
+public:
+    enum Window : uint8_t { Second, Minute, Hour, WINDOW_COUNT };
+
+    RateWindows() { clear(); }
+
+    void clear() { count_ = 0; }
+
+    /**
+     * @brief Add the total at the next whole second (the first call is t = 0)
+     */
+    void sample(uint64_t total);
+
+    /**
+     * @brief Events per second over a window
+     * @return false before the second sample
+     */
+    bool rate(Window window, float& per_second) const;
+
+    /**
+     * @brief Seconds since the first sample
+     */
+    uint32_t seconds() const { return (count_ != 0) ? count_ - 1 : 0; }
+
+    static const char* windowName(Window window);
+
+private:
+    static constexpr uint32_t SLOTS = 61;
+
+    uint64_t seconds_[SLOTS];   // Total at second n, slot n % SLOTS
+    uint64_t minutes_[SLOTS];   // Total at second 60 k, slot k % SLOTS
+    uint32_t count_;
+};
+
+} // namespace measure
+
+#endif /* RATE_WINDOWS_HPP */
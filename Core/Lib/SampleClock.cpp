@@ -0,0 +1,20 @@
+/**
+  ******************************************************************************
+  * @file           : SampleClock.cpp
+  * @brief          : Sample position of a moment implementation
+  ******************************************************************************
+  */
+
+#include "SampleClock.hpp"
+
+namespace capture {
+
+bool SampleClock::position(uint64_t cycles, uint32_t divider, uint64_t& position) {
+    if (divider == 0 || cycles < divider) {
+        return false;
+    }
+    position = ((cycles - divider) << FRACTION_BITS) / divider;
+    return true;
+}
+
+} // namespace capture
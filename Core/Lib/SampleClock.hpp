@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * @file           : SampleClock.hpp
+  * @brief          : Sample position of a moment in a DMA sampler capture
+  ******************************************************************************
+  * PortDma stores the input port on every TIM1 update event. configure()
+  * leaves the counter and the prescaler at 0, so with divider =
+  * (PSC + 1) * (ARR + 1) timer clocks per sample the first update, and
+  * with it sample 0, comes one full divider after CEN: sample k is taken
+  * (k + 1) * divider clocks after the timer starts. TIM1 and the DWT
+  * cycle counter both count the core clock, so a cycle stamp converts to
+  * a position exactly (sync frames of PortStream).
+  ******************************************************************************
+  */
+
+#ifndef SAMPLE_CLOCK_HPP
+#define SAMPLE_CLOCK_HPP
+
+#include <cstdint>
+
+namespace capture {
+
+class SampleClock {
+public:
+    static constexpr uint8_t FRACTION_BITS = 8;   ///< Positions in 1/256 samples
+
+    /**
+     * @brief Position of a moment, sample k at k << FRACTION_BITS
+     * @param cycles Timer clocks since CEN
+     * @param divider Timer clocks per sample (PortDma::divider())
+     * @return false before the first sample
+     */
+    static bool position(uint64_t cycles, uint32_t divider, uint64_t& position);
+};
+
+} // namespace capture
+
+#endif /* SAMPLE_CLOCK_HPP */
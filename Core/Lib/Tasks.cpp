@@ -1,10 +1,14 @@
 #include "Tasks.h"
 #include "main.h"
+#include "usbd_bulk_if.h"
+#include "usbd_cdc_if.h"
 #include <cstdio>
+#include <cstring>
 #include <stdio.h>
 
 // External logging function
 extern void Log_Printf(const char* format, ...);
+extern void Log_SetUsbPaused(bool paused);
 
 // External startup banner function
 extern void Print_Startup_Banner(void);
@@ -101,6 +105,139 @@ const uint8_t logic_ch3_data[] = {
     0x88, 0x23   // Go HIGH for 35 pixels
 };
 
+// Width of the waveform area right of the channel labels
+static const uint16_t VISIBLE_WIDTH = 120;
+
+// Frequency meter refresh period (4 readings per second)
+static const uint32_t METER_UPDATE_MS = 250;
+
+// Tick rate assumed for the test data in time readouts (1 tick = 1 us)
+static const uint32_t TEST_TICK_HZ = 1000000;
+
+// Sample rates auto-set can pick (84 MHz timer clock / integer divider)
+static const uint32_t SAMPLE_RATES[] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 2000000, 4000000
+};
+static const char* const SAMPLE_RATE_NAMES[] = {
+    "1k", "2k", "5k", "10k", "20k", "50k", "100k", "200k", "500k", "1M", "2M", "4M"
+};
+static const uint8_t NUM_SAMPLE_RATES = sizeof(SAMPLE_RATES) / sizeof(SAMPLE_RATES[0]);
+
+// Auto-set probe: length of each of the two meter windows
+static const uint32_t AUTOSET_WINDOW_MS = 100;
+
+// Golden capture for pass/fail comparison, copied from the capture
+// shown when COMPARE is entered (room for a whole transition buffer)
+static const uint16_t REFERENCE_CAPACITY = 512;
+static uint8_t reference_data[LA_NUM_CHANNELS][REFERENCE_CAPACITY];
+static const uint8_t* const reference_channels[LA_NUM_CHANNELS] = {
+    reference_data[0], reference_data[1], reference_data[2], reference_data[3]
+};
+static uint16_t reference_lengths[LA_NUM_CHANNELS];
+
+// Compare screen refresh period (the comparison itself runs every loop)
+static const uint32_t COMPARE_UPDATE_MS = 250;
+
+// Event counter: rate windows advance every second, USB report every minute
+static const uint32_t COUNTER_TICK_MS = 1000;
+static const uint32_t COUNTER_REPORT_S = 60;
+
+// Pattern generator: one period of BSRR words replayed at 1 MHz. The
+// self-test steps the rate up (84 MHz / divider) until a loopback capture
+// shows an error; buffers are static, the task stack is small.
+static const uint16_t PATTERN_PERIOD = 512;
+static const uint32_t PATTERN_DIVIDER = 84;
+static const uint16_t SELFTEST_SAMPLES = 1024;
+static const uint32_t SELFTEST_TIMEOUT_MS = 20;
+static const uint8_t SELFTEST_DIVIDERS[] = {84, 42, 28, 21, 16, 14, 12, 10, 8, 7, 6, 5, 4};
+static const uint8_t NUM_SELFTEST_RATES = sizeof(SELFTEST_DIVIDERS) / sizeof(SELFTEST_DIVIDERS[0]);
+static const uint8_t NUM_PATTERNS = (uint8_t)capture::PatternBuilder::Pattern::COUNT;
+static const uint8_t pattern_output_bits[LA_NUM_CHANNELS] = {
+    (uint8_t)__builtin_ctz(LA_GEN0_Pin), (uint8_t)__builtin_ctz(LA_GEN1_Pin),
+    (uint8_t)__builtin_ctz(LA_GEN2_Pin), (uint8_t)__builtin_ctz(LA_GEN3_Pin),
+};
+static const uint8_t channel_port_bits[LA_NUM_CHANNELS] = {
+    (uint8_t)__builtin_ctz(LA_CH0_Pin), (uint8_t)__builtin_ctz(LA_CH1_Pin),
+    (uint8_t)__builtin_ctz(LA_CH2_Pin), (uint8_t)__builtin_ctz(LA_CH3_Pin),
+};
+static const uint16_t PATTERN_INPUT_MASK = LA_CH0_Pin | LA_CH1_Pin | LA_CH2_Pin | LA_CH3_Pin;
+static uint8_t pattern_levels[PATTERN_PERIOD];
+static uint32_t pattern_words[PATTERN_PERIOD];
+static uint16_t pattern_expected[PATTERN_PERIOD];
+static uint16_t selftest_samples[SELFTEST_SAMPLES];
+
+// Self-test outcome of one pattern
+struct SelfTestResult {
+    uint32_t passed_hz;     // Highest rate without errors (0: none)
+    uint32_t failed_hz;     // Rate of the first failure (0: all passed)
+    capture::PatternBuilder::Verification failure;
+};
+
+// Burst capture: one unrolled CPU burst of the input port, and the same
+// samples as one bit-plane stream per channel
+static const uint32_t BURST_BLOCKS = capture::BurstSampler::SAMPLES / capture::BitPlanes::BLOCK_SAMPLES;
+static uint16_t burst_samples[capture::BurstSampler::SAMPLES];
+static uint32_t burst_planes[LA_NUM_CHANNELS][BURST_BLOCKS];
+static uint32_t* const burst_streams[LA_NUM_CHANNELS] = {
+    burst_planes[0], burst_planes[1], burst_planes[2], burst_planes[3],
+};
+
+// USB throughput benchmark length (host/usb_bench reads the stream)
+static const uint32_t USB_BENCH_SECONDS = 10;
+
+// OLED frames mirrored over the bulk pipe while host/la_mirror asks for them
+static display::FrameMirror frame_mirror;
+
+// Console: the shell task waits for this flag from the CDC receive
+// interrupt; a binary frame silent for SHELL_FRAME_TIMEOUT_MS is dropped
+static const uint32_t SHELL_RX_FLAG = 0x01;
+static const uint32_t SHELL_FRAME_TIMEOUT_MS = 100;
+// Dumps wait for this much room in the CDC ring before each line
+static const uint32_t SHELL_LINE_ROOM = 128;
+static const uint32_t SHELL_ROOM_TIMEOUT_MS = 200;
+static const uint32_t SHELL_DUMP_DEFAULT = 16;
+static const uint32_t SHELL_DUMP_MAX_EVENTS = 64;
+static const uint32_t SHELL_DUMP_MAX_WORDS = 512;
+static const uint8_t SHELL_WORDS_PER_LINE = 8;
+
+// Seek indexes for cursor measurements, one per channel
+static const uint32_t EDGE_CHECKPOINTS = 64;
+static decode::EdgeIndex::Checkpoint edge_checkpoints[LA_NUM_CHANNELS][EDGE_CHECKPOINTS];
+static decode::EdgeIndex edge_index[LA_NUM_CHANNELS] = {
+    {edge_checkpoints[0], EDGE_CHECKPOINTS},
+    {edge_checkpoints[1], EDGE_CHECKPOINTS},
+    {edge_checkpoints[2], EDGE_CHECKPOINTS},
+    {edge_checkpoints[3], EDGE_CHECKPOINTS},
+};
+
+// Single-shot capture (short press in the normal view): port words from
+// the DMA sampler at the selected sample rate, encoded into one
+// transition buffer per channel
+static const uint16_t CAPTURE_SAMPLES = 2048;
+static const uint32_t CAPTURE_TRANSITIONS = 512;
+static uint16_t capture_samples[CAPTURE_SAMPLES];
+static uint8_t capture_transitions[LA_NUM_CHANNELS][CAPTURE_TRANSITIONS];
+static capture::TransitionEncoder capture_encoder(channel_port_bits, LA_NUM_CHANNELS);
+static bool capture_armed = false;
+static bool capture_taken = false;
+static uint32_t capture_count = 0;      // Captures encoded so far
+static_assert(CAPTURE_TRANSITIONS <= REFERENCE_CAPACITY, "a capture must fit the compare reference");
+
+// Channel data the views show: the last capture, the test data until then
+static const uint8_t* channel_data[LA_NUM_CHANNELS] = {
+    logic_ch0_data, logic_ch1_data, logic_ch2_data, logic_ch3_data
+};
+static uint16_t channel_lengths[LA_NUM_CHANNELS] = {
+    sizeof(logic_ch0_data), sizeof(logic_ch1_data), sizeof(logic_ch2_data), sizeof(logic_ch3_data)
+};
+static uint32_t channel_tick_hz = TEST_TICK_HZ;
+
+// Protocol decoders run over every capture into g_events (FIND ALL/ERR),
+// chosen per channel with the decode console command
+static decode::DecoderSet decoder_set;
+static_assert(shell::CommandParser::PROTOCOL_COUNT == (uint8_t)decode::Protocol::COUNT,
+              "decode command and DecoderSet list the same protocols");
+
 // Helper function to calculate total signal length in pixels
 static uint16_t calculateSignalLength(const uint8_t* signal_data, uint16_t data_length) {
     uint16_t total_length = 0;
@@ -108,12 +245,1773 @@ static uint16_t calculateSignalLength(const uint8_t* signal_data, uint16_t data_
         uint8_t delta = signal_data[i] & 0x7F;  // Extract bits 6-0
         total_length += delta;
     }
-    return total_length;
+    return total_length;
+}
+
+// Scroll offset that puts a timestamp in the middle of the view
+// (transitions are counted in samples, so 1 sample = 1 pixel at 1.0x zoom)
+static uint16_t scrollToCentre(uint32_t timestamp, float zoom, uint16_t max_scroll) {
+    int32_t offset = (int32_t)((float)timestamp * zoom) - (VISIBLE_WIDTH / 2);
+    if (offset < 0) {
+        return 0;
+    }
+    if (offset > max_scroll) {
+        return max_scroll;
+    }
+    return (uint16_t)offset;
+}
+
+// Scroll limit for a signal length at a zoom level
+static uint16_t maxScrollFor(uint16_t signal_length, float zoom) {
+    uint16_t zoomed_signal_length = (uint16_t)(signal_length * zoom);
+    return (zoomed_signal_length > VISIBLE_WIDTH) ? zoomed_signal_length - VISIBLE_WIDTH : 0;
+}
+
+// Auto-set probe: two short meter windows on every channel, no sampling.
+// The first window counts edges; slow inputs then switch to reciprocal
+// mode and get their period from the second one. The CH0 meter runs on
+// TIM1, so the DMA sampler must be stopped first (cancelCapture()).
+static void probeChannels(measure::AutoSet::Probe* probes) {
+    if (g_port_dma->isRunning()) {
+        return;
+    }
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        g_meters[ch]->start();
+    }
+    for (uint8_t window = 0; window < 2; window++) {
+        vTaskDelay(pdMS_TO_TICKS(AUTOSET_WINDOW_MS));
+        for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+            g_meters[ch]->update();
+        }
+    }
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        const measure::FreqMeter::Reading& r = g_meters[ch]->reading();
+        probes[ch].frequency_hz = r.valid ? r.frequency_hz : 0.0f;
+        probes[ch].duty_pct = r.duty_pct;
+        g_meters[ch]->stop();
+    }
+}
+
+// Print a value with 6 significant digits and an SI prefix (n..M)
+static void formatSi(char* buffer, size_t size, float value, const char* unit) {
+    static const char* const prefixes[] = {"n", "u", "m", "", "k", "M"};
+    uint8_t prefix = 3;
+    while (value >= 1000.0f && prefix < 5) {
+        value /= 1000.0f;
+        prefix++;
+    }
+    while (value > 0.0f && value < 1.0f && prefix > 0) {
+        value *= 1000.0f;
+        prefix--;
+    }
+    int decimals = (value >= 100.0f) ? 3 : (value >= 10.0f) ? 4 : 5;
+    snprintf(buffer, size, "%.*f%s%s", decimals, value, prefixes[prefix], unit);
+}
+
+// Meter screen: frequency and duty of every channel, details of the selected one
+static void drawMeterView(uint8_t selected) {
+    char line[24];
+    char value[16];
+
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        const measure::FreqMeter::Reading& r = g_meters[ch]->reading();
+        char mark = (ch == selected) ? '>' : ' ';
+        if (!r.valid) {
+            snprintf(line, sizeof(line), "%c%d ---      %s", mark, ch, r.level ? "HIGH" : "LOW");
+        } else if (r.duty_pct < 0.0f) {
+            formatSi(value, sizeof(value), r.frequency_hz, "Hz");
+            snprintf(line, sizeof(line), "%c%d %-10s   -", mark, ch, value);
+        } else {
+            formatSi(value, sizeof(value), r.frequency_hz, "Hz");
+            snprintf(line, sizeof(line), "%c%d %-10s %4.1f%%", mark, ch, value, r.duty_pct);
+        }
+        g_oled->drawString(0, ch * 8, line, 1);
+    }
+
+    const measure::FreqMeter::Reading& r = g_meters[selected]->reading();
+    if (r.valid) {
+        formatSi(value, sizeof(value), r.period_s, "s");
+        snprintf(line, sizeof(line), "T=%s %s", value, r.counting ? "CNT" : "RCP");
+        g_oled->drawString(0, 40, line, 1);
+    }
+    snprintf(line, sizeof(line), "N=%lu", r.pulses);
+    g_oled->drawString(0, 48, line, 1);
+    // newlib-nano printf has no %llu
+    if (r.total > 0xFFFFFFFFull) {
+        snprintf(line, sizeof(line), "TOT=%luk", (uint32_t)(r.total / 1000));
+    } else {
+        snprintf(line, sizeof(line), "TOT=%lu", (uint32_t)r.total);
+    }
+    g_oled->drawString(0, 56, line, 1);
+}
+
+// Histogram screen: bar graph of the occupied bins plus the Welford statistics
+static void drawHistogramView(const measure::PulseStats& stats, uint8_t channel,
+                              measure::PulseStats::Series series) {
+    char line[24];
+    const measure::LogHistogram& histogram = stats.histogram(series);
+    const measure::Welford& welford = stats.stats(series);
+
+    snprintf(line, sizeof(line), "CH%d %s n=%lu", channel,
+             measure::PulseStats::seriesName(series), (uint32_t)welford.count());
+    g_oled->drawString(0, 0, line, 1);
+
+    uint16_t first, last;
+    if (!histogram.range(first, last)) {
+        g_oled->drawString(0, 24, "NO PULSES", 1);
+        return;
+    }
+    g_oled->drawBarGraph(0, 9, 128, 30, histogram.bins() + first, last - first + 1, 1);
+
+    snprintf(line, sizeof(line), "%lu..%lu", measure::LogHistogram::binLower(first),
+             measure::LogHistogram::binLower(last + 1) - 1);
+    g_oled->drawString(0, 40, line, 1);
+    snprintf(line, sizeof(line), "AVG=%.2f SD=%.2f", welford.mean(), welford.stddev());
+    g_oled->drawString(0, 48, line, 1);
+    snprintf(line, sizeof(line), "MIN=%lu MAX=%lu", welford.min(), welford.max());
+    g_oled->drawString(0, 56, line, 1);
+}
+
+// Waveforms of all channels from the top of the screen
+static void drawWaveforms(uint8_t start_y, uint8_t channel_height, uint16_t scroll_offset, float zoom) {
+    g_oled->drawLogicChannels(channel_data, channel_lengths, LA_NUM_CHANNELS, start_y, channel_height,
+                              scroll_offset, zoom, 1);
+}
+
+// Dotted vertical cursor line over the waveform area (if visible)
+static void drawCursorLine(uint32_t timestamp, float zoom, uint16_t scroll_offset,
+                           uint8_t top, uint8_t bottom, uint8_t spacing) {
+    int32_t x = 8 + (int32_t)((float)timestamp * zoom) - scroll_offset;
+    if (x < 8 || x >= g_oled->getWidth()) {
+        return;
+    }
+    for (uint8_t y = top; y < bottom; y += spacing) {
+        g_oled->setPixel((uint8_t)x, y, 1);
+    }
+}
+
+// Cursor screen: compact waveforms with both cursors, then delta-t,
+// 1/delta-t and the number of edges between the cursors on every channel
+static void drawCursorView(const uint32_t* cursor_time, const char* target,
+                           float zoom, uint16_t scroll_offset) {
+    char line[24];
+    char value[16];
+
+    drawWaveforms(0, 10, scroll_offset, zoom);
+    drawCursorLine(cursor_time[0], zoom, scroll_offset, 0, 40, 2);
+    drawCursorLine(cursor_time[1], zoom, scroll_offset, 0, 40, 4);
+
+    uint32_t from = (cursor_time[0] < cursor_time[1]) ? cursor_time[0] : cursor_time[1];
+    uint32_t to = (cursor_time[0] < cursor_time[1]) ? cursor_time[1] : cursor_time[0];
+    float dt = (float)(to - from) / channel_tick_hz;
+
+    formatSi(value, sizeof(value), dt, "s");
+    snprintf(line, sizeof(line), "dT=%s", value);
+    g_oled->drawString(0, 40, line, 1);
+    g_oled->drawString(104, 40, target, 1);
+
+    if (to != from) {
+        formatSi(value, sizeof(value), 1.0f / dt, "Hz");
+        snprintf(line, sizeof(line), "1/dT=%s", value);
+    } else {
+        snprintf(line, sizeof(line), "1/dT=---");
+    }
+    g_oled->drawString(0, 48, line, 1);
+
+    // Edge counts come from the seek index, not from rescanning the data
+    snprintf(line, sizeof(line), "E:%lu %lu %lu %lu",
+             edge_index[0].countEdges(from, to), edge_index[1].countEdges(from, to),
+             edge_index[2].countEdges(from, to), edge_index[3].countEdges(from, to));
+    g_oled->drawString(0, 56, line, 1);
+}
+
+// Pass/fail counter; newlib-nano printf has no %llu
+static void formatCount(char* buffer, size_t size, uint64_t count) {
+    if (count > 0xFFFFFFFFull) {
+        snprintf(buffer, size, "%luk", (uint32_t)(count / 1000));
+    } else {
+        snprintf(buffer, size, "%lu", (uint32_t)count);
+    }
+}
+
+// Store the current capture as the comparison reference
+static void storeReference(measure::CaptureCompare& compare) {
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        uint16_t length = channel_lengths[ch];
+        if (length > REFERENCE_CAPACITY) {
+            length = REFERENCE_CAPACITY;
+        }
+        memcpy(reference_data[ch], channel_data[ch], length);
+        reference_lengths[ch] = length;
+    }
+    compare.setReference(reference_channels, reference_lengths, LA_NUM_CHANNELS);
+    compare.clearCounters();
+}
+
+// Compare screen: soak counters, the first deviation of the last failed
+// capture, and the waveforms with a marker at the deviation
+static void drawCompareView(const measure::CaptureCompare& compare, bool failed,
+                            float zoom, uint16_t scroll_offset) {
+    char line[24];
+    char passes[12];
+    char fails[12];
+
+    formatCount(passes, sizeof(passes), compare.passes());
+    formatCount(fails, sizeof(fails), compare.fails());
+    snprintf(line, sizeof(line), "P:%s F:%s T:%lu", passes, fails, compare.tolerance());
+    g_oled->drawString(0, 0, line, 1);
+
+    const measure::CaptureCompare::Mismatch& m = compare.mismatch();
+    if (failed) {
+        snprintf(line, sizeof(line), "CH%d %s @%lu", m.channel,
+                 measure::CaptureCompare::deviationName(m.kind), m.time);
+    } else {
+        snprintf(line, sizeof(line), "PASS");
+    }
+    g_oled->drawString(0, 8, line, 1);
+
+    drawWaveforms(0, 16, scroll_offset, zoom);
+    if (failed) {
+        drawCursorLine(m.time, zoom, scroll_offset, 16, 64, 2);
+    }
+}
+
+// Counter screen: gate, elapsed time, totals of all channels and the
+// sliding-window rates of the selected one
+static void drawCounterView(const measure::EventCounter& counter, uint8_t selected) {
+    char line[24];
+    char value[16];
+
+    const measure::RateWindows& windows = counter.rates(selected);
+    uint32_t seconds = counter.seconds();
+    if (counter.gateChannel() == measure::EventCounter::NO_GATE) {
+        snprintf(line, sizeof(line), "GATE:OFF  %02lu:%02lu:%02lu",
+                 seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    } else {
+        snprintf(line, sizeof(line), "GATE:%d%s %02lu:%02lu:%02lu", counter.gateChannel(),
+                 counter.gateOpen() ? "^" : "_", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    }
+    g_oled->drawString(0, 0, line, 1);
+
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        char mark = (ch == selected) ? '>' : ' ';
+        if (counter.isCounted(ch)) {
+            formatCount(value, sizeof(value), counter.total(ch));
+            snprintf(line, sizeof(line), "%c%d %s", mark, ch, value);
+        } else {
+            snprintf(line, sizeof(line), "%c%d GATE", mark, ch);
+        }
+        g_oled->drawString(0, 8 + ch * 8, line, 1);
+    }
+
+    for (uint8_t w = 0; w < measure::RateWindows::WINDOW_COUNT; w++) {
+        auto window = (measure::RateWindows::Window)w;
+        float rate;
+        if (counter.isCounted(selected) && windows.rate(window, rate)) {
+            formatSi(value, sizeof(value), rate, "/s");
+            snprintf(line, sizeof(line), "%s %s", measure::RateWindows::windowName(window), value);
+        } else {
+            snprintf(line, sizeof(line), "%s ---", measure::RateWindows::windowName(window));
+        }
+        g_oled->drawString(0, 40 + w * 8, line, 1);
+    }
+}
+
+// Counter totals and rates over USB, one line per counted channel
+static void logCounterReport(const measure::EventCounter& counter) {
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        if (!counter.isCounted(ch)) {
+            continue;
+        }
+        const measure::RateWindows& windows = counter.rates(ch);
+        float rates[measure::RateWindows::WINDOW_COUNT];
+        for (uint8_t w = 0; w < measure::RateWindows::WINDOW_COUNT; w++) {
+            if (!windows.rate((measure::RateWindows::Window)w, rates[w])) {
+                rates[w] = 0.0f;
+            }
+        }
+        // 64-bit total as two decimal halves (newlib-nano printf has no %llu)
+        uint64_t total = counter.total(ch);
+        uint32_t high = (uint32_t)(total / 1000000000ull);
+        uint32_t low = (uint32_t)(total % 1000000000ull);
+        if (high != 0) {
+            Log_Printf("Count CH%d: t=%lus total=%lu%09lu rate 1s=%.3f 1m=%.3f 1h=%.3f /s\r\n", ch,
+                       counter.seconds(), high, low, rates[0], rates[1], rates[2]);
+        } else {
+            Log_Printf("Count CH%d: t=%lus total=%lu rate 1s=%.3f 1m=%.3f 1h=%.3f /s\r\n", ch,
+                       counter.seconds(), low, rates[0], rates[1], rates[2]);
+        }
+    }
+}
+
+// "min-max" of a timing range, or "---" when it has no samples
+static void formatRange(char* buffer, size_t size, const measure::TimingAnalysis::Range& range) {
+    if (range.count == 0) {
+        snprintf(buffer, size, "---");
+    } else {
+        snprintf(buffer, size, "%lu-%lu", range.min, range.max);
+    }
+}
+
+// Timing screen: clock selection, setup / hold of every data channel and
+// the bus skew, all in test data ticks
+static void drawTimingView(const measure::TimingAnalysis::Result& result) {
+    char line[24];
+    char setup[12];
+    char hold[12];
+
+    snprintf(line, sizeof(line), "CLK%d %s n=%lu", result.clock_channel,
+             result.rising ? "RISE" : "FALL", result.clock_edges);
+    g_oled->drawString(0, 0, line, 1);
+    g_oled->drawString(0, 8, "CH SETUP    HOLD", 1);
+
+    uint8_t y = 16;
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        if (ch == result.clock_channel) {
+            continue;
+        }
+        formatRange(setup, sizeof(setup), result.channels[ch].setup);
+        formatRange(hold, sizeof(hold), result.channels[ch].hold);
+        snprintf(line, sizeof(line), "%d  %-9s %s", ch, setup, hold);
+        g_oled->drawString(0, y, line, 1);
+        y += 8;
+    }
+
+    formatRange(setup, sizeof(setup), result.skew);
+    snprintf(line, sizeof(line), "SKEW %s", setup);
+    g_oled->drawString(0, 48, line, 1);
+    snprintf(line, sizeof(line), "1 TICK=%luns", 1000000000ul / channel_tick_hz);
+    g_oled->drawString(0, 56, line, 1);
+}
+
+// Timing summary over USB, one line per data channel
+static void logTimingResult(const measure::TimingAnalysis::Result& result) {
+    Log_Printf("Timing: clock CH%d %s, %lu edges, ticks of %lu ns\r\n", result.clock_channel,
+               result.rising ? "rising" : "falling", result.clock_edges, 1000000000ul / channel_tick_hz);
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        if (ch == result.clock_channel) {
+            continue;
+        }
+        const measure::TimingAnalysis::ChannelResult& r = result.channels[ch];
+        Log_Printf("Timing CH%d: setup n=%lu min=%lu max=%lu, hold n=%lu min=%lu max=%lu\r\n", ch,
+                   r.setup.count, r.setup.count ? r.setup.min : 0, r.setup.max,
+                   r.hold.count, r.hold.count ? r.hold.min : 0, r.hold.max);
+    }
+    Log_Printf("Timing skew: n=%lu min=%lu max=%lu\r\n", result.skew.count,
+               result.skew.count ? result.skew.min : 0, result.skew.max);
+}
+
+// Output words and expected input words of a pattern
+static void buildPattern(capture::PatternBuilder::Pattern pattern) {
+    capture::PatternBuilder::buildLevels(pattern, pattern_levels, PATTERN_PERIOD, LA_NUM_CHANNELS);
+    capture::PatternBuilder::buildBsrr(pattern_levels, PATTERN_PERIOD, pattern_output_bits,
+                                       LA_NUM_CHANNELS, pattern_words);
+    capture::PatternBuilder::buildPortWords(pattern_levels, PATTERN_PERIOD, channel_port_bits,
+                                            LA_NUM_CHANNELS, pattern_expected);
+}
+
+// Generate the built pattern and capture it back at 84 MHz / divider
+static capture::PatternBuilder::Verification loopbackCapture(uint32_t divider) {
+    g_port_dma->configure(divider);
+    g_port_dma->startOutput(pattern_words, PATTERN_PERIOD);
+    g_port_dma->startCapture(selftest_samples, SELFTEST_SAMPLES);
+    g_port_dma->run();
+    uint32_t start = HAL_GetTick();
+    while (!g_port_dma->captureDone() && HAL_GetTick() - start < SELFTEST_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    bool done = g_port_dma->captureDone();
+    g_port_dma->stop();
+    if (!done) {
+        return {false, 0, SELFTEST_SAMPLES, 0};
+    }
+    return capture::PatternBuilder::verify(pattern_expected, PATTERN_PERIOD, selftest_samples,
+                                           SELFTEST_SAMPLES, PATTERN_INPUT_MASK);
+}
+
+// Loopback self-test: every pattern at rising rates up to the first error
+static void runSelfTest(SelfTestResult* results) {
+    for (uint8_t p = 0; p < NUM_PATTERNS; p++) {
+        auto pattern = (capture::PatternBuilder::Pattern)p;
+        SelfTestResult& result = results[p];
+        result = {0, 0, {true, 0, 0, 0}};
+        buildPattern(pattern);
+        for (uint8_t r = 0; r < NUM_SELFTEST_RATES; r++) {
+            uint32_t rate = SystemCoreClock / SELFTEST_DIVIDERS[r];
+            capture::PatternBuilder::Verification v = loopbackCapture(SELFTEST_DIVIDERS[r]);
+            if (!v.locked || v.errors != 0) {
+                result.failed_hz = rate;
+                result.failure = v;
+                break;
+            }
+            result.passed_hz = rate;
+        }
+
+        const char* name = capture::PatternBuilder::patternName(pattern);
+        if (result.failed_hz == 0) {
+            Log_Printf("Selftest %s: all rates passed, up to %lu Hz\r\n", name, result.passed_hz);
+        } else if (!result.failure.locked) {
+            Log_Printf("Selftest %s: passed up to %lu Hz, no lock at %lu Hz (check jumpers)\r\n",
+                       name, result.passed_hz, result.failed_hz);
+        } else {
+            Log_Printf("Selftest %s: passed up to %lu Hz, at %lu Hz %lu/%u errors from sample %lu\r\n",
+                       name, result.passed_hz, result.failed_hz, result.failure.errors,
+                       SELFTEST_SAMPLES, result.failure.first_error);
+        }
+    }
+}
+
+// Pattern generator screen: pattern, rate and the loopback wiring
+static void drawPatternView(capture::PatternBuilder::Pattern pattern) {
+    char line[24];
+    char value[16];
+
+    snprintf(line, sizeof(line), "PATTERN %s", capture::PatternBuilder::patternName(pattern));
+    g_oled->drawString(0, 0, line, 1);
+    formatSi(value, sizeof(value), (float)g_port_dma->rate(), "Hz");
+    snprintf(line, sizeof(line), "RATE %s", value);
+    g_oled->drawString(0, 8, line, 1);
+    snprintf(line, sizeof(line), "PERIOD %u", PATTERN_PERIOD);
+    g_oled->drawString(0, 16, line, 1);
+    g_oled->drawString(0, 32, "PB0>CH0  PB1>CH1", 1);
+    g_oled->drawString(0, 40, "PB8>CH2  PB9>CH3", 1);
+}
+
+// Self-test screen: highest error-free rate of every pattern and the
+// first failing one
+static void drawSelfTestView(const SelfTestResult* results) {
+    char line[24];
+    char value[16];
+
+    g_oled->drawString(0, 0, "SELFTEST LOOPBACK", 1);
+    for (uint8_t p = 0; p < NUM_PATTERNS; p++) {
+        const SelfTestResult& result = results[p];
+        uint8_t y = 8 + p * 16;
+        if (result.passed_hz != 0) {
+            formatSi(value, sizeof(value), (float)result.passed_hz, "Hz");
+        } else {
+            snprintf(value, sizeof(value), "FAIL");
+        }
+        snprintf(line, sizeof(line), "%-8s%s", capture::PatternBuilder::patternName((capture::PatternBuilder::Pattern)p), value);
+        g_oled->drawString(0, y, line, 1);
+
+        if (result.failed_hz == 0) {
+            snprintf(line, sizeof(line), " ALL RATES OK");
+        } else if (!result.failure.locked) {
+            snprintf(line, sizeof(line), " NO LOCK");
+        } else {
+            formatSi(value, sizeof(value), (float)result.failed_hz, "Hz");
+            snprintf(line, sizeof(line), " %s E=%lu", value, result.failure.errors);
+        }
+        g_oled->drawString(0, y + 8, line, 1);
+    }
+}
+
+// New burst: capture and split into per-channel planes
+static uint32_t captureBurst(capture::BurstSampler& sampler) {
+    uint32_t cycles = sampler.capture(burst_samples);
+    capture::BitPlanes::transposeChannels(burst_samples, BURST_BLOCKS, channel_port_bits,
+                                          LA_NUM_CHANNELS, burst_streams);
+    return cycles;
+}
+
+// High samples and edges of a channel in the last burst
+static void burstChannelStats(uint8_t channel, uint32_t& high, uint32_t& edges) {
+    high = capture::BitPlanes::countHigh(burst_planes[channel], BURST_BLOCKS);
+    edges = capture::BitPlanes::countEdges(burst_planes[channel], BURST_BLOCKS);
+}
+
+// Burst screen: calibrated rate, burst length and what each channel did
+static void drawBurstView(const capture::BurstSampler::Calibration& calibration, uint32_t cycles) {
+    char line[24];
+    char value[16];
+
+    snprintf(line, sizeof(line), "BURST %u x %luCYC", capture::BurstSampler::SAMPLES,
+             calibration.cycles_per_sample);
+    g_oled->drawString(0, 0, line, 1);
+    formatSi(value, sizeof(value), (float)calibration.rate_hz, "Hz");
+    snprintf(line, sizeof(line), "RATE %s", value);
+    g_oled->drawString(0, 8, line, 1);
+    formatSi(value, sizeof(value), (float)cycles / (float)SystemCoreClock, "s");
+    snprintf(line, sizeof(line), "T=%s %s", value, calibration.stable ? "STABLE" : "JITTER");
+    g_oled->drawString(0, 16, line, 1);
+    g_oled->drawString(0, 24, "CH HIGH EDGES", 1);
+
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        uint32_t high;
+        uint32_t edges;
+        burstChannelStats(ch, high, edges);
+        snprintf(line, sizeof(line), "%d  %-4lu %lu", ch, high, edges);
+        g_oled->drawString(0, 32 + ch * 8, line, 1);
+    }
+}
+
+// Burst result over USB
+static void logBurst(const capture::BurstSampler::Calibration& calibration, uint32_t cycles) {
+    Log_Printf("Burst: %u samples in %lu cycles, %lu cycles/sample (%s) = %lu Hz\r\n",
+               capture::BurstSampler::SAMPLES, cycles, calibration.cycles_per_sample,
+               calibration.stable ? "stable" : "jitter", calibration.rate_hz);
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        uint32_t high;
+        uint32_t edges;
+        burstChannelStats(ch, high, edges);
+        Log_Printf("Burst CH%d: %lu high, %lu edges\r\n", ch, high, edges);
+    }
+}
+
+// USB benchmark screen: device-side throughput and pipe counters
+static void drawUsbBenchView(const measure::UsbBench::Result& result, bool ran) {
+    char line[24];
+    char value[16];
+
+    snprintf(line, sizeof(line), "%s BENCH %lus",
+             (result.pipe == measure::UsbBench::Pipe::Cdc) ? "USB" : "BULK", result.seconds);
+    g_oled->drawString(0, 0, line, 1);
+    if (!ran) {
+        g_oled->drawString(0, 16, "NO HOST READING", 1);
+        g_oled->drawString(0, 24, "run host/usb_bench", 1);
+        return;
+    }
+    formatSi(value, sizeof(value), (float)result.bytes_per_s, "B/s");
+    snprintf(line, sizeof(line), "RATE %s", value);
+    g_oled->drawString(0, 8, line, 1);
+    snprintf(line, sizeof(line), "BYTES %lu", result.bytes);
+    g_oled->drawString(0, 16, line, 1);
+    snprintf(line, sizeof(line), "XFERS %lu AVG %lu", result.transfers,
+             (result.transfers != 0) ? result.bytes / result.transfers : 0);
+    g_oled->drawString(0, 24, line, 1);
+    snprintf(line, sizeof(line), "BUSY %lu", result.busy);
+    g_oled->drawString(0, 32, line, 1);
+    snprintf(line, sizeof(line), "STARVED %lu", result.starved);
+    g_oled->drawString(0, 40, line, 1);
+    g_oled->drawString(0, 48, result.drained ? "DRAINED" : "NOT DRAINED", 1);
+}
+
+// Wait until a console line fits in the CDC transmit ring, so a dump is
+// paced by the host instead of dropped (gives up if nobody reads)
+static void waitConsoleRoom() {
+    uint32_t start = HAL_GetTick();
+    CDC_TxStatsTypeDef stats;
+    CDC_GetTxStats_FS(&stats);
+    while (APP_TX_DATA_SIZE - (stats.queued - stats.sent) < SHELL_LINE_ROOM &&
+           HAL_GetTick() - start < SHELL_ROOM_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+        CDC_GetTxStats_FS(&stats);
+    }
+}
+
+// Console dump of u16 port words, SHELL_WORDS_PER_LINE per line
+static void dumpWords(const char* name, const uint16_t* words, uint32_t size, uint32_t first, uint32_t count) {
+    if (first > size) {
+        first = size;
+    }
+    if (count > size - first) {
+        count = size - first;
+    }
+    Log_Printf("dump %s: %lu..%lu of %lu\r\n", name, first, first + count, size);
+    for (uint32_t i = first; i < first + count; i += SHELL_WORDS_PER_LINE) {
+        char line[64];
+        int length = snprintf(line, sizeof(line), "%5lu:", i);
+        for (uint32_t k = i; k < first + count && k < i + SHELL_WORDS_PER_LINE; k++) {
+            length += snprintf(line + length, sizeof(line) - length, " %04X", words[k]);
+        }
+        waitConsoleRoom();
+        Log_Printf("%s\r\n", line);
+    }
+}
+
+// Console dump of decoded events
+static void dumpEvents(uint32_t first, uint32_t count) {
+    uint32_t size = (g_events != nullptr) ? g_events->size() : 0;
+    if (first > size) {
+        first = size;
+    }
+    if (count > size - first) {
+        count = size - first;
+    }
+    Log_Printf("dump events: %lu..%lu of %lu (%lu dropped)\r\n", first, first + count, size,
+               (g_events != nullptr) ? g_events->dropped() : 0);
+    for (uint32_t i = first; i < first + count; i++) {
+        const decode::Event& event = (*g_events)[i];
+        waitConsoleRoom();
+        Log_Printf("%5lu: t=%lu CH%d %-8s 0x%08lX flags %02X len %d\r\n", i, event.timestamp, event.channel,
+                   decode::eventTypeName(event.type), event.value, event.flags, event.length);
+    }
+}
+
+// Day of the week of a date, 1 = Monday (RTC_WEEKDAY_MONDAY) .. 7 = Sunday
+static uint8_t weekDay(uint32_t year, uint32_t month, uint32_t day) {
+    static const uint8_t offsets[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+    if (month < 3) {
+        year--;
+    }
+    uint32_t sunday_based = (year + year / 4 - year / 100 + year / 400 + offsets[month - 1] + day) % 7;
+    return (uint8_t)((sunday_based == 0) ? 7 : sunday_based);
+}
+
+// Set the RTC from a checked Op::Time command and mark it as set, so a
+// reset keeps it (MX_RTC_Init)
+static bool setClock(const uint32_t* args) {
+    RTC_DateTypeDef date = {};
+    date.Year = (uint8_t)(args[0] - 2000);
+    date.Month = (uint8_t)args[1];
+    date.Date = (uint8_t)args[2];
+    date.WeekDay = weekDay(args[0], args[1], args[2]);
+    RTC_TimeTypeDef time = {};
+    time.Hours = (uint8_t)args[3];
+    time.Minutes = (uint8_t)args[4];
+    time.Seconds = (uint8_t)args[5];
+    time.DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
+    time.StoreOperation = RTC_STOREOPERATION_RESET;
+
+    // Log_Printf reads the clock from every task; no reads in between
+    vTaskSuspendAll();
+    bool ok = HAL_RTC_SetTime(&hrtc, &time, RTC_FORMAT_BIN) == HAL_OK &&
+              HAL_RTC_SetDate(&hrtc, &date, RTC_FORMAT_BIN) == HAL_OK;
+    if (ok) {
+        HAL_RTCEx_BKUPWrite(&hrtc, RTC_SET_REGISTER, RTC_SET_MARKER);
+    }
+    xTaskResumeAll();
+    return ok;
+}
+
+static void logClock() {
+    RTC_TimeTypeDef time;
+    RTC_DateTypeDef date;
+    HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
+    HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BIN);
+    Log_Printf("time: 20%02d-%02d-%02d %02d:%02d:%02d%s\r\n", date.Year, date.Month, date.Date, time.Hours,
+               time.Minutes, time.Seconds,
+               (HAL_RTCEx_BKUPRead(&hrtc, RTC_SET_REGISTER) == RTC_SET_MARKER) ? "" : " (not set)");
+}
+
+static void logShellStats() {
+    CDC_TxStatsTypeDef tx;
+    CDC_RxStatsTypeDef rx;
+    console::UartTx::Stats uart;
+    CDC_GetTxStats_FS(&tx);
+    CDC_GetRxStats_FS(&rx);
+    g_uart_tx->getStats(uart);
+    Log_Printf("stats: up %lu s, heap %u free (min %u)\r\n", HAL_GetTick() / 1000,
+               (unsigned)xPortGetFreeHeapSize(), (unsigned)xPortGetMinimumEverFreeHeapSize());
+    Log_Printf("stats: cdc tx %lu queued %lu sent %lu dropped, rx %lu received %lu dropped\r\n", tx.queued, tx.sent,
+               tx.dropped, rx.received, rx.dropped);
+    Log_Printf("stats: uart tx %lu queued %lu sent %lu dropped in %lu transfers\r\n", uart.queued, uart.sent,
+               uart.dropped, uart.transfers);
+    Log_Printf("stats: events %lu (%lu dropped), stack free test %lu shell %lu words\r\n",
+               (g_events != nullptr) ? g_events->size() : 0, (g_events != nullptr) ? g_events->dropped() : 0,
+               (uint32_t)uxTaskGetStackHighWaterMark((TaskHandle_t)testTaskHandle),
+               (uint32_t)uxTaskGetStackHighWaterMark((TaskHandle_t)shellTaskHandle));
+    Log_Printf("stats: mirror %s, %lu frames sent %lu dropped\r\n",
+               (g_oled != nullptr && g_oled->mirror() != nullptr) ? "on" : "off", frame_mirror.sent(),
+               frame_mirror.dropped());
+}
+
+// Commands that need no capture state run in the shell task; the rest go
+// to testTask, which owns it
+static void runShellCommand(const shell::Command& command) {
+    switch (command.op) {
+    case shell::Op::Error:
+        Log_Printf("err: %s\r\n", command.error);
+        break;
+    case shell::Op::Help:
+        Log_Printf("help: stats | rate [HZ] | dump events|burst|selftest [FIRST [COUNT]]\r\n");
+        Log_Printf("help: time [YYYY-MM-DD HH:MM:SS] | decode [CH off|can|manch|bmc|1wire|ws2812|nec [BITRATE]]\r\n");
+        Log_Printf("help: binary frames: Core/Lib/CommandParser.hpp\r\n");
+        break;
+    case shell::Op::Stats:
+        logShellStats();
+        break;
+    case shell::Op::Time:
+        if (command.argc != 0 && !setClock(command.args)) {
+            Log_Printf("err: RTC not set\r\n");
+            break;
+        }
+        logClock();
+        break;
+    default:
+        if (osMessageQueuePut(g_shell_queue, &command, 0, 0) != osOK) {
+            Log_Printf("err: busy, %s dropped\r\n", shell::CommandParser::opName(command.op));
+        }
+        break;
+    }
+}
+
+// CDC receive interrupt: wake the shell task
+static void shellRxNotify() {
+    osThreadFlagsSet(shellTaskHandle, SHELL_RX_FLAG);
+}
+
+// ---- testTask views ----
+//
+// Long press in the normal view opens the menu and a short press enters
+// the selected item. A short press leaves a mode, unless the mode uses it
+// (cursor target, counter gate): there a long press leaves. Everything a
+// mode does on entry, press, rotation, every loop and redraw lives in its
+// row of MODE_HANDLERS.
+
+enum class ViewMode : uint8_t { Normal, Menu, Zoom, Search, Meter, Histogram, Cursor, Timing, Compare, Counter,
+                                Pattern, SelfTest, Burst, UsbBench, COUNT };
+
+struct ModeHandlers {
+    const char* name;                 // For the log ("Zoom mode OFF")
+    void (*enter)(uint8_t variant);   // Chosen in the menu (variant: see MenuItem)
+    void (*press)();                  // Short press; nullptr: the press leaves the mode
+    void (*release)();                // nullptr: only logged
+    void (*rotate)(int delta);        // nullptr: rotation is ignored
+    void (*poll)();                   // Every loop while the mode is active
+    void (*leave)();                  // Undoes enter, logs "mode OFF"; nullptr: name only
+    void (*draw)();                   // Screen contents (cleared before, sent after)
+};
+
+// Menu entries: the mode they enter, and which variant of it
+struct MenuItem {
+    const char* name;
+    ViewMode mode;
+    uint8_t variant;
+};
+
+static const MenuItem MENU_ITEMS[] = {
+    {"ZOOM", ViewMode::Zoom, 0},
+    {"FIND ALL", ViewMode::Search, 0},
+    {"FIND ERR", ViewMode::Search, 1},
+    {"METER", ViewMode::Meter, 0},
+    {"HISTO", ViewMode::Histogram, 0},
+    {"CURSOR", ViewMode::Cursor, 0},
+    {"TIMING", ViewMode::Timing, 0},
+    {"COMPARE", ViewMode::Compare, 0},
+    {"COUNT", ViewMode::Counter, 0},
+    {"PATTERN", ViewMode::Pattern, 0},
+    {"SELFTEST", ViewMode::SelfTest, 0},
+    {"BURST", ViewMode::Burst, 0},
+    {"USB BENCH", ViewMode::UsbBench, 0},
+    {"BULK BENCH", ViewMode::UsbBench, 1},
+};
+static const uint8_t NUM_MENU_ITEMS = sizeof(MENU_ITEMS) / sizeof(MENU_ITEMS[0]);
+
+// Waveform position shared by every view
+static ViewMode view_mode = ViewMode::Normal;
+static uint8_t menu_index = 0;
+static bool logic_analyzer_shown = false;
+static bool display_needs_update = false;
+static uint16_t total_signal_length = 0;
+static uint16_t scroll_offset = 0;  // Horizontal scroll position
+static uint16_t max_scroll = 0;     // Maximum scroll value
+
+// Zoom levels (0.5x, 1.0x, 2.0x, 4.0x, 8.0x), starting at 1.0x
+static const float ZOOM_LEVELS[] = {0.5f, 1.0f, 2.0f, 4.0f, 8.0f};
+static const uint8_t NUM_ZOOM_LEVELS = sizeof(ZOOM_LEVELS) / sizeof(ZOOM_LEVELS[0]);
+static uint8_t current_zoom_index = 1;
+static float zoom_level = 1.0f;
+
+// Capture sample rate, set by auto-set (double click) or the rate command
+static uint8_t sample_rate_index = 9;   // 1 MHz, the test data tick
+
+// Event search: current query and the event the view is centred on
+static decode::EventStore::Query search_query;
+static int32_t search_match = decode::EventStore::NOT_FOUND;
+
+// Frequency meter: selected channel and time of the last refresh
+static uint8_t meter_channel = 0;
+static uint32_t meter_update_time = 0;
+
+// Histograms: one channel/series pair at a time (channel * 3 + series)
+static measure::PulseStats pulse_stats;
+static uint8_t histogram_index = 0;
+
+// Cursors: short press picks what the encoder moves (A, B or the
+// channel whose edges they snap to), long press leaves cursor mode
+static const char* const cursor_targets[] = {"A", "B", "CH"};
+static uint32_t cursor_time[2] = {0, 0};
+static uint8_t cursor_target = 0;
+static uint8_t cursor_channel = 0;
+
+// Timing analysis: clock channel and edge (channel * 2 + falling)
+static measure::TimingAnalysis::Result timing_result;
+static uint8_t timing_clock = 0;
+
+// Pass/fail comparison: soak counters live in the comparator, the
+// view stays on the last failed capture's deviation
+static measure::CaptureCompare capture_compare;
+static bool compare_failed = false;
+static uint32_t compare_update_time = 0;
+static uint32_t compared_count = 0;     // capture_count at the last comparison
+
+// Event counter: gate choice (0 = none, 1 + channel), channel shown in
+// detail and the time of the last one-second tick
+static measure::EventCounter event_counter(g_meters, LA_NUM_CHANNELS);
+static uint8_t counter_gate = 0;
+static uint8_t counter_channel = 0;
+static uint32_t counter_tick_time = 0;
+// The menu press that enters the mode is released inside it
+static bool counter_entry_release = false;
+
+// Pattern generator output and the last loopback self-test
+static uint8_t pattern_index = 0;
+static SelfTestResult selftest_results[NUM_PATTERNS];
+
+// Burst capture: calibrated on entry, recaptured on rotation
+static uint32_t burst_cycles = 0;
+
+// USB benchmark: last result (runs once on entry, blocking)
+static measure::UsbBench::Result usb_bench_result;
+static bool usb_bench_ran = false;
+
+// Built on first use: the core clock is only final once the task runs
+static capture::BurstSampler& burstSampler() {
+    static capture::BurstSampler sampler(LA_CH0_GPIO_Port, SystemCoreClock);
+    return sampler;
+}
+
+// Apply a zoom level and keep the scroll position in range
+static void setZoom(uint8_t index) {
+    current_zoom_index = index;
+    zoom_level = ZOOM_LEVELS[current_zoom_index];
+    max_scroll = maxScrollFor(total_signal_length, zoom_level);
+    if (scroll_offset > max_scroll) {
+        scroll_offset = max_scroll;
+    }
+}
+
+// Start a single-shot capture; testTask picks it up with pollCapture()
+static void armCapture() {
+    // TIM1 also clocks the CH0 meter, which would stop the sampler under it
+    if (capture_armed || g_port_dma->isRunning() || g_meters[0]->isRunning()) {
+        return;
+    }
+    // TIM1 runs at the core clock (APB2 undivided)
+    g_port_dma->configure(SystemCoreClock / SAMPLE_RATES[sample_rate_index]);
+    g_port_dma->startCapture(capture_samples, CAPTURE_SAMPLES);
+    g_port_dma->run();
+    capture_armed = true;
+}
+
+// Drop a capture still running before something else takes the DMA
+static void cancelCapture() {
+    if (capture_armed) {
+        g_port_dma->stop();
+        capture_armed = false;
+        display_needs_update = true;
+    }
+}
+
+// Fill the event store from the capture shown (test data has no events)
+static void decodeCapture() {
+    search_match = decode::EventStore::NOT_FOUND;
+    if (g_events == nullptr) {
+        return;
+    }
+    g_events->clear();
+    if (capture_taken) {
+        decoder_set.run(*g_events, channel_data, channel_lengths, LA_NUM_CHANNELS, channel_tick_hz);
+        g_events->sort();
+    }
+}
+
+// Encode a finished capture and make it the one the views show
+static void pollCapture() {
+    if (!capture_armed || !g_port_dma->captureDone()) {
+        return;
+    }
+    g_port_dma->stop();
+    capture_armed = false;
+
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        capture_encoder.setOutput(ch, capture_transitions[ch], CAPTURE_TRANSITIONS);
+    }
+    capture_encoder.reset();
+    capture_encoder.encode(capture_samples, CAPTURE_SAMPLES);
+    capture_encoder.finish();
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        channel_data[ch] = capture_transitions[ch];
+        channel_lengths[ch] = (uint16_t)capture_encoder.length(ch);
+    }
+    channel_tick_hz = g_port_dma->rate();
+    capture_taken = true;
+    capture_count++;
+    decodeCapture();
+
+    total_signal_length = (uint16_t)capture_encoder.samples();
+    setZoom(current_zoom_index);
+    // COMPARE captures back to back and redraws on its own clock
+    if (view_mode == ViewMode::Normal) {
+        Log_Printf("Capture: %u samples at %lu Hz, transitions %u %u %u %u%s, %lu events\r\n", CAPTURE_SAMPLES,
+                   channel_tick_hz, channel_lengths[0], channel_lengths[1], channel_lengths[2], channel_lengths[3],
+                   capture_encoder.overflow() ? " (truncated)" : "", (g_events != nullptr) ? g_events->size() : 0);
+        display_needs_update = true;
+    }
+}
+
+// Time at the middle of the view
+static uint32_t viewCentre() {
+    return (uint32_t)((scroll_offset + VISIBLE_WIDTH / 2) / zoom_level);
+}
+
+// Waveforms under a one-line header: the normal view and the modes that
+// only move around in it
+static void drawWaveformView(const char* header) {
+    g_oled->drawString(0, 0, header, 1);
+    drawWaveforms(0, 16, scroll_offset, zoom_level);
+}
+
+// -- Normal: press captures, scroll, long press opens the menu, double
+// click auto-sets --
+
+static void pressNormal() {
+    Log_Printf("Enter button pressed\r\n");
+    armCapture();
+    display_needs_update = true;
+}
+
+static void rotateNormal(int delta) {
+    // CW rotation = scroll right (show left part of signal)
+    // CCW rotation = scroll left (show right part of signal)
+    int16_t new_offset = scroll_offset + (delta * 4);  // 4 pixels per encoder click
+
+    // Clamp to valid range: [0, max_scroll]
+    if (new_offset < 0) {
+        new_offset = 0;
+    } else if (new_offset > max_scroll) {
+        new_offset = max_scroll;
+    }
+
+    // Only update if offset actually changed
+    if (new_offset != scroll_offset) {
+        scroll_offset = new_offset;
+        display_needs_update = true;
+        Log_Printf("Scroll %s: offset=%d, pos=%d (%s, delta=%d)\r\n", (delta > 0) ? "right" : "left",
+                   scroll_offset, g_encoder->getPosition(), (delta > 0) ? "CW" : "CCW", delta);
+    }
+}
+
+static void drawNormal() {
+    // "NORM", the sample rate and whether a capture is shown yet
+    char header[24];
+    snprintf(header, sizeof(header), "NORM %sS/s%s", SAMPLE_RATE_NAMES[sample_rate_index],
+             capture_armed ? " ..." : capture_taken ? "" : " DEMO");
+    drawWaveformView(header);
+}
+
+// Auto-set sample rate and zoom from a quick hardware probe of all channels
+static void autoSet() {
+    uint32_t probe_start = HAL_GetTick();
+    measure::AutoSet::Probe probes[LA_NUM_CHANNELS] = {};
+    // The press of a double click has armed a capture on TIM1
+    cancelCapture();
+    probeChannels(probes);
+
+    measure::AutoSet::Choice choice;
+    if (measure::AutoSet::choose(probes, LA_NUM_CHANNELS, SAMPLE_RATES, NUM_SAMPLE_RATES,
+                                 ZOOM_LEVELS, NUM_ZOOM_LEVELS, choice)) {
+        sample_rate_index = choice.rate_index;
+        setZoom(choice.zoom_index);
+        Log_Printf("Auto-set: CH%d shortest pulse %.3f us -> %sS/s, zoom %.1fx (%lu ms)\r\n",
+                   choice.channel, choice.pulse_s * 1e6f, SAMPLE_RATE_NAMES[sample_rate_index],
+                   zoom_level, HAL_GetTick() - probe_start);
+    } else {
+        Log_Printf("Auto-set: no activity on any channel (%lu ms)\r\n", HAL_GetTick() - probe_start);
+    }
+    display_needs_update = true;
+}
+
+// -- Menu: rotate through the items, press enters one --
+
+static void enterMenuItem();
+
+// COMPARE needs a real capture for its reference
+static bool menuItemAvailable(uint8_t index) {
+    return MENU_ITEMS[index].mode != ViewMode::Compare || capture_taken;
+}
+
+static void rotateMenu(int delta) {
+    do {
+        menu_index = (uint8_t)((menu_index + NUM_MENU_ITEMS + (delta > 0 ? 1 : -1)) % NUM_MENU_ITEMS);
+    } while (!menuItemAvailable(menu_index));
+    display_needs_update = true;
+}
+
+static void drawMenu() {
+    char header[16];
+    snprintf(header, sizeof(header), ">%s", MENU_ITEMS[menu_index].name);
+    drawWaveformView(header);
+}
+
+// -- Zoom: rotate to zoom in (CW) or out (CCW) --
+
+static void enterZoom(uint8_t) {
+    Log_Printf("Zoom mode ON (zoom=%.1fx) - rotate to adjust, press to exit\r\n", zoom_level);
+}
+
+static void rotateZoom(int delta) {
+    uint8_t index = current_zoom_index;
+    if (delta > 0 && index < NUM_ZOOM_LEVELS - 1) {
+        index++;
+    } else if (delta < 0 && index > 0) {
+        index--;
+    }
+    if (index != current_zoom_index) {
+        setZoom(index);
+        display_needs_update = true;
+        Log_Printf("Zoom %s: %.1fx (max_scroll=%d)\r\n", (delta > 0) ? "IN" : "OUT", zoom_level, max_scroll);
+    }
+}
+
+static void leaveZoom() {
+    Log_Printf("Zoom mode OFF (zoom=%.1fx)\r\n", zoom_level);
+}
+
+static void drawZoom() {
+    char header[12];
+    snprintf(header, sizeof(header), "Z:%.1fx", zoom_level);
+    drawWaveformView(header);
+}
+
+// -- Search: CW = next match, CCW = previous match (variant 1: errors only) --
+
+static void enterSearch(uint8_t variant) {
+    search_query = (variant == 0) ? decode::EventStore::Query() : decode::EventStore::Query::errors();
+    search_match = decode::EventStore::NOT_FOUND;
+    if (!decoder_set.any()) {
+        Log_Printf("Search: no decoders set (console: decode CH PROTOCOL)\r\n");
+    }
+    if (g_events != nullptr) {
+        Log_Printf("Search mode ON (%s, %lu matches) - rotate to step, press to exit\r\n",
+                   MENU_ITEMS[menu_index].name, g_events->count(search_query));
+    }
+}
+
+static void rotateSearch(int delta) {
+    // From the current match by position (events may share a timestamp),
+    // else from the view centre by time
+    if (g_events == nullptr) {
+        return;
+    }
+    int32_t match;
+    if (search_match != decode::EventStore::NOT_FOUND) {
+        match = (delta > 0) ? g_events->nextMatch(search_query, (uint32_t)search_match)
+                            : g_events->prevMatch(search_query, (uint32_t)search_match);
+    } else {
+        uint32_t centre = viewCentre();
+        match = (delta > 0) ? g_events->findNext(search_query, centre) : g_events->findPrev(search_query, centre);
+    }
+    if (match == decode::EventStore::NOT_FOUND) {
+        Log_Printf("No %s match\r\n", (delta > 0) ? "next" : "previous");
+        return;
+    }
+    const decode::Event& event = (*g_events)[match];
+    search_match = match;
+    scroll_offset = scrollToCentre(event.timestamp, zoom_level, max_scroll);
+    display_needs_update = true;
+    Log_Printf("Match %ld: %s ch%d t=%lu value=0x%lX (offset=%d)\r\n", match, decode::eventTypeName(event.type),
+               event.channel, event.timestamp, event.value, scroll_offset);
+}
+
+static void drawSearch() {
+    // "F:n/N" (current match of all matches)
+    char header[24];
+    uint32_t total = (g_events != nullptr) ? g_events->count(search_query) : 0;
+    if (search_match != decode::EventStore::NOT_FOUND) {
+        snprintf(header, sizeof(header), "F:%lu/%lu", g_events->rank(search_query, search_match) + 1, total);
+    } else {
+        snprintf(header, sizeof(header), "F:-/%lu%s", total, decoder_set.any() ? "" : " NO DECODERS");
+    }
+    drawWaveformView(header);
+}
+
+// -- Meter: rotate through the channels shown in detail --
+
+static void enterMeter(uint8_t) {
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        g_meters[ch]->start();
+    }
+    meter_update_time = HAL_GetTick();
+    Log_Printf("Meter mode ON - rotate to select channel, press to exit\r\n");
+}
+
+static void rotateMeter(int delta) {
+    meter_channel = (uint8_t)((meter_channel + LA_NUM_CHANNELS + (delta > 0 ? 1 : -1)) % LA_NUM_CHANNELS);
+    const measure::FreqMeter::Reading& r = g_meters[meter_channel]->reading();
+    Log_Printf("Meter CH%d: f=%.6f Hz duty=%.1f%% pulses=%lu\r\n", meter_channel, r.frequency_hz, r.duty_pct,
+               r.pulses);
+    display_needs_update = true;
+}
+
+static void pollMeter() {
+    // Refresh the readings a few times per second
+    if (HAL_GetTick() - meter_update_time >= METER_UPDATE_MS) {
+        meter_update_time = HAL_GetTick();
+        for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+            g_meters[ch]->update();
+        }
+        display_needs_update = true;
+    }
+}
+
+static void leaveMeter() {
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        g_meters[ch]->stop();
+    }
+    Log_Printf("Meter mode OFF\r\n");
+}
+
+static void drawMeter() {
+    drawMeterView(meter_channel);
+}
+
+// -- Histogram: step through HIGH/LOW/PERIOD of every channel --
+
+// Widths are in samples of the capture shown in the normal view
+static void loadHistogramChannel(uint8_t channel) {
+    pulse_stats.clear();
+    decode::feedTransitions(pulse_stats, channel_data[channel], channel_lengths[channel]);
+}
+
+static void enterHistogram(uint8_t) {
+    uint8_t ch = histogram_index / measure::PulseStats::SERIES_COUNT;
+    loadHistogramChannel(ch);
+    Log_Printf("Histogram mode ON (CH%d) - rotate to select, press to exit\r\n", ch);
+}
+
+static void rotateHistogram(int delta) {
+    const uint8_t num_histograms = LA_NUM_CHANNELS * measure::PulseStats::SERIES_COUNT;
+    uint8_t old_channel = histogram_index / measure::PulseStats::SERIES_COUNT;
+    histogram_index = (uint8_t)((histogram_index + num_histograms + (delta > 0 ? 1 : -1)) % num_histograms);
+    uint8_t ch = histogram_index / measure::PulseStats::SERIES_COUNT;
+    if (ch != old_channel) {
+        loadHistogramChannel(ch);
+    }
+    auto series = (measure::PulseStats::Series)(histogram_index % measure::PulseStats::SERIES_COUNT);
+    const measure::Welford& w = pulse_stats.stats(series);
+    Log_Printf("Histogram CH%d %s: n=%lu mean=%.2f sd=%.2f min=%lu max=%lu\r\n", ch,
+               measure::PulseStats::seriesName(series), (uint32_t)w.count(), w.mean(), w.stddev(), w.min(), w.max());
+    display_needs_update = true;
+}
+
+static void drawHistogram() {
+    drawHistogramView(pulse_stats, histogram_index / measure::PulseStats::SERIES_COUNT,
+                      (measure::PulseStats::Series)(histogram_index % measure::PulseStats::SERIES_COUNT));
+}
+
+// -- Cursor: rotate moves A, B or the snap channel; press picks which --
+
+static void enterCursor(uint8_t) {
+    for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+        edge_index[ch].build(channel_data[ch], channel_lengths[ch]);
+    }
+    // Start on the edge nearest to the view centre and the one after it
+    uint32_t centre = viewCentre();
+    const decode::EdgeIndex& index = edge_index[cursor_channel];
+    if (!index.nearestEdge(centre, cursor_time[0])) {
+        cursor_time[0] = centre;
+    }
+    if (!index.nextEdge(cursor_time[0], cursor_time[1])) {
+        cursor_time[1] = cursor_time[0];
+    }
+    cursor_target = 0;
+    Log_Printf("Cursor mode ON - rotate to move, press to switch A/B/CH, long press to exit\r\n");
+}
+
+static void pressCursor() {
+    cursor_target = (uint8_t)((cursor_target + 1) % 3);
+    Log_Printf("Cursor: moving %s\r\n", cursor_targets[cursor_target]);
+    display_needs_update = true;
+}
+
+static void rotateCursor(int delta) {
+    // Step the selected cursor edge by edge, or pick the channel and snap
+    // both cursors to its nearest edges
+    const decode::EdgeIndex* index = &edge_index[cursor_channel];
+    if (cursor_target == 2) {
+        cursor_channel = (uint8_t)((cursor_channel + LA_NUM_CHANNELS + (delta > 0 ? 1 : -1)) % LA_NUM_CHANNELS);
+        index = &edge_index[cursor_channel];
+        for (uint8_t c = 0; c < 2; c++) {
+            index->nearestEdge(cursor_time[c], cursor_time[c]);
+        }
+    } else {
+        uint32_t& t = cursor_time[cursor_target];
+        for (int step = 0; step < (delta > 0 ? delta : -delta); step++) {
+            uint32_t edge;
+            if (!(delta > 0 ? index->nextEdge(t, edge) : index->prevEdge(t, edge))) {
+                break;
+            }
+            t = edge;
+        }
+
+        // Keep the moved cursor on screen
+        int32_t x = 8 + (int32_t)((float)t * zoom_level) - scroll_offset;
+        if (x < 8 || x >= g_oled->getWidth()) {
+            scroll_offset = scrollToCentre(t, zoom_level, max_scroll);
+        }
+    }
+    uint32_t dt = (cursor_time[1] > cursor_time[0]) ? cursor_time[1] - cursor_time[0]
+                                                    : cursor_time[0] - cursor_time[1];
+    Log_Printf("Cursor A=%lu B=%lu dT=%lu ticks (CH%d)\r\n", cursor_time[0], cursor_time[1], dt, cursor_channel);
+    display_needs_update = true;
+}
+
+static void drawCursor() {
+    char target[8];
+    if (cursor_target == 2) {
+        snprintf(target, sizeof(target), "CH%d", cursor_channel);
+    } else {
+        snprintf(target, sizeof(target), "%s@%d", cursor_targets[cursor_target], cursor_channel);
+    }
+    drawCursorView(cursor_time, target, zoom_level, scroll_offset);
+}
+
+// -- Timing: step through the clock channels, rising then falling edge --
+
+static void analyzeTiming() {
+    measure::TimingAnalysis::analyze(channel_data, channel_lengths, LA_NUM_CHANNELS, timing_clock / 2,
+                                     (timing_clock & 1) == 0, timing_result);
+    logTimingResult(timing_result);
+}
+
+static void enterTiming(uint8_t) {
+    Log_Printf("Timing mode ON - rotate to select clock, press to exit\r\n");
+    analyzeTiming();
+}
+
+static void rotateTiming(int delta) {
+    const uint8_t num_clocks = LA_NUM_CHANNELS * 2;
+    timing_clock = (uint8_t)((timing_clock + num_clocks + (delta > 0 ? 1 : -1)) % num_clocks);
+    analyzeTiming();
+    display_needs_update = true;
+}
+
+static void drawTiming() {
+    drawTimingView(timing_result);
+}
+
+// -- Compare: the capture shown on entry is the reference, new ones are
+// taken back to back and checked against it; rotate sets the edge
+// tolerance in ticks and restarts the counters --
+
+static void enterCompare(uint8_t) {
+    storeReference(capture_compare);
+    compared_count = capture_count;
+    compare_failed = false;
+    compare_update_time = HAL_GetTick();
+    Log_Printf("Compare mode ON (tolerance %lu ticks) - reference stored, rotate to adjust, press to exit\r\n",
+               capture_compare.tolerance());
+}
+
+// Check the newest capture; a failure scrolls the view to its first deviation
+static void compareCapture() {
+    if (!capture_compare.compare(channel_data, channel_lengths)) {
+        const measure::CaptureCompare::Mismatch& m = capture_compare.mismatch();
+        if (!compare_failed) {
+            Log_Printf("Compare FAIL: CH%d %s at %lu (expected %ld, actual %ld)\r\n", m.channel,
+                       measure::CaptureCompare::deviationName(m.kind), m.time, (int32_t)m.expected,
+                       (int32_t)m.actual);
+        }
+        compare_failed = true;
+        scroll_offset = scrollToCentre(m.time, zoom_level, max_scroll);
+    }
+}
+
+static void rotateCompare(int delta) {
+    int32_t tolerance = (int32_t)capture_compare.tolerance() + (delta > 0 ? 1 : -1);
+    capture_compare.setTolerance(tolerance < 0 ? 0 : (uint32_t)tolerance);
+    capture_compare.clearCounters();
+    compare_failed = false;
+    Log_Printf("Compare tolerance: %lu ticks\r\n", capture_compare.tolerance());
+    display_needs_update = true;
+}
+
+static void pollCompare() {
+    // One comparison per capture, and the next one started right away
+    if (compared_count != capture_count) {
+        compared_count = capture_count;
+        compareCapture();
+    }
+    armCapture();
+    if (HAL_GetTick() - compare_update_time >= COMPARE_UPDATE_MS) {
+        compare_update_time = HAL_GetTick();
+        display_needs_update = true;
+    }
+}
+
+static void leaveCompare() {
+    cancelCapture();
+    Log_Printf("Compare mode OFF (%lu passed, %lu failed)\r\n", (uint32_t)capture_compare.passes(),
+               (uint32_t)capture_compare.fails());
+}
+
+static void drawCompare() {
+    drawCompareView(capture_compare, compare_failed, zoom_level, scroll_offset);
+}
+
+// -- Counter: rotate picks the channel, a press (on release) the gate --
+
+static void startCounter() {
+    event_counter.start(counter_gate == 0 ? measure::EventCounter::NO_GATE : counter_gate - 1);
+    counter_tick_time = HAL_GetTick();
+}
+
+static void enterCounter(uint8_t) {
+    startCounter();
+    counter_entry_release = true;
+    Log_Printf("Count mode ON - rotate to select channel, press to change gate, long press to exit\r\n");
+}
+
+static void pressCounter() {
+    // The gate changes on release: a long press has left the mode by then
+}
+
+static void releaseCounter() {
+    if (counter_entry_release) {
+        // Release of the press that chose COUNT in the menu
+        counter_entry_release = false;
+        return;
+    }
+    counter_gate = (uint8_t)((counter_gate + 1) % (LA_NUM_CHANNELS + 1));
+    startCounter();
+    if (counter_gate == 0) {
+        Log_Printf("Count: no gate, counters restarted\r\n");
+    } else {
+        Log_Printf("Count: gated by CH%d high, counters restarted\r\n", counter_gate - 1);
+    }
+    display_needs_update = true;
+}
+
+static void rotateCounter(int delta) {
+    counter_channel = (uint8_t)((counter_channel + LA_NUM_CHANNELS + (delta > 0 ? 1 : -1)) % LA_NUM_CHANNELS);
+    display_needs_update = true;
+}
+
+static void pollCounter() {
+    // Advance the rate windows once per second (catching up without
+    // drift) and report over USB every minute
+    while (HAL_GetTick() - counter_tick_time >= COUNTER_TICK_MS) {
+        counter_tick_time += COUNTER_TICK_MS;
+        event_counter.tick();
+        uint32_t seconds = event_counter.seconds();
+        if (seconds != 0 && seconds % COUNTER_REPORT_S == 0) {
+            logCounterReport(event_counter);
+        }
+        display_needs_update = true;
+    }
+}
+
+static void leaveCounter() {
+    logCounterReport(event_counter);
+    event_counter.stop();
+    Log_Printf("Count mode OFF\r\n");
+}
+
+static void drawCounter() {
+    drawCounterView(event_counter, counter_channel);
+}
+
+// -- Pattern: rotate switches the generated pattern (output restarts) --
+
+static void startPattern() {
+    buildPattern((capture::PatternBuilder::Pattern)pattern_index);
+    g_port_dma->configure(PATTERN_DIVIDER);
+    g_port_dma->startOutput(pattern_words, PATTERN_PERIOD);
+    g_port_dma->run();
+}
+
+static void enterPattern(uint8_t) {
+    startPattern();
+    Log_Printf("Pattern mode ON (%s at %lu Hz on PB0/PB1/PB8/PB9) - rotate to select, press to exit\r\n",
+               capture::PatternBuilder::patternName((capture::PatternBuilder::Pattern)pattern_index),
+               g_port_dma->rate());
+}
+
+static void rotatePattern(int delta) {
+    pattern_index = (uint8_t)((pattern_index + NUM_PATTERNS + (delta > 0 ? 1 : -1)) % NUM_PATTERNS);
+    g_port_dma->stop();
+    startPattern();
+    Log_Printf("Pattern: %s\r\n", capture::PatternBuilder::patternName((capture::PatternBuilder::Pattern)pattern_index));
+    display_needs_update = true;
+}
+
+static void leavePattern() {
+    g_port_dma->stop();
+    Log_Printf("Pattern mode OFF\r\n");
+}
+
+static void drawPattern() {
+    drawPatternView((capture::PatternBuilder::Pattern)pattern_index);
+}
+
+// -- Self-test: runs once on entry --
+
+static void enterSelfTest(uint8_t) {
+    Log_Printf("Selftest: loopback PB0->PA8, PB1->PA15, PB8->PA6, PB9->PA2\r\n");
+    runSelfTest(selftest_results);
+    Log_Printf("Selftest done - press to exit\r\n");
+}
+
+static void drawSelfTest() {
+    drawSelfTestView(selftest_results);
+}
+
+// -- Burst: calibrated on entry, rotate captures again --
+
+static void enterBurst(uint8_t) {
+    burstSampler().calibrate(burst_samples);
+    burst_cycles = captureBurst(burstSampler());
+    Log_Printf("Burst mode ON - rotate to capture again, press to exit\r\n");
+    logBurst(burstSampler().calibration(), burst_cycles);
+}
+
+static void rotateBurst(int) {
+    burst_cycles = captureBurst(burstSampler());
+    logBurst(burstSampler().calibration(), burst_cycles);
+    display_needs_update = true;
+}
+
+static void drawBurst() {
+    drawBurstView(burstSampler().calibration(), burst_cycles);
+}
+
+// -- USB bench: runs once on entry, blocking (variant 1: vendor bulk) --
+
+static void enterUsbBench(uint8_t variant) {
+    measure::UsbBench::Pipe pipe = (variant == 0) ? measure::UsbBench::Pipe::Cdc : measure::UsbBench::Pipe::Bulk;
+    const char* pipe_name = (variant == 0) ? "CDC" : "bulk";
+    if (g_oled != nullptr) {
+        g_oled->clear();
+        g_oled->drawString(0, 0, (variant == 0) ? "USB BENCH RUNNING" : "BULK BENCH RUNNING", 1);
+        g_oled->update();
+    }
+    // Log lines in the CDC stream would break the host's frame check
+    Log_SetUsbPaused(pipe == measure::UsbBench::Pipe::Cdc);
+    usb_bench_ran = measure::UsbBench::run(pipe, USB_BENCH_SECONDS, usb_bench_result);
+    Log_SetUsbPaused(false);
+    if (usb_bench_ran) {
+        const measure::UsbBench::Result& r = usb_bench_result;
+        Log_Printf("USB bench (%s): %lu bytes in %lu ms = %lu B/s, %lu transfers, %lu busy, %lu starved, %s\r\n",
+                   pipe_name, r.bytes, r.elapsed_ms, r.bytes_per_s, r.transfers, r.busy, r.starved,
+                   r.drained ? "drained" : "not drained");
+    } else {
+        usb_bench_result.pipe = pipe;
+        usb_bench_result.seconds = USB_BENCH_SECONDS;
+        Log_Printf("USB bench (%s): no host reading, start frame not sent\r\n", pipe_name);
+    }
+}
+
+static void drawUsbBench() {
+    drawUsbBenchView(usb_bench_result, usb_bench_ran);
+}
+
+// Self-test and USB bench leave the rotation to the waveform behind them
+static const ModeHandlers MODE_HANDLERS[] = {
+    // name       enter           press          release         rotate           poll         leave         draw
+    {"Normal",    nullptr,        pressNormal,   nullptr,        rotateNormal,    nullptr,     nullptr,      drawNormal},
+    {"Menu",      nullptr,        enterMenuItem, nullptr,        rotateMenu,      nullptr,     nullptr,      drawMenu},
+    {"Zoom",      enterZoom,      nullptr,       nullptr,        rotateZoom,      nullptr,     leaveZoom,    drawZoom},
+    {"Search",    enterSearch,    nullptr,       nullptr,        rotateSearch,    nullptr,     nullptr,      drawSearch},
+    {"Meter",     enterMeter,     nullptr,       nullptr,        rotateMeter,     pollMeter,   leaveMeter,   drawMeter},
+    {"Histogram", enterHistogram, nullptr,       nullptr,        rotateHistogram, nullptr,     nullptr,      drawHistogram},
+    {"Cursor",    enterCursor,    pressCursor,   nullptr,        rotateCursor,    nullptr,     nullptr,      drawCursor},
+    {"Timing",    enterTiming,    nullptr,       nullptr,        rotateTiming,    nullptr,     nullptr,      drawTiming},
+    {"Compare",   enterCompare,   nullptr,       nullptr,        rotateCompare,   pollCompare, leaveCompare, drawCompare},
+    {"Count",     enterCounter,   pressCounter,  releaseCounter, rotateCounter,   pollCounter, leaveCounter, drawCounter},
+    {"Pattern",   enterPattern,   nullptr,       nullptr,        rotatePattern,   nullptr,     leavePattern, drawPattern},
+    {"Selftest",  enterSelfTest,  nullptr,       nullptr,        rotateNormal,    nullptr,     nullptr,      drawSelfTest},
+    {"Burst",     enterBurst,     nullptr,       nullptr,        rotateBurst,     nullptr,     nullptr,      drawBurst},
+    {"USB bench", enterUsbBench,  nullptr,       nullptr,        rotateNormal,    nullptr,     nullptr,      drawUsbBench},
+};
+static_assert(sizeof(MODE_HANDLERS) / sizeof(MODE_HANDLERS[0]) == (size_t)ViewMode::COUNT,
+              "one MODE_HANDLERS row per ViewMode");
+
+static const ModeHandlers& modeHandlers() {
+    return MODE_HANDLERS[(uint8_t)view_mode];
+}
+
+// Short press in the menu: enter the selected item
+static void enterMenuItem() {
+    const MenuItem& item = MENU_ITEMS[menu_index];
+    view_mode = item.mode;
+    if (modeHandlers().enter != nullptr) {
+        modeHandlers().enter(item.variant);
+    }
+    display_needs_update = true;
+}
+
+static void leaveMode() {
+    const ModeHandlers& handlers = modeHandlers();
+    if (handlers.leave != nullptr) {
+        handlers.leave();
+    } else {
+        Log_Printf("%s mode OFF\r\n", handlers.name);
+    }
+    view_mode = ViewMode::Normal;
+    display_needs_update = true;
+}
+
+static void buttonPressed() {
+    if (modeHandlers().press != nullptr) {
+        modeHandlers().press();
+    } else {
+        leaveMode();
+    }
+}
+
+static void buttonReleased() {
+    if (modeHandlers().release != nullptr) {
+        modeHandlers().release();
+    } else {
+        Log_Printf("Enter button released\r\n");
+    }
+}
+
+// Long press opens the menu from the normal view and leaves the modes
+// that keep the short press for themselves (not the menu, where the
+// short press enters an item)
+static void buttonLongPress() {
+    if (view_mode == ViewMode::Normal && logic_analyzer_shown) {
+        cancelCapture();
+        view_mode = ViewMode::Menu;
+        Log_Printf("Menu: %s - rotate to select, press to enter\r\n", MENU_ITEMS[menu_index].name);
+        display_needs_update = true;
+    } else if (view_mode != ViewMode::Normal && view_mode != ViewMode::Menu && modeHandlers().press != nullptr) {
+        leaveMode();
+    } else {
+        Log_Printf("Enter button long press detected\r\n");
+        Log_Printf("Current pos: %d (reset to 0)\r\n", g_encoder->getPosition());
+    }
+}
+
+// Console commands that touch capture state, forwarded by the shell task
+static void runCaptureCommand(const shell::Command& command) {
+    const uint32_t* args = command.args;
+    if (command.op == shell::Op::Rate) {
+        if (command.argc == 1) {
+            // Nearest of the rates auto-set uses
+            uint8_t best = 0;
+            for (uint8_t k = 1; k < NUM_SAMPLE_RATES; k++) {
+                uint32_t distance = (SAMPLE_RATES[k] > args[0]) ? SAMPLE_RATES[k] - args[0]
+                                                                : args[0] - SAMPLE_RATES[k];
+                uint32_t best_distance = (SAMPLE_RATES[best] > args[0]) ? SAMPLE_RATES[best] - args[0]
+                                                                        : args[0] - SAMPLE_RATES[best];
+                if (distance < best_distance) {
+                    best = k;
+                }
+            }
+            sample_rate_index = best;
+            display_needs_update = true;
+        }
+        Log_Printf("rate: %sS/s\r\n", SAMPLE_RATE_NAMES[sample_rate_index]);
+    } else if (command.op == shell::Op::Dump) {
+        uint32_t first = (command.argc >= 2) ? args[1] : 0;
+        uint32_t count = (command.argc >= 3) ? args[2] : SHELL_DUMP_DEFAULT;
+        if ((shell::DumpBuffer)args[0] == shell::DumpBuffer::Events) {
+            dumpEvents(first, (count < SHELL_DUMP_MAX_EVENTS) ? count : SHELL_DUMP_MAX_EVENTS);
+        } else if ((shell::DumpBuffer)args[0] == shell::DumpBuffer::Burst) {
+            dumpWords("burst", burst_samples, capture::BurstSampler::SAMPLES, first,
+                      (count < SHELL_DUMP_MAX_WORDS) ? count : SHELL_DUMP_MAX_WORDS);
+        } else {
+            dumpWords("selftest", selftest_samples, SELFTEST_SAMPLES, first,
+                      (count < SHELL_DUMP_MAX_WORDS) ? count : SHELL_DUMP_MAX_WORDS);
+        }
+    } else if (command.op == shell::Op::Decode) {
+        if (command.argc != 0) {
+            if (args[0] >= LA_NUM_CHANNELS) {
+                Log_Printf("err: no channel %lu\r\n", args[0]);
+                return;
+            }
+            // The shown capture is decoded again right away
+            decoder_set.set((uint8_t)args[0], (decode::Protocol)args[1], (command.argc == 3) ? args[2] : 0);
+            decodeCapture();
+            display_needs_update = true;
+        }
+        for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+            const decode::DecoderSet::Channel& channel = decoder_set.channel(ch);
+            if (channel.bitrate != 0) {
+                Log_Printf("decode: CH%d %s %lu\r\n", ch, decode::protocolName(channel.protocol), channel.bitrate);
+            } else {
+                Log_Printf("decode: CH%d %s\r\n", ch, decode::protocolName(channel.protocol));
+            }
+        }
+        if (capture_taken) {
+            Log_Printf("decode: %lu events, %lu dropped\r\n", (g_events != nullptr) ? g_events->size() : 0,
+                       (g_events != nullptr) ? g_events->dropped() : 0);
+        } else {
+            Log_Printf("decode: no capture yet (press in the normal view)\r\n");
+        }
+    }
+}
+
+// Requests on the bulk pipe: the OLED mirror (host/la_mirror) and
+// streaming capture (host/la_capture), which blocks until it ends. The
+// other modes keep the DMA to themselves.
+static void serviceBulkRequests() {
+    static uint8_t stream_packet[BULK_FS_MAX_PACKET_SIZE];
+    uint32_t packet_length = BULK_ReadPacket_FS(stream_packet);
+    display::FrameMirror::Request mirror_request = display::FrameMirror::parseCommand(stream_packet, packet_length);
+    if (mirror_request != display::FrameMirror::Request::None && g_oled != nullptr) {
+        bool on = (mirror_request == display::FrameMirror::Request::On);
+        g_oled->setMirror(on ? &frame_mirror : nullptr);
+        Log_Printf("Mirror: %s\r\n", on ? "on" : "off");
+    }
+    capture::PortStream::Command command = capture::PortStream::parseCommand(stream_packet, packet_length);
+    if (command.type != capture::PortStream::Command::Type::Start) {
+        return;
+    }
+    if (view_mode != ViewMode::Normal) {
+        capture::PortStream::refuse(capture::PortStream::Status::Busy);
+        Log_Printf("Stream: refused, leave %s first\r\n", MENU_ITEMS[menu_index].name);
+        return;
+    }
+    cancelCapture();
+    if (g_oled != nullptr) {
+        // The stream owns the pipe now (a mirror left on by a host that
+        // went away would get in its way)
+        g_oled->setMirror(nullptr);
+        g_oled->clear();
+        g_oled->drawString(0, 0, "STREAMING", 1);
+        g_oled->update();
+    }
+    capture::PortStream::Result result;
+    capture::PortStream::run(*g_port_dma, command, channel_port_bits, result);
+    // newlib-nano printf has no %llu
+    Log_Printf("Stream: %lu Hz, %lu samples in %lu ms, status %lu\r\n", result.rate_hz, (uint32_t)result.samples,
+               result.elapsed_ms, (uint32_t)result.status);
+    if (result.encoding == capture::PortStream::Encoding::Compressed && result.wire_bytes != 0) {
+        uint32_t ratio_x100 = (uint32_t)(result.samples * 200 / result.wire_bytes);
+        Log_Printf("Stream: %lu KB sent, %lu.%02lu:1, %lu cycles/KB\r\n", (uint32_t)(result.wire_bytes / 1024),
+                   ratio_x100 / 100, ratio_x100 % 100, result.cycles_per_kb);
+    }
+    if (result.sync_frames != 0) {
+        Log_Printf("Stream: %lu sync frames\r\n", result.sync_frames);
+    }
+    display_needs_update = true;
+}
+
+// Encoder test screen (TEST_BTN held at reset): position, delta and button
+// state until PA0 is pressed again
+static void runEncoderTest() {
+    static int last_position = 0;
+    static bool last_btn_state = true;
+    static bool last_long_press = false;
+    static bool last_pa0_state = true;  // Start as released
+    static bool test_mode_ready = false;  // Flag to indicate PA0 was released
+
+    // Wait for PA0 to be released before activating test mode
+    bool pa0_pressed = (HAL_GPIO_ReadPin(TEST_BTN_GPIO_Port, TEST_BTN_Pin) == GPIO_PIN_RESET);
+
+    if (!test_mode_ready) {
+        // Waiting for PA0 to be released
+        if (!pa0_pressed) {
+            // PA0 released - now test mode is ready
+            test_mode_ready = true;
+            last_pa0_state = false;
+            Log_Printf("[TEST] Test mode ready - PA0 released\r\n");
+        }
+        // Show waiting message
+        if (g_oled != nullptr) {
+            static bool msg_shown = false;
+            if (!msg_shown) {
+                g_oled->clear();
+                g_oled->drawString(0, 24, "Release PA0...", 1);
+                g_oled->update();
+                msg_shown = true;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+        return;
+    }
+
+    // Check PA0 button for exit from test mode (only when test mode is ready)
+    if (pa0_pressed && !last_pa0_state) {
+        // PA0 pressed - exit test mode
+        g_test_mode = false;
+        test_mode_ready = false;
+        Log_Printf("[TEST] Exit test mode - PA0 pressed\r\n");
+
+        // Clear display and show message
+        if (g_oled != nullptr) {
+            g_oled->clear();
+            g_oled->drawString(0, 24, "Exiting test...", 1);
+            g_oled->update();
+            HAL_Delay(500);
+        }
+
+        // Continue to normal mode
+        return;
+    }
+    last_pa0_state = pa0_pressed;
+
+    int current_position = g_encoder->getPosition();
+    bool button_pressed = g_encoder->isButtonPressed();
+    bool long_press = g_encoder->isLongPress();
+
+    // Handle long press - reset position to 0
+    if (long_press && !last_long_press) {
+        g_encoder->resetPosition();
+        current_position = 0;
+        Log_Printf("[TEST] Position reset to 0 (long press)\r\n");
+        last_long_press = true;
+    }
+    if (!long_press) {
+        last_long_press = false;
+    }
+
+    // Display test mode info on OLED (update every 50ms max)
+    static uint32_t last_display_update = 0;
+    uint32_t current_time = HAL_GetTick();
+    bool force_update = (current_position != last_position || button_pressed != last_btn_state);
+
+    if (g_oled != nullptr && force_update && (current_time - last_display_update >= 50)) {
+        char buffer[32];
+
+        g_oled->clear();
+
+        // Title
+        g_oled->drawString(0, 0, "***TEST MODE***", 1);
+
+        // Position with delta
+        int delta = current_position - last_position;
+        snprintf(buffer, sizeof(buffer), "Pos:%d D:%+d", current_position, delta);
+        g_oled->drawString(0, 16, buffer, 1);
+
+        // Button state
+        if (button_pressed) {
+            g_oled->drawString(0, 32, "ENC: PRESSED", 1);
+        } else {
+            g_oled->drawString(0, 32, "ENC: RELEASED", 1);
+        }
+
+        // Exit instruction
+        g_oled->drawString(0, 48, "PA0: EXIT", 1);
+
+        g_oled->update();
+
+        last_display_update = current_time;
+        last_position = current_position;
+        last_btn_state = button_pressed;
+    }
+
+    // Log encoder changes (throttled to avoid flooding)
+    static uint32_t last_log_time = 0;
+    int delta = g_encoder->getDelta();
+    if (delta != 0 && (current_time - last_log_time >= 100)) {
+        Log_Printf("[TEST] Pos: %d, Delta: %d\r\n", current_position, delta);
+        last_log_time = current_time;
+    }
+
+    // Log button state changes
+    if (button_pressed != last_btn_state) {
+        if (button_pressed) {
+            Log_Printf("[TEST] Button PRESSED\r\n");
+        } else {
+            Log_Printf("[TEST] Button RELEASED\r\n");
+        }
+    }
+
+    // Run at 500Hz in test mode (2ms) for fast encoder response
+    vTaskDelay(pdMS_TO_TICKS(2));
 }
 
 // Task handles (using CMSIS-RTOS types)
 osThreadId_t ledTaskHandle = nullptr;
 osThreadId_t testTaskHandle = nullptr;
+osThreadId_t shellTaskHandle = nullptr;
 
 // Shared resources (defined in main.cpp, declared in Tasks.h)
 // No need to define here - they are extern in Tasks.h
@@ -149,6 +2047,8 @@ void ledTask(void* argument) {
  * - Prints startup banner after button press or 5 sec timeout (for USB enumeration)
  * - After banner (4 seconds), shows logic analyzer display permanently
  * - Encoder rotation scrolls the display horizontally
+ *
+ * Button, rotation and drawing go to the active view's MODE_HANDLERS row.
  */
 void testTask(void* argument) {
     (void)argument;
@@ -156,19 +2056,8 @@ void testTask(void* argument) {
     static bool last_button_state = true;
     static bool last_long_press = false;
     static bool startup_banner_printed = false;
-    static bool logic_analyzer_shown = false;
     static uint32_t banner_time = 0;
     static uint32_t startup_time = 0;
-    static uint16_t scroll_offset = 0;  // Horizontal scroll position
-    static uint16_t max_scroll = 0;     // Maximum scroll value
-    static bool display_needs_update = false;
-
-    // Zoom mode variables
-    static bool zoom_mode = false;      // True when in zoom adjustment mode
-    static float zoom_level = 1.0f;     // Current zoom level (0.5x, 1.0x, 2.0x, 4.0x, 8.0x)
-    static const float zoom_levels[] = {0.5f, 1.0f, 2.0f, 4.0f, 8.0f};
-    static const uint8_t num_zoom_levels = sizeof(zoom_levels) / sizeof(zoom_levels[0]);
-    static uint8_t current_zoom_index = 1;  // Start at 1.0x (index 1)
 
     // Screen saver variables
     static uint32_t last_activity_time = 0;  // Last encoder activity timestamp
@@ -182,145 +2071,22 @@ void testTask(void* argument) {
     // Calculate maximum scroll (once)
     // Max scroll = total signal length - visible width (120 pixels)
     // Use CH0 as reference (all channels should be similar length)
-    uint16_t total_signal_length = calculateSignalLength(logic_ch0_data, sizeof(logic_ch0_data));
-    uint16_t visible_width = 120;  // ~120 pixels visible area after label
-    if (total_signal_length > visible_width) {
-        max_scroll = total_signal_length - visible_width;
-    } else {
-        max_scroll = 0;  // No scrolling needed if signal fits on screen
-    }
+    total_signal_length = calculateSignalLength(logic_ch0_data, sizeof(logic_ch0_data));
+    max_scroll = maxScrollFor(total_signal_length, zoom_level);
 
     for(;;) {
         if (g_encoder != nullptr) {
-            // Update encoder state
+            // Update encoder state. Double click is the normal view's
+            // auto-set: presses in other views (the one leaving a mode,
+            // menu selections) must not count towards it.
+            g_encoder->setDoubleClickEnabled(logic_analyzer_shown && view_mode == ViewMode::Normal);
             g_encoder->update();
 
-            // === TEST MODE ===
-            // If TEST_BTN was pressed at startup, enter test mode
+            // If TEST_BTN was pressed at startup, run the encoder test screen
             if (g_test_mode) {
-                static int last_position = 0;
-                static bool last_btn_state = true;
-                static bool last_long_press = false;
-                static bool last_pa0_state = true;  // Start as released
-                static bool test_mode_ready = false;  // Flag to indicate PA0 was released
-
-                // Wait for PA0 to be released before activating test mode
-                bool pa0_pressed = (HAL_GPIO_ReadPin(TEST_BTN_GPIO_Port, TEST_BTN_Pin) == GPIO_PIN_RESET);
-
-                if (!test_mode_ready) {
-                    // Waiting for PA0 to be released
-                    if (!pa0_pressed) {
-                        // PA0 released - now test mode is ready
-                        test_mode_ready = true;
-                        last_pa0_state = false;
-                        Log_Printf("[TEST] Test mode ready - PA0 released\r\n");
-                    }
-                    // Show waiting message
-                    if (g_oled != nullptr) {
-                        static bool msg_shown = false;
-                        if (!msg_shown) {
-                            g_oled->clear();
-                            g_oled->drawString(0, 24, "Release PA0...", 1);
-                            g_oled->update();
-                            msg_shown = true;
-                        }
-                    }
-                    vTaskDelay(pdMS_TO_TICKS(10));
-                    continue;
-                }
-
-                // Check PA0 button for exit from test mode (only when test mode is ready)
-                if (pa0_pressed && !last_pa0_state) {
-                    // PA0 pressed - exit test mode
-                    g_test_mode = false;
-                    test_mode_ready = false;
-                    Log_Printf("[TEST] Exit test mode - PA0 pressed\r\n");
-
-                    // Clear display and show message
-                    if (g_oled != nullptr) {
-                        g_oled->clear();
-                        g_oled->drawString(0, 24, "Exiting test...", 1);
-                        g_oled->update();
-                        HAL_Delay(500);
-                    }
-
-                    // Continue to normal mode
-                    continue;
-                }
-                last_pa0_state = pa0_pressed;
-
-                int current_position = g_encoder->getPosition();
-                bool button_pressed = g_encoder->isButtonPressed();
-                bool long_press = g_encoder->isLongPress();
-
-                // Handle long press - reset position to 0
-                if (long_press && !last_long_press) {
-                    g_encoder->resetPosition();
-                    current_position = 0;
-                    Log_Printf("[TEST] Position reset to 0 (long press)\r\n");
-                    last_long_press = true;
-                }
-                if (!long_press) {
-                    last_long_press = false;
-                }
-
-                // Display test mode info on OLED (update every 50ms max)
-                static uint32_t last_display_update = 0;
-                uint32_t current_time = HAL_GetTick();
-                bool force_update = (current_position != last_position || button_pressed != last_btn_state);
-
-                if (g_oled != nullptr && force_update && (current_time - last_display_update >= 50)) {
-                    char buffer[32];
-
-                    g_oled->clear();
-
-                    // Title
-                    g_oled->drawString(0, 0, "***TEST MODE***", 1);
-
-                    // Position with delta
-                    int delta = current_position - last_position;
-                    snprintf(buffer, sizeof(buffer), "Pos:%d D:%+d", current_position, delta);
-                    g_oled->drawString(0, 16, buffer, 1);
-
-                    // Button state
-                    if (button_pressed) {
-                        g_oled->drawString(0, 32, "ENC: PRESSED", 1);
-                    } else {
-                        g_oled->drawString(0, 32, "ENC: RELEASED", 1);
-                    }
-
-                    // Exit instruction
-                    g_oled->drawString(0, 48, "PA0: EXIT", 1);
-
-                    g_oled->update();
-
-                    last_display_update = current_time;
-                    last_position = current_position;
-                    last_btn_state = button_pressed;
-                }
-
-                // Log encoder changes (throttled to avoid flooding)
-                static uint32_t last_log_time = 0;
-                int delta = g_encoder->getDelta();
-                if (delta != 0 && (current_time - last_log_time >= 100)) {
-                    Log_Printf("[TEST] Pos: %d, Delta: %d\r\n", current_position, delta);
-                    last_log_time = current_time;
-                }
-
-                // Log button state changes
-                if (button_pressed != last_btn_state) {
-                    if (button_pressed) {
-                        Log_Printf("[TEST] Button PRESSED\r\n");
-                    } else {
-                        Log_Printf("[TEST] Button RELEASED\r\n");
-                    }
-                }
-
-                // Run at 500Hz in test mode (2ms) for fast encoder response
-                vTaskDelay(pdMS_TO_TICKS(2));
-                continue;  // Skip normal logic analyzer mode
+                runEncoderTest();
+                continue;
             }
-            // === END TEST MODE ===
 
             // Check for any encoder activity (button or rotation)
             int delta = g_encoder->getDelta();
@@ -354,7 +2120,6 @@ void testTask(void* argument) {
             // Print startup banner after button press OR 3 sec timeout
             // This gives USB CDC time to enumerate
             if (!startup_banner_printed) {
-                // Note: button_pressed already declared above for activity detection
                 uint32_t elapsed = HAL_GetTick() - startup_time;
 
                 if (button_pressed || elapsed >= 3000) {
@@ -366,7 +2131,6 @@ void testTask(void* argument) {
 
             // Show logic analyzer display 3 seconds after banner, OR immediately if button pressed
             if (startup_banner_printed && !logic_analyzer_shown) {
-                // Note: button_pressed already declared above for activity detection
                 uint32_t elapsed_since_banner = HAL_GetTick() - banner_time;
 
                 if (button_pressed || (elapsed_since_banner >= 3000 && g_oled != nullptr)) {
@@ -377,154 +2141,51 @@ void testTask(void* argument) {
                 }
             }
 
-            // Handle button press/release
-            // Note: button_pressed already declared above for activity detection
-
+            // Button press/release and long press go to the active view
             if (button_pressed != last_button_state) {
                 if (button_pressed) {
-                    // Short press exits zoom mode
-                    if (zoom_mode && logic_analyzer_shown) {
-                        zoom_mode = false;
-                        Log_Printf("Zoom mode OFF (zoom=%.1fx)\r\n", zoom_level);
-                        display_needs_update = true;  // Update display to show normal mode
-                    } else {
-                        Log_Printf("Enter button pressed\r\n");
-                    }
+                    buttonPressed();
                 } else {
-                    Log_Printf("Enter button released\r\n");
+                    buttonReleased();
                 }
                 last_button_state = button_pressed;
             }
-
-            // Handle long press - enters zoom mode (after logic analyzer is shown)
             if (g_encoder->isLongPress() && !last_long_press) {
                 last_long_press = true;
-                if (logic_analyzer_shown && !zoom_mode) {
-                    zoom_mode = true;
-                    Log_Printf("Zoom mode ON (zoom=%.1fx) - rotate to adjust, press to exit\r\n", zoom_level);
-                    display_needs_update = true;
-                } else {
-                    Log_Printf("Enter button long press detected\r\n");
-                    Log_Printf("Current pos: %d (reset to 0)\r\n", g_encoder->getPosition());
-                }
+                buttonLongPress();
             }
             if (!g_encoder->isLongPress()) {
                 last_long_press = false;
             }
 
-            // Handle encoder rotation (after LA is shown)
-            // Note: delta already declared above for activity detection
-            int pos = g_encoder->getPosition();
-
-            if (delta != 0 && logic_analyzer_shown) {
-                if (zoom_mode) {
-                    // ZOOM MODE: Adjust zoom level
-                    // CW rotation = zoom in (increase zoom)
-                    // CCW rotation = zoom out (decrease zoom)
-                    int8_t new_zoom_index = current_zoom_index;
-
-                    if (delta > 0) {
-                        // Zoom in - increase index (up to max)
-                        if (new_zoom_index < (num_zoom_levels - 1)) {
-                            new_zoom_index++;
-                        }
-                    } else {
-                        // Zoom out - decrease index (down to 0)
-                        if (new_zoom_index > 0) {
-                            new_zoom_index--;
-                        }
-                    }
+            // Double click in the normal view: auto-set
+            if (g_encoder->getDoubleClick() && logic_analyzer_shown && view_mode == ViewMode::Normal) {
+                autoSet();
+            }
 
-                    // Update zoom if changed
-                    if (new_zoom_index != current_zoom_index) {
-                        current_zoom_index = new_zoom_index;
-                        zoom_level = zoom_levels[current_zoom_index];
-                        display_needs_update = true;
-
-                        // Recalculate max_scroll based on new zoom
-                        uint16_t zoomed_signal_length = (uint16_t)(total_signal_length * zoom_level);
-                        if (zoomed_signal_length > visible_width) {
-                            max_scroll = zoomed_signal_length - visible_width;
-                        } else {
-                            max_scroll = 0;
-                        }
-
-                        // Clamp scroll offset to new max
-                        if (scroll_offset > max_scroll) {
-                            scroll_offset = max_scroll;
-                        }
-
-                        if (delta > 0) {
-                            Log_Printf("Zoom IN: %.1fx (max_scroll=%d)\r\n", zoom_level, max_scroll);
-                        } else {
-                            Log_Printf("Zoom OUT: %.1fx (max_scroll=%d)\r\n", zoom_level, max_scroll);
-                        }
-                    }
-                } else {
-                    // NORMAL MODE: Scroll horizontally
-                    // CW rotation = scroll right (show left part of signal)
-                    // CCW rotation = scroll left (show right part of signal)
-                    int16_t new_offset = scroll_offset + (delta * 4);  // 4 pixels per encoder click
-
-                    // Clamp to valid range: [0, max_scroll]
-                    if (new_offset < 0) {
-                        new_offset = 0;
-                    } else if (new_offset > max_scroll) {
-                        new_offset = max_scroll;
-                    }
+            // Rotation and periodic work of the active view (after LA is shown)
+            if (delta != 0 && logic_analyzer_shown && modeHandlers().rotate != nullptr) {
+                modeHandlers().rotate(delta);
+            }
+            if (modeHandlers().poll != nullptr) {
+                modeHandlers().poll();
+            }
+            pollCapture();
 
-                    // Only update if offset actually changed
-                    if (new_offset != scroll_offset) {
-                        scroll_offset = new_offset;
-                        display_needs_update = true;  // Mark display for update
+            shell::Command shell_command;
+            while (g_shell_queue != nullptr && osMessageQueueGet(g_shell_queue, &shell_command, nullptr, 0) == osOK) {
+                runCaptureCommand(shell_command);
+            }
 
-                        if (delta > 0) {
-                            Log_Printf("Scroll right: offset=%d, pos=%d (CW, delta=%d)\r\n", scroll_offset, pos, delta);
-                        } else {
-                            Log_Printf("Scroll left: offset=%d, pos=%d (CCW, delta=%d)\r\n", scroll_offset, pos, delta);
-                        }
-                    }
-                }
+            if (logic_analyzer_shown) {
+                serviceBulkRequests();
             }
 
-            // Update display ONLY when needed (offset changed or first display) AND display is on
+            // Update display ONLY when needed AND display is on
             if (logic_analyzer_shown && g_oled != nullptr && display_needs_update && display_is_on) {
-                // Clear display
                 g_oled->clear();
-
-                // Draw mode indicator in top-left corner
-                if (zoom_mode) {
-                    // Show "ZOOM" and current zoom level
-                    char zoom_str[12];
-                    snprintf(zoom_str, sizeof(zoom_str), "Z:%.1fx", zoom_level);
-                    g_oled->drawString(0, 0, zoom_str, 1);
-                } else {
-                    // Show "NORM" in normal scrolling mode
-                    g_oled->drawString(0, 0, "NORM", 1);
-                }
-
-                // Prepare channel data for drawing
-                const uint8_t* channel_data[4] = {
-                    logic_ch0_data,
-                    logic_ch1_data,
-                    logic_ch2_data,
-                    logic_ch3_data
-                };
-
-                const uint16_t data_lengths[4] = {
-                    sizeof(logic_ch0_data),
-                    sizeof(logic_ch1_data),
-                    sizeof(logic_ch2_data),
-                    sizeof(logic_ch3_data)
-                };
-
-                // Draw all 4 channels with current scroll offset and zoom level
-                g_oled->drawLogicChannels(channel_data, data_lengths, 4, 0, 16, scroll_offset, zoom_level, 1);
-
-                // Update display
+                modeHandlers().draw();
                 g_oled->update();
-
-                // Clear update flag
                 display_needs_update = false;
             }
         }
@@ -533,3 +2194,41 @@ void testTask(void* argument) {
         vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
+
+/**
+ * @brief Shell Task - console commands from the USB CDC port
+ *
+ * The CDC receive interrupt only copies bytes into a ring and sets a
+ * thread flag; this task drains the ring into the command parser and
+ * answers on the console. Capture commands are queued to testTask.
+ */
+void shellTask(void* argument) {
+    (void)argument;
+
+    static shell::CommandParser parser;
+    CDC_SetRxCallback_FS(shellRxNotify);
+
+    for (;;) {
+        uint32_t flags = osThreadFlagsWait(SHELL_RX_FLAG, osFlagsWaitAny, pdMS_TO_TICKS(SHELL_FRAME_TIMEOUT_MS));
+        if ((flags & osFlagsError) != 0) {
+            // Nothing for a while: a frame cut off by the host would
+            // otherwise swallow the next command
+            if (parser.inFrame()) {
+                parser.reset();
+                Log_Printf("err: frame timed out\r\n");
+            }
+            continue;
+        }
+
+        uint8_t buffer[32];
+        uint32_t length;
+        while ((length = CDC_Read_FS(buffer, sizeof(buffer))) != 0) {
+            for (uint32_t k = 0; k < length; k++) {
+                shell::Command command;
+                if (parser.feed(buffer[k], command)) {
+                    runShellCommand(command);
+                }
+            }
+        }
+    }
+}
@@ -5,15 +5,39 @@
 #include "Led.h"
 #include "Encoder.h"
 #include "Oled.hpp"
+#include "AutoSet.hpp"
+#include "BitPlanes.hpp"
+#include "BurstSampler.hpp"
+#include "CaptureCompare.hpp"
+#include "CommandParser.hpp"
+#include "DecoderSet.hpp"
+#include "EventStore.hpp"
+#include "EdgeIndex.hpp"
+#include "EventCounter.hpp"
+#include "FreqMeter.hpp"
+#include "PatternBuilder.hpp"
+#include "PortDma.hpp"
+#include "PortStream.hpp"
+#include "PulseStats.hpp"
+#include "TimingAnalysis.hpp"
+#include "TransitionEncoder.hpp"
+#include "UartTx.hpp"
+#include "UsbBench.hpp"
 
 // Task handles (using CMSIS-RTOS types)
 extern osThreadId_t ledTaskHandle;
 extern osThreadId_t testTaskHandle;
+extern osThreadId_t shellTaskHandle;
 
 // Shared resources
 extern Led* g_led;
 extern Encoder* g_encoder;
 extern display::Oled* g_oled;
+extern decode::EventStore* g_events;  // Decoded events of the current capture
+extern measure::FreqMeter* g_meters[];  // Per-channel meters (LA_NUM_CHANNELS)
+extern capture::PortDma* g_port_dma;    // Pattern generator / loopback sampler
+extern osMessageQueueId_t g_shell_queue; // shell::Command, shellTask -> testTask
+extern console::UartTx* g_uart_tx;      // UART console transmit ring
 
 // Test mode flag (set at startup if TEST_BTN pressed)
 extern bool g_test_mode;
@@ -21,5 +45,6 @@ extern bool g_test_mode;
 // Task functions
 void ledTask(void* argument);
 void testTask(void* argument);
+void shellTask(void* argument);
 
 #endif // TASKS_H
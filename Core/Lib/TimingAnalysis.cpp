@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file           : TimingAnalysis.cpp
+  * @brief          : Setup / hold and skew analysis implementation
+  ******************************************************************************
+  */
+
+#include "TimingAnalysis.hpp"
+#include "Decoder.hpp"
+
+namespace measure {
+
+void TimingAnalysis::analyze(const uint8_t* const* data, const uint16_t* lengths,
+                             uint8_t num_channels, uint8_t clock_channel, bool rising,
+                             Result& result) {
+    if (num_channels > MAX_CHANNELS) {
+        num_channels = MAX_CHANNELS;
+    }
+    result.clock_channel = clock_channel;
+    result.rising = rising ? 1 : 0;
+    result.clock_edges = 0;
+    result.skew.clear();
+    for (uint8_t ch = 0; ch < MAX_CHANNELS; ch++) {
+        result.channels[ch].setup.clear();
+        result.channels[ch].hold.clear();
+    }
+    if (clock_channel >= num_channels) {
+        return;
+    }
+
+    decode::EdgeWalker walkers[MAX_CHANNELS];
+    uint32_t last_edge[MAX_CHANNELS];   // Last data edge in the current cycle
+    bool in_cycle[MAX_CHANNELS];        // Channel toggled in the current cycle
+    bool hold_pending[MAX_CHANNELS];    // Waiting for the edge after a clock edge
+    for (uint8_t ch = 0; ch < num_channels; ch++) {
+        walkers[ch].init(data[ch], lengths[ch]);
+        last_edge[ch] = 0;
+        in_cycle[ch] = false;
+        hold_pending[ch] = false;
+    }
+
+    uint32_t clock_time = 0;
+    uint32_t cycle_first = UINT32_MAX;
+    uint32_t cycle_last = 0;
+    uint8_t cycle_channels = 0;
+    const uint8_t clock_level = rising ? 1 : 0;
+
+    for (;;) {
+        // Earliest pending edge; on a tie data goes first, so a data edge
+        // at the clock edge is setup 0 rather than hold 0
+        uint8_t ch = MAX_CHANNELS;
+        for (uint8_t c = 0; c < num_channels; c++) {
+            if (walkers[c].done) {
+                continue;
+            }
+            if (ch == MAX_CHANNELS || walkers[c].time < walkers[ch].time ||
+                (walkers[c].time == walkers[ch].time && ch == clock_channel)) {
+                ch = c;
+            }
+        }
+        if (ch == MAX_CHANNELS) {
+            break;
+        }
+
+        decode::EdgeWalker& walker = walkers[ch];
+        uint32_t t = walker.time;
+        if (ch == clock_channel) {
+            if (walker.level == clock_level) {
+                result.clock_edges++;
+                for (uint8_t c = 0; c < num_channels; c++) {
+                    if (in_cycle[c]) {
+                        result.channels[c].setup.add(t - last_edge[c]);
+                        in_cycle[c] = false;
+                    }
+                    hold_pending[c] = (c != clock_channel);
+                }
+                if (cycle_channels >= 2) {
+                    result.skew.add(cycle_last - cycle_first);
+                }
+                cycle_first = UINT32_MAX;
+                cycle_last = 0;
+                cycle_channels = 0;
+                clock_time = t;
+            }
+        } else {
+            if (hold_pending[ch]) {
+                result.channels[ch].hold.add(t - clock_time);
+                hold_pending[ch] = false;
+            }
+            if (!in_cycle[ch]) {
+                // Skew looks at the first edge of each channel in the cycle
+                if (t < cycle_first) cycle_first = t;
+                if (t > cycle_last) cycle_last = t;
+                cycle_channels++;
+            }
+            in_cycle[ch] = true;
+            last_edge[ch] = t;
+        }
+        walker.next();
+    }
+}
+
+} // namespace measure
@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file           : TimingAnalysis.hpp
+  * @brief          : Setup / hold and skew between a clock and data channels
+  ******************************************************************************
+  * One channel is the clock; every other channel is data sampled on the
+  * chosen clock edge. For each data channel:
+  *   setup = clock edge - last data edge in the clock cycle before it
+  *   hold  = first data edge after the clock edge (up to the next clock
+  *           edge) - clock edge
+  * A data edge at the same time as the clock edge counts as setup 0.
+  * Cycles in which a line does not toggle give no sample, so the maxima
+  * stay within one clock period.
+  *
+  * Skew is the spread between the first edges of the data channels that
+  * toggled in the same clock cycle (two or more of them).
+  *
+  * All channels are walked together in time order, one transition list
+  * merged with the others, so the cost is linear in the number of
+  * transition entries whatever the sample rate.
+  ******************************************************************************
+  */
+
+#ifndef TIMING_ANALYSIS_HPP
+#define TIMING_ANALYSIS_HPP
+
+#include <cstdint>
+
+namespace measure {
+
+class TimingAnalysis {
+public:
+    static constexpr uint8_t MAX_CHANNELS = 8;
+
+    /**
+     * @brief Count, minimum and maximum of a series of ticks
+     */
+    struct Range {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+
+        void clear() { count = 0; min = UINT32_MAX; max = 0; }
+        void add(uint32_t value) {
+            count++;
+            if (value < min) min = value;
+            if (value > max) max = value;
+        }
+    };
+
+    struct ChannelResult {
+        Range setup;
+        Range hold;
+    };
+
+    struct Result {
+        uint8_t clock_channel;
+        uint8_t rising;                       ///< 1 = rising clock edge
+        uint32_t clock_edges;
+        ChannelResult channels[MAX_CHANNELS]; ///< Empty for the clock channel
+        Range skew;
+    };
+
+    /**
+     * @brief Analyse a capture in one pass
+     * @param data Transition data of every channel
+     * @param lengths Number of entries of every channel
+     * @param num_channels Number of channels (max MAX_CHANNELS)
+     * @param clock_channel Channel used as clock
+     * @param rising Sample on the rising (true) or falling (false) edge
+     * @param result Filled with the measurements, in ticks
+     */
+    static void analyze(const uint8_t* const* data, const uint16_t* lengths,
+                        uint8_t num_channels, uint8_t clock_channel, bool rising,
+                        Result& result);
+};
+
+} // namespace measure
+
+#endif /* TIMING_ANALYSIS_HPP */
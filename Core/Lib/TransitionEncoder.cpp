@@ -0,0 +1,229 @@
+/**
+  ******************************************************************************
+  * @file           : TransitionEncoder.cpp
+  * @brief          : Port-word to transition encoder implementation
+  ******************************************************************************
+  */
+
+#include "TransitionEncoder.hpp"
+
+namespace capture {
+
+TransitionEncoder::TransitionEncoder(const uint8_t* channel_bits, uint8_t num_channels)
+    : num_channels_(num_channels > MAX_CHANNELS ? MAX_CHANNELS : num_channels),
+      channel_mask_(0), filter_mask_(0), depth_(1),
+      glitch_buffer_(nullptr), glitch_capacity_(0), glitch_count_(0), glitches_dropped_(0),
+      pos_(0), time_(0), filtered_(0), deviating_(0), started_(false), overflow_(false) {
+    for (uint8_t ch = 0; ch < MAX_CHANNELS; ch++) {
+        channels_[ch] = {};
+        channels_[ch].min_width = 1;
+        if (ch < num_channels_) {
+            channels_[ch].bit = 1u << channel_bits[ch];
+            channel_mask_ |= channels_[ch].bit;
+        }
+    }
+    updateMasks();
+}
+
+void TransitionEncoder::setOutput(uint8_t channel, uint8_t* buffer, uint32_t capacity) {
+    if (channel < num_channels_) {
+        channels_[channel].data = buffer;
+        channels_[channel].capacity = (buffer != nullptr) ? capacity : 0;
+        channels_[channel].length = 0;
+    }
+}
+
+void TransitionEncoder::setMinWidth(uint8_t channel, uint8_t samples) {
+    if (channel >= num_channels_) {
+        return;
+    }
+    if (samples < 1) {
+        samples = 1;
+    } else if (samples > MAX_MIN_WIDTH) {
+        samples = MAX_MIN_WIDTH;
+    }
+    channels_[channel].min_width = samples;
+    updateMasks();
+}
+
+void TransitionEncoder::setGlitchCapture(Glitch* buffer, uint32_t capacity) {
+    glitch_buffer_ = buffer;
+    glitch_capacity_ = (buffer != nullptr) ? capacity : 0;
+    glitch_count_ = 0;
+    glitches_dropped_ = 0;
+}
+
+void TransitionEncoder::updateMasks() {
+    for (uint8_t k = 0; k < MAX_MIN_WIDTH; k++) {
+        width_masks_[k] = 0;
+    }
+    filter_mask_ = 0;
+    depth_ = 1;
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        uint8_t width = channels_[ch].min_width;
+        width_masks_[width - 1] |= channels_[ch].bit;
+        if (width > 1) {
+            filter_mask_ |= channels_[ch].bit;
+        }
+        if (width > depth_) {
+            depth_ = width;
+        }
+    }
+}
+
+void TransitionEncoder::reset() {
+    started_ = false;
+    overflow_ = false;
+    time_ = 0;
+    glitch_count_ = 0;
+    glitches_dropped_ = 0;
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        channels_[ch].length = 0;
+    }
+}
+
+void TransitionEncoder::start(uint32_t sample) {
+    // The first sample is taken as settled, so a capture never starts with a glitch
+    for (uint8_t k = 0; k < MAX_MIN_WIDTH; k++) {
+        history_[k] = sample;
+    }
+    pos_ = 0;
+    filtered_ = sample;
+    deviating_ = 0;
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        channels_[ch].level = (sample & channels_[ch].bit) ? 1 : 0;
+        channels_[ch].last_change = time_;
+    }
+    started_ = true;
+}
+
+void TransitionEncoder::encode(const uint16_t* samples, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (!started_) {
+        start(samples[0]);
+    }
+
+    const uint8_t depth = depth_;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t sample = samples[i];
+
+        // ones/zeros: bits that were 1/0 in each of the last k+1 samples.
+        // A bit whose min width is k+1 takes that level once it is stable.
+        uint32_t ones = sample;
+        uint32_t zeros = ~sample;
+        uint32_t set = ones & width_masks_[0];
+        uint32_t clear = zeros & width_masks_[0];
+        for (uint8_t k = 1; k < depth; k++) {
+            uint32_t older = history_[(pos_ - k) & HISTORY_MASK];
+            ones &= older;
+            zeros &= ~older;
+            set |= ones & width_masks_[k];
+            clear |= zeros & width_masks_[k];
+        }
+        history_[pos_ & HISTORY_MASK] = sample;
+        pos_++;
+
+        uint32_t filtered = (filtered_ | set) & ~clear;
+        uint32_t changed = (filtered ^ filtered_) & channel_mask_;
+
+        if (glitch_buffer_ != nullptr) {
+            // A deviation that ends without being accepted was a glitch
+            uint32_t deviating = (sample ^ filtered) & filter_mask_;
+            uint32_t ended = deviating_ & ~deviating & ~changed;
+            deviating_ = deviating;
+            if (ended != 0) {
+                recordGlitches(ended);
+            }
+        }
+        if (changed != 0) {
+            emitChanges(changed, filtered);
+        }
+
+        filtered_ = filtered;
+        time_++;
+    }
+}
+
+void TransitionEncoder::emitChanges(uint32_t changed, uint32_t filtered) {
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        Channel& channel = channels_[ch];
+        if (changed & channel.bit) {
+            // The filter accepts a level min_width - 1 samples after it started
+            uint32_t change_time = time_ - (channel.min_width - 1);
+            emitRun(channel, change_time - channel.last_change);
+            channel.last_change = change_time;
+            channel.level = (filtered & channel.bit) ? 1 : 0;
+        }
+    }
+}
+
+void TransitionEncoder::emitRun(Channel& channel, uint32_t duration) {
+    uint8_t level = channel.level << 7;
+    while (duration > 0) {
+        if (channel.length >= channel.capacity) {
+            overflow_ = true;
+            return;
+        }
+        uint32_t part = (duration > 0x7F) ? 0x7F : duration;
+        channel.data[channel.length++] = level | (uint8_t)part;
+        duration -= part;
+    }
+}
+
+void TransitionEncoder::recordGlitches(uint32_t ended) {
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        uint32_t bit = channels_[ch].bit;
+        if ((ended & bit) == 0) {
+            continue;
+        }
+
+        // The current sample is back at the filtered level; count the
+        // samples before it that were at the other level
+        uint32_t pulse = (filtered_ & bit) ^ bit;
+        uint8_t width = 0;
+        while (width < MAX_MIN_WIDTH - 1 &&
+               (history_[(pos_ - 2 - width) & HISTORY_MASK] & bit) == pulse) {
+            width++;
+        }
+
+        if (glitch_count_ >= glitch_capacity_) {
+            glitches_dropped_++;
+            continue;
+        }
+        Glitch& glitch = glitch_buffer_[glitch_count_++];
+        glitch.timestamp = time_ - width;
+        glitch.channel = ch;
+        glitch.width = width;
+        glitch.level = pulse ? 1 : 0;
+    }
+}
+
+void TransitionEncoder::flush() {
+    if (!started_) {
+        return;
+    }
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        Channel& channel = channels_[ch];
+        // A change still to come is dated at most min_width - 1 samples back
+        uint32_t settled = time_ - (channel.min_width - 1);
+        if ((int32_t)(settled - channel.last_change) > 0) {
+            emitRun(channel, settled - channel.last_change);
+            channel.last_change = settled;
+        }
+    }
+}
+
+void TransitionEncoder::finish() {
+    if (!started_) {
+        return;
+    }
+    for (uint8_t ch = 0; ch < num_channels_; ch++) {
+        Channel& channel = channels_[ch];
+        emitRun(channel, time_ - channel.last_change);
+        channel.last_change = time_;
+    }
+}
+
+} // namespace capture
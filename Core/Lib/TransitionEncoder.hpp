@@ -0,0 +1,137 @@
+/**
+  ******************************************************************************
+  * @file           : TransitionEncoder.hpp
+  * @brief          : Port-word to transition encoder with glitch filter / capture
+  ******************************************************************************
+  * Input is a stream of sampled GPIO port words (one IDR read per sample,
+  * each channel on its own port bit). Output is one transition buffer per
+  * channel in the display format (bit 7 = level, bits 6-0 = duration),
+  * with runs longer than 127 samples split into several entries.
+  *
+  * Minimum pulse width filter: a bit only changes in the filtered word once
+  * the input has held the new level for N samples. All bits are handled at
+  * once with AND masks over the last samples, with no branches on the data.
+  * Pulses shorter than N never reach the output. The fixed N-1 sample
+  * delay is taken out of the timestamps again.
+  *
+  * Glitch capture: a bit that left the filtered level and came back before
+  * it was accepted is a suppressed pulse. It is detected with the same
+  * masks, and each one is recorded with its start time, width and level.
+  ******************************************************************************
+  */
+
+#ifndef TRANSITION_ENCODER_HPP
+#define TRANSITION_ENCODER_HPP
+
+#include <cstdint>
+
+namespace capture {
+
+class TransitionEncoder {
+public:
+    static constexpr uint8_t MAX_CHANNELS = 4;
+    static constexpr uint8_t MAX_MIN_WIDTH = 16;
+
+    /**
+     * @brief A pulse removed by the filter
+     */
+    struct Glitch {
+        uint32_t timestamp;   ///< First sample of the pulse
+        uint8_t channel;
+        uint8_t width;        ///< Samples
+        uint8_t level;        ///< Level of the pulse (1 = positive spike)
+    };
+
+    /**
+     * @param channel_bits Port bit of each channel
+     * @param num_channels Number of channels (max MAX_CHANNELS)
+     */
+    TransitionEncoder(const uint8_t* channel_bits, uint8_t num_channels);
+
+    /**
+     * @brief Transition buffer of a channel
+     */
+    void setOutput(uint8_t channel, uint8_t* buffer, uint32_t capacity);
+
+    /**
+     * @brief Shortest pulse kept on a channel, in samples
+     * @param samples 0 or 1 disables the filter, at most MAX_MIN_WIDTH
+     */
+    void setMinWidth(uint8_t channel, uint8_t samples);
+
+    /**
+     * @brief Record filtered-out pulses (nullptr disables)
+     */
+    void setGlitchCapture(Glitch* buffer, uint32_t capacity);
+
+    /**
+     * @brief Start a new capture (keeps configuration and buffers)
+     */
+    void reset();
+
+    /**
+     * @brief Encode a block of samples; blocks may be fed one after another
+     */
+    void encode(const uint16_t* samples, uint32_t count);
+
+    /**
+     * @brief Emit every run up to the samples the filter has settled,
+     *        without closing it; lets a long stream be drained block by
+     *        block into buffers of bounded size (setOutput between blocks)
+     */
+    void flush();
+
+    /**
+     * @brief Close the last run of every channel
+     */
+    void finish();
+
+    uint32_t length(uint8_t channel) const { return channels_[channel].length; }
+    uint32_t samples() const { return time_; }
+    uint32_t glitches() const { return glitch_count_; }
+    uint32_t glitchesDropped() const { return glitches_dropped_; }
+    bool overflow() const { return overflow_; }
+
+private:
+    static constexpr uint32_t HISTORY_MASK = MAX_MIN_WIDTH - 1;
+
+    struct Channel {
+        uint32_t bit;
+        uint8_t* data;
+        uint32_t capacity;
+        uint32_t length;
+        uint8_t min_width;
+        uint8_t level;
+        uint32_t last_change;
+    };
+
+    void updateMasks();
+    void start(uint32_t sample);
+    void emitChanges(uint32_t changed, uint32_t filtered);
+    void emitRun(Channel& channel, uint32_t duration);
+    void recordGlitches(uint32_t ended);
+
+    Channel channels_[MAX_CHANNELS];
+    uint8_t num_channels_;
+    uint32_t channel_mask_;
+    uint32_t filter_mask_;                  // Channels with a filter
+    uint32_t width_masks_[MAX_MIN_WIDTH];   // Bits accepted after k+1 stable samples
+    uint8_t depth_;                         // Longest min width in use
+
+    Glitch* glitch_buffer_;
+    uint32_t glitch_capacity_;
+    uint32_t glitch_count_;
+    uint32_t glitches_dropped_;
+
+    uint32_t history_[MAX_MIN_WIDTH];
+    uint32_t pos_;
+    uint32_t time_;
+    uint32_t filtered_;
+    uint32_t deviating_;
+    bool started_;
+    bool overflow_;
+};
+
+} // namespace capture
+
+#endif /* TRANSITION_ENCODER_HPP */
@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file           : UartTx.cpp
+  * @brief          : DMA UART transmit ring implementation
+  ******************************************************************************
+  */
+
+#include "UartTx.hpp"
+#include <cstring>
+
+namespace console {
+
+UartTx::UartTx(UART_HandleTypeDef* huart, uint8_t* ring, uint32_t size)
+    : huart_(huart), ring_(ring), mask_(size - 1), head_(0), tail_(0), in_flight_(0), dropped_(0), transfers_(0) {
+}
+
+bool UartTx::write(const uint8_t* data, uint32_t length) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // head and tail run freely, head - tail is the fill level
+    uint32_t head = head_;
+    uint32_t size = mask_ + 1;
+    if (length > size - (head - tail_)) {
+        dropped_ = dropped_ + length;
+        __set_PRIMASK(primask);
+        return false;
+    }
+    uint32_t offset = head & mask_;
+    uint32_t first = size - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(ring_ + offset, data, first);
+    memcpy(ring_, data + first, length - first);
+    head_ = head + length;
+
+    // An idle UART needs a kick; a running transfer chains on completion
+    if (in_flight_ == 0) {
+        startTransfer();
+    }
+    __set_PRIMASK(primask);
+    return true;
+}
+
+void UartTx::handleTxComplete() {
+    tail_ = tail_ + in_flight_;
+    in_flight_ = 0;
+    startTransfer();
+}
+
+// Interrupts off or in the completion interrupt
+void UartTx::startTransfer() {
+    uint32_t tail = tail_;
+    uint32_t pending = head_ - tail;
+    if (pending == 0) {
+        return;
+    }
+    // Up to the end of the ring; the rest goes in the next transfer
+    uint32_t offset = tail & mask_;
+    uint32_t chunk = mask_ + 1 - offset;
+    if (chunk > pending) {
+        chunk = pending;
+    }
+    __DMB();   // Ring data written before the DMA reads it
+    if (HAL_UART_Transmit_DMA(huart_, ring_ + offset, (uint16_t)chunk) != HAL_OK) {
+        return;   // Not initialised yet or busy: the next write kicks again
+    }
+    in_flight_ = chunk;
+    transfers_ = transfers_ + 1;
+}
+
+void UartTx::getStats(Stats& stats) const {
+    stats.queued = head_;
+    stats.sent = tail_;
+    stats.dropped = dropped_;
+    stats.transfers = transfers_;
+}
+
+} // namespace console
@@ -0,0 +1,70 @@
+/**
+  ******************************************************************************
+  * @file           : UartTx.hpp
+  * @brief          : Non-blocking UART transmit through DMA from a ring buffer
+  ******************************************************************************
+  * write() copies into the ring and returns; the DMA sends straight from the
+  * ring, one transfer per contiguous run of pending bytes, and the transfer
+  * complete interrupt (HAL_UART_TxCpltCallback -> handleTxComplete) starts
+  * the next. Writes are whole or dropped, never partial, so a full ring
+  * loses lines rather than halves of them.
+  *
+  * Any task (or interrupt) may write: the copy and the kick run with
+  * interrupts off, a few microseconds for a log line. The UART needs its
+  * hdmatx linked (HAL_UART_MspInit) and both the DMA stream and the UART
+  * interrupt enabled.
+  ******************************************************************************
+  */
+
+#ifndef UART_TX_HPP
+#define UART_TX_HPP
+
+#include "stm32f4xx_hal.h"
+#include <cstdint>
+
+namespace console {
+
+class UartTx {
+public:
+    struct Stats {
+        uint32_t queued;      ///< Bytes accepted (wraps at 2^32)
+        uint32_t sent;        ///< Bytes the DMA has finished
+        uint32_t dropped;     ///< Bytes refused because the ring was full
+        uint32_t transfers;   ///< DMA transfers started
+    };
+
+    /**
+     * @param huart UART with a DMA transmit channel
+     * @param ring Ring storage, size a power of two
+     */
+    UartTx(UART_HandleTypeDef* huart, uint8_t* ring, uint32_t size);
+
+    /**
+     * @brief Queue bytes for sending (never waits)
+     * @return false if they did not fit and were dropped
+     */
+    bool write(const uint8_t* data, uint32_t length);
+
+    /**
+     * @brief Transfer complete; call from HAL_UART_TxCpltCallback
+     */
+    void handleTxComplete();
+
+    void getStats(Stats& stats) const;
+
+private:
+    void startTransfer();
+
+    UART_HandleTypeDef* huart_;
+    uint8_t* ring_;
+    uint32_t mask_;
+    volatile uint32_t head_;        ///< Written by write()
+    volatile uint32_t tail_;        ///< Written by handleTxComplete()
+    volatile uint32_t in_flight_;   ///< Length of the running transfer, 0 = idle
+    volatile uint32_t dropped_;
+    volatile uint32_t transfers_;
+};
+
+} // namespace console
+
+#endif /* UART_TX_HPP */
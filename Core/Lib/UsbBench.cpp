@@ -0,0 +1,161 @@
+/**
+  ******************************************************************************
+  * @file           : UsbBench.cpp
+  * @brief          : USB CDC / vendor bulk throughput benchmark implementation
+  ******************************************************************************
+  */
+
+#include "UsbBench.hpp"
+#include "stm32f4xx_hal.h"
+#include "cmsis_os.h"
+#include "usbd_cdc_if.h"
+#include "usbd_bulk_if.h"
+#include <cstring>
+
+namespace measure {
+
+static const uint8_t FRAME_BYTES = 16;
+static const char START_MAGIC[8] = {'L', 'A', 'B', 'E', 'N', 'C', 'H', '1'};
+static const char END_MAGIC[8] = {'L', 'A', 'B', 'E', 'N', 'D', '!', '!'};
+
+// Written by the task only; static because the task stack is small. The
+// bulk pipe sends from these in place, so frames are static too.
+static uint8_t chunk[UsbBench::CHUNK_BYTES];
+static uint8_t bulk_chunks[2][UsbBench::BULK_CHUNK_BYTES];
+static uint8_t start_frame[FRAME_BYTES];
+static uint8_t end_frame[FRAME_BYTES];
+
+// Counters of either pipe
+struct PipeStats {
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t transfers;
+    uint32_t starved;
+};
+
+static void readStats(UsbBench::Pipe pipe, PipeStats& stats) {
+    if (pipe == UsbBench::Pipe::Cdc) {
+        CDC_TxStatsTypeDef cdc;
+        CDC_GetTxStats_FS(&cdc);
+        stats = {cdc.queued, cdc.sent, cdc.transfers, cdc.starved};
+    } else {
+        BULK_StatsTypeDef bulk;
+        BULK_GetStats_FS(&bulk);
+        stats = {bulk.queued, bulk.sent, bulk.transfers, bulk.starved};
+    }
+}
+
+static uint8_t pipeWrite(UsbBench::Pipe pipe, uint8_t* data, uint32_t length) {
+    if (pipe == UsbBench::Pipe::Cdc) {
+        // The CDC ring has a single producer: take turns with Log_Printf
+        // the same way it does
+        vTaskSuspendAll();
+        uint8_t status = CDC_Transmit_FS(data, (uint16_t)length);
+        xTaskResumeAll();
+        return status;
+    }
+    return BULK_Transmit_FS(data, length);
+}
+
+static void putWord(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+// Frame of a magic and two words, retried while the pipe is full
+static bool writeFrame(UsbBench::Pipe pipe, uint8_t* frame, const char* magic,
+                       uint32_t first, uint32_t second) {
+    memcpy(frame, magic, 8);
+    putWord(frame + 8, first);
+    putWord(frame + 12, second);
+
+    uint32_t start = HAL_GetTick();
+    while (pipeWrite(pipe, frame, FRAME_BYTES) != USBD_OK) {
+        if (HAL_GetTick() - start >= UsbBench::FRAME_TIMEOUT_MS) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return true;
+}
+
+bool UsbBench::run(Pipe pipe, uint32_t seconds, Result& result) {
+    memset(&result, 0, sizeof(result));
+    result.pipe = pipe;
+    result.seconds = seconds;
+
+    // Bulk frames and chunks are sent in place: nothing of an earlier
+    // run may still be queued when they are rewritten
+    if (pipe == Pipe::Bulk) {
+        uint32_t wait_start = HAL_GetTick();
+        while (BULK_TxPending_FS() != 0) {
+            if (HAL_GetTick() - wait_start >= FRAME_TIMEOUT_MS) {
+                return false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+
+    uint32_t chunk_bytes = (pipe == Pipe::Cdc) ? CHUNK_BYTES : BULK_CHUNK_BYTES;
+    PipeStats before;
+    readStats(pipe, before);
+    uint32_t start = HAL_GetTick();
+    if (!writeFrame(pipe, start_frame, START_MAGIC, seconds, chunk_bytes)) {
+        return false;
+    }
+
+    // Keep the pipe full: a refused chunk is retried as soon as the
+    // scheduler comes back, without sleeping a whole tick. Bulk chunks
+    // alternate; the one queued two writes ago is free once fewer than two
+    // transfers are pending.
+    uint32_t word = 0;
+    uint8_t next = 0;
+    bool filled = false;
+    while (HAL_GetTick() - start < seconds * 1000) {
+        uint8_t* buffer = (pipe == Pipe::Cdc) ? chunk : bulk_chunks[next];
+        if (!filled) {
+            if (pipe == Pipe::Bulk && BULK_TxPending_FS() >= BULK_TX_QUEUE_DEPTH) {
+                result.busy++;
+                taskYIELD();
+                continue;
+            }
+            for (uint16_t k = 0; k < chunk_bytes / 4; k++) {
+                putWord(buffer + k * 4, word + k);
+            }
+            filled = true;
+        }
+        if (pipeWrite(pipe, buffer, chunk_bytes) == USBD_OK) {
+            word += chunk_bytes / 4;
+            next ^= 1;
+            filled = false;
+        } else {
+            result.busy++;
+            taskYIELD();
+        }
+    }
+
+    bool ended = writeFrame(pipe, end_frame, END_MAGIC, word, HAL_GetTick() - start);
+    PipeStats after;
+    uint32_t drain_start = HAL_GetTick();
+    for (;;) {
+        readStats(pipe, after);
+        if (after.sent == after.queued || HAL_GetTick() - drain_start >= FRAME_TIMEOUT_MS) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    result.elapsed_ms = HAL_GetTick() - start;
+    result.words = word;
+    result.bytes = after.sent - before.sent;
+    result.bytes_per_s = (result.elapsed_ms != 0)
+                             ? (uint32_t)((uint64_t)result.bytes * 1000 / result.elapsed_ms) : 0;
+    result.transfers = after.transfers - before.transfers;
+    result.starved = after.starved - before.starved;
+    result.drained = ended && after.sent == after.queued;
+    return true;
+}
+
+} // namespace measure
@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * @file           : UsbBench.hpp
+  * @brief          : USB CDC throughput benchmark (device side)
+  ******************************************************************************
+  * Streams a known pattern for a number of seconds, as fast as the pipe
+ * drains, over one of two pipes:
+ *   Cdc   the normal CDC transmit ring. Each write is CHUNK_BYTES, and the
+ *         ring sends everything pending up to its end as one transfer, so
+ *         transfers are as large as the ring allows.
+ *   Bulk  the vendor bulk interface: two static BULK_CHUNK_BYTES buffers
+ *         alternate, one in flight while the other is refilled, no copy.
+ *
+ * Stream (all little endian), checked by host/usb_bench:
+ *   start   "LABENCH1", u32 seconds, u32 chunk bytes
+ *   payload u32 counter words 0, 1, 2, ...
+ *   end     "LABEND!!", u32 payload words, u32 elapsed ms
+ *
+ * Device-side figures come from the pipe counters: bytes confirmed sent
+ * per second, writes refused because the pipe was full (the host is the
+ * bottleneck) and transfers that completed with nothing queued (the
+ * producer is; the endpoint NAKs until the next write).
+ ******************************************************************************
+  */
+
+#ifndef USB_BENCH_HPP
+#define USB_BENCH_HPP
+
+#include <cstdint>
+
+namespace measure {
+
+class UsbBench {
+public:
+    static constexpr uint16_t CHUNK_BYTES = 512;
+    static constexpr uint16_t BULK_CHUNK_BYTES = 2048;
+    static constexpr uint32_t FRAME_TIMEOUT_MS = 1000;
+
+    enum class Pipe : uint8_t { Cdc, Bulk };
+
+    struct Result {
+        Pipe pipe;
+        uint32_t seconds;
+        uint32_t elapsed_ms;    ///< Start frame queued to last byte sent
+        uint32_t words;         ///< Payload words queued
+        uint32_t bytes;         ///< Bytes confirmed sent (frames included)
+        uint32_t bytes_per_s;
+        uint32_t transfers;     ///< IN transfers started
+        uint32_t busy;          ///< Writes refused, pipe full
+        uint32_t starved;       ///< Transfers completed with nothing queued
+        bool drained;           ///< Everything was sent before the timeout
+    };
+
+    /**
+     * @brief Run the benchmark (blocks for about seconds + drain time)
+     * @return false if the start frame could not be queued (no host)
+     */
+    static bool run(Pipe pipe, uint32_t seconds, Result& result);
+};
+
+} // namespace measure
+
+#endif /* USB_BENCH_HPP */
@@ -31,6 +31,10 @@
 #include "Led.h"
 #include "Oled.hpp"
 #include "Tasks.h"
+#include "EventStore.hpp"
+#include "FreqMeter.hpp"
+#include "PortDma.hpp"
+#include "UartTx.hpp"
 #include "cmsis_os.h"
 
 /* USER CODE END Includes */
@@ -54,6 +58,19 @@
 #define LOG_UART_ENABLED 1  // Enable/disable UART logging
 #define LOG_USB_ENABLED  1  // Enable/disable USB CDC logging
 
+// Console UART rate. APB2 84 MHz / 16 divides it exactly (3000000 too);
+// the USB-UART adapter has to support it
+#define LOG_UART_BAUD 2000000
+
+// UART console transmit ring, drained by DMA (power of two)
+#define UART_TX_RING_SIZE 1024
+
+// Decoded event store size (12 bytes per event)
+#define EVENT_STORE_CAPACITY 1024
+
+// Console commands waiting for testTask
+#define SHELL_QUEUE_DEPTH 4
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -67,6 +84,7 @@ I2C_HandleTypeDef hi2c1;
 RTC_HandleTypeDef hrtc;
 
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_tx;
 
 /* Definitions for defaultTask */
 osThreadId_t defaultTaskHandle;
@@ -85,14 +103,30 @@ Encoder* encoder = nullptr;
 Led* led = nullptr;
 display::Oled* oled = nullptr;
 
+// Decoded events live in a fixed array next to the capture data
+static decode::Event event_storage[EVENT_STORE_CAPACITY];
+
+// Console output queued for the UART DMA (the constructor touches no hardware)
+static uint8_t uart_tx_ring[UART_TX_RING_SIZE];
+static console::UartTx uart_tx(&huart1, uart_tx_ring, UART_TX_RING_SIZE);
+
 // Export for tasks
 Led* g_led = nullptr;
 Encoder* g_encoder = nullptr;
 display::Oled* g_oled = nullptr;
+decode::EventStore* g_events = nullptr;
+measure::FreqMeter* g_meters[LA_NUM_CHANNELS] = {nullptr};
+capture::PortDma* g_port_dma = nullptr;
+osMessageQueueId_t g_shell_queue = nullptr;
+console::UartTx* g_uart_tx = &uart_tx;
 
 // Test mode flag (set at startup if TEST_BTN pressed)
 bool g_test_mode = false;
 
+// Set while something else owns the CDC stream (USB bench): log lines go
+// to the UART only
+static volatile bool log_usb_paused = false;
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -117,6 +151,20 @@ extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
   }
 }
 
+// Timer interrupts of the per-channel frequency meters (see stm32f4xx_it.c)
+extern "C" void FreqMeter_IRQHandler(uint8_t channel) {
+  if (channel < LA_NUM_CHANNELS && g_meters[channel] != nullptr) {
+    g_meters[channel]->handleInterrupt();
+  }
+}
+
+// UART DMA transfer done: send what was queued meanwhile
+extern "C" void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+  if (huart == &huart1) {
+    uart_tx.handleTxComplete();
+  }
+}
+
 // Dual output logging function (UART + USB-CDC) with timestamp
 // VERBOSE = 0: All logging disabled
 // VERBOSE = 1: Logging enabled, channels controlled by LOG_UART_ENABLED and LOG_USB_ENABLED
@@ -147,24 +195,41 @@ void Log_Printf(const char* format, ...) {
 
     if (total_len > 0 && total_len < (int)sizeof(full_message)) {
 #if LOG_UART_ENABLED
-      // Send to UART1 if enabled (single transmission)
-      HAL_UART_Transmit(&huart1, (uint8_t*)full_message, total_len, 100);
+      // Queue for UART1 if enabled; the DMA sends it in the background
+      uart_tx.write((const uint8_t*)full_message, total_len);
 #endif
 
 #if LOG_USB_ENABLED
-      // Send to USB-CDC if enabled (single transmission)
-      CDC_Transmit_FS((uint8_t*)full_message, total_len);
+      // Queue for USB-CDC if enabled. The transmit ring has a single
+      // producer, so tasks take turns (the copy is short, interrupts stay on)
+      bool scheduler_running = (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
+      if (scheduler_running) {
+        vTaskSuspendAll();
+      }
+      if (!log_usb_paused) {
+        CDC_Transmit_FS((uint8_t*)full_message, total_len);
+      }
+      if (scheduler_running) {
+        xTaskResumeAll();
+      }
 #endif
     }
   }
 #endif
 }
 
-// Printf redirect for standard printf (uses UART only)
+// Keep log lines out of the CDC stream while a benchmark writes to it
+void Log_SetUsbPaused(bool paused) {
+  log_usb_paused = paused;
+}
+
+// Printf redirect for standard printf (uses UART only). Replaces the weak
+// _write of syscalls.c, which would queue one character at a time
 #ifdef __GNUC__
-extern "C" int __io_putchar(int ch) {
-  HAL_UART_Transmit(&huart1, (uint8_t*)&ch, 1, 10);
-  return ch;
+extern "C" int _write(int file, char* ptr, int len) {
+  (void)file;
+  uart_tx.write((const uint8_t*)ptr, (uint32_t)len);
+  return len;
 }
 #endif
 
@@ -275,6 +340,28 @@ int main(void)
     // Note: Banner timeout handled in testTask (non-blocking)
   }
 
+  // Event store for protocol decoders
+  g_events = new decode::EventStore(event_storage, EVENT_STORE_CAPACITY);
+
+  // Frequency meters, one per channel (all timer clocks run at HCLK)
+  const measure::FreqMeter::Hardware meter_hw[LA_NUM_CHANNELS] = {
+    {TIM1, LA_CH0_GPIO_Port, LA_CH0_Pin, GPIO_AF1_TIM1, TIM1_CC_IRQn, TIM1_UP_TIM10_IRQn, SystemCoreClock},
+    {TIM2, LA_CH1_GPIO_Port, LA_CH1_Pin, GPIO_AF1_TIM2, TIM2_IRQn, TIM2_IRQn, SystemCoreClock},
+    {TIM3, LA_CH2_GPIO_Port, LA_CH2_Pin, GPIO_AF2_TIM3, TIM3_IRQn, TIM3_IRQn, SystemCoreClock},
+    {TIM9, LA_CH3_GPIO_Port, LA_CH3_Pin, GPIO_AF3_TIM9, TIM1_BRK_TIM9_IRQn, TIM1_BRK_TIM9_IRQn, SystemCoreClock},
+  };
+  for (uint8_t ch = 0; ch < LA_NUM_CHANNELS; ch++) {
+    g_meters[ch] = new measure::FreqMeter(meter_hw[ch]);
+  }
+
+  // Pattern generator and loopback sampler: only DMA2 reaches the GPIO
+  // ports and only TIM1 requests DMA2 (CC1 -> stream 1, UP -> stream 5)
+  const capture::PortDma::Hardware port_dma_hw = {
+    TIM1, SystemCoreClock, DMA2_Stream1, DMA_CHANNEL_6, DMA2_Stream5, DMA_CHANNEL_6,
+    LA_GEN_GPIO_Port, LA_GEN0_Pin | LA_GEN1_Pin | LA_GEN2_Pin | LA_GEN3_Pin, LA_CH0_GPIO_Port,
+  };
+  g_port_dma = new capture::PortDma(port_dma_hw);
+
   // Share with FreeRTOS tasks
   g_encoder = encoder;
   g_led = led;
@@ -302,6 +389,7 @@ int main(void)
 
   /* USER CODE BEGIN RTOS_QUEUES */
   /* add queues, ... */
+  g_shell_queue = osMessageQueueNew(SHELL_QUEUE_DEPTH, sizeof(shell::Command), NULL);
   /* USER CODE END RTOS_QUEUES */
 
   /* Create the thread(s) */
@@ -327,6 +415,14 @@ int main(void)
   };
   testTaskHandle = osThreadNew(testTask, NULL, &testTask_attributes);
 
+  // Create console command task (bytes from the CDC receive ring)
+  const osThreadAttr_t shellTask_attributes = {
+    .name = "shellTask",
+    .stack_size = 384 * 4,
+    .priority = (osPriority_t) osPriorityNormal,
+  };
+  shellTaskHandle = osThreadNew(shellTask, NULL, &shellTask_attributes);
+
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -462,6 +558,12 @@ static void MX_RTC_Init(void)
   }
   /* USER CODE BEGIN RTC_Init 2 */
 
+  // The clock runs on through resets once set over the console ("time")
+  if (HAL_RTCEx_BKUPRead(&hrtc, RTC_SET_REGISTER) == RTC_SET_MARKER)
+  {
+    return;
+  }
+
   // Set initial date and time: 10.10.2025 14:00:00
   RTC_TimeTypeDef sTime = {0};
   RTC_DateTypeDef sDate = {0};
@@ -520,6 +622,13 @@ static void MX_USART1_UART_Init(void)
   }
   /* USER CODE BEGIN USART1_Init 2 */
 
+  // The console runs faster than the CubeMX setting
+  huart1.Init.BaudRate = LOG_UART_BAUD;
+  if (HAL_UART_Init(&huart1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
   /* USER CODE END USART1_Init 2 */
 
 }
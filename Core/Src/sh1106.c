@@ -92,6 +92,38 @@ static HAL_StatusTypeDef SH1106_WriteData(SH1106_t *dev, const uint8_t *data, ui
     }
 }
 
+/**
+ * @brief Find the changed columns of each page and remember them as shown
+ * @param dev Pointer to SH1106 device structure
+ */
+static void SH1106_FindDirty(SH1106_t *dev)
+{
+    for (uint8_t page = 0; page < SH1106_PAGES; page++) {
+        const uint8_t *now = &dev->framebuffer[page * SH1106_WIDTH];
+        uint8_t *shown = &dev->prev_framebuffer[page * SH1106_WIDTH];
+        uint8_t first = 0;
+        uint8_t last = SH1106_WIDTH - 1;
+
+        if (!dev->full_refresh) {
+            while (first < SH1106_WIDTH && now[first] == shown[first]) {
+                first++;
+            }
+            if (first == SH1106_WIDTH) {
+                dev->dirty_count[page] = 0;
+                continue;
+            }
+            while (now[last] == shown[last]) {
+                last--;
+            }
+        }
+
+        dev->dirty_first[page] = first;
+        dev->dirty_count[page] = last - first + 1;
+        memcpy(shown + first, now + first, last - first + 1);
+    }
+    dev->full_refresh = false;
+}
+
 /**
  * @brief Check if device is present on I2C bus at address 0x3C
  * @param hi2c Pointer to I2C handle
@@ -114,6 +146,7 @@ HAL_StatusTypeDef SH1106_Init(SH1106_t *dev, I2C_HandleTypeDef *hi2c)
     dev->hi2c = hi2c;
     dev->address = SH1106_I2C_ADDR;
     dev->initialized = false;
+    dev->full_refresh = true;
     memset(dev->framebuffer, 0, sizeof(dev->framebuffer));
 
     // Check if device is present
@@ -258,34 +291,47 @@ HAL_StatusTypeDef SH1106_UpdateScreen(SH1106_t *dev)
 {
     HAL_StatusTypeDef status;
 
+    // Changed columns only; a failed write makes the next update a full one
+    SH1106_FindDirty(dev);
+
     // SH1106 has 8 pages (rows of 8 pixels each)
     for (uint8_t page = 0; page < SH1106_PAGES; page++) {
+        if (dev->dirty_count[page] == 0) {
+            continue;
+        }
+        uint8_t first = dev->dirty_first[page];
+        uint8_t column = SH1106_COLUMN_OFFSET + first;
+
         // Set page address (0xB0 - 0xB7)
         status = SH1106_WriteCommand(dev, SH1106_CMD_SET_PAGE_ADDR | page);
         if (status != HAL_OK) {
             printf("SH1106: Error setting page %d (status=%d)\r\n", page, status);
+            dev->full_refresh = true;
             return status;
         }
 
         // Set column address (with 2-pixel offset for SH1106)
         // Lower nibble
-        status = SH1106_WriteCommand(dev, SH1106_CMD_SET_COLUMN_ADDR_LOW | (SH1106_COLUMN_OFFSET & 0x0F));
+        status = SH1106_WriteCommand(dev, SH1106_CMD_SET_COLUMN_ADDR_LOW | (column & 0x0F));
         if (status != HAL_OK) {
             printf("SH1106: Error setting column low (page=%d, status=%d)\r\n", page, status);
+            dev->full_refresh = true;
             return status;
         }
 
         // Higher nibble
-        status = SH1106_WriteCommand(dev, SH1106_CMD_SET_COLUMN_ADDR_HIGH | ((SH1106_COLUMN_OFFSET >> 4) & 0x0F));
+        status = SH1106_WriteCommand(dev, SH1106_CMD_SET_COLUMN_ADDR_HIGH | ((column >> 4) & 0x0F));
         if (status != HAL_OK) {
             printf("SH1106: Error setting column high (page=%d, status=%d)\r\n", page, status);
+            dev->full_refresh = true;
             return status;
         }
 
-        // Write page data (128 bytes)
-        status = SH1106_WriteData(dev, &dev->framebuffer[page * SH1106_WIDTH], SH1106_WIDTH);
+        // Write the changed columns of the page (up to 128 bytes)
+        status = SH1106_WriteData(dev, &dev->framebuffer[page * SH1106_WIDTH + first], dev->dirty_count[page]);
         if (status != HAL_OK) {
             printf("SH1106: Error writing data (page=%d, status=%d)\r\n", page, status);
+            dev->full_refresh = true;
             return status;
         }
     }
@@ -51,7 +51,7 @@
 
 /* External functions --------------------------------------------------------*/
 /* USER CODE BEGIN ExternalFunctions */
-
+extern DMA_HandleTypeDef hdma_usart1_tx;
 /* USER CODE END ExternalFunctions */
 
 /* USER CODE BEGIN 0 */
@@ -234,6 +234,31 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
 
   /* USER CODE BEGIN USART1_MspInit 1 */
 
+    /* USART1_TX on DMA2 Stream7 channel 4 (console transmit ring, UartTx).
+       Streams 1 and 5 of DMA2 belong to PortDma. */
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    hdma_usart1_tx.Instance = DMA2_Stream7;
+    hdma_usart1_tx.Init.Channel = DMA_CHANNEL_4;
+    hdma_usart1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart1_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart1_tx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_usart1_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_usart1_tx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+    __HAL_LINKDMA(huart, hdmatx, hdma_usart1_tx);
+
+    /* DMA complete enables the UART TC interrupt, which ends the transfer */
+    HAL_NVIC_SetPriority(DMA2_Stream7_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
+    HAL_NVIC_SetPriority(USART1_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(USART1_IRQn);
+
   /* USER CODE END USART1_MspInit 1 */
 
   }
@@ -263,7 +288,9 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_9|GPIO_PIN_10);
 
   /* USER CODE BEGIN USART1_MspDeInit 1 */
-
+    HAL_DMA_DeInit(huart->hdmatx);
+    HAL_NVIC_DisableIRQ(DMA2_Stream7_IRQn);
+    HAL_NVIC_DisableIRQ(USART1_IRQn);
   /* USER CODE END USART1_MspDeInit 1 */
   }
 
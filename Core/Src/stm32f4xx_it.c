@@ -59,7 +59,8 @@ extern PCD_HandleTypeDef hpcd_USB_OTG_FS;
 extern TIM_HandleTypeDef htim10;
 
 /* USER CODE BEGIN EV */
-
+extern DMA_HandleTypeDef hdma_usart1_tx;
+extern UART_HandleTypeDef huart1;
 /* USER CODE END EV */
 
 /******************************************************************************/
@@ -166,6 +167,13 @@ void DebugMon_Handler(void)
 void TIM1_UP_TIM10_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM1_UP_TIM10_IRQn 0 */
+  /* One vector for two owners: TIM1 update is the CH0 meter's counter wrap,
+   * TIM10 the HAL time base. The meter only runs for its own enabled flag;
+   * HAL_TIM_IRQHandler checks TIM10's flags itself. */
+  if ((TIM1->SR & TIM_SR_UIF) != 0U && (TIM1->DIER & TIM_DIER_UIE) != 0U)
+  {
+    FreqMeter_IRQHandler(0);
+  }
 
   /* USER CODE END TIM1_UP_TIM10_IRQn 0 */
   HAL_TIM_IRQHandler(&htim10);
@@ -204,4 +212,52 @@ void EXTI15_10_IRQHandler(void)
   /* USER CODE END EXTI15_10_IRQn 1 */
 }
 
+/**
+  * @brief This function handles TIM1 capture compare interrupt (CH0 meter).
+  */
+void TIM1_CC_IRQHandler(void)
+{
+  FreqMeter_IRQHandler(0);
+}
+
+/**
+  * @brief This function handles TIM2 global interrupt (CH1 meter).
+  */
+void TIM2_IRQHandler(void)
+{
+  FreqMeter_IRQHandler(1);
+}
+
+/**
+  * @brief This function handles TIM3 global interrupt (CH2 meter).
+  */
+void TIM3_IRQHandler(void)
+{
+  FreqMeter_IRQHandler(2);
+}
+
+/**
+  * @brief This function handles TIM1 break and TIM9 global interrupts (CH3 meter).
+  */
+void TIM1_BRK_TIM9_IRQHandler(void)
+{
+  FreqMeter_IRQHandler(3);
+}
+
+/**
+  * @brief This function handles DMA2 stream7 global interrupt (USART1 TX).
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+}
+
+/**
+  * @brief This function handles USART1 global interrupt.
+  */
+void USART1_IRQHandler(void)
+{
+  HAL_UART_IRQHandler(&huart1);
+}
+
 /* USER CODE END 1 */
@@ -25,6 +25,8 @@
 #include "usbd_desc.h"
 #include "usbd_cdc.h"
 #include "usbd_cdc_if.h"
+#include "usbd_composite.h"
+#include "usbd_bulk_if.h"
 
 /* USER CODE BEGIN Includes */
 
@@ -72,7 +74,8 @@ void MX_USB_DEVICE_Init(void)
   {
     Error_Handler();
   }
-  if (USBD_RegisterClass(&hUsbDeviceFS, &USBD_CDC) != USBD_OK)
+  /* CDC console + vendor bulk; the composite class drives USBD_CDC */
+  if (USBD_RegisterClass(&hUsbDeviceFS, &USBD_COMPOSITE) != USBD_OK)
   {
     Error_Handler();
   }
@@ -80,6 +83,10 @@ void MX_USB_DEVICE_Init(void)
   {
     Error_Handler();
   }
+  if (USBD_BULK_RegisterInterface(&hUsbDeviceFS, &USBD_Bulk_fops_FS) != USBD_OK)
+  {
+    Error_Handler();
+  }
   if (USBD_Start(&hUsbDeviceFS) != USBD_OK)
   {
     Error_Handler();
@@ -0,0 +1,226 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_bulk_if.c
+  * @brief          : Vendor bulk interface for capture data
+  ******************************************************************************
+  */
+
+#include "usbd_bulk_if.h"
+#include <string.h>
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+typedef struct
+{
+  uint8_t *buf;
+  uint32_t len;
+} BULK_TxSlotTypeDef;
+
+/* Slot tx_first is in flight whenever tx_count != 0. The task appends and
+   the interrupt retires, both with interrupts off for the few stores. */
+static BULK_TxSlotTypeDef tx_queue[BULK_TX_QUEUE_DEPTH];
+static volatile uint8_t tx_first;
+static volatile uint8_t tx_count;
+static volatile BULK_StatsTypeDef bulk_stats;
+
+static uint8_t bulk_rx_buffer[BULK_FS_MAX_PACKET_SIZE];
+static uint8_t bulk_packet[BULK_FS_MAX_PACKET_SIZE];
+static volatile uint32_t bulk_packet_len;
+
+static volatile BULK_SofTypeDef bulk_sof;
+
+static int8_t BULK_Init_FS(void);
+static int8_t BULK_DeInit_FS(void);
+static int8_t BULK_Receive_FS(uint8_t *Buf, uint32_t Len);
+static int8_t BULK_TransmitCplt_FS(uint8_t *Buf, uint32_t Len);
+static void BULK_Sof_FS(uint32_t Frame);
+
+USBD_BULK_ItfTypeDef USBD_Bulk_fops_FS =
+{
+  BULK_Init_FS,
+  BULK_DeInit_FS,
+  BULK_Receive_FS,
+  BULK_TransmitCplt_FS,
+  BULK_Sof_FS
+};
+
+/* Start the transfer at the front of the queue (interrupts off) */
+static void BULK_StartTransfer_FS(void)
+{
+  BULK_TxSlotTypeDef *slot = &tx_queue[tx_first];
+  if (USBD_BULK_Transmit(&hUsbDeviceFS, slot->buf, slot->len) == USBD_OK)
+  {
+    bulk_stats.transfers++;
+  }
+}
+
+static int8_t BULK_Init_FS(void)
+{
+  /* Anything queued before a reset is gone with the endpoint */
+  tx_first = 0U;
+  tx_count = 0U;
+  (void)USBD_BULK_ReceivePacket(&hUsbDeviceFS, bulk_rx_buffer);
+  return (USBD_OK);
+}
+
+static int8_t BULK_DeInit_FS(void)
+{
+  tx_count = 0U;
+  return (USBD_OK);
+}
+
+static int8_t BULK_Receive_FS(uint8_t *Buf, uint32_t Len)
+{
+  bulk_stats.received += Len;
+  memcpy(bulk_packet, Buf, Len);
+  bulk_packet_len = Len;
+  (void)USBD_BULK_ReceivePacket(&hUsbDeviceFS, Buf);
+  return (USBD_OK);
+}
+
+/* From the USB interrupt: retire the finished slot, start the next */
+static int8_t BULK_TransmitCplt_FS(uint8_t *Buf, uint32_t Len)
+{
+  UNUSED(Buf);
+
+  if (tx_count == 0U)
+  {
+    return (USBD_OK);
+  }
+  bulk_stats.sent += Len;
+  tx_first = (uint8_t)((tx_first + 1U) % BULK_TX_QUEUE_DEPTH);
+  tx_count--;
+  if (tx_count != 0U)
+  {
+    BULK_StartTransfer_FS();
+  }
+  else
+  {
+    bulk_stats.starved++;
+  }
+  return (USBD_OK);
+}
+
+/* From the USB interrupt, only while stamping is on */
+static void BULK_Sof_FS(uint32_t Frame)
+{
+  uint32_t cycles = DWT->CYCCNT;
+
+  bulk_sof.frame = Frame;
+  bulk_sof.cycles = cycles;
+  bulk_sof.count++;
+}
+
+/**
+  * @brief  Queue Buf for the bulk IN endpoint (no copy)
+  * @param  Len: 1 .. BULK_MAX_TRANSFER_SIZE bytes
+  * @retval USBD_OK if queued, USBD_BUSY if the queue is full, USBD_FAIL
+  *         when not configured or the length is out of range
+  */
+uint8_t BULK_Transmit_FS(uint8_t *Buf, uint32_t Len)
+{
+  if (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED || Len == 0U || Len > BULK_MAX_TRANSFER_SIZE)
+  {
+    return USBD_FAIL;
+  }
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (tx_count == BULK_TX_QUEUE_DEPTH)
+  {
+    __set_PRIMASK(primask);
+    return USBD_BUSY;
+  }
+  BULK_TxSlotTypeDef *slot = &tx_queue[(tx_first + tx_count) % BULK_TX_QUEUE_DEPTH];
+  slot->buf = Buf;
+  slot->len = Len;
+  tx_count++;
+  bulk_stats.queued += Len;
+  if (tx_count == 1U)
+  {
+    BULK_StartTransfer_FS();
+  }
+  __set_PRIMASK(primask);
+  return USBD_OK;
+}
+
+/**
+  * @brief  Transfers queued or in flight
+  */
+uint8_t BULK_TxPending_FS(void)
+{
+  return tx_count;
+}
+
+/**
+  * @brief  Take the OUT packet received since the last call
+  * @param  Buf: BULK_FS_MAX_PACKET_SIZE bytes
+  * @retval Its length, 0 if nothing arrived (empty packets are ignored)
+  */
+uint32_t BULK_ReadPacket_FS(uint8_t *Buf)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t len = bulk_packet_len;
+  memcpy(Buf, bulk_packet, len);
+  bulk_packet_len = 0U;
+  __set_PRIMASK(primask);
+  return len;
+}
+
+/**
+  * @brief  Snapshot of the bulk counters
+  */
+void BULK_GetStats_FS(BULK_StatsTypeDef *stats)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  stats->queued = bulk_stats.queued;
+  stats->sent = bulk_stats.sent;
+  stats->transfers = bulk_stats.transfers;
+  stats->starved = bulk_stats.starved;
+  stats->received = bulk_stats.received;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Stamp every start of frame (unmasks the SOF interrupt) or stop
+  *         stamping; turning it on restarts the count and runs the DWT
+  *         cycle counter
+  */
+void BULK_EnableSof_FS(uint8_t enable)
+{
+  PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)hUsbDeviceFS.pData;
+
+  if (hpcd == NULL)
+  {
+    return;
+  }
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (enable != 0U)
+  {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    bulk_sof.count = 0U;
+    hpcd->Instance->GINTMSK |= USB_OTG_GINTMSK_SOFM;
+  }
+  else
+  {
+    hpcd->Instance->GINTMSK &= ~USB_OTG_GINTMSK_SOFM;
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Snapshot of the latest start of frame stamp
+  */
+void BULK_GetSof_FS(BULK_SofTypeDef *sof)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  sof->frame = bulk_sof.frame;
+  sof->cycles = bulk_sof.cycles;
+  sof->count = bulk_sof.count;
+  __set_PRIMASK(primask);
+}
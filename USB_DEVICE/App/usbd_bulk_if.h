@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_bulk_if.h
+  * @brief          : Vendor bulk interface for capture data
+  ******************************************************************************
+  * BULK_Transmit_FS queues a buffer for the bulk IN endpoint without
+  * copying it. Two transfers can be queued; the second starts from the USB
+  * interrupt the moment the first completes, so a producer alternating two
+  * buffers keeps the endpoint busy. A buffer must stay untouched until its
+  * transfer is done: with two buffers alternating, the one queued earlier
+  * is free again once BULK_TxPending_FS() < 2.
+  *
+  * Each transfer arrives on the host as one read (ZLP after a full last
+  * packet). OUT packets are commands: the latest one waits in a mailbox
+  * for BULK_ReadPacket_FS (an unread older one is replaced).
+  *
+  * With BULK_EnableSof_FS(1U) every start of frame the host sends (1 ms)
+  * is stamped with the DWT cycle counter from the USB interrupt; the
+  * latest stamp is kept. The SOF interrupt is masked otherwise.
+  ******************************************************************************
+  */
+
+#ifndef __USBD_BULK_IF_H__
+#define __USBD_BULK_IF_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "usbd_composite.h"
+
+#define BULK_TX_QUEUE_DEPTH  2U
+
+/** Bulk counters since reset (wrap at 2^32) */
+typedef struct
+{
+  uint32_t queued;     /* Bytes accepted by BULK_Transmit_FS */
+  uint32_t sent;       /* Bytes completed on the IN endpoint */
+  uint32_t transfers;  /* IN transfers started */
+  uint32_t starved;    /* Transfers that completed with the queue empty */
+  uint32_t received;   /* Bytes received on the OUT endpoint */
+} BULK_StatsTypeDef;
+
+/** Latest start of frame while stamping is on */
+typedef struct
+{
+  uint32_t frame;      /* USB frame number (11 bits) */
+  uint32_t cycles;     /* DWT->CYCCNT when the SOF interrupt ran */
+  uint32_t count;      /* SOFs stamped since stamping was turned on */
+} BULK_SofTypeDef;
+
+extern USBD_BULK_ItfTypeDef USBD_Bulk_fops_FS;
+
+uint8_t BULK_Transmit_FS(uint8_t *Buf, uint32_t Len);
+uint8_t BULK_TxPending_FS(void);
+uint32_t BULK_ReadPacket_FS(uint8_t *Buf);
+void BULK_GetStats_FS(BULK_StatsTypeDef *stats);
+void BULK_EnableSof_FS(uint8_t enable);
+void BULK_GetSof_FS(BULK_SofTypeDef *sof);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_BULK_IF_H__ */
@@ -22,7 +22,7 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN INCLUDE */
-
+#include <string.h>
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -62,6 +62,11 @@
   */
 
 /* USER CODE BEGIN PRIVATE_DEFINES */
+/* UserTxBufferFS is the transmit ring; its size must be a power of two */
+#define CDC_TX_RING_MASK  (APP_TX_DATA_SIZE - 1U)
+/* Received bytes wait here for the shell task (power of two) */
+#define CDC_RX_RING_SIZE  512U
+#define CDC_RX_RING_MASK  (CDC_RX_RING_SIZE - 1U)
 /* USER CODE END PRIVATE_DEFINES */
 
 /**
@@ -95,6 +100,27 @@ uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
 
 /* USER CODE BEGIN PRIVATE_VARIABLES */
 
+/* Transmit ring, single producer / single consumer, no locks:
+ *   tx_head      written only by the producer (CDC_Transmit_FS),
+ *   tx_tail      written only by the consumer (transfer complete),
+ *   tx_in_flight length of the transfer on the IN endpoint (0 = idle).
+ * The indices run freely and wrap at 2^32, so head - tail is the fill
+ * level, and the indices double as the queued / sent byte counters. */
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+static volatile uint32_t tx_in_flight = 0;
+static volatile uint32_t tx_dropped = 0;
+static volatile uint32_t tx_transfers = 0;
+static volatile uint32_t tx_starved = 0;
+
+/* Receive ring, same scheme: rx_head written only by CDC_Receive_FS (USB
+ * interrupt), rx_tail only by CDC_Read_FS (one task). */
+static uint8_t rx_ring[CDC_RX_RING_SIZE];
+static volatile uint32_t rx_head = 0;
+static volatile uint32_t rx_tail = 0;
+static volatile uint32_t rx_dropped = 0;
+static void (*volatile rx_callback)(void) = NULL;
+
 /* USER CODE END PRIVATE_VARIABLES */
 
 /**
@@ -129,6 +155,8 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
 
+static void CDC_StartTransfer_FS(void);
+
 /* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
 
 /**
@@ -155,6 +183,10 @@ static int8_t CDC_Init_FS(void)
   /* Set Application Buffers */
   USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+  /* A transfer cut off by a reset never completes: send it again, then
+     whatever was queued while disconnected */
+  tx_in_flight = 0;
+  CDC_StartTransfer_FS();
   return (USBD_OK);
   /* USER CODE END 3 */
 }
@@ -180,6 +212,8 @@ static int8_t CDC_DeInit_FS(void)
 static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 {
   /* USER CODE BEGIN 5 */
+  (void)pbuf;
+  (void)length;
   switch(cmd)
   {
     case CDC_SEND_ENCAPSULATED_COMMAND:
@@ -261,8 +295,32 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
+  /* Copy what fits and re-arm at once: parsing happens in the shell task,
+     never here, so the OUT endpoint is never held up */
+  uint32_t head = rx_head;
+  uint32_t length = *Len;
+  uint32_t room = CDC_RX_RING_SIZE - (head - rx_tail);
+  if (length > room) {
+    rx_dropped = rx_dropped + (length - room);
+    length = room;
+  }
+  uint32_t offset = head & CDC_RX_RING_MASK;
+  uint32_t first = CDC_RX_RING_SIZE - offset;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(&rx_ring[offset], Buf, first);
+  memcpy(rx_ring, Buf + first, length - first);
+  __DMB();  /* Data before the index that publishes it */
+  rx_head = head + length;
+
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
   USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+
+  void (*callback)(void) = rx_callback;
+  if (callback != NULL && length != 0) {
+    callback();
+  }
   return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -282,12 +340,31 @@ uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len)
 {
   uint8_t result = USBD_OK;
   /* USER CODE BEGIN 7 */
-  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
-  if (hcdc->TxState != 0){
+  /* Queue the whole buffer or nothing (no partial lines), never block */
+  uint32_t head = tx_head;
+  if (Len > APP_TX_DATA_SIZE - (head - tx_tail)) {
+    tx_dropped = tx_dropped + Len;
     return USBD_BUSY;
   }
-  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, Buf, Len);
-  result = USBD_CDC_TransmitPacket(&hUsbDeviceFS);
+  uint32_t offset = head & CDC_TX_RING_MASK;
+  uint32_t first = APP_TX_DATA_SIZE - offset;
+  if (first > Len) {
+    first = Len;
+  }
+  memcpy(&UserTxBufferFS[offset], Buf, first);
+  memcpy(UserTxBufferFS, Buf + first, Len - first);
+  __DMB();  /* Data before the index that publishes it */
+  tx_head = head + Len;
+
+  /* An idle endpoint needs a kick. If a transfer is in flight, its
+     completion sees the new head. The kick itself must not interleave
+     with the completion interrupt. */
+  if (tx_in_flight == 0) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    CDC_StartTransfer_FS();
+    __set_PRIMASK(primask);
+  }
   /* USER CODE END 7 */
   return result;
 }
@@ -311,12 +388,107 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
   UNUSED(Buf);
   UNUSED(Len);
   UNUSED(epnum);
+  /* Called after the ZLP when the transfer was a multiple of 64 bytes */
+  tx_tail = tx_tail + tx_in_flight;
+  tx_in_flight = 0;
+  if (tx_head == tx_tail) {
+    /* Nothing to chain: the endpoint NAKs the host until the next write */
+    tx_starved = tx_starved + 1;
+  }
+  CDC_StartTransfer_FS();
   /* USER CODE END 13 */
   return result;
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
+/**
+  * @brief  Start the next transfer straight from the ring (no copy): all
+  *         pending bytes up to the end of the buffer, as one multi-packet
+  *         transfer. Runs in the USB interrupt or with interrupts off.
+  */
+static void CDC_StartTransfer_FS(void)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+  if (hcdc == NULL || hcdc->TxState != 0 || tx_in_flight != 0) {
+    return;
+  }
+  uint32_t tail = tx_tail;
+  uint32_t pending = tx_head - tail;
+  if (pending == 0) {
+    return;
+  }
+  __DMB();  /* Index before the data it publishes */
+  uint32_t offset = tail & CDC_TX_RING_MASK;
+  uint32_t chunk = APP_TX_DATA_SIZE - offset;
+  if (chunk > pending) {
+    chunk = pending;
+  }
+  tx_in_flight = chunk;
+  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, &UserTxBufferFS[offset], chunk);
+  if (USBD_CDC_TransmitPacket(&hUsbDeviceFS) != USBD_OK) {
+    tx_in_flight = 0;
+    return;
+  }
+  tx_transfers = tx_transfers + 1;
+}
+
+/**
+  * @brief  Transmit ring counters
+  */
+void CDC_GetTxStats_FS(CDC_TxStatsTypeDef* stats)
+{
+  stats->queued = tx_head;
+  stats->sent = tx_tail;
+  stats->dropped = tx_dropped;
+  stats->transfers = tx_transfers;
+  stats->starved = tx_starved;
+}
+
+/**
+  * @brief  Take up to Len received bytes out of the receive ring
+  *         (one consumer task only)
+  * @retval Bytes copied
+  */
+uint32_t CDC_Read_FS(uint8_t* Buf, uint32_t Len)
+{
+  uint32_t tail = rx_tail;
+  uint32_t available = rx_head - tail;
+  if (Len > available) {
+    Len = available;
+  }
+  __DMB();  /* Index before the data it publishes */
+  uint32_t offset = tail & CDC_RX_RING_MASK;
+  uint32_t first = CDC_RX_RING_SIZE - offset;
+  if (first > Len) {
+    first = Len;
+  }
+  memcpy(Buf, &rx_ring[offset], first);
+  memcpy(Buf + first, rx_ring, Len - first);
+  __DMB();  /* Data read before the space is given back */
+  rx_tail = tail + Len;
+  return Len;
+}
+
+/**
+  * @brief  Receive ring counters
+  */
+void CDC_GetRxStats_FS(CDC_RxStatsTypeDef* stats)
+{
+  stats->received = rx_head;
+  stats->read = rx_tail;
+  stats->dropped = rx_dropped;
+}
+
+/**
+  * @brief  Function the USB interrupt calls after received bytes were
+  *         queued (e.g. to wake the reader); NULL for none
+  */
+void CDC_SetRxCallback_FS(void (*callback)(void))
+{
+  rx_callback = callback;
+}
+
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
 /**
@@ -65,6 +65,24 @@
 
 /* USER CODE BEGIN EXPORTED_TYPES */
 
+/** Transmit ring counters (bytes since reset, wrap at 2^32) */
+typedef struct
+{
+  uint32_t queued;   /* Accepted by CDC_Transmit_FS */
+  uint32_t sent;     /* Completed on the IN endpoint */
+  uint32_t dropped;  /* Refused because the ring was full */
+  uint32_t transfers; /* IN transfers started */
+  uint32_t starved;  /* Transfers that completed with the ring empty */
+} CDC_TxStatsTypeDef;
+
+/** Receive ring counters (bytes since reset, wrap at 2^32) */
+typedef struct
+{
+  uint32_t received; /* Copied out of OUT packets */
+  uint32_t read;     /* Taken by CDC_Read_FS */
+  uint32_t dropped;  /* Lost because the ring was full */
+} CDC_RxStatsTypeDef;
+
 /* USER CODE END EXPORTED_TYPES */
 
 /**
@@ -109,6 +127,11 @@ uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
 
+void CDC_GetTxStats_FS(CDC_TxStatsTypeDef* stats);
+uint32_t CDC_Read_FS(uint8_t* Buf, uint32_t Len);
+void CDC_GetRxStats_FS(CDC_RxStatsTypeDef* stats);
+void CDC_SetRxCallback_FS(void (*callback)(void));
+
 /* USER CODE END EXPORTED_FUNCTIONS */
 
 /**
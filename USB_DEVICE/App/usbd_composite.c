@@ -0,0 +1,389 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_composite.c
+  * @brief          : CDC ACM + vendor bulk composite class
+  ******************************************************************************
+  * Interfaces 0 and 1 and their endpoints go to USBD_CDC unchanged (it
+  * keeps its handle in pClassData and its callbacks in pUserData); interface
+  * 2 and endpoint 3 are handled here.
+  ******************************************************************************
+  */
+
+#include "usbd_composite.h"
+#include "usbd_ctlreq.h"
+
+typedef struct
+{
+  uint8_t *TxBuffer;
+  uint32_t TxLength;
+  uint8_t *RxBuffer;
+  __IO uint32_t TxState;
+} USBD_BULK_HandleTypeDef;
+
+/* Exported by usbd_cdc.c but not declared in its header */
+uint8_t *USBD_CDC_GetDeviceQualifierDescriptor(uint16_t *length);
+
+static USBD_BULK_HandleTypeDef hbulk;
+static USBD_BULK_ItfTypeDef *bulk_fops;
+
+static uint8_t USBD_COMPOSITE_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_COMPOSITE_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev);
+static uint8_t USBD_COMPOSITE_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_COMPOSITE_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_COMPOSITE_SOF(USBD_HandleTypeDef *pdev);
+static uint8_t *USBD_COMPOSITE_GetCfgDesc(uint16_t *length);
+
+USBD_ClassTypeDef USBD_COMPOSITE =
+{
+  USBD_COMPOSITE_Init,
+  USBD_COMPOSITE_DeInit,
+  USBD_COMPOSITE_Setup,
+  NULL,                 /* EP0_TxSent */
+  USBD_COMPOSITE_EP0_RxReady,
+  USBD_COMPOSITE_DataIn,
+  USBD_COMPOSITE_DataOut,
+  USBD_COMPOSITE_SOF,   /* Only while the SOF interrupt is unmasked */
+  NULL,
+  NULL,
+  USBD_COMPOSITE_GetCfgDesc,
+  USBD_COMPOSITE_GetCfgDesc,
+  USBD_COMPOSITE_GetCfgDesc,
+  USBD_CDC_GetDeviceQualifierDescriptor,
+};
+
+/* USB composite device Configuration Descriptor */
+__ALIGN_BEGIN static uint8_t USBD_COMPOSITE_CfgDesc[USB_COMPOSITE_CONFIG_DESC_SIZ] __ALIGN_END =
+{
+  /* Configuration Descriptor */
+  0x09,                                       /* bLength: Configuration Descriptor size */
+  USB_DESC_TYPE_CONFIGURATION,                /* bDescriptorType: Configuration */
+  USB_COMPOSITE_CONFIG_DESC_SIZ,              /* wTotalLength */
+  0x00,
+  0x03,                                       /* bNumInterfaces: 3 interfaces */
+  0x01,                                       /* bConfigurationValue: Configuration value */
+  0x00,                                       /* iConfiguration */
+#if (USBD_SELF_POWERED == 1U)
+  0xC0,                                       /* bmAttributes: Self Powered */
+#else
+  0x80,                                       /* bmAttributes: Bus Powered */
+#endif /* USBD_SELF_POWERED */
+  USBD_MAX_POWER,                             /* MaxPower (mA) */
+
+  /* Interface Association Descriptor: CDC */
+  0x08,                                       /* bLength */
+  0x0B,                                       /* bDescriptorType: IAD */
+  0x00,                                       /* bFirstInterface */
+  0x02,                                       /* bInterfaceCount */
+  0x02,                                       /* bFunctionClass: Communication */
+  0x02,                                       /* bFunctionSubClass: Abstract Control Model */
+  0x01,                                       /* bFunctionProtocol: Common AT commands */
+  0x00,                                       /* iFunction */
+
+  /* CDC Communication Interface Descriptor */
+  0x09,                                       /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,                    /* bDescriptorType: Interface */
+  0x00,                                       /* bInterfaceNumber */
+  0x00,                                       /* bAlternateSetting */
+  0x01,                                       /* bNumEndpoints: One endpoint used */
+  0x02,                                       /* bInterfaceClass: Communication Interface Class */
+  0x02,                                       /* bInterfaceSubClass: Abstract Control Model */
+  0x01,                                       /* bInterfaceProtocol: Common AT commands */
+  0x00,                                       /* iInterface */
+
+  /* Header Functional Descriptor */
+  0x05,                                       /* bLength */
+  0x24,                                       /* bDescriptorType: CS_INTERFACE */
+  0x00,                                       /* bDescriptorSubtype: Header Func Desc */
+  0x10,                                       /* bcdCDC: spec release number */
+  0x01,
+
+  /* Call Management Functional Descriptor */
+  0x05,                                       /* bFunctionLength */
+  0x24,                                       /* bDescriptorType: CS_INTERFACE */
+  0x01,                                       /* bDescriptorSubtype: Call Management Func Desc */
+  0x00,                                       /* bmCapabilities: D0+D1 */
+  0x01,                                       /* bDataInterface */
+
+  /* ACM Functional Descriptor */
+  0x04,                                       /* bFunctionLength */
+  0x24,                                       /* bDescriptorType: CS_INTERFACE */
+  0x02,                                       /* bDescriptorSubtype: Abstract Control Management desc */
+  0x02,                                       /* bmCapabilities */
+
+  /* Union Functional Descriptor */
+  0x05,                                       /* bFunctionLength */
+  0x24,                                       /* bDescriptorType: CS_INTERFACE */
+  0x06,                                       /* bDescriptorSubtype: Union func desc */
+  0x00,                                       /* bMasterInterface: Communication class interface */
+  0x01,                                       /* bSlaveInterface0: Data Class Interface */
+
+  /* CDC Command Endpoint Descriptor */
+  0x07,                                       /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                     /* bDescriptorType: Endpoint */
+  CDC_CMD_EP,                                 /* bEndpointAddress */
+  0x03,                                       /* bmAttributes: Interrupt */
+  LOBYTE(CDC_CMD_PACKET_SIZE),                /* wMaxPacketSize */
+  HIBYTE(CDC_CMD_PACKET_SIZE),
+  CDC_FS_BINTERVAL,                           /* bInterval */
+
+  /* CDC Data Interface Descriptor */
+  0x09,                                       /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,                    /* bDescriptorType: Interface */
+  0x01,                                       /* bInterfaceNumber */
+  0x00,                                       /* bAlternateSetting */
+  0x02,                                       /* bNumEndpoints: Two endpoints used */
+  0x0A,                                       /* bInterfaceClass: CDC */
+  0x00,                                       /* bInterfaceSubClass */
+  0x00,                                       /* bInterfaceProtocol */
+  0x00,                                       /* iInterface */
+
+  /* CDC Endpoint OUT Descriptor */
+  0x07,                                       /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                     /* bDescriptorType: Endpoint */
+  CDC_OUT_EP,                                 /* bEndpointAddress */
+  0x02,                                       /* bmAttributes: Bulk */
+  LOBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),        /* wMaxPacketSize */
+  HIBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                                       /* bInterval */
+
+  /* CDC Endpoint IN Descriptor */
+  0x07,                                       /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                     /* bDescriptorType: Endpoint */
+  CDC_IN_EP,                                  /* bEndpointAddress */
+  0x02,                                       /* bmAttributes: Bulk */
+  LOBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),        /* wMaxPacketSize */
+  HIBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                                       /* bInterval */
+
+  /* Vendor Bulk Interface Descriptor */
+  0x09,                                       /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,                    /* bDescriptorType: Interface */
+  BULK_ITF_NBR,                               /* bInterfaceNumber */
+  0x00,                                       /* bAlternateSetting */
+  0x02,                                       /* bNumEndpoints: Two endpoints used */
+  0xFF,                                       /* bInterfaceClass: Vendor specific */
+  0x00,                                       /* bInterfaceSubClass */
+  0x00,                                       /* bInterfaceProtocol */
+  0x00,                                       /* iInterface */
+
+  /* Vendor Endpoint OUT Descriptor */
+  0x07,                                       /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                     /* bDescriptorType: Endpoint */
+  BULK_OUT_EP,                                /* bEndpointAddress */
+  0x02,                                       /* bmAttributes: Bulk */
+  LOBYTE(BULK_FS_MAX_PACKET_SIZE),            /* wMaxPacketSize */
+  HIBYTE(BULK_FS_MAX_PACKET_SIZE),
+  0x00,                                       /* bInterval */
+
+  /* Vendor Endpoint IN Descriptor */
+  0x07,                                       /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                     /* bDescriptorType: Endpoint */
+  BULK_IN_EP,                                 /* bEndpointAddress */
+  0x02,                                       /* bmAttributes: Bulk */
+  LOBYTE(BULK_FS_MAX_PACKET_SIZE),            /* wMaxPacketSize */
+  HIBYTE(BULK_FS_MAX_PACKET_SIZE),
+  0x00                                        /* bInterval */
+};
+
+static uint8_t USBD_COMPOSITE_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  uint8_t ret = USBD_CDC.Init(pdev, cfgidx);
+
+  (void)USBD_LL_OpenEP(pdev, BULK_IN_EP, USBD_EP_TYPE_BULK, BULK_FS_MAX_PACKET_SIZE);
+  pdev->ep_in[BULK_IN_EP & 0xFU].is_used = 1U;
+  (void)USBD_LL_OpenEP(pdev, BULK_OUT_EP, USBD_EP_TYPE_BULK, BULK_FS_MAX_PACKET_SIZE);
+  pdev->ep_out[BULK_OUT_EP & 0xFU].is_used = 1U;
+
+  hbulk.TxState = 0U;
+  hbulk.RxBuffer = NULL;
+  if (bulk_fops != NULL)
+  {
+    bulk_fops->Init();
+  }
+  return ret;
+}
+
+static uint8_t USBD_COMPOSITE_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  (void)USBD_LL_CloseEP(pdev, BULK_IN_EP);
+  pdev->ep_in[BULK_IN_EP & 0xFU].is_used = 0U;
+  (void)USBD_LL_CloseEP(pdev, BULK_OUT_EP);
+  pdev->ep_out[BULK_OUT_EP & 0xFU].is_used = 0U;
+
+  hbulk.TxState = 0U;
+  if (bulk_fops != NULL)
+  {
+    bulk_fops->DeInit();
+  }
+  return USBD_CDC.DeInit(pdev, cfgidx);
+}
+
+/* Standard requests to the vendor interface or its endpoints; it has no
+   class or vendor requests of its own */
+static uint8_t USBD_BULK_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  static uint8_t ifalt = 0U;
+  static uint16_t status_info = 0U;
+
+  if ((req->bmRequest & USB_REQ_TYPE_MASK) != USB_REQ_TYPE_STANDARD ||
+      pdev->dev_state != USBD_STATE_CONFIGURED)
+  {
+    USBD_CtlError(pdev, req);
+    return (uint8_t)USBD_FAIL;
+  }
+
+  switch (req->bRequest)
+  {
+    case USB_REQ_GET_STATUS:
+      (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+      break;
+
+    case USB_REQ_GET_INTERFACE:
+      (void)USBD_CtlSendData(pdev, &ifalt, 1U);
+      break;
+
+    case USB_REQ_SET_INTERFACE:
+    case USB_REQ_CLEAR_FEATURE:
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      return (uint8_t)USBD_FAIL;
+  }
+  return (uint8_t)USBD_OK;
+}
+
+static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  uint8_t recipient = req->bmRequest & USB_REQ_RECIPIENT_MASK;
+
+  if ((recipient == USB_REQ_RECIPIENT_INTERFACE && LOBYTE(req->wIndex) == BULK_ITF_NBR) ||
+      (recipient == USB_REQ_RECIPIENT_ENDPOINT && (LOBYTE(req->wIndex) & 0xFU) == (BULK_IN_EP & 0xFU)))
+  {
+    return USBD_BULK_Setup(pdev, req);
+  }
+  return USBD_CDC.Setup(pdev, req);
+}
+
+static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  return USBD_CDC.EP0_RxReady(pdev);
+}
+
+static uint8_t USBD_COMPOSITE_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+  uint8_t ep = epnum & 0xFU;
+
+  if (ep != (BULK_IN_EP & 0xFU))
+  {
+    return USBD_CDC.DataIn(pdev, epnum);
+  }
+
+  /* A transfer that fills its last packet ends with a ZLP, so each
+     USBD_BULK_Transmit arrives on the host as one read */
+  if ((pdev->ep_in[ep].total_length > 0U) &&
+      ((pdev->ep_in[ep].total_length % hpcd->IN_ep[ep].maxpacket) == 0U))
+  {
+    pdev->ep_in[ep].total_length = 0U;
+    (void)USBD_LL_Transmit(pdev, epnum, NULL, 0U);
+  }
+  else
+  {
+    hbulk.TxState = 0U;
+    if (bulk_fops != NULL && bulk_fops->TransmitCplt != NULL)
+    {
+      bulk_fops->TransmitCplt(hbulk.TxBuffer, hbulk.TxLength);
+    }
+  }
+  return (uint8_t)USBD_OK;
+}
+
+static uint8_t USBD_COMPOSITE_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if (epnum != BULK_OUT_EP)
+  {
+    return USBD_CDC.DataOut(pdev, epnum);
+  }
+
+  if (bulk_fops != NULL && hbulk.RxBuffer != NULL)
+  {
+    bulk_fops->Receive(hbulk.RxBuffer, USBD_LL_GetRxDataSize(pdev, epnum));
+  }
+  return (uint8_t)USBD_OK;
+}
+
+static uint8_t USBD_COMPOSITE_SOF(USBD_HandleTypeDef *pdev)
+{
+  PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+  uint32_t USBx_BASE = (uint32_t)hpcd->Instance;
+
+  if (bulk_fops != NULL && bulk_fops->Sof != NULL)
+  {
+    bulk_fops->Sof((USBx_DEVICE->DSTS & USB_OTG_DSTS_FNSOF) >> USB_OTG_DSTS_FNSOF_Pos);
+  }
+  return (uint8_t)USBD_OK;
+}
+
+static uint8_t *USBD_COMPOSITE_GetCfgDesc(uint16_t *length)
+{
+  *length = (uint16_t)sizeof(USBD_COMPOSITE_CfgDesc);
+  return USBD_COMPOSITE_CfgDesc;
+}
+
+/**
+  * @brief  Register the vendor interface callbacks
+  * @param  fops: Init, DeInit, Receive, TransmitCplt and Sof (from the USB
+  *         interrupt)
+  * @retval status
+  */
+uint8_t USBD_BULK_RegisterInterface(USBD_HandleTypeDef *pdev, USBD_BULK_ItfTypeDef *fops)
+{
+  UNUSED(pdev);
+
+  if (fops == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+  bulk_fops = fops;
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  Start an IN transfer on the vendor endpoint straight from pbuff
+  *         (left untouched until TransmitCplt)
+  * @param  length: 1 .. BULK_MAX_TRANSFER_SIZE bytes
+  * @retval USBD_OK, USBD_BUSY while a transfer is in flight, USBD_FAIL when
+  *         not configured or the length is out of range
+  */
+uint8_t USBD_BULK_Transmit(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length)
+{
+  if (pdev->dev_state != USBD_STATE_CONFIGURED || length == 0U || length > BULK_MAX_TRANSFER_SIZE)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+  if (hbulk.TxState != 0U)
+  {
+    return (uint8_t)USBD_BUSY;
+  }
+
+  hbulk.TxState = 1U;
+  hbulk.TxBuffer = pbuff;
+  hbulk.TxLength = length;
+  pdev->ep_in[BULK_IN_EP & 0xFU].total_length = length;
+  (void)USBD_LL_Transmit(pdev, BULK_IN_EP, pbuff, length);
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  Arm the vendor OUT endpoint for one packet into pbuff
+  *         (BULK_FS_MAX_PACKET_SIZE bytes)
+  * @retval status
+  */
+uint8_t USBD_BULK_ReceivePacket(USBD_HandleTypeDef *pdev, uint8_t *pbuff)
+{
+  hbulk.RxBuffer = pbuff;
+  return (uint8_t)USBD_LL_PrepareReceive(pdev, BULK_OUT_EP, pbuff, BULK_FS_MAX_PACKET_SIZE);
+}
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_composite.h
+  * @brief          : CDC ACM + vendor bulk composite class
+  ******************************************************************************
+  * One configuration, three interfaces:
+  *   0, 1  CDC ACM (console, Log_Printf), grouped by an IAD; handled by the
+  *         stock CDC class
+  *   2     vendor specific (class 0xFF), bulk IN 0x83 / bulk OUT 0x03, for
+  *         capture data: no line coding, no framing, transfers of any size
+  *         straight from the caller's buffer
+  * The library is built without USE_USBD_COMPOSITE, so this class is the
+  * only one registered and routes requests and endpoint events itself.
+  ******************************************************************************
+  */
+
+#ifndef __USBD_COMPOSITE_H__
+#define __USBD_COMPOSITE_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "usbd_cdc.h"
+
+#define BULK_ITF_NBR                  0x02U
+#define BULK_IN_EP                    0x83U
+#define BULK_OUT_EP                   0x03U
+#define BULK_FS_MAX_PACKET_SIZE       64U
+/* Packet count field of DIEPTSIZ is 10 bits */
+#define BULK_MAX_TRANSFER_SIZE        (1023U * BULK_FS_MAX_PACKET_SIZE)
+
+#define USB_COMPOSITE_CONFIG_DESC_SIZ 98U
+
+typedef struct _USBD_BULK_Itf
+{
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  int8_t (* Receive)(uint8_t *Buf, uint32_t Len);
+  int8_t (* TransmitCplt)(uint8_t *Buf, uint32_t Len);
+  void (* Sof)(uint32_t Frame);  /* Start of frame, 11-bit frame number */
+} USBD_BULK_ItfTypeDef;
+
+extern USBD_ClassTypeDef USBD_COMPOSITE;
+
+uint8_t USBD_BULK_RegisterInterface(USBD_HandleTypeDef *pdev, USBD_BULK_ItfTypeDef *fops);
+uint8_t USBD_BULK_Transmit(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length);
+uint8_t USBD_BULK_ReceivePacket(USBD_HandleTypeDef *pdev, uint8_t *pbuff);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_COMPOSITE_H__ */
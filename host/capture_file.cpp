@@ -0,0 +1,186 @@
+/**
+  ******************************************************************************
+  * @file           : capture_file.cpp
+  * @brief          : Capture file written through a sliding memory map
+  ******************************************************************************
+  */
+
+#include "capture_file.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace capture {
+
+namespace {
+
+const uint8_t MAGIC[8] = {'L', 'A', 'C', 'A', 'P', '0', '0', '1'};
+const size_t HEADER_FIELDS_BYTES = 72;
+
+void putWord(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+uint32_t getWord(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void putLong(uint8_t* p, uint64_t value) {
+    putWord(p, (uint32_t)value);
+    putWord(p + 4, (uint32_t)(value >> 32));
+}
+
+uint64_t getLong(const uint8_t* p) {
+    return getWord(p) | ((uint64_t)getWord(p + 4) << 32);
+}
+
+} // namespace
+
+CaptureFile::~CaptureFile() {
+    unmapWindow();
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool CaptureFile::open(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        perror(path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CaptureFile::mapWindow(uint64_t offset) {
+    unmapWindow();
+    while (allocated_ < offset + WINDOW_BYTES) {
+        int error = posix_fallocate(fd_, (off_t)(HEADER_BYTES + allocated_), (off_t)GROW_BYTES);
+        if (error != 0) {
+            fprintf(stderr, "capture file: cannot allocate: %s\n", strerror(error));
+            return false;
+        }
+        allocated_ += GROW_BYTES;
+    }
+    void* window = mmap(nullptr, WINDOW_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                        (off_t)(HEADER_BYTES + offset));
+    if (window == MAP_FAILED) {
+        perror("capture file: mmap");
+        return false;
+    }
+    window_ = (uint8_t*)window;
+    window_offset_ = offset;
+    return true;
+}
+
+void CaptureFile::unmapWindow() {
+    if (window_ != nullptr) {
+        // Dirty pages stay in the page cache for writeback, not in our RSS
+        munmap(window_, WINDOW_BYTES);
+        window_ = nullptr;
+    }
+}
+
+uint8_t* CaptureFile::reserve(size_t& available) {
+    available = 0;
+    if (fd_ < 0) {
+        return nullptr;
+    }
+    if (window_ == nullptr || size_ == window_offset_ + WINDOW_BYTES) {
+        // Windows are whole multiples apart, so size_ is at a window start
+        if (!mapWindow(size_)) {
+            return nullptr;
+        }
+    }
+    size_t used = (size_t)(size_ - window_offset_);
+    available = WINDOW_BYTES - used;
+    return window_ + used;
+}
+
+void CaptureFile::commit(size_t length) {
+    size_ += length;
+}
+
+bool CaptureFile::append(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        size_t available;
+        uint8_t* space = reserve(available);
+        if (space == nullptr) {
+            return false;
+        }
+        size_t n = (length < available) ? length : available;
+        memcpy(space, data, n);
+        commit(n);
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool CaptureFile::finish(const CaptureHeader& header) {
+    unmapWindow();
+    if (fd_ < 0) {
+        return false;
+    }
+    if (ftruncate(fd_, (off_t)(HEADER_BYTES + size_)) != 0) {
+        perror("capture file: truncate");
+        return false;
+    }
+
+    uint8_t page[HEADER_BYTES] = {};
+    memcpy(page, MAGIC, sizeof(MAGIC));
+    putWord(page + 8, (uint32_t)HEADER_BYTES);
+    putWord(page + 12, header.rate_hz);
+    page[16] = (uint8_t)header.sample_bytes;
+    page[17] = (uint8_t)(header.sample_bytes >> 8);
+    page[18] = (uint8_t)header.block_bytes;
+    page[19] = (uint8_t)(header.block_bytes >> 8);
+    memcpy(page + 20, header.channel_bits, sizeof(header.channel_bits));
+    putWord(page + 24, (uint32_t)header.samples);
+    putWord(page + 28, (uint32_t)(header.samples >> 32));
+    putWord(page + 32, header.status);
+    putWord(page + 36, header.elapsed_ms);
+    putWord(page + 40, header.sync_count);
+    putWord(page + 44, header.first_sof_frame);
+    putLong(page + 48, header.first_sof_position);
+    putLong(page + 56, header.sof_frames);
+    putLong(page + 64, header.last_sof_position);
+    if (pwrite(fd_, page, sizeof(page), 0) != (ssize_t)sizeof(page)) {
+        perror("capture file: header");
+        return false;
+    }
+    close(fd_);
+    fd_ = -1;
+    return true;
+}
+
+bool CaptureFile::readHeader(int fd, CaptureHeader& header) {
+    uint8_t fields[HEADER_FIELDS_BYTES];
+    if (pread(fd, fields, sizeof(fields), 0) != (ssize_t)sizeof(fields) ||
+        memcmp(fields, MAGIC, sizeof(MAGIC)) != 0 || getWord(fields + 8) != HEADER_BYTES) {
+        return false;
+    }
+    header.rate_hz = getWord(fields + 12);
+    header.sample_bytes = (uint16_t)(fields[16] | (fields[17] << 8));
+    header.block_bytes = (uint16_t)(fields[18] | (fields[19] << 8));
+    memcpy(header.channel_bits, fields + 20, sizeof(header.channel_bits));
+    header.samples = getWord(fields + 24) | ((uint64_t)getWord(fields + 28) << 32);
+    header.status = getWord(fields + 32);
+    header.elapsed_ms = getWord(fields + 36);
+    // Zero in files from before sync frames
+    header.sync_count = getWord(fields + 40);
+    header.first_sof_frame = getWord(fields + 44);
+    header.first_sof_position = getLong(fields + 48);
+    header.sof_frames = getLong(fields + 56);
+    header.last_sof_position = getLong(fields + 64);
+    return true;
+}
+
+} // namespace capture
@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file           : capture_file.hpp
+  * @brief          : Capture file written through a sliding memory map
+  ******************************************************************************
+  * Layout (little endian):
+  *   0     "LACAP001"
+  *   8     u32 data offset (HEADER_BYTES)
+  *   12    u32 sample rate, Hz
+  *   16    u16 bytes per sample, u16 block bytes
+  *   20    u8  port bit of CH0..CH3
+  *   24    u64 samples
+  *   32    u32 device status (PortStream::Status, STATUS_CUT if no end frame)
+  *   36    u32 elapsed ms (device)
+  *   40    u32 sync frames seen (0 = captured without sync)
+  *   44    u32 USB frame number of the first (11 bits)
+  *   48    u64 its sample position, 1/256 samples
+  *   56    u64 USB frames (ms) from the first sync frame to the last
+  *   64    u64 sample position of the last, 1/256 samples
+  *   HEADER_BYTES  samples as sent by the device (u16 port words)
+  *
+  * The file is pre-sized with posix_fallocate GROW_BYTES at a time and
+  * written through one MAP_SHARED window of WINDOW_BYTES; the window is
+  * unmapped before the next is mapped, so a session of any length keeps
+  * the process at a few window sizes of memory. The producer asks for
+  * space with reserve() and fills it in place - straight from read() for
+  * file descriptors - and commits what it wrote. finish() truncates to the
+  * committed size and writes the header last, so a file without a valid
+  * header was never finished.
+  ******************************************************************************
+  */
+
+#ifndef CAPTURE_FILE_HPP
+#define CAPTURE_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace capture {
+
+struct CaptureHeader {
+    uint32_t rate_hz = 0;
+    uint16_t sample_bytes = 2;
+    uint16_t block_bytes = 0;
+    uint8_t channel_bits[4] = {0, 0, 0, 0};
+    uint64_t samples = 0;
+    uint32_t status = 0;
+    uint32_t elapsed_ms = 0;
+    uint32_t sync_count = 0;
+    uint32_t first_sof_frame = 0;
+    uint64_t first_sof_position = 0;
+    uint64_t sof_frames = 0;
+    uint64_t last_sof_position = 0;
+};
+
+class CaptureFile {
+public:
+    static const size_t HEADER_BYTES = 4096;
+    static const size_t WINDOW_BYTES = 32u << 20;
+    static const size_t GROW_BYTES = 256u << 20;
+    static const uint32_t STATUS_CUT = 0xFFFFFFFF;
+
+    CaptureFile() = default;
+    CaptureFile(const CaptureFile&) = delete;
+    CaptureFile& operator=(const CaptureFile&) = delete;
+    ~CaptureFile();
+
+    // Create or truncate. Errors go to stderr.
+    bool open(const std::string& path);
+
+    // Writable space at the end of the data, at most up to the end of the
+    // current window (never 0 unless an error occurred)
+    uint8_t* reserve(size_t& available);
+
+    // The first length bytes from reserve() are data
+    void commit(size_t length);
+
+    // Copy through reserve/commit
+    bool append(const uint8_t* data, size_t length);
+
+    // Data bytes committed so far
+    uint64_t size() const { return size_; }
+
+    // Unmap, cut to size and write the header
+    bool finish(const CaptureHeader& header);
+
+    // Header of a finished file; false if it is not one
+    static bool readHeader(int fd, CaptureHeader& header);
+
+private:
+    bool mapWindow(uint64_t offset);
+    void unmapWindow();
+
+    int fd_ = -1;
+    uint8_t* window_ = nullptr;
+    uint64_t window_offset_ = 0;   // Data offset of the window start
+    uint64_t size_ = 0;
+    uint64_t allocated_ = 0;       // Data bytes the file is pre-sized to
+};
+
+} // namespace capture
+
+#endif /* CAPTURE_FILE_HPP */
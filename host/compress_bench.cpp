@@ -0,0 +1,254 @@
+/**
+  ******************************************************************************
+  * @file           : compress_bench.cpp
+  * @brief          : Ratio and speed of the capture block compressor
+  ******************************************************************************
+  *   compress_bench [--samples N] [--rate HZ] [--link BYTES/S] [--device-cpb N]
+  *
+  * Synthesizes port words for typical traffic on CH0..CH3 (idle lines, a
+  * UART, I2C and SPI bursts, and noise on every channel as the worst case)
+  * with the other port bits flickering, codes them in device blocks
+  * (PortStream::BLOCK_SAMPLES) and decodes them back, checking the channel
+  * bits. Reports per pattern:
+  *   ratio      raw bytes / wire bytes (record headers included)
+  *   decode     host decompression, GB/s of port words
+  *   link       sample rate the bulk link (--link, ~1.2 MB/s at full speed)
+  *              carries at this ratio; raw is link / 2
+  * --device-cpb takes the "cycles/KB" la_capture --compress reports from a
+  * real device and adds the rate the M4 can code at; the stream keeps up
+  * with the lower of the two. Host coding speed is shown for reference only.
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BlockCompressor.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const uint32_t BLOCK_SAMPLES = 512;   // PortStream::BLOCK_SAMPLES
+const uint32_t RECORD_HEADER_BYTES = 2;
+const uint32_t DEVICE_CLOCK_HZ = 84000000;
+const uint8_t CHANNEL_BITS[capture::BlockCompressor::NUM_CHANNELS] = {8, 15, 6, 2};
+
+// Port words with the channels driven by a pattern; state carries over
+class Traffic {
+public:
+    enum class Pattern { Idle, Uart, I2c, Spi, Noise };
+
+    Traffic(Pattern pattern, uint32_t rate_hz) : pattern_(pattern), rate_hz_(rate_hz) {}
+
+    void fill(uint16_t* words, size_t count) {
+        for (size_t i = 0; i < count; i++, time_++) {
+            uint8_t state = next();
+            uint16_t word = (uint16_t)(random() & ~mask());
+            for (uint8_t ch = 0; ch < capture::BlockCompressor::NUM_CHANNELS; ch++) {
+                if (state & (1u << ch)) {
+                    word |= (uint16_t)(1u << CHANNEL_BITS[ch]);
+                }
+            }
+            words[i] = word;
+        }
+    }
+
+    static uint16_t mask() {
+        uint16_t mask = 0;
+        for (uint8_t bit : CHANNEL_BITS) {
+            mask |= (uint16_t)(1u << bit);
+        }
+        return mask;
+    }
+
+private:
+    uint32_t random() {
+        lfsr_ ^= lfsr_ << 13;
+        lfsr_ ^= lfsr_ >> 17;
+        lfsr_ ^= lfsr_ << 5;
+        return lfsr_;
+    }
+
+    uint64_t period(uint32_t bit_hz) const { return (rate_hz_ > bit_hz) ? rate_hz_ / bit_hz : 1; }
+
+    // Channel state (bit n = CH n) at time_
+    uint8_t next() {
+        switch (pattern_) {
+        case Pattern::Idle:
+            return 0x03;   // Pulled-up lines, nothing moves
+        case Pattern::Uart:
+            return uart();
+        case Pattern::I2c:
+            return i2c();
+        case Pattern::Spi:
+            return spi();
+        default:
+            return (uint8_t)(random() & 0x0F);
+        }
+    }
+
+    // CH0 TX at 115200 baud: bytes with 0..3 idle bytes between them
+    uint8_t uart() {
+        uint64_t bit_samples = period(115200);
+        uint64_t slot = (time_ - frame_start_) / bit_samples;
+        if (slot >= 10u + gap_) {
+            frame_start_ = time_;
+            byte_ = (uint8_t)random();
+            gap_ = (uint8_t)((random() & 3) * 10);
+            slot = 0;
+        }
+        uint8_t line = 1;
+        if (slot == 0) {
+            line = 0;
+        } else if (slot <= 8) {
+            line = (byte_ >> (slot - 1)) & 1;
+        }
+        return (uint8_t)(line | 0x0E);
+    }
+
+    // CH0 SCL at 100 kHz, CH1 SDA: 4-byte transfers, then as long idle
+    uint8_t i2c() {
+        uint64_t clock = period(100000);
+        uint64_t transfer = clock * 9 * 4;
+        uint64_t t = time_ % (2 * transfer);
+        if (t >= transfer) {
+            return 0x03;
+        }
+        uint64_t phase = t % clock;
+        if (phase == 0) {
+            byte_ = (uint8_t)random();   // Next data bit, set while SCL is low
+        }
+        uint8_t scl = (phase >= clock / 2) ? 1 : 0;
+        uint8_t sda = (phase >= clock / 4) ? (byte_ & 1) : (sda_ & 1);
+        sda_ = sda;
+        return (uint8_t)(scl | (sda << 1));
+    }
+
+    // CH0 SCK at rate / 8, CH1 MOSI, CH2 MISO, CH3 CS: 16-byte bursts
+    uint8_t spi() {
+        uint64_t clock = 8;
+        uint64_t burst = clock * 8 * 16;
+        uint64_t t = time_ % (4 * burst);
+        if (t >= burst) {
+            return 0x08;   // CS high, bus idle
+        }
+        uint64_t phase = t % clock;
+        if (phase == 0) {
+            byte_ = (uint8_t)random();
+        }
+        uint8_t sck = (phase >= clock / 2) ? 1 : 0;
+        return (uint8_t)(sck | ((byte_ & 1) << 1) | (byte_ & 4));
+    }
+
+    Pattern pattern_;
+    uint32_t rate_hz_;
+    uint64_t time_ = 0;
+    uint64_t frame_start_ = 0;
+    uint8_t byte_ = 0;
+    uint8_t gap_ = 0;
+    uint8_t sda_ = 0;
+    uint32_t lfsr_ = 0x2545F491u;
+};
+
+struct Options {
+    uint64_t samples = 16u << 20;
+    uint32_t rate_hz = 1000000;
+    double link_bytes = 1.2e6;
+    uint32_t device_cpb = 0;
+};
+
+bool bench(const char* name, Traffic::Pattern pattern, const Options& options) {
+    uint64_t blocks = (options.samples + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES;
+    size_t samples = (size_t)(blocks * BLOCK_SAMPLES);
+    std::vector<uint16_t> words(samples);
+    Traffic(pattern, options.rate_hz).fill(words.data(), samples);
+
+    capture::BlockCompressor compressor(CHANNEL_BITS);
+    std::vector<uint8_t> wire(blocks * (RECORD_HEADER_BYTES + capture::BlockCompressor::maxCompressed(BLOCK_SAMPLES)));
+    Clock::time_point start = Clock::now();
+    size_t wire_bytes = 0;
+    for (uint64_t b = 0; b < blocks; b++) {
+        uint8_t* record = wire.data() + wire_bytes;
+        uint32_t length = compressor.compress(words.data() + b * BLOCK_SAMPLES, BLOCK_SAMPLES,
+                                              record + RECORD_HEADER_BYTES);
+        record[0] = (uint8_t)length;
+        record[1] = (uint8_t)(length >> 8);
+        wire_bytes += RECORD_HEADER_BYTES + length;
+    }
+    double code_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<uint16_t> decoded(samples + capture::BlockCompressor::DECODE_SLACK);
+    start = Clock::now();
+    const uint8_t* p = wire.data();
+    for (uint64_t b = 0; b < blocks; b++) {
+        uint32_t length = p[0] | ((uint32_t)p[1] << 8);
+        if (compressor.decompress(p + RECORD_HEADER_BYTES, length, decoded.data() + b * BLOCK_SAMPLES,
+                                  BLOCK_SAMPLES) != BLOCK_SAMPLES) {
+            printf("%-6s FAILED at block %llu\n", name, (unsigned long long)b);
+            return false;
+        }
+        p += RECORD_HEADER_BYTES + length;
+    }
+    double decode_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    uint16_t mask = Traffic::mask();
+    for (size_t i = 0; i < samples; i++) {
+        if (decoded[i] != (words[i] & mask)) {
+            printf("%-6s FAILED at sample %zu\n", name, i);
+            return false;
+        }
+    }
+
+    double raw_bytes = samples * 2.0;
+    double ratio = raw_bytes / wire_bytes;
+    double link_rate = options.link_bytes * ratio / 2;
+    printf("%-6s %7.2f:1  decode %5.2f GB/s  code %5.2f GB/s (host)  link %7.2f MS/s", name, ratio,
+           raw_bytes / decode_seconds / 1e9, raw_bytes / code_seconds / 1e9, link_rate / 1e6);
+    if (options.device_cpb != 0) {
+        double device_rate = DEVICE_CLOCK_HZ / (double)options.device_cpb * 1024 / 2;
+        printf("  device %6.2f MS/s  -> %6.2f MS/s", device_rate / 1e6,
+               ((link_rate < device_rate) ? link_rate : device_rate) / 1e6);
+    }
+    printf("\n");
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "--samples" && has_value) {
+            options.samples = strtoull(argv[++k], nullptr, 0);
+        } else if (arg == "--rate" && has_value) {
+            options.rate_hz = (uint32_t)strtoul(argv[++k], nullptr, 0);
+        } else if (arg == "--link" && has_value) {
+            options.link_bytes = strtod(argv[++k], nullptr);
+        } else if (arg == "--device-cpb" && has_value) {
+            options.device_cpb = (uint32_t)strtoul(argv[++k], nullptr, 0);
+        } else {
+            fprintf(stderr, "usage: compress_bench [--samples N] [--rate HZ] [--link BYTES/S] [--device-cpb N]\n");
+            return 2;
+        }
+    }
+    if (options.samples == 0 || options.rate_hz == 0) {
+        fprintf(stderr, "--samples and --rate must not be 0\n");
+        return 2;
+    }
+    printf("%llu samples at %u Hz, link %.2f MB/s (raw: %.2f MS/s)\n", (unsigned long long)options.samples,
+           options.rate_hz, options.link_bytes / 1e6, options.link_bytes / 2 / 1e6);
+
+    bool ok = bench("idle", Traffic::Pattern::Idle, options);
+    ok = bench("uart", Traffic::Pattern::Uart, options) && ok;
+    ok = bench("i2c", Traffic::Pattern::I2c, options) && ok;
+    ok = bench("spi", Traffic::Pattern::Spi, options) && ok;
+    ok = bench("noise", Traffic::Pattern::Noise, options) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/**
+  ******************************************************************************
+  * @file           : decode_bench.cpp
+  * @brief          : Edge throughput of the Manchester / biphase-mark decoder
+  ******************************************************************************
+  *   decode_bench [--bits N] [--jitter PCT]
+  *
+  * Synthesizes a long stream of random bits in both codings (10 MHz ticks,
+  * 100 kbit/s, every edge moved by up to --jitter percent of a half bit),
+  * feeds it edge by edge to decode::ManchesterDecoder as the streaming
+  * path does, and reports edges per second and whether every bit after
+  * the lock came out right.
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "ManchesterDecoder.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using decode::ManchesterDecoder;
+
+const uint32_t SAMPLE_RATE_HZ = 10000000;
+const uint32_t BITRATE = 100000;
+
+// Counts decoded bits and compares them with what was sent
+class BitCheck : public decode::EventSink {
+public:
+    explicit BitCheck(const std::vector<uint8_t>& sent) : sent_(sent) {}
+
+    void onEvent(const decode::Event& event) override {
+        if (event.type == decode::EventType::ClockUnlock) {
+            unlocks_++;
+        }
+        if (event.type != decode::EventType::BitData) {
+            return;
+        }
+        for (int i = event.length - 1; i >= 0; i--) {
+            bits_.push_back((uint8_t)((event.value >> i) & 1));
+        }
+    }
+
+    // Decoded bits must be the sent ones minus a few lost while locking
+    bool ok() const {
+        if (bits_.size() > sent_.size() || bits_.size() + 8 < sent_.size()) {
+            return false;
+        }
+        size_t offset = sent_.size() - bits_.size();
+        for (size_t i = 0; i < bits_.size(); i++) {
+            if (bits_[i] != sent_[offset + i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t bits() const { return bits_.size(); }
+    uint32_t unlocks() const { return unlocks_; }
+
+private:
+    const std::vector<uint8_t>& sent_;
+    std::vector<uint8_t> bits_;
+    uint32_t unlocks_ = 0;
+};
+
+struct Stream {
+    std::vector<uint32_t> edges;
+    uint8_t first_level;
+    uint32_t end;
+};
+
+uint32_t random32(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+Stream synthesize(const std::vector<uint8_t>& bits, ManchesterDecoder::Coding coding, double jitter_pct) {
+    std::vector<uint8_t> halves;
+    uint8_t level = 1;
+    for (uint8_t bit : bits) {
+        if (coding == ManchesterDecoder::Coding::Manchester) {
+            halves.push_back(bit ^ 1);
+            halves.push_back(bit);
+        } else {
+            level ^= 1;
+            halves.push_back(level);
+            level ^= bit;
+            halves.push_back(level);
+        }
+    }
+    halves.push_back(halves.back() ^ 1);
+
+    Stream stream;
+    stream.first_level = halves[0];
+    double half = SAMPLE_RATE_HZ / (2.0 * BITRATE);
+    double jitter = half * jitter_pct / 100.0;
+    uint32_t state = 0x9E3779B9u;
+    for (size_t i = 1; i < halves.size(); i++) {
+        if (halves[i] != halves[i - 1]) {
+            double spread = ((random32(state) & 0xFFFF) / 32767.5 - 1.0) * jitter;
+            stream.edges.push_back((uint32_t)(i * half + spread));
+        }
+    }
+    stream.end = (uint32_t)((halves.size() + 20) * half);
+    return stream;
+}
+
+bool bench(const char* name, ManchesterDecoder::Coding coding, const std::vector<uint8_t>& bits, double jitter_pct) {
+    Stream stream = synthesize(bits, coding, jitter_pct);
+
+    ManchesterDecoder::Config config;
+    config.sample_rate_hz = SAMPLE_RATE_HZ;
+    config.bitrate = BITRATE;
+    config.coding = coding;
+    BitCheck check(bits);
+    ManchesterDecoder decoder(check, config);
+
+    Clock::time_point start = Clock::now();
+    uint8_t level = stream.first_level;
+    decoder.begin(0, level);
+    for (uint32_t t : stream.edges) {
+        level ^= 1;
+        decoder.edge(t, level);
+    }
+    decoder.end(stream.end);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    bool ok = check.ok();
+    printf("%-10s %10zu edges  %7.1f Medges/s  %10zu bits  %u unlocks  %s\n", name, stream.edges.size(),
+           stream.edges.size() / seconds / 1e6, check.bits(), check.unlocks(), ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = 8u << 20;
+    double jitter_pct = 10.0;
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "--bits" && has_value) {
+            count = strtoull(argv[++k], nullptr, 0);
+        } else if (arg == "--jitter" && has_value) {
+            jitter_pct = strtod(argv[++k], nullptr);
+        } else {
+            fprintf(stderr, "usage: decode_bench [--bits N] [--jitter PCT]\n");
+            return 2;
+        }
+    }
+    if (count == 0) {
+        fprintf(stderr, "--bits must not be 0\n");
+        return 2;
+    }
+
+    // A 0x55 preamble to lock on, then random data
+    std::vector<uint8_t> bits(count);
+    uint32_t state = 0x2545F491u;
+    for (size_t i = 0; i < count; i++) {
+        bits[i] = (i < 16) ? (uint8_t)(i & 1) : (uint8_t)(random32(state) & 1);
+    }
+
+    printf("%zu bits at %u bit/s, %u Hz ticks, +-%.0f%% edge jitter\n", count, BITRATE, SAMPLE_RATE_HZ, jitter_pct);
+    bool ok = bench("manchester", ManchesterDecoder::Coding::Manchester, bits, jitter_pct);
+    ok = bench("biphase", ManchesterDecoder::Coding::BiphaseMark, bits, jitter_pct) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+/**
+  ******************************************************************************
+  * @file           : export_bench.cpp
+  * @brief          : Throughput of the exporters on synthetic captures
+  ******************************************************************************
+  *   export_bench [--samples N] [--period N] [--out DIR]
+  *
+  * Synthesizes port words block by block (channel n toggles every
+  * period * 4^n samples, with jitter from an LFSR) and runs them through
+  * TransitionExport into each writer. Output goes to /dev/null unless
+  * --out names a directory for bench.vcd and bench.sr. Reports input
+  * samples and MB (2 bytes per sample) per second and the peak RSS, which
+  * should not depend on --samples.
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "sigrok_writer.hpp"
+#include "vcd_writer.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const uint32_t BENCH_RATE_HZ = 1000000;
+
+// Synthetic port words for one block; state carries over between blocks
+class Synthesizer {
+public:
+    explicit Synthesizer(uint32_t period) {
+        for (uint8_t ch = 0; ch < exporter::NUM_CHANNELS; ch++) {
+            periods_[ch] = period << (2 * ch);
+            next_[ch] = periods_[ch];
+        }
+    }
+
+    void fill(uint16_t* words, size_t count) {
+        for (size_t i = 0; i < count; i++, time_++) {
+            for (uint8_t ch = 0; ch < exporter::NUM_CHANNELS; ch++) {
+                if (time_ == next_[ch]) {
+                    word_ ^= (uint16_t)(1u << ch);
+                    lfsr_ = (lfsr_ >> 1) ^ (-(lfsr_ & 1u) & 0xB400u);
+                    next_[ch] += periods_[ch] + (lfsr_ & (periods_[ch] / 2));
+                }
+            }
+            words[i] = word_;
+        }
+    }
+
+private:
+    uint64_t periods_[exporter::NUM_CHANNELS];
+    uint64_t next_[exporter::NUM_CHANNELS];
+    uint64_t time_ = 0;
+    uint16_t word_ = 0;
+    uint32_t lfsr_ = 0xACE1u;
+};
+
+double run(exporter::ChangeSink& sink, uint64_t samples, uint32_t period, uint64_t& changes) {
+    exporter::CaptureInfo info;
+    info.rate_hz = BENCH_RATE_HZ;
+    exporter::TransitionExport exporter(info, sink);
+    Synthesizer synthesizer(period);
+    std::vector<uint16_t> block(exporter::TransitionExport::BLOCK_SAMPLES);
+
+    // Synthesis is timed apart and taken out
+    double synth_seconds = 0.0;
+    Clock::time_point start = Clock::now();
+    for (uint64_t done = 0; done < samples;) {
+        size_t n = (samples - done < block.size()) ? (size_t)(samples - done) : block.size();
+        Clock::time_point t = Clock::now();
+        synthesizer.fill(block.data(), n);
+        synth_seconds += std::chrono::duration<double>(Clock::now() - t).count();
+        if (!exporter.feedSamples(block.data(), n)) {
+            return -1.0;
+        }
+        done += n;
+    }
+    if (!exporter.finish(samples)) {
+        return -1.0;
+    }
+    changes = exporter.changeCount();
+    return std::chrono::duration<double>(Clock::now() - start).count() - synth_seconds;
+}
+
+void report(const char* name, uint64_t samples, uint64_t changes, uint64_t bytes, double seconds) {
+    if (seconds < 0.0) {
+        printf("%-6s FAILED\n", name);
+        return;
+    }
+    printf("%-6s %6.1f MS/s %7.1f MB/s in, %llu changes, %.1f MB out, %.2f s\n", name,
+           samples / seconds / 1e6, samples * 2.0 / seconds / 1e6, (unsigned long long)changes,
+           bytes / 1e6, seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t samples = 200000000;
+    uint32_t period = 16;
+    std::string out;
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        if (arg == "--samples" && k + 1 < argc) {
+            samples = strtoull(argv[++k], nullptr, 0);
+        } else if (arg == "--period" && k + 1 < argc) {
+            period = (uint32_t)strtoul(argv[++k], nullptr, 0);
+        } else if (arg == "--out" && k + 1 < argc) {
+            out = argv[++k];
+        } else {
+            fprintf(stderr, "usage: export_bench [--samples N] [--period N] [--out DIR]\n");
+            return 2;
+        }
+    }
+    if (period == 0) {
+        period = 1;
+    }
+    printf("%llu samples, CH0 toggles every %u samples\n", (unsigned long long)samples, period);
+
+    uint64_t changes = 0;
+    {
+        exporter::VcdWriter vcd;
+        if (!vcd.open(out.empty() ? "/dev/null" : out + "/bench.vcd")) {
+            return 2;
+        }
+        double seconds = run(vcd, samples, period, changes);
+        report("vcd", samples, changes, vcd.bytesWritten(), seconds);
+    }
+    {
+        exporter::SigrokWriter sigrok;
+        if (!sigrok.open(out.empty() ? "/dev/null" : out + "/bench.sr")) {
+            return 2;
+        }
+        double seconds = run(sigrok, samples, period, changes);
+        report("sr", samples, changes, sigrok.bytesWritten(), seconds);
+    }
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("peak RSS %ld kB\n", usage.ru_maxrss);
+    return 0;
+}
@@ -0,0 +1,843 @@
+/**
+  ******************************************************************************
+  * @file           : la_capture.cpp
+  * @brief          : Streaming capture client (device side: Core/Lib/PortStream)
+  ******************************************************************************
+  * Starts a continuous capture, stores the port words in a capture file
+  * (capture_file.hpp) and reports what arrived. Stream and command format:
+  * Core/Lib/PortStream.hpp.
+  *
+  *   la_capture --bulk [node] [--rate HZ | --divider N] [--samples N]
+  *              [--compress] [--sync] [-o FILE]
+  *       start a capture over the vendor bulk interface; --samples 0 (the
+  *       default) streams until Ctrl-C, which sends the stop command;
+  *       --compress asks for run-length coded blocks (BlockCompressor),
+  *       --sync for sync frames (USB start of frame stamps, for la_merge)
+  *   la_capture --input FILE|- [-o FILE]
+  *       read a recorded stream from a file, pipe or serial port (passive:
+  *       waits for the start frame, sends nothing)
+  *   la_capture --generate FILE --samples N [--rate HZ] [--compress]
+  *              [--sync [FRAME] [--offset US] [--ppm N] [--jitter US]]
+  *       write a synthetic recorded stream (a u16 counter) for offline runs;
+  *       with --sync, a simulated device on a rig: the channels see square
+  *       waves of USB frame time (CH n toggles every 250 << n us), the first
+  *       sample is taken --offset us after the start of frame FRAME (0), the
+  *       sample clock is off by --ppm and each SOF stamp is late by up to
+  *       --jitter us (interrupt latency)
+  *
+  * Raw payload is written into the mapped file as it arrives: a file
+  * descriptor is read straight into the mapping, a bulk URB is copied once.
+  * Coded records are decoded straight into the mapping (SSE2 stores). The
+  * end frame is recognised only at block or record boundaries, and so are
+  * sync frames, which are cut out of the payload and summed up in the
+  * file header (first and last SOF stamp). A coded stream keeps only the
+  * channel bits of the port words, the file format is the same.
+  *
+  * Exit status 0 when the stream ended with a done or stopped end frame
+  * whose sample count matches the samples received.
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "BlockCompressor.hpp"
+#include "capture_file.hpp"
+#include "usbfs.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const uint8_t START_COMMAND[8] = {'L', 'A', 'S', 'T', 'A', 'R', 'T', '!'};
+const uint8_t STOP_COMMAND[8] = {'L', 'A', 'S', 'T', 'O', 'P', '!', '!'};
+const uint8_t START_MAGIC[8] = {'L', 'A', 'S', 'T', 'R', 'E', 'A', 'M'};
+const uint8_t END_MAGIC[8] = {'L', 'A', 'S', 'T', 'E', 'N', 'D', '!'};
+const uint8_t SYNC_MAGIC[8] = {'L', 'A', 'S', 'Y', 'N', 'C', '!', '!'};
+const size_t COMMAND_BYTES = 20;
+const size_t START_FRAME_BYTES = 24;
+const size_t END_FRAME_BYTES = 32;
+const size_t SYNC_FRAME_BYTES = 24;
+const size_t RECORD_HEADER_BYTES = 2;
+const uint32_t FLAG_COMPRESS = 1u << 0;
+const uint32_t FLAG_SYNC = 1u << 1;
+const uint32_t ENCODING_RAW = 0;
+const uint32_t ENCODING_COMPRESSED = 1;
+const uint32_t DEVICE_CLOCK_HZ = 84000000;
+const uint32_t SOF_FRAME_MASK = 0x7FF;
+const uint32_t SYNC_INTERVAL_MS = 100;   // PortStream::SYNC_INTERVAL_MS
+
+// What the generator writes (the device's PortStream block)
+const uint16_t GENERATED_BLOCK_BYTES = 1024;
+
+const char* const STATUS_NAMES[] = {"done", "stopped", "overrun", "busy", "timeout"};
+
+volatile sig_atomic_t interrupted = 0;
+
+void onInterrupt(int) {
+    interrupted++;
+}
+
+uint32_t getWord(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void putWord(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+uint64_t getLong(const uint8_t* p) {
+    return getWord(p) | ((uint64_t)getWord(p + 4) << 32);
+}
+
+const char* statusName(uint32_t status) {
+    if (status == capture::CaptureFile::STATUS_CUT) {
+        return "cut off";
+    }
+    return (status < sizeof(STATUS_NAMES) / sizeof(STATUS_NAMES[0])) ? STATUS_NAMES[status] : "unknown";
+}
+
+// Stream parser writing the payload into the capture file
+class StreamParser {
+public:
+    enum class State { Search, Payload, Frame, Done };
+
+    explicit StreamParser(capture::CaptureFile& file) : file_(file) {
+        header_.status = capture::CaptureFile::STATUS_CUT;
+    }
+
+    // Bytes from anywhere (copied into the file while in the payload)
+    bool feed(const uint8_t* data, size_t length) {
+        while (length > 0 && state_ != State::Done) {
+            if (state_ == State::Search) {
+                size_t used = search(data, length);
+                data += used;
+                length -= used;
+            } else if (state_ == State::Payload && compressed_) {
+                size_t used;
+                if (!records(data, length, used)) {
+                    return false;
+                }
+                data += used;
+                length -= used;
+            } else if (state_ == State::Payload) {
+                size_t available;
+                uint8_t* space = payloadSpace(available);
+                if (space == nullptr) {
+                    return false;
+                }
+                size_t n = std::min(length, available);
+                memcpy(space, data, n);
+                received(n);
+                data += n;
+                length -= n;
+            } else {
+                size_t n = std::min(length, frameBytes() - frame_.size());
+                frame_.insert(frame_.end(), data, data + n);
+                data += n;
+                length -= n;
+                if (!checkFrame()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // While in the payload: where the next bytes go in the file
+    uint8_t* payloadSpace(size_t& available) {
+        uint8_t* space = file_.reserve(available);
+        if (space == nullptr) {
+            return nullptr;
+        }
+        available -= tail_;
+        return space + tail_;
+    }
+
+    // length bytes were written at payloadSpace(); sort them into payload,
+    // sync frames and the end frame, which can only start at a block
+    // boundary
+    void received(size_t length) {
+        if (!payload_started_) {
+            payload_start_ = Clock::now();
+            payload_started_ = true;
+        }
+        size_t available;
+        uint8_t* p = file_.reserve(available);
+        size_t left = tail_ + length;
+        while (left > 0) {
+            size_t offset = (size_t)(file_.size() % header_.block_bytes);
+            if (offset == 0) {
+                if (left < sizeof(END_MAGIC)) {
+                    break;
+                }
+                if (memcmp(p, SYNC_MAGIC, sizeof(SYNC_MAGIC)) == 0) {
+                    if (left < SYNC_FRAME_BYTES) {
+                        break;
+                    }
+                    onSync(p);
+                    // The payload after it moves down over the frame
+                    memmove(p, p + SYNC_FRAME_BYTES, left - SYNC_FRAME_BYTES);
+                    left -= SYNC_FRAME_BYTES;
+                    continue;
+                }
+                if (memcmp(p, END_MAGIC, sizeof(END_MAGIC)) == 0) {
+                    state_ = State::Frame;
+                    size_t n = std::min(left, END_FRAME_BYTES);
+                    frame_.assign(p, p + n);
+                    left = 0;
+                    checkFrame();
+                    break;
+                }
+            }
+            size_t n = std::min(left, (size_t)header_.block_bytes - offset);
+            file_.commit(n);
+            p += n;
+            left -= n;
+        }
+        tail_ = left;
+    }
+
+    State state() const { return state_; }
+    bool done() const { return state_ == State::Done; }
+    bool compressed() const { return compressed_; }
+    bool started() const { return started_; }
+
+    // Close the file and print what arrived
+    int finish() {
+        Clock::time_point end = done() ? end_time_ : Clock::now();
+        uint64_t bytes = file_.size();
+        header_.samples = (header_.sample_bytes != 0) ? bytes / header_.sample_bytes : 0;
+        if (!file_.finish(header_)) {
+            return 2;
+        }
+
+        if (!started_ && !done()) {
+            printf("no start frame seen\n");
+            return 1;
+        }
+        if (started_) {
+            printf("start frame: %u Hz, %u byte blocks, channel bits %u %u %u %u\n", header_.rate_hz,
+                   header_.block_bytes, header_.channel_bits[0], header_.channel_bits[1],
+                   header_.channel_bits[2], header_.channel_bits[3]);
+        }
+        printf("received: %llu samples (%llu bytes)\n", (unsigned long long)header_.samples,
+               (unsigned long long)bytes);
+        if (!done()) {
+            printf("no end frame (stream cut off)\n");
+            return 1;
+        }
+        printf("end frame: %llu samples in %u ms (device), %s\n", (unsigned long long)end_samples_,
+               header_.elapsed_ms, statusName(header_.status));
+        if (header_.sync_count != 0) {
+            printf("sync: %u frames, first at USB frame %u, sample %.2f\n", header_.sync_count,
+                   header_.first_sof_frame, header_.first_sof_position / 256.0);
+        }
+        if (header_.sof_frames != 0 && header_.rate_hz != 0) {
+            // Samples per USB millisecond against the nominal rate
+            double samples = (header_.last_sof_position - header_.first_sof_position) / 256.0;
+            double ppm = (samples / (header_.sof_frames * (header_.rate_hz / 1000.0)) - 1.0) * 1e6;
+            printf("sync: sample clock %+.1f ppm against USB frames over %.1f s\n", ppm,
+                   header_.sof_frames / 1000.0);
+        }
+        if (compressed_ && wire_bytes_ != 0) {
+            printf("compressed: %llu bytes on the wire, %.2f:1\n", (unsigned long long)wire_bytes_,
+                   (double)bytes / wire_bytes_);
+        }
+        if (cycles_per_kb_ != 0) {
+            printf("device coding: %u cycles/KB (%.1f MB/s at %u MHz)\n", cycles_per_kb_,
+                   DEVICE_CLOCK_HZ / (double)cycles_per_kb_ * 1024 / 1e6, DEVICE_CLOCK_HZ / 1000000);
+        }
+
+        double seconds = std::chrono::duration<double>(end - payload_start_).count();
+        if (payload_started_ && seconds > 0.0) {
+            if (compressed_) {
+                printf("throughput: %.2f MB/s on the wire, %.2f MB/s of samples over %.2f s (host)\n",
+                       wire_bytes_ / seconds / 1e6, bytes / seconds / 1e6, seconds);
+            } else {
+                printf("throughput: %.2f MB/s over %.2f s (host)\n", bytes / seconds / 1e6, seconds);
+            }
+        }
+        bool pass = (header_.status == 0 || header_.status == 1) && end_samples_ == header_.samples;
+        return pass ? 0 : 1;
+    }
+
+private:
+    // Look for a start frame (or a lone end frame: the device refused)
+    size_t search(const uint8_t* data, size_t length) {
+        pending_.insert(pending_.end(), data, data + length);
+        auto start = std::search(pending_.begin(), pending_.end(), START_MAGIC, START_MAGIC + 8);
+        auto end = std::search(pending_.begin(), pending_.end(), END_MAGIC, END_MAGIC + 8);
+        auto found = std::min(start, end);
+        if (found == pending_.end()) {
+            // Keep what could be the start of a split magic
+            size_t keep = std::min(pending_.size(), sizeof(START_MAGIC) - 1);
+            pending_.erase(pending_.begin(), pending_.end() - keep);
+            return length;
+        }
+        if ((size_t)(pending_.end() - found) < START_FRAME_BYTES && found == start) {
+            pending_.erase(pending_.begin(), found);
+            return length;
+        }
+
+        std::vector<uint8_t> rest(found, pending_.end());
+        pending_.clear();
+        if (found == end) {
+            state_ = State::Frame;
+            frame_.clear();
+            feed(rest.data(), rest.size());
+            return length;
+        }
+
+        header_.rate_hz = getWord(&rest[8]);
+        header_.block_bytes = (uint16_t)(rest[12] | (rest[13] << 8));
+        header_.sample_bytes = (uint16_t)(rest[14] | (rest[15] << 8));
+        memcpy(header_.channel_bits, &rest[16], sizeof(header_.channel_bits));
+        uint32_t encoding = getWord(&rest[20]);
+        if (header_.block_bytes < END_FRAME_BYTES || header_.sample_bytes == 0 ||
+            capture::CaptureFile::WINDOW_BYTES % header_.block_bytes != 0) {
+            fprintf(stderr, "start frame: unusable block of %u bytes\n", header_.block_bytes);
+            state_ = State::Done;
+            return length;
+        }
+        if (encoding != ENCODING_RAW && (encoding != ENCODING_COMPRESSED || header_.sample_bytes != 2)) {
+            fprintf(stderr, "start frame: unknown encoding %u\n", encoding);
+            state_ = State::Done;
+            return length;
+        }
+        compressed_ = (encoding == ENCODING_COMPRESSED);
+        if (compressed_) {
+            compressor_.setChannels(header_.channel_bits);
+            block_samples_ = header_.block_bytes / 2;
+            record_.reserve(RECORD_HEADER_BYTES + capture::BlockCompressor::maxCompressed(block_samples_));
+            decoded_.resize(block_samples_ + capture::BlockCompressor::DECODE_SLACK);
+        }
+        started_ = true;
+        state_ = State::Payload;
+        feed(rest.data() + START_FRAME_BYTES, rest.size() - START_FRAME_BYTES);
+        return length;
+    }
+
+    // Coded payload: u16 length + one block per record, or a sync or end
+    // frame (whose "LA" is no valid length); false if the stream is corrupt
+    bool records(const uint8_t* data, size_t length, size_t& used) {
+        if (!payload_started_) {
+            payload_start_ = Clock::now();
+            payload_started_ = true;
+        }
+        const uint8_t* p = data;
+        const uint8_t* end = data + length;
+        while (p < end && state_ == State::Payload) {
+            // Whole records are decoded from the input, split ones gathered
+            if (record_.empty() && end - p >= (ptrdiff_t)RECORD_HEADER_BYTES) {
+                if (isFrame(p)) {
+                    state_ = State::Frame;
+                    frame_.clear();
+                    break;
+                }
+                size_t size = recordSize(p);
+                if (!checkSize(size)) {
+                    return false;
+                }
+                if ((size_t)(end - p) >= RECORD_HEADER_BYTES + size) {
+                    if (!decode(p + RECORD_HEADER_BYTES, size)) {
+                        return false;
+                    }
+                    p += RECORD_HEADER_BYTES + size;
+                    continue;
+                }
+            }
+
+            size_t need = RECORD_HEADER_BYTES;
+            if (record_.size() >= RECORD_HEADER_BYTES) {
+                need += recordSize(record_.data());
+            }
+            size_t n = std::min((size_t)(end - p), need - record_.size());
+            record_.insert(record_.end(), p, p + n);
+            p += n;
+            if (record_.size() < need) {
+                continue;
+            }
+            if (need == RECORD_HEADER_BYTES) {
+                // Header complete: a frame or the length to gather
+                if (isFrame(record_.data())) {
+                    state_ = State::Frame;
+                    frame_.assign(record_.begin(), record_.end());
+                    record_.clear();
+                    break;
+                }
+                if (!checkSize(recordSize(record_.data()))) {
+                    return false;
+                }
+                continue;
+            }
+            if (!decode(record_.data() + RECORD_HEADER_BYTES, record_.size() - RECORD_HEADER_BYTES)) {
+                return false;
+            }
+            record_.clear();
+        }
+        used = (size_t)(p - data);
+        return true;
+    }
+
+    static bool isFrame(const uint8_t* header) { return header[0] == END_MAGIC[0] && header[1] == END_MAGIC[1]; }
+
+    static size_t recordSize(const uint8_t* header) { return header[0] | ((size_t)header[1] << 8); }
+
+    bool checkSize(size_t size) const {
+        if (size == 0 || size > capture::BlockCompressor::maxCompressed(block_samples_)) {
+            fprintf(stderr, "record of %zu bytes: stream is corrupt\n", size);
+            return false;
+        }
+        return true;
+    }
+
+    // One block into the file: in place when the window has room for the
+    // decoder's overshoot, else through a bounce buffer
+    bool decode(const uint8_t* in, size_t size) {
+        wire_bytes_ += RECORD_HEADER_BYTES + size;
+        size_t available;
+        uint8_t* space = file_.reserve(available);
+        if (space == nullptr) {
+            return false;
+        }
+        size_t needed = (block_samples_ + capture::BlockCompressor::DECODE_SLACK) * 2;
+        uint16_t* out = (available >= needed) ? (uint16_t*)space : decoded_.data();
+        if (compressor_.decompress(in, (uint32_t)size, out, block_samples_) != block_samples_) {
+            fprintf(stderr, "record of %zu bytes: stream is corrupt\n", size);
+            return false;
+        }
+        if (out == decoded_.data()) {
+            return file_.append((const uint8_t*)out, header_.block_bytes);
+        }
+        file_.commit(header_.block_bytes);
+        return true;
+    }
+
+    // Bytes of the frame being gathered: the magic tells its length
+    size_t frameBytes() const {
+        if (frame_.size() >= sizeof(SYNC_MAGIC) && memcmp(frame_.data(), SYNC_MAGIC, sizeof(SYNC_MAGIC)) == 0) {
+            return SYNC_FRAME_BYTES;
+        }
+        return (frame_.size() < sizeof(END_MAGIC)) ? sizeof(END_MAGIC) : END_FRAME_BYTES;
+    }
+
+    // A gathered sync frame returns to the payload, an end frame ends it;
+    // false for anything else
+    bool checkFrame() {
+        if (frame_.size() < frameBytes()) {
+            return true;
+        }
+        if (frame_.size() == SYNC_FRAME_BYTES && memcmp(frame_.data(), SYNC_MAGIC, sizeof(SYNC_MAGIC)) == 0) {
+            onSync(frame_.data());
+            frame_.clear();
+            state_ = State::Payload;
+            return true;
+        }
+        if (memcmp(frame_.data(), END_MAGIC, sizeof(END_MAGIC)) != 0) {
+            fprintf(stderr, "unknown frame: stream is corrupt\n");
+            state_ = State::Done;
+            return false;
+        }
+        if (frame_.size() < END_FRAME_BYTES) {
+            return true;
+        }
+        end_samples_ = getLong(&frame_[8]);
+        header_.status = getWord(&frame_[16]);
+        header_.elapsed_ms = getWord(&frame_[20]);
+        cycles_per_kb_ = getWord(&frame_[24]);
+        end_time_ = Clock::now();
+        state_ = State::Done;
+        return true;
+    }
+
+    // First and last stamp go into the header; the frame number is
+    // unwrapped in between (sync frames come every SYNC_INTERVAL_MS)
+    void onSync(const uint8_t* frame) {
+        uint64_t position = getLong(frame + 8);
+        uint32_t number = getWord(frame + 16) & SOF_FRAME_MASK;
+        if (header_.sync_count == 0) {
+            header_.first_sof_frame = number;
+            header_.first_sof_position = position;
+        } else {
+            header_.sof_frames += (number - last_sof_frame_) & SOF_FRAME_MASK;
+        }
+        header_.last_sof_position = position;
+        header_.sync_count++;
+        last_sof_frame_ = number;
+    }
+
+    capture::CaptureFile& file_;
+    capture::CaptureHeader header_;
+    State state_ = State::Search;
+    bool started_ = false;
+    std::vector<uint8_t> pending_;
+    std::vector<uint8_t> frame_;    // Sync or end frame being gathered
+    size_t tail_ = 0;               // Unsorted bytes after the payload (< a sync frame)
+    bool compressed_ = false;
+    capture::BlockCompressor compressor_;
+    uint32_t block_samples_ = 0;
+    std::vector<uint8_t> record_;   // A record split across reads
+    std::vector<uint16_t> decoded_;
+    uint64_t wire_bytes_ = 0;       // Record bytes received
+    uint32_t cycles_per_kb_ = 0;
+    uint64_t end_samples_ = 0;
+    uint32_t last_sof_frame_ = 0;
+    bool payload_started_ = false;
+    Clock::time_point payload_start_;
+    Clock::time_point end_time_;
+};
+
+bool makeRaw(int fd) {
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIFLUSH);
+    return true;
+}
+
+void printPeakMemory() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        printf("peak RSS: %ld kB\n", usage.ru_maxrss);
+    }
+}
+
+void catchInterrupt() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onInterrupt;   // No SA_RESTART: blocking calls return EINTR
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+int runInput(const std::string& input, const std::string& output) {
+    int fd = (input == "-") ? STDIN_FILENO : open(input.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(input.c_str());
+        return 2;
+    }
+    bool tty = isatty(fd) && makeRaw(fd);
+    capture::CaptureFile file;
+    if (!file.open(output)) {
+        return 2;
+    }
+    if (tty) {
+        printf("waiting for a stream on %s...\n", input.c_str());
+        fflush(stdout);
+    }
+    catchInterrupt();
+
+    StreamParser parser(file);
+    std::vector<uint8_t> buffer(64 * 1024);
+    while (!parser.done() && !interrupted) {
+        if (parser.state() == StreamParser::State::Payload && !parser.compressed()) {
+            size_t available;
+            uint8_t* space = parser.payloadSpace(available);
+            if (space == nullptr) {
+                break;
+            }
+            ssize_t n = read(fd, space, available);
+            if (n <= 0) {
+                break;  // End of a recorded stream, the port went away or Ctrl-C
+            }
+            parser.received((size_t)n);
+        } else {
+            ssize_t n = read(fd, buffer.data(), buffer.size());
+            if (n <= 0) {
+                break;
+            }
+            if (!parser.feed(buffer.data(), (size_t)n)) {
+                break;
+            }
+        }
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    int status = parser.finish();
+    printPeakMemory();
+    return status;
+}
+
+int runBulk(const std::string& node, uint32_t divider, uint32_t samples, uint32_t flags, const std::string& output) {
+    usbfs::BulkDevice device;
+    if (!device.open(node)) {
+        return 2;
+    }
+    capture::CaptureFile file;
+    if (!file.open(output)) {
+        return 2;
+    }
+    device.drain();
+
+    uint8_t command[COMMAND_BYTES] = {};
+    memcpy(command, START_COMMAND, sizeof(START_COMMAND));
+    putWord(command + 8, divider);
+    putWord(command + 12, samples);
+    putWord(command + 16, flags);
+    if (!device.send(command, sizeof(command))) {
+        return 2;
+    }
+    printf("capturing from %s at %u Hz, %s%s%s (Ctrl-C stops)...\n", device.node().c_str(),
+           DEVICE_CLOCK_HZ / divider, (samples != 0) ? (std::to_string(samples) + " samples").c_str()
+                                                      : "until stopped",
+           (flags & FLAG_COMPRESS) ? ", compressed" : "", (flags & FLAG_SYNC) ? ", sync frames" : "");
+    fflush(stdout);
+    catchInterrupt();
+
+    StreamParser parser(file);
+    bool stop_sent = false;
+    device.stream(
+        [&](const uint8_t* data, size_t length) { return parser.feed(data, length) && !parser.done(); },
+        [&]() {
+            // First Ctrl-C asks the device to stop, the second gives up
+            if (!stop_sent) {
+                uint8_t stop[COMMAND_BYTES] = {};
+                memcpy(stop, STOP_COMMAND, sizeof(STOP_COMMAND));
+                stop_sent = device.send(stop, sizeof(stop));
+                return stop_sent;
+            }
+            return interrupted < 2;
+        });
+    device.close();
+    int status = parser.finish();
+    printPeakMemory();
+    return status;
+}
+
+// A simulated device on a rig for --generate --sync (times in us from
+// the start of frame first_frame)
+struct Rig {
+    bool sync = false;
+    uint32_t first_frame = 0;
+    double offset_us = 0.0;   // First sample
+    double ppm = 0.0;         // Sample clock error
+    double jitter_us = 0.0;   // Largest SOF stamp delay
+};
+
+// Port word at host time t (us from USB frame 0): CH n toggles every
+// 250 << n us, on every simulated device alike
+uint16_t rigWord(double t_us, const uint8_t* bits) {
+    uint16_t word = 0;
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        if (t_us >= 0.0 && ((uint64_t)(t_us / (250u << ch)) & 1u) != 0) {
+            word = (uint16_t)(word | (1u << bits[ch]));
+        }
+    }
+    return word;
+}
+
+// Recorded stream of a capture of a u16 counter (or of the rig signals),
+// raw or coded the way the device codes it
+int generate(const std::string& path, uint64_t samples, uint32_t rate, bool compress, const Rig& rig) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        perror(path.c_str());
+        return 2;
+    }
+    const uint64_t block_samples = GENERATED_BLOCK_BYTES / 2;
+    uint64_t blocks = (samples + block_samples - 1) / block_samples;
+
+    uint8_t frame[END_FRAME_BYTES] = {};
+    memcpy(frame, START_MAGIC, sizeof(START_MAGIC));
+    putWord(frame + 8, rate);
+    frame[12] = (uint8_t)GENERATED_BLOCK_BYTES;
+    frame[13] = (uint8_t)(GENERATED_BLOCK_BYTES >> 8);
+    frame[14] = 2;
+    const uint8_t bits[4] = {8, 15, 6, 2};
+    memcpy(frame + 16, bits, sizeof(bits));
+    putWord(frame + 20, compress ? ENCODING_COMPRESSED : ENCODING_RAW);
+    fwrite(frame, 1, START_FRAME_BYTES, f);
+
+    capture::BlockCompressor compressor(bits);
+    std::vector<uint16_t> words(block_samples);
+    std::vector<uint8_t> chunk(256 * GENERATED_BLOCK_BYTES);
+    uint64_t sample = 0;
+    uint64_t written = 0;
+    // Samples per us of host time, and the next SOF to stamp
+    double clock = rate * (1.0 + rig.ppm * 1e-6) / 1e6;
+    uint64_t sof_ms = (rig.offset_us > 0.0) ? (uint64_t)(rig.offset_us / 1000.0) + 1 : 0;
+    uint32_t jitter_state = 1;
+    uint32_t sync_frames = 0;
+    for (uint64_t block = 0; block < blocks; block++) {
+        // The device sends a sync frame between blocks once its SOF has passed
+        while (rig.sync) {
+            jitter_state = jitter_state * 1103515245u + 12345u;
+            double stamp_us = sof_ms * 1000.0 + rig.jitter_us * ((jitter_state >> 16) & 0x7FFF) / 0x7FFF;
+            double position = (stamp_us - rig.offset_us) * clock;
+            if (position > (double)sample) {
+                break;
+            }
+            if (fwrite(chunk.data(), 1, written, f) != written) {
+                perror(path.c_str());
+                fclose(f);
+                return 2;
+            }
+            written = 0;
+            memset(frame, 0, sizeof(frame));
+            memcpy(frame, SYNC_MAGIC, sizeof(SYNC_MAGIC));
+            uint64_t fixed = (uint64_t)(position * 256.0 + 0.5);
+            putWord(frame + 8, (uint32_t)fixed);
+            putWord(frame + 12, (uint32_t)(fixed >> 32));
+            putWord(frame + 16, (uint32_t)((rig.first_frame + sof_ms) & SOF_FRAME_MASK));
+            fwrite(frame, 1, SYNC_FRAME_BYTES, f);
+            sync_frames++;
+            sof_ms += SYNC_INTERVAL_MS;
+        }
+        for (uint64_t k = 0; k < block_samples; k++, sample++) {
+            words[k] = rig.sync ? rigWord(rig.first_frame * 1000.0 + rig.offset_us + sample / clock, bits)
+                                : (uint16_t)sample;
+        }
+        size_t length = GENERATED_BLOCK_BYTES;
+        uint8_t* p = chunk.data() + written;
+        if (compress) {
+            length = compressor.compress(words.data(), (uint32_t)block_samples, p + RECORD_HEADER_BYTES);
+            p[0] = (uint8_t)length;
+            p[1] = (uint8_t)(length >> 8);
+            length += RECORD_HEADER_BYTES;
+        } else {
+            for (uint64_t k = 0; k < block_samples; k++) {
+                p[2 * k] = (uint8_t)words[k];
+                p[2 * k + 1] = (uint8_t)(words[k] >> 8);
+            }
+        }
+        written += length;
+        // Room for one more block or record (at most a raw block plus its length)
+        if (written + GENERATED_BLOCK_BYTES + RECORD_HEADER_BYTES > chunk.size() || block + 1 == blocks) {
+            if (fwrite(chunk.data(), 1, written, f) != written) {
+                perror(path.c_str());
+                fclose(f);
+                return 2;
+            }
+            written = 0;
+        }
+    }
+
+    memset(frame, 0, sizeof(frame));
+    memcpy(frame, END_MAGIC, sizeof(END_MAGIC));
+    putWord(frame + 8, (uint32_t)sample);
+    putWord(frame + 12, (uint32_t)(sample >> 32));
+    putWord(frame + 16, 0);
+    putWord(frame + 20, (rate != 0) ? (uint32_t)(sample * 1000 / rate) : 0);
+    fwrite(frame, 1, END_FRAME_BYTES, f);
+    if (fclose(f) != 0) {
+        perror(path.c_str());
+        return 2;
+    }
+    printf("%s: %llu samples in %llu blocks", path.c_str(), (unsigned long long)sample,
+           (unsigned long long)blocks);
+    if (rig.sync) {
+        printf(", %u sync frames", sync_frames);
+    }
+    printf("\n");
+    return 0;
+}
+
+int usage() {
+    fprintf(stderr,
+            "usage: la_capture --bulk [node] [--rate HZ | --divider N] [--samples N] [--compress] [--sync]\n"
+            "                  [-o FILE]\n"
+            "       la_capture --input FILE|- [-o FILE]\n"
+            "       la_capture --generate FILE --samples N [--rate HZ] [--compress]\n"
+            "                  [--sync [FRAME] [--offset US] [--ppm N] [--jitter US]]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    enum class Mode { None, Bulk, Input, Generate } mode = Mode::None;
+    std::string source;
+    std::string output = "capture.lacap";
+    uint32_t divider = 840;   // 100 kHz
+    uint64_t samples = 0;
+    bool have_samples = false;
+    bool compress = false;
+    bool sync = false;
+    Rig rig;
+
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "--bulk") {
+            mode = Mode::Bulk;
+            if (has_value && argv[k + 1][0] != '-') {
+                source = argv[++k];
+            }
+        } else if ((arg == "--input" || arg == "--generate") && has_value) {
+            mode = (arg == "--input") ? Mode::Input : Mode::Generate;
+            source = argv[++k];
+        } else if (arg == "--rate" && has_value) {
+            uint32_t rate = (uint32_t)strtoul(argv[++k], nullptr, 0);
+            divider = (rate != 0) ? std::max<uint32_t>(1, DEVICE_CLOCK_HZ / rate) : 0;
+        } else if (arg == "--divider" && has_value) {
+            divider = (uint32_t)strtoul(argv[++k], nullptr, 0);
+        } else if (arg == "--samples" && has_value) {
+            samples = strtoull(argv[++k], nullptr, 0);
+            have_samples = true;
+        } else if (arg == "--compress") {
+            compress = true;
+        } else if (arg == "--sync") {
+            // The first frame number, when generating
+            sync = true;
+            if (has_value && isdigit((unsigned char)argv[k + 1][0])) {
+                rig.first_frame = (uint32_t)strtoul(argv[++k], nullptr, 0) & SOF_FRAME_MASK;
+            }
+        } else if (arg == "--offset" && has_value) {
+            rig.offset_us = strtod(argv[++k], nullptr);
+        } else if (arg == "--ppm" && has_value) {
+            rig.ppm = strtod(argv[++k], nullptr);
+        } else if (arg == "--jitter" && has_value) {
+            rig.jitter_us = strtod(argv[++k], nullptr);
+        } else if (arg == "-o" && has_value) {
+            output = argv[++k];
+        } else {
+            return usage();
+        }
+    }
+    if (divider == 0) {
+        return usage();
+    }
+
+    switch (mode) {
+    case Mode::Bulk:
+        if (samples > UINT32_MAX) {
+            fprintf(stderr, "--samples: at most %u per capture\n", UINT32_MAX);
+            return 2;
+        }
+        return runBulk(source, divider, (uint32_t)samples,
+                       (compress ? FLAG_COMPRESS : 0) | (sync ? FLAG_SYNC : 0), output);
+    case Mode::Input:
+        return runInput(source, output);
+    case Mode::Generate:
+        if (!have_samples) {
+            return usage();
+        }
+        rig.sync = sync;
+        return generate(source, samples, DEVICE_CLOCK_HZ / divider, compress, rig);
+    default:
+        return usage();
+    }
+}
@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file           : la_export.cpp
+  * @brief          : Convert a capture file to VCD and/or a sigrok session
+  ******************************************************************************
+  *   la_export capture.lacap [--vcd out.vcd|-] [--sr out.sr] [--min-width N]
+  *
+  * The port words go through the firmware's TransitionEncoder (--min-width
+  * is its pulse filter, as on the device) and are exported from the
+  * transition runs block by block; see transition_export.hpp.
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "sigrok_writer.hpp"
+#include "vcd_writer.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Both outputs from one pass
+class TeeSink : public exporter::ChangeSink {
+public:
+    TeeSink(exporter::ChangeSink* first, exporter::ChangeSink* second) : first_(first), second_(second) {}
+
+    bool begin(const exporter::CaptureInfo& info, uint8_t levels) override {
+        return (first_ == nullptr || first_->begin(info, levels)) &&
+               (second_ == nullptr || second_->begin(info, levels));
+    }
+
+    bool changes(const exporter::Change* changes, size_t count, uint64_t horizon) override {
+        return (first_ == nullptr || first_->changes(changes, count, horizon)) &&
+               (second_ == nullptr || second_->changes(changes, count, horizon));
+    }
+
+    bool end(uint64_t samples) override {
+        return (first_ == nullptr || first_->end(samples)) && (second_ == nullptr || second_->end(samples));
+    }
+
+private:
+    exporter::ChangeSink* first_;
+    exporter::ChangeSink* second_;
+};
+
+int usage() {
+    fprintf(stderr, "usage: la_export capture.lacap [--vcd out.vcd|-] [--sr out.sr] [--min-width N]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string input;
+    std::string vcd_path;
+    std::string sr_path;
+    unsigned long min_width = 1;
+
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "--vcd" && has_value) {
+            vcd_path = argv[++k];
+        } else if (arg == "--sr" && has_value) {
+            sr_path = argv[++k];
+        } else if (arg == "--min-width" && has_value) {
+            min_width = strtoul(argv[++k], nullptr, 0);
+        } else if (arg[0] != '-' && input.empty()) {
+            input = arg;
+        } else {
+            return usage();
+        }
+    }
+    if (input.empty() || (vcd_path.empty() && sr_path.empty()) ||
+        min_width > capture::TransitionEncoder::MAX_MIN_WIDTH) {
+        return usage();
+    }
+
+    exporter::VcdWriter vcd;
+    exporter::SigrokWriter sigrok;
+    if ((!vcd_path.empty() && !vcd.open(vcd_path)) || (!sr_path.empty() && !sigrok.open(sr_path))) {
+        return 2;
+    }
+    TeeSink sink(vcd_path.empty() ? nullptr : &vcd, sr_path.empty() ? nullptr : &sigrok);
+
+    Clock::time_point start = Clock::now();
+    bool ok = exporter::exportCaptureFile(input, (uint8_t)min_width, sink);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Progress and results on stderr, VCD may be on stdout
+    if (!vcd_path.empty()) {
+        fprintf(stderr, "vcd: %llu bytes\n", (unsigned long long)vcd.bytesWritten());
+    }
+    if (!sr_path.empty()) {
+        fprintf(stderr, "sr: %llu samples\n", (unsigned long long)sigrok.bytesWritten());
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "%.2f s, peak RSS %ld kB%s\n", seconds, usage.ru_maxrss, ok ? "" : ", FAILED");
+    return ok ? 0 : 1;
+}
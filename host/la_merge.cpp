@@ -0,0 +1,521 @@
+/**
+  ******************************************************************************
+  * @file           : la_merge.cpp
+  * @brief          : Merge captures of several analyzers onto one timeline
+  ******************************************************************************
+  *   la_merge [-o out.vcd|-] [--min-width N] INPUT INPUT...
+  *       INPUT: a recorded stream captured with sync frames (file or "-"),
+  *       or a .lacap file from la_capture --sync
+  *
+  * Analyzers on one host controller see the same USB start of frame
+  * numbers, 1 ms apart. Each sync frame (Core/Lib/PortStream.hpp) places
+  * one SOF on a device's sample clock, so between two of them the
+  * device's samples map linearly onto USB frame time, whatever its
+  * crystal is off by; the mapping is good to the SOF interrupt latency
+  * (microseconds). Before the first sync frame and after the last the
+  * nearest segment is extended; a .lacap file keeps only its first and
+  * last stamp, one segment for the whole capture.
+  *
+  * The frame number is only 11 bits: the captures must start within a
+  * second of each other. Time 0 of every device is the first SOF number
+  * seen on any input.
+  *
+  * Streaming: each input goes through TransitionExport (--min-width as in
+  * la_export) and its changes are timed once a sync frame after them has
+  * arrived; the input whose timed changes end earliest is read next, and
+  * changes are written as soon as no input can still have an earlier one.
+  * Memory is a sync interval of changes per input. The output is VCD with
+  * a module per input (dev0, dev1, ...) in ns from the first change.
+  ******************************************************************************
+  */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "capture_file.hpp"
+#include "stream_decoder.hpp"
+#include "transition_export.hpp"
+
+namespace {
+
+const uint32_t SOF_FRAME_MASK = 0x7FF;
+const uint32_t SOF_FRAMES = SOF_FRAME_MASK + 1;
+const size_t MAX_INPUTS = 16;       // VCD identifiers '!' + 4 per input
+const size_t READ_BYTES = 64 * 1024;
+const double RATE_TOLERANCE = 0.01; // Sync frames that disagree more with the rate
+const int64_t NEVER = std::numeric_limits<int64_t>::max();
+
+// The SOF number that is time 0, from the first input to have one
+struct Timeline {
+    bool known = false;
+    uint32_t reference = 0;
+};
+
+struct Timed {
+    int64_t ns;
+    uint8_t channel;
+    uint8_t level;
+};
+
+// One input: decoded stream or capture file -> changes -> timed changes.
+// Both sink interfaces: StreamSink from the decoder, ChangeSink from the
+// transition export.
+class Input : public capture::StreamSink, public exporter::ChangeSink {
+public:
+    Input(const std::string& path, uint8_t min_width, Timeline& timeline)
+        : path_(path), min_width_(min_width), timeline_(timeline), decoder_(*this) {}
+
+    ~Input() override {
+        if (fd_ >= 0 && fd_ != STDIN_FILENO) {
+            close(fd_);
+        }
+    }
+
+    bool open() {
+        fd_ = (path_ == "-") ? STDIN_FILENO : ::open(path_.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            perror(path_.c_str());
+            return false;
+        }
+        capture::CaptureHeader header;
+        if (fd_ == STDIN_FILENO || !capture::CaptureFile::readHeader(fd_, header)) {
+            return true;   // A recorded stream
+        }
+        if (header.sample_bytes != 2) {
+            fprintf(stderr, "%s: not a capture file of 16-bit samples\n", path_.c_str());
+            return false;
+        }
+        if (header.sync_count == 0) {
+            fprintf(stderr, "%s: captured without sync frames\n", path_.c_str());
+            return false;
+        }
+        file_ = true;
+        capture::StreamStart start;
+        start.rate_hz = header.rate_hz;
+        memcpy(start.channel_bits, header.channel_bits, sizeof(start.channel_bits));
+        this->start(start);
+        sync(header.first_sof_position, header.first_sof_frame);
+        if (header.sync_count > 1) {
+            addPoint(header.last_sof_position / 256.0, points_.back().frame + (int64_t)header.sof_frames);
+        }
+        sync_count_ = header.sync_count;
+        return lseek(fd_, capture::CaptureFile::HEADER_BYTES, SEEK_SET) >= 0;
+    }
+
+    // Decode the next chunk; false on an error
+    bool readMore() {
+        uint8_t buffer[READ_BYTES];
+        ssize_t n = read(fd_, buffer, sizeof(buffer) - sizeof(buffer) % 2);
+        if (n < 0) {
+            perror(path_.c_str());
+            return false;
+        }
+        if (n == 0) {
+            if (!decoder_.done() && !file_) {
+                fprintf(stderr, "%s: %s\n", path_.c_str(),
+                        decoder_.started() ? "no end frame (stream cut off)" : "no start frame");
+            }
+            return finish();
+        }
+        if (file_) {
+            std::vector<uint16_t> words((size_t)n / 2);
+            for (size_t k = 0; k < words.size(); k++) {
+                words[k] = (uint16_t)(buffer[2 * k] | (buffer[2 * k + 1] << 8));
+            }
+            return samples(words.data(), words.size());
+        }
+        if (!decoder_.feed(buffer, (size_t)n)) {
+            return false;
+        }
+        return !decoder_.done() || finish();
+    }
+
+    bool finished() const { return finished_; }
+
+    // No timed change can come before this any more
+    int64_t horizon() const {
+        if (finished_) {
+            return NEVER;
+        }
+        if (points_.size() < 2) {
+            return std::numeric_limits<int64_t>::min();
+        }
+        double last = std::min(points_.back().position, (double)export_horizon_);
+        return nsOf(last);
+    }
+
+    const std::deque<Timed>& timed() const { return timed_; }
+    void pop() { timed_.pop_front(); }
+
+    const std::string& path() const { return path_; }
+    bool started() const { return exporter_ != nullptr; }
+
+    void summary(uint8_t index) const {
+        fprintf(stderr, "dev%u %s: %u Hz, %llu samples, %llu sync frames", index, path_.c_str(), info_.rate_hz,
+                (unsigned long long)samples_, (unsigned long long)sync_count_);
+        if (first_.frame != last_.frame && info_.rate_hz != 0) {
+            double expected = (last_.frame - first_.frame) * (info_.rate_hz / 1000.0);
+            double ppm = ((last_.position - first_.position) / expected - 1.0) * 1e6;
+            fprintf(stderr, ", clock %+.1f ppm against USB frames", ppm);
+        }
+        if (residuals_ != 0) {
+            fprintf(stderr, ", sync residual up to %.1f us", max_residual_us_);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    // capture::StreamSink
+    bool start(const capture::StreamStart& start) override {
+        info_.rate_hz = start.rate_hz;
+        memcpy(info_.channel_bits, start.channel_bits, sizeof(info_.channel_bits));
+        if (info_.rate_hz == 0) {
+            fprintf(stderr, "%s: no sample rate\n", path_.c_str());
+            return false;
+        }
+        exporter_.reset(new exporter::TransitionExport(info_, *this));
+        exporter_->setMinWidth(min_width_);
+        return true;
+    }
+
+    bool samples(const uint16_t* words, size_t count) override {
+        samples_ += count;
+        return exporter_->feedSamples(words, count);
+    }
+
+    bool sync(uint64_t position, uint32_t frame) override {
+        frame &= SOF_FRAME_MASK;
+        int64_t unwrapped;
+        if (points_.empty()) {
+            if (!timeline_.known) {
+                timeline_.known = true;
+                timeline_.reference = frame;
+            }
+            // Nearest to the reference either way
+            int64_t delta = (int64_t)((frame - timeline_.reference) & SOF_FRAME_MASK);
+            unwrapped = (delta >= SOF_FRAMES / 2) ? delta - SOF_FRAMES : delta;
+        } else {
+            unwrapped = points_.back().frame + ((frame - last_number_) & SOF_FRAME_MASK);
+        }
+        last_number_ = frame;
+        addPoint(position / 256.0, unwrapped);
+        return true;
+    }
+
+    void end(const capture::StreamEnd& end) override {
+        if (end.status > 1) {
+            fprintf(stderr, "%s: stream ended with status %u\n", path_.c_str(), end.status);
+        }
+    }
+
+    // exporter::ChangeSink
+    bool begin(const exporter::CaptureInfo&, uint8_t levels) override {
+        // The starting levels are changes at sample 0 (from x)
+        for (uint8_t ch = 0; ch < exporter::NUM_CHANNELS; ch++) {
+            pending_.push_back({0, ch, (uint8_t)((levels >> ch) & 1)});
+        }
+        return true;
+    }
+
+    bool changes(const exporter::Change* changes, size_t count, uint64_t horizon) override {
+        pending_.insert(pending_.end(), changes, changes + count);
+        export_horizon_ = horizon;
+        resolve();
+        return true;
+    }
+
+    bool end(uint64_t) override { return true; }
+
+private:
+    struct Point {
+        double position;   // Samples
+        int64_t frame;     // USB frames (ms) from the reference
+    };
+
+    void addPoint(double position, int64_t frame) {
+        if (!points_.empty()) {
+            const Point& last = points_.back();
+            double expected = (frame - last.frame) * (info_.rate_hz / 1000.0);
+            if (frame <= last.frame || std::fabs((position - last.position) / expected - 1.0) > RATE_TOLERANCE) {
+                if (!warned_) {
+                    fprintf(stderr,
+                            "%s: sync frames at USB frames %lld and %lld disagree with %u Hz (another host "
+                            "controller, or more than 2 s between them?)\n",
+                            path_.c_str(), (long long)last.frame, (long long)frame, info_.rate_hz);
+                    warned_ = true;
+                }
+                return;
+            }
+            if (points_.size() >= 2) {
+                // How far the stamp is off the line through the last two
+                const Point& before = points_[points_.size() - 2];
+                double slope = (last.position - before.position) / (last.frame - before.frame);
+                double predicted = last.position + (frame - last.frame) * slope;
+                double residual_us = std::fabs(position - predicted) / info_.rate_hz * 1e6;
+                max_residual_us_ = std::max(max_residual_us_, residual_us);
+                residuals_++;
+            }
+        } else {
+            first_ = {position, frame};
+        }
+        last_ = {position, frame};
+        points_.push_back({position, frame});
+        sync_count_++;
+        resolve();
+    }
+
+    // Sample -> ns on the timeline, on the segment around it (or the
+    // nearest one); a single point runs at the nominal rate
+    int64_t nsOf(double sample) const {
+        double ms;
+        if (points_.size() == 1) {
+            ms = points_[0].frame + (sample - points_[0].position) * 1000.0 / info_.rate_hz;
+        } else {
+            size_t k = 1;
+            while (k + 1 < points_.size() && points_[k].position < sample) {
+                k++;
+            }
+            const Point& a = points_[k - 1];
+            const Point& b = points_[k];
+            ms = a.frame + (sample - a.position) * (b.frame - a.frame) / (b.position - a.position);
+        }
+        return (int64_t)std::llround(ms * 1e6);
+    }
+
+    // Time the changes a sync frame has arrived after (all once finished)
+    void resolve() {
+        if (points_.empty() || (points_.size() < 2 && !finished_)) {
+            return;
+        }
+        double last = points_.back().position;
+        while (!pending_.empty() && (finished_ || (double)pending_.front().time <= last)) {
+            const exporter::Change& change = pending_.front();
+            timed_.push_back({nsOf((double)change.time), change.channel, change.level});
+            pending_.pop_front();
+            // Segments behind every pending change are done with
+            while (points_.size() > 2 && !pending_.empty() && points_[1].position <= (double)pending_.front().time) {
+                points_.pop_front();
+            }
+        }
+    }
+
+    bool finish() {
+        if (exporter_ != nullptr && !exporter_->finish(samples_)) {
+            return false;
+        }
+        finished_ = true;
+        if (exporter_ != nullptr && points_.empty()) {
+            fprintf(stderr, "%s: no sync frames (capture with --sync)\n", path_.c_str());
+            return false;
+        }
+        resolve();
+        return true;
+    }
+
+    std::string path_;
+    uint8_t min_width_;
+    Timeline& timeline_;
+    int fd_ = -1;
+    bool file_ = false;
+    bool finished_ = false;
+    bool warned_ = false;
+    capture::StreamDecoder decoder_;
+    exporter::CaptureInfo info_;
+    std::unique_ptr<exporter::TransitionExport> exporter_;
+    uint64_t samples_ = 0;
+    uint64_t export_horizon_ = 0;
+    std::deque<Point> points_;
+    Point first_ = {0.0, 0};
+    Point last_ = {0.0, 0};
+    uint32_t last_number_ = 0;
+    uint64_t sync_count_ = 0;
+    double max_residual_us_ = 0.0;
+    uint64_t residuals_ = 0;
+    std::deque<exporter::Change> pending_;
+    std::deque<Timed> timed_;
+};
+
+// VCD of all inputs, header written with the first change (its time is 0)
+class MergedVcd {
+public:
+    ~MergedVcd() {
+        if (file_ != nullptr && file_ != stdout) {
+            fclose(file_);
+        }
+    }
+
+    bool open(const std::string& path) {
+        file_ = (path == "-") ? stdout : fopen(path.c_str(), "w");
+        if (file_ == nullptr) {
+            perror(path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void change(const std::vector<std::unique_ptr<Input>>& inputs, const Timeline& timeline, uint8_t input,
+                const Timed& change) {
+        if (!begun_) {
+            header(inputs, timeline, change.ns);
+        }
+        if (change.ns != last_ns_) {
+            fprintf(file_, "#%lld\n", (long long)(change.ns - origin_ns_));
+            last_ns_ = change.ns;
+        }
+        fprintf(file_, "%c%c\n", change.level ? '1' : '0', identifier(input, change.channel));
+        changes_++;
+    }
+
+    bool close() {
+        bool ok = (fflush(file_) == 0 && !ferror(file_));
+        if (file_ != stdout) {
+            ok = (fclose(file_) == 0) && ok;
+            file_ = nullptr;
+        }
+        return ok;
+    }
+
+    uint64_t changes() const { return changes_; }
+
+private:
+    static char identifier(uint8_t input, uint8_t channel) {
+        return (char)('!' + input * exporter::NUM_CHANNELS + channel);
+    }
+
+    void header(const std::vector<std::unique_ptr<Input>>& inputs, const Timeline& timeline, int64_t origin_ns) {
+        origin_ns_ = origin_ns;
+        fprintf(file_, "$comment la_merge: time 0 is %.6f ms after USB frame %u $end\n", origin_ns / 1e6,
+                timeline.reference);
+        fprintf(file_, "$timescale 1 ns $end\n");
+        for (size_t k = 0; k < inputs.size(); k++) {
+            fprintf(file_, "$comment dev%zu: %s $end\n", k, inputs[k]->path().c_str());
+            fprintf(file_, "$scope module dev%zu $end\n", k);
+            for (uint8_t ch = 0; ch < exporter::NUM_CHANNELS; ch++) {
+                fprintf(file_, "$var wire 1 %c CH%u $end\n", identifier((uint8_t)k, ch), ch);
+            }
+            fprintf(file_, "$upscope $end\n");
+        }
+        fprintf(file_, "$enddefinitions $end\n$dumpvars\n");
+        for (size_t k = 0; k < inputs.size(); k++) {
+            for (uint8_t ch = 0; ch < exporter::NUM_CHANNELS; ch++) {
+                fprintf(file_, "x%c\n", identifier((uint8_t)k, ch));
+            }
+        }
+        fprintf(file_, "$end\n");
+        begun_ = true;
+    }
+
+    FILE* file_ = nullptr;
+    bool begun_ = false;
+    int64_t origin_ns_ = 0;
+    int64_t last_ns_ = std::numeric_limits<int64_t>::min();
+    uint64_t changes_ = 0;
+};
+
+// Write every timed change before horizon, earliest first
+void release(std::vector<std::unique_ptr<Input>>& inputs, const Timeline& timeline, int64_t horizon, MergedVcd& vcd) {
+    for (;;) {
+        size_t first = inputs.size();
+        for (size_t k = 0; k < inputs.size(); k++) {
+            const std::deque<Timed>& timed = inputs[k]->timed();
+            if (!timed.empty() && timed.front().ns < horizon &&
+                (first == inputs.size() || timed.front().ns < inputs[first]->timed().front().ns)) {
+                first = k;
+            }
+        }
+        if (first == inputs.size()) {
+            return;
+        }
+        vcd.change(inputs, timeline, (uint8_t)first, inputs[first]->timed().front());
+        inputs[first]->pop();
+    }
+}
+
+int usage() {
+    fprintf(stderr, "usage: la_merge [-o out.vcd|-] [--min-width N] INPUT INPUT...\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string output = "merged.vcd";
+    unsigned long min_width = 1;
+    std::vector<std::string> paths;
+
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "-o" && has_value) {
+            output = argv[++k];
+        } else if (arg == "--min-width" && has_value) {
+            min_width = strtoul(argv[++k], nullptr, 0);
+        } else if (arg[0] != '-' || arg == "-") {
+            paths.push_back(arg);
+        } else {
+            return usage();
+        }
+    }
+    if (paths.empty() || paths.size() > MAX_INPUTS || min_width > capture::TransitionEncoder::MAX_MIN_WIDTH) {
+        return usage();
+    }
+
+    Timeline timeline;
+    std::vector<std::unique_ptr<Input>> inputs;
+    for (const std::string& path : paths) {
+        inputs.emplace_back(new Input(path, (uint8_t)min_width, timeline));
+        if (!inputs.back()->open()) {
+            return 2;
+        }
+    }
+    MergedVcd vcd;
+    if (!vcd.open(output)) {
+        return 2;
+    }
+
+    // Read the input that holds the others back until all are done
+    bool ok = true;
+    for (;;) {
+        Input* laggard = nullptr;
+        int64_t horizon = NEVER;
+        for (const std::unique_ptr<Input>& input : inputs) {
+            if (!input->finished() && (laggard == nullptr || input->horizon() < laggard->horizon())) {
+                laggard = input.get();
+            }
+            horizon = std::min(horizon, input->horizon());
+        }
+        if (laggard == nullptr) {
+            break;
+        }
+        if (!laggard->readMore()) {
+            ok = false;
+            break;
+        }
+        release(inputs, timeline, horizon, vcd);
+    }
+    if (ok) {
+        release(inputs, timeline, NEVER, vcd);
+    }
+    ok = vcd.close() && ok;
+
+    // Results on stderr, VCD may be on stdout
+    for (size_t k = 0; k < inputs.size(); k++) {
+        inputs[k]->summary((uint8_t)k);
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "vcd: %llu changes, peak RSS %ld kB%s\n", (unsigned long long)vcd.changes(), usage.ru_maxrss,
+            ok ? "" : ", FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,393 @@
+/**
+  ******************************************************************************
+  * @file           : la_mirror.cpp
+  * @brief          : OLED mirror viewer (device side: Core/Lib/FrameMirror)
+  ******************************************************************************
+  * Rebuilds the 128x64 panel from the mirrored frames and saves them. Frame
+  * and command format: Core/Lib/FrameMirror.hpp.
+  *
+  *   la_mirror --bulk [node] [-o DIR] [--scale N] [--count N] [--view]
+  *       turn the mirror on over the vendor bulk interface and follow it
+  *       until Ctrl-C (or --count frames), which turns it off again
+  *   la_mirror --input FILE|- [-o DIR] [--scale N] [--count N] [--view]
+  *       replay a recorded bulk stream (sends nothing)
+  *
+  * Every rebuilt frame is written to DIR as frame_NNNNNN.pbm (--scale
+  * pixels per panel pixel, default 4), and one line per frame goes to
+  * stdout: sequence, device time, spans and bytes received. --view draws
+  * the panel in the terminal instead (two rows per character). Frames are
+  * only rebuilt from the first key frame on; a sequence gap is a frame the
+  * device dropped, and the frame after it is always a key frame.
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "usbfs.hpp"
+
+namespace {
+
+const uint8_t COMMAND[8] = {'L', 'A', 'M', 'I', 'R', 'R', 'O', 'R'};
+const uint8_t FRAME_MAGIC[8] = {'L', 'A', 'F', 'R', 'A', 'M', 'E', '!'};
+const size_t COMMAND_BYTES = 16;
+const size_t HEADER_BYTES = 20;
+const size_t SPAN_HEADER_BYTES = 3;
+const uint8_t FLAG_KEY = 1u << 0;
+const int WIDTH = 128;
+const int HEIGHT = 64;
+const int PAGES = HEIGHT / 8;
+const size_t FRAME_MAX = HEADER_BYTES + PAGES * (SPAN_HEADER_BYTES + WIDTH);
+
+volatile sig_atomic_t interrupted = 0;
+
+void onInterrupt(int) {
+    interrupted++;
+}
+
+uint32_t getWord(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void putWord(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+void catchInterrupt() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onInterrupt;   // No SA_RESTART: blocking calls return EINTR
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+// The panel as the device keeps it: page by page, bit n of a byte is row
+// page * 8 + n
+struct Panel {
+    uint8_t pages[PAGES * WIDTH] = {};
+
+    bool pixel(int x, int y) const { return (pages[(y / 8) * WIDTH + x] >> (y % 8)) & 1; }
+};
+
+struct FrameInfo {
+    uint32_t sequence;
+    uint32_t tick_ms;
+    uint8_t spans;
+    bool key;
+    size_t bytes;   ///< Whole frame on the wire
+};
+
+struct Options {
+    std::string directory;
+    uint32_t scale = 4;
+    uint64_t count = 0;   ///< Stop after this many frames, 0 = never
+    bool view = false;
+};
+
+// Byte stream to panel frames; frames are found by their magic, so a
+// stream may start anywhere
+class MirrorParser {
+public:
+    // Rebuilt frame; return false to stop
+    using Consumer = std::function<bool(const Panel& panel, const FrameInfo& info)>;
+
+    explicit MirrorParser(const Consumer& consume) : consume_(consume) {}
+
+    bool feed(const uint8_t* data, size_t length) {
+        pending_.insert(pending_.end(), data, data + length);
+        size_t offset = 0;
+        bool more = true;
+        while (more) {
+            auto start = std::search(pending_.begin() + offset, pending_.end(), FRAME_MAGIC, FRAME_MAGIC + 8);
+            if (start == pending_.end()) {
+                // Keep what could be the start of a magic
+                size_t keep = std::max(offset, pending_.size() - std::min(pending_.size(), sizeof(FRAME_MAGIC) - 1));
+                skipped_ += keep - offset;
+                offset = keep;
+                break;
+            }
+            skipped_ += (size_t)(start - pending_.begin()) - offset;
+            offset = (size_t)(start - pending_.begin());
+            size_t available = pending_.size() - offset;
+            if (available < HEADER_BYTES) {
+                break;
+            }
+            const uint8_t* frame = pending_.data() + offset;
+            size_t span_bytes = frame[16] | ((size_t)frame[17] << 8);
+            if (HEADER_BYTES + span_bytes > FRAME_MAX) {
+                bad_++;
+                offset++;
+                continue;
+            }
+            if (available < HEADER_BYTES + span_bytes) {
+                break;
+            }
+            if (!apply(frame, span_bytes)) {
+                bad_++;
+                offset++;
+                continue;
+            }
+            offset += HEADER_BYTES + span_bytes;
+            more = !stopped_;
+        }
+        pending_.erase(pending_.begin(), pending_.begin() + offset);
+        return !stopped_;
+    }
+
+    void report() const {
+        printf("%llu frames (%llu key), %llu bytes, %llu dropped by the device", (unsigned long long)frames_,
+               (unsigned long long)keys_, (unsigned long long)bytes_, (unsigned long long)dropped_);
+        if (frames_ != 0) {
+            printf(", %.0f bytes/frame", (double)bytes_ / frames_);
+        }
+        if (bad_ != 0 || skipped_ != 0) {
+            printf(", %llu bad frames, %llu bytes skipped", (unsigned long long)bad_, (unsigned long long)skipped_);
+        }
+        printf("\n");
+    }
+
+    uint64_t frames() const { return frames_; }
+
+private:
+    bool apply(const uint8_t* frame, size_t span_bytes) {
+        FrameInfo info = {getWord(frame + 8), getWord(frame + 12), frame[18], (frame[19] & FLAG_KEY) != 0,
+                          HEADER_BYTES + span_bytes};
+
+        // Check every span before touching the panel
+        const uint8_t* spans = frame + HEADER_BYTES;
+        size_t at = 0;
+        for (uint8_t s = 0; s < info.spans; s++) {
+            if (at + SPAN_HEADER_BYTES > span_bytes) {
+                return false;
+            }
+            uint8_t page = spans[at];
+            uint8_t first = spans[at + 1];
+            uint8_t count = spans[at + 2];
+            if (page >= PAGES || count == 0 || first + count > WIDTH ||
+                at + SPAN_HEADER_BYTES + count > span_bytes) {
+                return false;
+            }
+            at += SPAN_HEADER_BYTES + count;
+        }
+        if (at != span_bytes) {
+            return false;
+        }
+
+        if (have_sequence_ && info.sequence != sequence_ + 1) {
+            dropped_ += info.sequence - sequence_ - 1;
+            synced_ = synced_ && info.key;   // The device follows a drop with a key frame
+        }
+        have_sequence_ = true;
+        sequence_ = info.sequence;
+        synced_ = synced_ || info.key;
+        if (!synced_) {
+            return true;   // Changes to a panel not seen yet
+        }
+
+        for (at = 0; at < span_bytes;) {
+            uint8_t page = spans[at];
+            uint8_t first = spans[at + 1];
+            uint8_t count = spans[at + 2];
+            memcpy(panel_.pages + page * WIDTH + first, spans + at + SPAN_HEADER_BYTES, count);
+            at += SPAN_HEADER_BYTES + count;
+        }
+        frames_++;
+        keys_ += info.key;
+        bytes_ += info.bytes;
+        stopped_ = !consume_(panel_, info);
+        return true;
+    }
+
+    Consumer consume_;
+    std::vector<uint8_t> pending_;
+    Panel panel_;
+    bool synced_ = false;
+    bool have_sequence_ = false;
+    bool stopped_ = false;
+    uint32_t sequence_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t keys_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t bad_ = 0;
+    uint64_t skipped_ = 0;
+};
+
+// Binary PBM, scale x scale pixels per panel pixel
+bool savePbm(const std::string& path, const Panel& panel, uint32_t scale) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        perror(path.c_str());
+        return false;
+    }
+    uint32_t width = WIDTH * scale;
+    fprintf(f, "P4\n%u %u\n", width, HEIGHT * scale);
+    std::vector<uint8_t> row((width + 7) / 8);
+    for (int y = 0; y < HEIGHT; y++) {
+        std::fill(row.begin(), row.end(), 0);
+        for (uint32_t x = 0; x < width; x++) {
+            if (panel.pixel((int)(x / scale), y)) {
+                row[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+            }
+        }
+        for (uint32_t k = 0; k < scale; k++) {
+            fwrite(row.data(), 1, row.size(), f);
+        }
+    }
+    if (fclose(f) != 0) {
+        perror(path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Two panel rows per terminal line with half blocks, drawn over the last one
+void drawPanel(const Panel& panel, const FrameInfo& info) {
+    static const char* const CELLS[4] = {" ", "▀", "▄", "█"};
+    std::string screen = "\x1b[H";
+    for (int y = 0; y < HEIGHT; y += 2) {
+        for (int x = 0; x < WIDTH; x++) {
+            screen += CELLS[panel.pixel(x, y) | (panel.pixel(x, y + 1) << 1)];
+        }
+        screen += "\n";
+    }
+    fputs(screen.c_str(), stdout);
+    printf("seq %u  %u ms  %u spans  %zu bytes%s\x1b[K\n", info.sequence, info.tick_ms, info.spans, info.bytes,
+           info.key ? "  key" : "");
+    fflush(stdout);
+}
+
+MirrorParser::Consumer frameSink(const Options& options) {
+    return [&options](const Panel& panel, const FrameInfo& info) {
+        static uint64_t saved = 0;
+        if (!options.directory.empty()) {
+            char name[32];
+            snprintf(name, sizeof(name), "/frame_%06llu.pbm", (unsigned long long)saved);
+            if (!savePbm(options.directory + name, panel, options.scale)) {
+                return false;
+            }
+        }
+        saved++;
+        if (options.view) {
+            drawPanel(panel, info);
+        } else {
+            printf("frame %llu: seq %u, %u ms, %u spans, %zu bytes%s\n", (unsigned long long)(saved - 1),
+                   info.sequence, info.tick_ms, info.spans, info.bytes, info.key ? ", key" : "");
+        }
+        return options.count == 0 || saved < options.count;
+    };
+}
+
+int runInput(const std::string& input, const Options& options) {
+    int fd = (input == "-") ? STDIN_FILENO : open(input.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(input.c_str());
+        return 2;
+    }
+    catchInterrupt();
+    if (options.view) {
+        printf("\x1b[2J");
+    }
+
+    MirrorParser parser(frameSink(options));
+    std::vector<uint8_t> buffer(64 * 1024);
+    while (!interrupted) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n <= 0 || !parser.feed(buffer.data(), (size_t)n)) {
+            break;
+        }
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    parser.report();
+    return (parser.frames() != 0) ? 0 : 1;
+}
+
+bool sendCommand(usbfs::BulkDevice& device, bool on) {
+    uint8_t command[COMMAND_BYTES] = {};
+    memcpy(command, COMMAND, sizeof(COMMAND));
+    putWord(command + 8, on ? 1 : 0);
+    return device.send(command, sizeof(command));
+}
+
+int runBulk(const std::string& node, const Options& options) {
+    usbfs::BulkDevice device;
+    if (!device.open(node)) {
+        return 2;
+    }
+    device.drain();
+    if (!sendCommand(device, true)) {
+        return 2;
+    }
+    if (!options.view) {
+        printf("mirroring %s (Ctrl-C stops)...\n", device.node().c_str());
+        fflush(stdout);
+    } else {
+        printf("\x1b[2J");
+    }
+    catchInterrupt();
+
+    MirrorParser parser(frameSink(options));
+    device.stream([&](const uint8_t* data, size_t length) { return parser.feed(data, length); },
+                  [&]() { return false; });
+    bool off = sendCommand(device, false);
+    device.close();
+    parser.report();
+    return off ? 0 : 1;
+}
+
+int usage() {
+    fprintf(stderr, "usage: la_mirror --bulk [node] [-o DIR] [--scale N] [--count N] [--view]\n"
+                    "       la_mirror --input FILE|- [-o DIR] [--scale N] [--count N] [--view]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::string input;
+    std::string node;
+    bool bulk = false;
+
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "--bulk") {
+            bulk = true;
+            if (has_value && argv[k + 1][0] != '-') {
+                node = argv[++k];
+            }
+        } else if (arg == "--input" && has_value) {
+            input = argv[++k];
+        } else if (arg == "-o" && has_value) {
+            options.directory = argv[++k];
+        } else if (arg == "--scale" && has_value) {
+            options.scale = (uint32_t)strtoul(argv[++k], nullptr, 0);
+        } else if (arg == "--count" && has_value) {
+            options.count = strtoull(argv[++k], nullptr, 0);
+        } else if (arg == "--view") {
+            options.view = true;
+        } else {
+            return usage();
+        }
+    }
+    if (bulk == !input.empty() || options.scale == 0 || options.scale > 16) {
+        return usage();
+    }
+    return bulk ? runBulk(node, options) : runInput(input, options);
+}
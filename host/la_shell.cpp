@@ -0,0 +1,171 @@
+/**
+  ******************************************************************************
+  * @file           : la_shell.cpp
+  * @brief          : Console commands to the device over the CDC port
+  ******************************************************************************
+  *   la_shell [--tty DEV] [--binary] [--wait MS] COMMAND...
+  *       send one command (words as on the console, e.g. "dump events 0 8")
+  *       and print the replies until the port is quiet for --wait ms
+  *       (default 300); --binary sends it as a frame instead of a line
+  *   la_shell --parse
+  *       run the firmware's parser over stdin and print what it makes of
+  *       it, one command per line (for checking scripts and the parser)
+  *
+  * Commands and the frame format: Core/Lib/CommandParser.hpp. The device
+  * answers in text on the same port, between its log lines.
+  ******************************************************************************
+  */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "CommandParser.hpp"
+
+namespace {
+
+const char* const DEFAULT_TTY = "/dev/ttyACM0";
+
+void printCommand(const shell::Command& command) {
+    if (command.op == shell::Op::Error) {
+        printf("%s error: %s\n", command.binary ? "frame" : "line", command.error);
+        return;
+    }
+    printf("%s %s", command.binary ? "frame" : "line", shell::CommandParser::opName(command.op));
+    if (command.op == shell::Op::Dump) {
+        printf(" %s", shell::CommandParser::bufferName((shell::DumpBuffer)command.args[0]));
+        for (uint8_t k = 1; k < command.argc; k++) {
+            printf(" %u", command.args[k]);
+        }
+    } else if (command.op == shell::Op::Decode && command.argc != 0) {
+        printf(" %u %s", command.args[0], shell::CommandParser::protocolName(command.args[1]));
+        for (uint8_t k = 2; k < command.argc; k++) {
+            printf(" %u", command.args[k]);
+        }
+    } else {
+        for (uint8_t k = 0; k < command.argc; k++) {
+            printf(" %u", command.args[k]);
+        }
+    }
+    printf("\n");
+}
+
+int parseInput() {
+    shell::CommandParser parser;
+    uint8_t buffer[4096];
+    ssize_t n;
+    int errors = 0;
+    while ((n = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t k = 0; k < n; k++) {
+            shell::Command command;
+            if (parser.feed(buffer[k], command)) {
+                printCommand(command);
+                errors += (command.op == shell::Op::Error);
+            }
+        }
+    }
+    return (errors == 0) ? 0 : 1;
+}
+
+bool makeRaw(int fd) {
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+int sendCommand(const std::string& tty, const std::string& text, bool binary, int wait_ms) {
+    // Checked here first, so a typo is not sent
+    shell::CommandParser parser;
+    shell::Command command;
+    bool complete = false;
+    for (char c : text + "\n") {
+        complete = parser.feed((uint8_t)c, command) || complete;
+    }
+    if (!complete || command.op == shell::Op::Error) {
+        fprintf(stderr, "%s: %s\n", text.c_str(), complete ? command.error : "nothing to send");
+        return 2;
+    }
+
+    int fd = open(tty.c_str(), O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(tty.c_str());
+        return 2;
+    }
+    makeRaw(fd);
+    tcflush(fd, TCIFLUSH);
+
+    uint8_t frame[shell::CommandParser::FRAME_MAX];
+    std::string line = text + "\r\n";
+    const uint8_t* data = (const uint8_t*)line.data();
+    size_t length = line.size();
+    if (binary) {
+        length = shell::CommandParser::encodeFrame(command.op, command.args, command.argc, frame);
+        data = frame;
+    }
+    if (write(fd, data, length) != (ssize_t)length) {
+        perror(tty.c_str());
+        close(fd);
+        return 2;
+    }
+
+    // Replies until the port goes quiet
+    char buffer[4096];
+    pollfd waiting = {fd, POLLIN, 0};
+    while (poll(&waiting, 1, wait_ms) > 0) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        fwrite(buffer, 1, (size_t)n, stdout);
+    }
+    fflush(stdout);
+    close(fd);
+    return 0;
+}
+
+int usage() {
+    fprintf(stderr, "usage: la_shell [--tty DEV] [--binary] [--wait MS] COMMAND...\n"
+                    "       la_shell --parse < input\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string tty = DEFAULT_TTY;
+    std::string text;
+    bool binary = false;
+    int wait_ms = 300;
+
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "--parse" && argc == 2) {
+            return parseInput();
+        } else if (arg == "--tty" && has_value) {
+            tty = argv[++k];
+        } else if (arg == "--binary") {
+            binary = true;
+        } else if (arg == "--wait" && has_value) {
+            wait_ms = atoi(argv[++k]);
+        } else if (arg[0] != '-' || text.size() != 0) {
+            text += (text.empty() ? "" : " ") + arg;
+        } else {
+            return usage();
+        }
+    }
+    if (text.empty()) {
+        return usage();
+    }
+    return sendCommand(tty, text, binary, wait_ms);
+}
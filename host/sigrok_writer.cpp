@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * @file           : sigrok_writer.cpp
+  * @brief          : sigrok session file output (PulseView)
+  ******************************************************************************
+  */
+
+#include "sigrok_writer.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace exporter {
+
+namespace {
+
+// libsigrok's own spelling of a rate, which its parser reads back exactly
+void formatRate(char* text, size_t size, uint32_t rate_hz) {
+    if (rate_hz != 0 && rate_hz % 1000000 == 0) {
+        snprintf(text, size, "%u MHz", rate_hz / 1000000);
+    } else if (rate_hz != 0 && rate_hz % 1000 == 0) {
+        snprintf(text, size, "%u kHz", rate_hz / 1000);
+    } else {
+        snprintf(text, size, "%u Hz", rate_hz);
+    }
+}
+
+} // namespace
+
+bool SigrokWriter::open(const std::string& path) {
+    chunk_.resize(CHUNK_BYTES);
+    return zip_.open(path);
+}
+
+bool SigrokWriter::begin(const CaptureInfo& info, uint8_t levels) {
+    char rate[32];
+    formatRate(rate, sizeof(rate), info.rate_hz);
+    std::string metadata = "[global]\nsigrok version=0.5.2\n\n[device 1]\ncapturefile=logic-1\n";
+    metadata += "total probes=" + std::to_string(NUM_CHANNELS) + "\n";
+    metadata += std::string("samplerate=") + rate + "\ntotal analog=0\n";
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        metadata += "probe" + std::to_string(ch + 1) + "=CH" + std::to_string(ch) + "\n";
+    }
+    metadata += "unitsize=1\n";
+
+    state_ = levels;
+    ok_ = zip_.addEntry("version", "2", 1) && zip_.addEntry("metadata", metadata.data(), metadata.size());
+    return ok_;
+}
+
+bool SigrokWriter::storeChunk() {
+    if (used_ == 0) {
+        return ok_;
+    }
+    chunks_++;
+    ok_ = ok_ && zip_.addEntry("logic-1-" + std::to_string(chunks_), chunk_.data(), used_);
+    written_ += used_;
+    used_ = 0;
+    return ok_;
+}
+
+// Repeat the current state up to sample until
+bool SigrokWriter::fill(uint64_t until) {
+    while (position_ < until && ok_) {
+        size_t n = chunk_.size() - used_;
+        if (until - position_ < n) {
+            n = (size_t)(until - position_);
+        }
+        memset(chunk_.data() + used_, state_, n);
+        used_ += n;
+        position_ += n;
+        if (used_ == chunk_.size()) {
+            storeChunk();
+        }
+    }
+    return ok_;
+}
+
+bool SigrokWriter::changes(const Change* changes, size_t count, uint64_t horizon) {
+    for (size_t k = 0; k < count && ok_; k++) {
+        fill(changes[k].time);
+        uint8_t bit = (uint8_t)(1u << changes[k].channel);
+        state_ = changes[k].level ? (state_ | bit) : (state_ & ~bit);
+    }
+    return fill(horizon);
+}
+
+bool SigrokWriter::end(uint64_t samples) {
+    return fill(samples) && storeChunk() && zip_.close();
+}
+
+} // namespace exporter
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file           : sigrok_writer.hpp
+  * @brief          : sigrok session file output (PulseView)
+  ******************************************************************************
+  * A .sr session is a ZIP archive: "version" (2), "metadata" (INI: rate,
+  * probe names, unit size) and the samples in "logic-1-1", "logic-1-2",
+  * ... chunks. Samples are one byte each, bit n = CH n, rebuilt from the
+  * change list into a CHUNK_BYTES buffer that is stored once full.
+  ******************************************************************************
+  */
+
+#ifndef SIGROK_WRITER_HPP
+#define SIGROK_WRITER_HPP
+
+#include <string>
+#include <vector>
+
+#include "transition_export.hpp"
+#include "zip_store.hpp"
+
+namespace exporter {
+
+class SigrokWriter : public ChangeSink {
+public:
+    static const size_t CHUNK_BYTES = 4 << 20;
+
+    // Errors go to stderr
+    bool open(const std::string& path);
+
+    bool begin(const CaptureInfo& info, uint8_t levels) override;
+    bool changes(const Change* changes, size_t count, uint64_t horizon) override;
+    bool end(uint64_t samples) override;
+
+    uint64_t bytesWritten() const { return written_; }
+
+private:
+    bool fill(uint64_t until);
+    bool storeChunk();
+
+    ZipStore zip_;
+    std::vector<uint8_t> chunk_;
+    size_t used_ = 0;
+    uint32_t chunks_ = 0;
+    uint64_t position_ = 0;   // Samples written into chunks
+    uint8_t state_ = 0;
+    uint64_t written_ = 0;
+    bool ok_ = true;
+};
+
+} // namespace exporter
+
+#endif /* SIGROK_WRITER_HPP */
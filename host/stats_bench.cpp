@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file           : stats_bench.cpp
+  * @brief          : Per-transition cost of the pulse statistics engine
+  ******************************************************************************
+  *   stats_bench [--edges N] [--ghz F]
+  *
+  * Plays a jittery clock edge by edge into measure::PulseStats and into an
+  * empty receiver with the same interface, and reports the difference in
+  * nanoseconds per transition (and in cycles at --ghz, the host clock, when
+  * given). The statistics are checked against the generated widths.
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "PulseStats.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Same interface as PulseStats, only sums the pulse widths
+class NullSink {
+public:
+    void begin(uint32_t t, uint8_t) { last_ = t; }
+    void edge(uint32_t t, uint8_t level) {
+        sum_ += (t - last_) ^ level;
+        last_ = t;
+    }
+    void end(uint32_t) {}
+    uint32_t sum() const { return sum_; }
+
+private:
+    uint32_t last_ = 0;
+    uint32_t sum_ = 0;
+};
+
+template <typename SinkT>
+double run(SinkT& sink, const std::vector<uint32_t>& edges, uint32_t repeat) {
+    Clock::time_point start = Clock::now();
+    for (uint32_t r = 0; r < repeat; r++) {
+        sink.begin(0, 0);
+        for (size_t i = 0; i < edges.size(); i++) {
+            sink.edge(edges[i], (uint8_t)((i & 1) ^ 1));
+        }
+        sink.end(edges.back());
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)edges.size() * repeat);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = 4u << 20;
+    double ghz = 0;
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = (k + 1 < argc);
+        if (arg == "--edges" && has_value) {
+            count = strtoull(argv[++k], nullptr, 0);
+        } else if (arg == "--ghz" && has_value) {
+            ghz = strtod(argv[++k], nullptr);
+        } else {
+            fprintf(stderr, "usage: stats_bench [--edges N] [--ghz F]\n");
+            return 2;
+        }
+    }
+    if (count < 4) {
+        fprintf(stderr, "--edges must be at least 4\n");
+        return 2;
+    }
+
+    // High 100 ticks, low 150, each edge +-5 ticks
+    std::vector<uint32_t> edges(count);
+    uint32_t t = 1000;
+    uint32_t state = 0x2545F491u;
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        t += ((i & 1) ? 100 : 150) + (state % 11) - 5;
+        edges[i] = t;
+    }
+
+    const uint32_t repeat = 10;
+    NullSink null_sink;
+    static measure::PulseStats stats;  // 3 KB of bins
+    double base_ns = run(null_sink, edges, repeat);
+    double stats_ns = run(stats, edges, repeat);
+
+    const measure::Welford& high = stats.stats(measure::PulseStats::High);
+    const measure::Welford& period = stats.stats(measure::PulseStats::Period);
+    bool ok = high.mean() > 99.0 && high.mean() < 101.0 && period.mean() > 249.0 && period.mean() < 251.0 &&
+              high.min() >= 90 && high.max() <= 110;
+
+    printf("%zu edges x %u: loop %.2f ns, with PulseStats %.2f ns, cost %.2f ns/transition", count, repeat, base_ns,
+           stats_ns, stats_ns - base_ns);
+    if (ghz > 0) {
+        printf(" (%.1f cycles at %.2f GHz)", (stats_ns - base_ns) * ghz, ghz);
+    }
+    printf("\nhigh mean %.3f sd %.3f, period mean %.3f sd %.3f  %s\n", high.mean(), high.stddev(), period.mean(),
+           period.stddev(), ok ? "ok" : "MISMATCH");
+    return (ok && null_sink.sum() != 0) ? 0 : 1;
+}
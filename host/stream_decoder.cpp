@@ -0,0 +1,201 @@
+/**
+  ******************************************************************************
+  * @file           : stream_decoder.cpp
+  * @brief          : Incremental decoder of a recorded capture stream
+  ******************************************************************************
+  */
+
+#include "stream_decoder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace capture {
+
+namespace {
+
+const uint8_t START_MAGIC[8] = {'L', 'A', 'S', 'T', 'R', 'E', 'A', 'M'};
+const uint8_t END_MAGIC[8] = {'L', 'A', 'S', 'T', 'E', 'N', 'D', '!'};
+const uint8_t SYNC_MAGIC[8] = {'L', 'A', 'S', 'Y', 'N', 'C', '!', '!'};
+const size_t START_FRAME_BYTES = 24;
+const size_t END_FRAME_BYTES = 32;
+const size_t SYNC_FRAME_BYTES = 24;
+const size_t RECORD_HEADER_BYTES = 2;
+
+uint32_t getWord(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t getLong(const uint8_t* p) {
+    return getWord(p) | ((uint64_t)getWord(p + 4) << 32);
+}
+
+} // namespace
+
+bool StreamDecoder::feed(const uint8_t* data, size_t length) {
+    if (state_ == State::Done) {
+        return true;
+    }
+    buffer_.insert(buffer_.end(), data, data + length);
+    size_t used = 0;
+    bool ok = parse(used);
+    buffer_.erase(buffer_.begin(), buffer_.begin() + used);
+    return ok;
+}
+
+bool StreamDecoder::parse(size_t& used) {
+    while (state_ != State::Done) {
+        const uint8_t* p = buffer_.data() + used;
+        size_t left = buffer_.size() - used;
+        size_t n = 0;
+        bool waiting = false;
+        bool ok;
+        if (state_ == State::Search) {
+            ok = search(p, left, n);
+            waiting = (state_ == State::Search);
+        } else if (left >= 2 && p[0] == 'L' && p[1] == 'A') {
+            // A frame, or a raw block that happens to start with "LA"
+            ok = frame(p, left, n, waiting);
+            if (ok && n == 0 && !waiting) {
+                ok = block(p, left, n, waiting);
+            }
+        } else {
+            ok = block(p, left, n, waiting);
+        }
+        used += n;
+        if (!ok) {
+            state_ = State::Done;
+            return false;
+        }
+        if (waiting) {
+            break;
+        }
+    }
+    return true;
+}
+
+// Look for a start frame (or a lone end frame: the device refused)
+bool StreamDecoder::search(const uint8_t* p, size_t left, size_t& used) {
+    const uint8_t* end = p + left;
+    const uint8_t* start = std::search(p, end, START_MAGIC, START_MAGIC + 8);
+    const uint8_t* refused = std::search(p, end, END_MAGIC, END_MAGIC + 8);
+    const uint8_t* found = std::min(start, refused);
+    if (found == end) {
+        // Keep what could be the start of a split magic
+        used = left - std::min(left, sizeof(START_MAGIC) - 1);
+        return true;
+    }
+    used = (size_t)(found - p);
+    if (found == refused) {
+        bool waiting;
+        size_t n = 0;
+        state_ = State::Payload;
+        bool ok = frame(found, (size_t)(end - found), n, waiting);
+        if (n == 0) {
+            state_ = State::Search;   // Not all of it yet
+        }
+        used += n;
+        return ok;
+    }
+    if ((size_t)(end - found) < START_FRAME_BYTES) {
+        return true;
+    }
+
+    start_.rate_hz = getWord(found + 8);
+    start_.block_bytes = (uint16_t)(found[12] | (found[13] << 8));
+    start_.sample_bytes = (uint16_t)(found[14] | (found[15] << 8));
+    memcpy(start_.channel_bits, found + 16, sizeof(start_.channel_bits));
+    start_.encoding = getWord(found + 20);
+    used += START_FRAME_BYTES;
+    if (start_.block_bytes < END_FRAME_BYTES || start_.sample_bytes != 2 || start_.block_bytes % 2 != 0) {
+        fprintf(stderr, "start frame: unusable block of %u bytes\n", start_.block_bytes);
+        return false;
+    }
+    if (start_.encoding != ENCODING_RAW && start_.encoding != ENCODING_COMPRESSED) {
+        fprintf(stderr, "start frame: unknown encoding %u\n", start_.encoding);
+        return false;
+    }
+    block_samples_ = start_.block_bytes / 2;
+    compressor_.setChannels(start_.channel_bits);
+    words_.resize(block_samples_ + BlockCompressor::DECODE_SLACK);
+    state_ = State::Payload;
+    return sink_.start(start_);
+}
+
+// Sync or end frame at a block or record boundary; used stays 0 if p is
+// none (raw data starting with "LA")
+bool StreamDecoder::frame(const uint8_t* p, size_t left, size_t& used, bool& waiting) {
+    waiting = false;
+    if (left < sizeof(END_MAGIC)) {
+        waiting = true;
+        return true;
+    }
+    if (memcmp(p, END_MAGIC, sizeof(END_MAGIC)) == 0) {
+        if (left < END_FRAME_BYTES) {
+            waiting = true;
+            return true;
+        }
+        StreamEnd end;
+        end.samples = getLong(p + 8);
+        end.status = getWord(p + 16);
+        end.elapsed_ms = getWord(p + 20);
+        end.cycles_per_kb = getWord(p + 24);
+        used = END_FRAME_BYTES;
+        state_ = State::Done;
+        sink_.end(end);
+        return true;
+    }
+    if (memcmp(p, SYNC_MAGIC, sizeof(SYNC_MAGIC)) == 0) {
+        if (left < SYNC_FRAME_BYTES) {
+            waiting = true;
+            return true;
+        }
+        used = SYNC_FRAME_BYTES;
+        return sink_.sync(getLong(p + 8), getWord(p + 16));
+    }
+    if (start_.encoding == ENCODING_COMPRESSED) {
+        fprintf(stderr, "unknown frame in a coded stream: stream is corrupt\n");
+        return false;
+    }
+    return true;
+}
+
+// One raw block or coded record
+bool StreamDecoder::block(const uint8_t* p, size_t left, size_t& used, bool& waiting) {
+    waiting = false;
+    if (start_.encoding == ENCODING_RAW) {
+        if (left < start_.block_bytes) {
+            waiting = true;
+            return true;
+        }
+        for (uint32_t k = 0; k < block_samples_; k++) {
+            words_[k] = (uint16_t)(p[2 * k] | (p[2 * k + 1] << 8));
+        }
+        used = start_.block_bytes;
+        return sink_.samples(words_.data(), block_samples_);
+    }
+
+    if (left < RECORD_HEADER_BYTES) {
+        waiting = true;
+        return true;
+    }
+    size_t size = p[0] | ((size_t)p[1] << 8);
+    if (size == 0 || size > BlockCompressor::maxCompressed(block_samples_)) {
+        fprintf(stderr, "record of %zu bytes: stream is corrupt\n", size);
+        return false;
+    }
+    if (left < RECORD_HEADER_BYTES + size) {
+        waiting = true;
+        return true;
+    }
+    if (compressor_.decompress(p + RECORD_HEADER_BYTES, (uint32_t)size, words_.data(), block_samples_) !=
+        block_samples_) {
+        fprintf(stderr, "record of %zu bytes: stream is corrupt\n", size);
+        return false;
+    }
+    used = RECORD_HEADER_BYTES + size;
+    return sink_.samples(words_.data(), block_samples_);
+}
+
+} // namespace capture
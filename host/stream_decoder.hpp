@@ -0,0 +1,88 @@
+/**
+  ******************************************************************************
+  * @file           : stream_decoder.hpp
+  * @brief          : Incremental decoder of a recorded capture stream
+  ******************************************************************************
+  * Turns the bytes of a PortStream stream (Core/Lib/PortStream.hpp) into
+  * port words, sync points and the end frame, whatever the read sizes:
+  * it waits for the start frame, then sorts the payload into blocks or
+  * coded records and the sync and end frames between them. Unlike
+  * la_capture, which reads raw payload straight into its file mapping,
+  * everything is copied once; it is meant for tools that consume the
+  * samples (la_merge).
+  ******************************************************************************
+  */
+
+#ifndef STREAM_DECODER_HPP
+#define STREAM_DECODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BlockCompressor.hpp"
+
+namespace capture {
+
+struct StreamStart {
+    uint32_t rate_hz = 0;
+    uint16_t block_bytes = 0;
+    uint16_t sample_bytes = 0;
+    uint8_t channel_bits[4] = {0, 0, 0, 0};
+    uint32_t encoding = 0;
+};
+
+struct StreamEnd {
+    uint64_t samples = 0;
+    uint32_t status = 0;
+    uint32_t elapsed_ms = 0;
+    uint32_t cycles_per_kb = 0;
+};
+
+// Receiver of a decoded stream; returning false stops the decoder
+class StreamSink {
+public:
+    virtual ~StreamSink() = default;
+    virtual bool start(const StreamStart& start) = 0;
+    virtual bool samples(const uint16_t* words, size_t count) = 0;
+
+    // USB start of frame `frame` (11 bits) fell on sample position / 256
+    virtual bool sync(uint64_t position, uint32_t frame) = 0;
+
+    virtual void end(const StreamEnd& end) = 0;
+};
+
+class StreamDecoder {
+public:
+    static const uint32_t ENCODING_RAW = 0;
+    static const uint32_t ENCODING_COMPRESSED = 1;
+
+    explicit StreamDecoder(StreamSink& sink) : sink_(sink) {}
+
+    // Bytes from anywhere; false if the stream is corrupt or the sink
+    // stopped (errors go to stderr)
+    bool feed(const uint8_t* data, size_t length);
+
+    bool started() const { return state_ != State::Search; }
+    bool done() const { return state_ == State::Done; }
+
+private:
+    enum class State { Search, Payload, Done };
+
+    bool parse(size_t& used);
+    bool search(const uint8_t* p, size_t left, size_t& used);
+    bool frame(const uint8_t* p, size_t left, size_t& used, bool& waiting);
+    bool block(const uint8_t* p, size_t left, size_t& used, bool& waiting);
+
+    StreamSink& sink_;
+    State state_ = State::Search;
+    StreamStart start_;
+    std::vector<uint8_t> buffer_;   // Bytes not decoded yet
+    std::vector<uint16_t> words_;
+    BlockCompressor compressor_;
+    uint32_t block_samples_ = 0;
+};
+
+} // namespace capture
+
+#endif /* STREAM_DECODER_HPP */
@@ -0,0 +1,202 @@
+/**
+  ******************************************************************************
+  * @file           : bit_planes_test.cpp
+  * @brief          : BitPlanes transpose and plane-stream helpers vs references
+  ******************************************************************************
+  * transpose() must equal transposeReference() on random and sparse blocks.
+  * The host build runs the portable steps; the DSP ones (PKHBT, PKHTB,
+  * UADD8 + SEL) are checked here against an emulation of the instructions
+  * so both paths are known to compute the same thing. Plane streams are
+  * checked against the port words and TransitionEncoder output.
+  ******************************************************************************
+  */
+
+#include "BitPlanes.hpp"
+#include "TransitionEncoder.hpp"
+#include "check.hpp"
+
+#include <cstring>
+#include <random>
+
+using capture::BitPlanes;
+using capture::TransitionEncoder;
+
+namespace {
+
+const uint8_t CHANNEL_BITS[4] = {8, 15, 6, 2};
+
+// Instruction semantics from the ARMv7-M reference manual
+struct Dsp {
+    uint32_t ge = 0;
+
+    static uint32_t pkhbt(uint32_t n, uint32_t m, uint8_t lsl) {
+        return (n & 0xFFFF) | ((m << lsl) & 0xFFFF0000u);
+    }
+    static uint32_t pkhtb(uint32_t n, uint32_t m, uint8_t asr) {
+        return (n & 0xFFFF0000u) | ((uint32_t)((int32_t)m >> asr) & 0xFFFF);
+    }
+    void uadd8(uint32_t a, uint32_t b) {
+        ge = 0;
+        for (int i = 0; i < 4; i++) {
+            if (((a >> (8 * i)) & 0xFF) + ((b >> (8 * i)) & 0xFF) >= 0x100) {
+                ge |= 1u << i;
+            }
+        }
+    }
+    uint32_t sel(uint32_t a, uint32_t b) const {
+        uint32_t r = 0;
+        for (int i = 0; i < 4; i++) {
+            uint32_t byte = 0xFFu << (8 * i);
+            r |= ((ge >> i) & 1) ? (a & byte) : (b & byte);
+        }
+        return r;
+    }
+};
+
+void testDspSteps() {
+    // The operands as BitPlanes.cpp passes them, against the portable steps
+    std::mt19937 rng(7);
+    Dsp dsp;
+    dsp.uadd8(0x00FF00FFu, 0x00010001u);
+    CHECK_EQ(dsp.ge, 0x5);
+
+    uint32_t bad = 0;
+    for (int i = 0; i < 100000; i++) {
+        uint32_t a = rng();
+        uint32_t b = rng();
+        bad += (Dsp::pkhbt(a, b, 16) != ((a & 0xFFFF) | (b << 16))) ? 1 : 0;
+        bad += (Dsp::pkhtb(b, a, 16) != ((a >> 16) | (b & 0xFFFF0000u))) ? 1 : 0;
+
+        uint32_t sel_a = dsp.sel(a, b << 8);
+        uint32_t sel_b = dsp.sel(a >> 8, b);
+        uint32_t t = ((a >> 8) ^ b) & 0x00FF00FFu;
+        bad += (sel_a != (a ^ (t << 8)) || sel_b != (b ^ t)) ? 1 : 0;
+    }
+    CHECK_EQ(bad, 0);
+}
+
+void testTranspose() {
+    std::mt19937 rng(3);
+    uint16_t samples[BitPlanes::BLOCK_SAMPLES];
+    uint32_t fast[BitPlanes::PORT_BITS];
+    uint32_t reference[BitPlanes::PORT_BITS];
+    uint32_t bad = 0;
+    for (int iteration = 0; iteration < 100000; iteration++) {
+        // Dense random words, and sparse ones with only a few bits in use
+        uint16_t mask = (iteration % 3) ? 0xFFFF : 0x8145;
+        for (uint16_t& s : samples) {
+            s = (uint16_t)(rng() & mask);
+        }
+        BitPlanes::transpose(samples, fast);
+        BitPlanes::transposeReference(samples, reference);
+        bad += (memcmp(fast, reference, sizeof(fast)) != 0) ? 1 : 0;
+    }
+    CHECK_EQ(bad, 0);
+
+    // Single bits land in the right plane and position
+    for (uint8_t i = 0; i < BitPlanes::BLOCK_SAMPLES; i++) {
+        for (uint8_t bit = 0; bit < BitPlanes::PORT_BITS; bit++) {
+            memset(samples, 0, sizeof(samples));
+            samples[i] = (uint16_t)(1u << bit);
+            BitPlanes::transpose(samples, fast);
+            for (uint8_t b = 0; b < BitPlanes::PORT_BITS; b++) {
+                bad += (fast[b] != ((b == bit) ? (1u << i) : 0)) ? 1 : 0;
+            }
+        }
+    }
+    CHECK_EQ(bad, 0);
+}
+
+void testStreams() {
+    const uint32_t blocks = 32;
+    const uint32_t count = blocks * BitPlanes::BLOCK_SAMPLES;
+    static uint16_t words[count];
+    static uint32_t stream_data[4][blocks];
+    uint32_t* streams[4] = {stream_data[0], stream_data[1], stream_data[2], stream_data[3]};
+    static uint8_t encoded[4][2048];
+    std::mt19937 rng(11);
+
+    uint32_t bad = 0;
+    for (int iteration = 0; iteration < 2000; iteration++) {
+        // From an edge on almost every sample to a few per capture
+        uint32_t spacing = 1 + iteration % 50;
+        uint16_t current = (uint16_t)rng();
+        for (uint32_t i = 0; i < count; i++) {
+            if (rng() % spacing == 0) {
+                current ^= (uint16_t)(1u << CHANNEL_BITS[rng() % 4]);
+            }
+            words[i] = current;
+        }
+        BitPlanes::transposeChannels(words, blocks, CHANNEL_BITS, 4, streams);
+
+        TransitionEncoder encoder(CHANNEL_BITS, 4);
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            encoder.setOutput(ch, encoded[ch], sizeof(encoded[ch]));
+        }
+        encoder.encode(words, count);
+        encoder.finish();
+
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            uint8_t transitions[2048];
+            uint32_t length = 0;
+            bool complete = BitPlanes::toTransitions(streams[ch], blocks, transitions, sizeof(transitions), length);
+            bad += (!complete || length != encoder.length(ch) ||
+                    memcmp(transitions, encoded[ch], length) != 0) ? 1 : 0;
+
+            uint32_t high = 0;
+            uint32_t edges = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                uint8_t level = (words[i] >> CHANNEL_BITS[ch]) & 1;
+                high += level;
+                edges += (i != 0 && level != ((words[i - 1] >> CHANNEL_BITS[ch]) & 1)) ? 1 : 0;
+                bad += (BitPlanes::level(streams[ch], i) != level) ? 1 : 0;
+            }
+            bad += (BitPlanes::countHigh(streams[ch], blocks) != high) ? 1 : 0;
+            bad += (BitPlanes::countEdges(streams[ch], blocks) != edges) ? 1 : 0;
+        }
+    }
+    CHECK_EQ(bad, 0);
+}
+
+void testTransitionLimits() {
+    // Alternating samples need one entry per sample: a small buffer fills
+    uint32_t stream[2] = {0x55555555u, 0x55555555u};
+    uint8_t out[8] = {};
+    uint32_t length = 0;
+    CHECK(!BitPlanes::toTransitions(stream, 2, out, 5, length));
+    CHECK_EQ(length, 5);
+    CHECK_EQ(out[5], 0);
+
+    // Constant streams: one run split at 127
+    uint32_t ones[8];
+    memset(ones, 0xFF, sizeof(ones));
+    CHECK(BitPlanes::toTransitions(ones, 8, out, sizeof(out), length));
+    CHECK_EQ(length, 3);  // 256 = 127 + 127 + 2
+    CHECK_EQ(out[0], 0x80 | 127);
+    CHECK_EQ(out[2], 0x80 | 2);
+    CHECK_EQ(BitPlanes::countEdges(ones, 8), 0);
+    CHECK_EQ(BitPlanes::countHigh(ones, 8), 256);
+
+    // Nothing in, nothing out
+    CHECK(BitPlanes::toTransitions(ones, 0, out, sizeof(out), length));
+    CHECK_EQ(length, 0);
+    CHECK_EQ(BitPlanes::countEdges(ones, 0), 0);
+
+    // An edge exactly at a word boundary counts once
+    uint32_t step[2] = {0x00000000u, 0xFFFFFFFFu};
+    CHECK_EQ(BitPlanes::countEdges(step, 2), 1);
+    CHECK(BitPlanes::toTransitions(step, 2, out, sizeof(out), length));
+    CHECK_EQ(length, 2);
+    CHECK_EQ(out[0], 32);
+    CHECK_EQ(out[1], 0x80 | 32);
+}
+
+} // namespace
+
+int main() {
+    testDspSteps();
+    testTranspose();
+    testStreams();
+    testTransitionLimits();
+    return check::result("bit_planes_test");
+}
@@ -0,0 +1,290 @@
+/**
+  ******************************************************************************
+  * @file           : can_decoder_test.cpp
+  * @brief          : CanDecoder against frames built bit by bit
+  ******************************************************************************
+  * Frames are assembled like a transmitter would (CRC-15, stuffing from SOF
+  * to the end of the CRC, fixed-form tail), turned into a line signal and
+  * played into the decoder with clock drift and edge jitter.
+  ******************************************************************************
+  */
+
+#include "CanDecoder.hpp"
+#include "check.hpp"
+#include "test_signal.hpp"
+
+#include <vector>
+
+using decode::CanDecoder;
+using decode::Event;
+using decode::EventType;
+
+namespace {
+
+constexpr uint32_t SAMPLE_RATE = 10000000;
+constexpr uint32_t BITRATE = 500000;
+constexpr double BIT_TICKS = (double)SAMPLE_RATE / BITRATE;
+
+struct Frame {
+    uint32_t id;
+    bool extended;
+    bool rtr;
+    std::vector<uint8_t> data;
+    bool ack = true;
+    bool bad_crc = false;
+};
+
+struct Bits {
+    std::vector<uint8_t> line;  // Bits on the wire, SOF to end of EOF
+    uint16_t crc;               // CRC as transmitted
+    bool stuff_after_crc;       // A stuff bit follows the last CRC bit
+    std::vector<size_t> stuff;  // Positions of stuff bits in line
+};
+
+void put(std::vector<uint8_t>& bits, uint32_t value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        bits.push_back((value >> i) & 1);
+    }
+}
+
+uint16_t crc15(const std::vector<uint8_t>& bits) {
+    uint16_t crc = 0;
+    for (uint8_t b : bits) {
+        uint16_t next = b ^ ((crc >> 14) & 1);
+        crc = (uint16_t)((crc << 1) & 0x7FFF);
+        if (next) {
+            crc ^= 0x4599;
+        }
+    }
+    return crc;
+}
+
+Bits build(const Frame& frame) {
+    std::vector<uint8_t> raw;
+    raw.push_back(0);  // SOF
+    if (!frame.extended) {
+        put(raw, frame.id, 11);
+        put(raw, frame.rtr ? 1 : 0, 1);
+        put(raw, 0, 2);  // IDE, r0
+    } else {
+        put(raw, frame.id >> 18, 11);
+        put(raw, 1, 2);  // SRR, IDE
+        put(raw, frame.id & 0x3FFFF, 18);
+        put(raw, frame.rtr ? 1 : 0, 1);
+        put(raw, 0, 2);  // r1, r0
+    }
+    put(raw, (uint32_t)frame.data.size(), 4);
+    if (!frame.rtr) {
+        for (uint8_t byte : frame.data) {
+            put(raw, byte, 8);
+        }
+    }
+
+    Bits out{};
+    out.crc = crc15(raw);
+    put(raw, frame.bad_crc ? (out.crc ^ 1) : out.crc, 15);
+
+    // Stuff bits after every five equal bits, the last CRC bit included
+    uint8_t last = 2;
+    int same = 0;
+    for (size_t i = 0; i < raw.size(); i++) {
+        same = (raw[i] == last) ? same + 1 : 1;
+        last = raw[i];
+        out.line.push_back(raw[i]);
+        if (same == 5) {
+            last ^= 1;
+            same = 1;
+            out.stuff.push_back(out.line.size());
+            out.line.push_back(last);
+            out.stuff_after_crc = (i + 1 == raw.size());
+        }
+    }
+
+    out.line.push_back(1);                   // CRC delimiter
+    out.line.push_back(frame.ack ? 0 : 1);   // ACK slot
+    out.line.push_back(1);                   // ACK delimiter
+    for (int i = 0; i < 7; i++) {
+        out.line.push_back(1);               // EOF
+    }
+    return out;
+}
+
+// Idle bus, the frames with three bits of intermission, idle again
+test::Signal toSignal(const std::vector<std::vector<uint8_t>>& frames, double drift, uint32_t seed) {
+    test::Signal signal(seed);
+    double bit = BIT_TICKS * drift;
+    signal.add(1, 20 * bit);
+    for (const std::vector<uint8_t>& line : frames) {
+        for (uint8_t b : line) {
+            signal.add(b, bit);
+        }
+        signal.add(1, 3 * bit);
+    }
+    signal.add(1, 20 * bit);
+    return signal;
+}
+
+CanDecoder::Config config() {
+    CanDecoder::Config c;
+    c.sample_rate_hz = SAMPLE_RATE;
+    c.bitrate = BITRATE;
+    c.channel = 2;
+    return c;
+}
+
+void checkFrame(const std::vector<Event>& events, size_t& i, const Frame& frame) {
+    CHECK(i < events.size());
+    if (i >= events.size()) {
+        return;
+    }
+    const Event& id = events[i++];
+    CHECK_EQ(id.type, EventType::CanId);
+    CHECK_EQ(id.value, frame.id);
+    CHECK_EQ(id.channel, 2);
+    CHECK_EQ(id.length, frame.data.size());
+    CHECK_EQ(id.flags, (frame.extended ? decode::EVENT_FLAG_EXTENDED : 0) | (frame.rtr ? decode::EVENT_FLAG_RTR : 0));
+    if (frame.rtr) {
+        return;
+    }
+    for (uint8_t byte : frame.data) {
+        CHECK(i < events.size());
+        if (i >= events.size()) {
+            return;
+        }
+        CHECK_EQ(events[i].type, EventType::CanData);
+        CHECK_EQ(events[i].value, byte);
+        i++;
+    }
+}
+
+void testCleanFrames() {
+    const std::vector<Frame> frames = {
+        {0x123, false, false, {1, 2, 3, 0xAA}},
+        {0x1ABCDEF, true, false, {0xFF, 0xFF, 0x00}},
+        {0x7FF, false, true, {0, 0}},
+        {0x000, false, false, {0, 0, 0, 0, 0, 0, 0, 0}},
+        {0x0, true, false, {}},
+    };
+
+    // Nominal, and both ways off by 1% with +-1 tick of jitter
+    for (double drift : {1.0, 1.01, 0.99}) {
+        std::vector<std::vector<uint8_t>> lines;
+        for (const Frame& frame : frames) {
+            lines.push_back(build(frame).line);
+        }
+        test::Signal signal = toSignal(lines, drift, 7);
+        test::EventLog log;
+        CanDecoder decoder(log, config());
+        signal.play(decoder, drift == 1.0 ? 0.0 : 1.0);
+
+        size_t i = 0;
+        for (const Frame& frame : frames) {
+            checkFrame(log.events, i, frame);
+        }
+        CHECK_EQ(i, log.events.size());
+        CHECK_EQ(decoder.stats().frames, frames.size());
+        CHECK_EQ(decoder.stats().stuff_errors + decoder.stats().crc_errors + decoder.stats().form_errors, 0);
+        CHECK_EQ(decoder.stats().ack_missing, 0);
+    }
+}
+
+void testStuffBitAfterCrc() {
+    // Find frames whose CRC ends in five equal bits, so the transmitter
+    // puts a stuff bit between the CRC and its delimiter
+    std::vector<Frame> frames;
+    std::vector<std::vector<uint8_t>> lines;
+    bool ones = false;
+    bool zeros = false;
+    for (uint32_t id = 0; id < 0x800 && !(ones && zeros); id++) {
+        Frame frame{id, false, false, {0x5A, (uint8_t)id}};
+        Bits bits = build(frame);
+        if (!bits.stuff_after_crc) {
+            continue;
+        }
+        bool all_ones = (bits.crc & 0x1F) == 0x1F;
+        if ((all_ones && ones) || (!all_ones && zeros)) {
+            continue;
+        }
+        (all_ones ? ones : zeros) = true;
+        frames.push_back(frame);
+        lines.push_back(bits.line);
+    }
+    CHECK(ones && zeros);
+
+    test::Signal signal = toSignal(lines, 1.0, 3);
+    test::EventLog log;
+    CanDecoder decoder(log, config());
+    signal.play(decoder);
+
+    size_t i = 0;
+    for (const Frame& frame : frames) {
+        checkFrame(log.events, i, frame);
+    }
+    CHECK_EQ(i, log.events.size());
+    CHECK_EQ(decoder.stats().frames, frames.size());
+    CHECK_EQ(decoder.stats().form_errors, 0);
+    CHECK_EQ(decoder.stats().ack_missing, 0);
+}
+
+void testErrors() {
+    // No ACK: the frame is still complete, the missing ACK is reported
+    {
+        Frame frame{0x321, false, false, {0x42}, false};
+        test::Signal signal = toSignal({build(frame).line}, 1.0, 1);
+        test::EventLog log;
+        CanDecoder decoder(log, config());
+        signal.play(decoder);
+        CHECK_EQ(log.count(EventType::CanId), 1);
+        CHECK_EQ(log.count(EventType::CanAckMissing), 1);
+        CHECK_EQ(decoder.stats().ack_missing, 1);
+        CHECK_EQ(decoder.stats().frames, 1);
+    }
+
+    // Corrupted CRC: value carries computed and received CRC
+    {
+        Frame frame{0x55, false, false, {0x10}, true, true};
+        Bits bits = build(frame);
+        test::Signal signal = toSignal({bits.line}, 1.0, 1);
+        test::EventLog log;
+        CanDecoder decoder(log, config());
+        signal.play(decoder);
+        std::vector<Event> crc = log.of(EventType::CanCrcError);
+        CHECK_EQ(crc.size(), 1);
+        if (!crc.empty()) {
+            CHECK_EQ(crc[0].value, ((uint32_t)bits.crc << 16) | (bits.crc ^ 1u));
+        }
+        CHECK_EQ(decoder.stats().crc_errors, 1);
+        CHECK_EQ(decoder.stats().frames, 0);
+    }
+
+    // A stuff bit with the wrong polarity is six equal bits in a row;
+    // the next frame still decodes
+    {
+        Frame broken{0x000, false, false, {0x00}};
+        Frame good{0x246, false, false, {0x99}};
+        Bits bits = build(broken);
+        CHECK(!bits.stuff.empty());
+        bits.line[bits.stuff[0]] ^= 1;
+        test::Signal signal = toSignal({bits.line, build(good).line}, 1.0, 1);
+        test::EventLog log;
+        CanDecoder decoder(log, config());
+        signal.play(decoder);
+        CHECK_EQ(log.count(EventType::CanStuffError), 1);
+        CHECK_EQ(decoder.stats().stuff_errors, 1);
+        std::vector<Event> ids = log.of(EventType::CanId);
+        CHECK_EQ(ids.size(), 1);
+        if (!ids.empty()) {
+            CHECK_EQ(ids[0].value, 0x246);
+        }
+        CHECK_EQ(decoder.stats().frames, 1);
+    }
+}
+
+} // namespace
+
+int main() {
+    testCleanFrames();
+    testStuffBitAfterCrc();
+    testErrors();
+    return check::result("can_decoder_test");
+}
@@ -0,0 +1,281 @@
+/**
+  ******************************************************************************
+  * @file           : capture_compare_test.cpp
+  * @brief          : Capture pass / fail comparison against a reference
+  ******************************************************************************
+  * Random references are edge lists with gaps of more than twice the
+  * tolerance, some long enough to need split runs. Each capture is made
+  * from its reference in one known way, so the expected verdict follows
+  * from how it was made: edges moved within the tolerance pass, and an
+  * edge moved early or late, a missing or an extra pulse, or the other
+  * start level fails with that kind at that time. Several channels
+  * together report the earliest deviation. Fixed cases cover the end of
+  * a shorter capture and empty channels.
+  ******************************************************************************
+  */
+
+#include "CaptureCompare.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+using measure::CaptureCompare;
+using Deviation = CaptureCompare::Deviation;
+
+namespace {
+
+// Display format: bit 7 = level, bits 6-0 = ticks, long runs split at 127
+void addRun(std::vector<uint8_t>& data, uint8_t level, uint32_t ticks) {
+    while (ticks > 0) {
+        uint8_t run = (ticks > 127) ? 127 : (uint8_t)ticks;
+        data.push_back((uint8_t)((level << 7) | run));
+        ticks -= run;
+    }
+}
+
+// Edge times must rise, the first above 0 and the last below the end
+std::vector<uint8_t> encode(uint8_t level, const std::vector<uint32_t>& edges, uint32_t end) {
+    std::vector<uint8_t> data;
+    uint32_t t = 0;
+    for (uint32_t edge : edges) {
+        addRun(data, level, edge - t);
+        level ^= 1;
+        t = edge;
+    }
+    addRun(data, level, end - t);
+    return data;
+}
+
+struct Reference {
+    uint8_t level;
+    std::vector<uint32_t> edges;
+    uint32_t end;
+};
+
+Reference randomReference(std::mt19937& rng, uint32_t tolerance) {
+    Reference r;
+    r.level = (uint8_t)(rng() & 1);
+    uint32_t min_gap = 2 * tolerance + 4;
+    uint32_t t = 0;
+    uint32_t count = rng() % 40;
+    for (uint32_t k = 0; k < count; k++) {
+        t += min_gap + rng() % 300;
+        r.edges.push_back(t);
+    }
+    r.end = t + min_gap + rng() % 300;
+    return r;
+}
+
+uint32_t between(std::mt19937& rng, uint32_t lo, uint32_t hi) {
+    return lo + rng() % (hi - lo + 1);
+}
+
+// One way to derive a capture from its reference, with the verdict it gets
+struct Capture {
+    std::vector<uint8_t> data;
+    bool pass;
+    CaptureCompare::Mismatch mismatch;
+};
+
+enum class Change : uint8_t { Jitter, Early, Late, Missing, Extra, Level, COUNT };
+
+Capture derive(std::mt19937& rng, const Reference& ref, uint32_t tolerance, Change change) {
+    const uint32_t NO_EDGE = CaptureCompare::NO_EDGE;
+    std::vector<uint32_t> edges = ref.edges;
+    uint32_t count = (uint32_t)edges.size();
+    Capture c;
+    c.pass = false;
+    c.mismatch = {Deviation::None, 0, 0, NO_EDGE, NO_EDGE};
+
+    if ((change == Change::Early || change == Change::Late) && count == 0) {
+        change = Change::Extra;
+    }
+    if (change == Change::Missing && count < 2) {
+        change = Change::Jitter;
+    }
+    uint32_t k = (count > 0) ? rng() % count : 0;
+    uint32_t prev = (k > 0) ? edges[k - 1] : 0;
+    uint32_t next = (k + 1 < count) ? edges[k + 1] : ref.end;
+
+    switch (change) {
+    case Change::Jitter:
+        // Gaps exceed twice the tolerance, so the order holds
+        for (uint32_t& edge : edges) {
+            edge = edge - tolerance + rng() % (2 * tolerance + 1);
+        }
+        c.pass = true;
+        break;
+    case Change::Early: {
+        uint32_t moved = edges[k] - between(rng, tolerance + 1, edges[k] - prev - 1);
+        c.mismatch = {Deviation::Early, 0, moved, edges[k], moved};
+        edges[k] = moved;
+        break;
+    }
+    case Change::Late: {
+        uint32_t moved = edges[k] + between(rng, tolerance + 1, next - edges[k] - 1);
+        c.mismatch = {Deviation::Late, 0, edges[k], edges[k], moved};
+        edges[k] = moved;
+        break;
+    }
+    case Change::Missing:
+        // Edges k and k + 1 go; the next capture edge is the one after them
+        k = rng() % (count - 1);
+        c.mismatch = {Deviation::Late, 0, ref.edges[k], ref.edges[k], (k + 2 < count) ? edges[k + 2] : NO_EDGE};
+        edges.erase(edges.begin() + k, edges.begin() + k + 2);
+        break;
+    case Change::Extra: {
+        // A pulse in the gap before edge k (or before the end), ahead of it
+        // by more than the tolerance
+        k = rng() % (count + 1);
+        prev = (k > 0) ? edges[k - 1] : 0;
+        next = (k < count) ? edges[k] : ref.end;
+        uint32_t rise = between(rng, prev + 1, next - tolerance - 2);
+        uint32_t fall = between(rng, rise + 1, next - 1);
+        c.mismatch = {Deviation::Early, 0, rise, (k < count) ? edges[k] : NO_EDGE, rise};
+        edges.insert(edges.begin() + k, {rise, fall});
+        break;
+    }
+    case Change::Level:
+    default:
+        c.mismatch = {Deviation::Level, 0, 0, NO_EDGE, NO_EDGE};
+        c.data = encode((uint8_t)(ref.level ^ 1), edges, ref.end);
+        return c;
+    }
+    c.data = encode(ref.level, edges, ref.end);
+    return c;
+}
+
+bool sameMismatch(const CaptureCompare::Mismatch& a, const CaptureCompare::Mismatch& b) {
+    return a.kind == b.kind && a.channel == b.channel && a.time == b.time && a.expected == b.expected &&
+           a.actual == b.actual;
+}
+
+void testRandomChannels() {
+    std::mt19937 rng(36);
+    uint32_t wrong[(uint8_t)Change::COUNT] = {};
+    uint32_t tried[(uint8_t)Change::COUNT] = {};
+    for (uint32_t round = 0; round < 20000; round++) {
+        uint32_t tolerance = rng() % 21;
+        Reference ref = randomReference(rng, tolerance);
+        Change change = (Change)(rng() % (uint8_t)Change::COUNT);
+        Capture capture = derive(rng, ref, tolerance, change);
+        std::vector<uint8_t> reference = encode(ref.level, ref.edges, ref.end);
+
+        CaptureCompare::Mismatch mismatch = {Deviation::None, 0, 0, 0, 0};
+        bool pass = CaptureCompare::compareChannel(reference.data(), (uint16_t)reference.size(),
+                                                   capture.data.data(), (uint16_t)capture.data.size(),
+                                                   tolerance, mismatch);
+        bool right = (pass == capture.pass) && (pass || sameMismatch(mismatch, capture.mismatch));
+        tried[(uint8_t)change]++;
+        wrong[(uint8_t)change] += right ? 0 : 1;
+    }
+    for (uint8_t change = 0; change < (uint8_t)Change::COUNT; change++) {
+        CHECK(tried[change] > 1000);
+        CHECK_EQ(wrong[change], 0);
+    }
+}
+
+void testRandomCaptures() {
+    // The earliest deviation of all channels, the lowest channel on a tie
+    std::mt19937 rng(360);
+    uint32_t wrong = 0;
+    uint64_t expected_passes = 0;
+    CaptureCompare compare;
+    for (uint32_t round = 0; round < 5000; round++) {
+        uint32_t tolerance = rng() % 11;
+        uint8_t num_channels = (uint8_t)(1 + rng() % CaptureCompare::MAX_CHANNELS);
+        std::vector<std::vector<uint8_t>> references;
+        std::vector<Capture> captures;
+        bool pass = true;
+        CaptureCompare::Mismatch first = {};
+        for (uint8_t ch = 0; ch < num_channels; ch++) {
+            Reference ref = randomReference(rng, tolerance);
+            // Mostly clean channels, so that a fair share of captures pass
+            Change change = (rng() % 4 != 0) ? Change::Jitter : (Change)(rng() % (uint8_t)Change::COUNT);
+            captures.push_back(derive(rng, ref, tolerance, change));
+            references.push_back(encode(ref.level, ref.edges, ref.end));
+            Capture& capture = captures.back();
+            capture.mismatch.channel = ch;
+            if (!capture.pass && (pass || capture.mismatch.time < first.time)) {
+                first = capture.mismatch;
+            }
+            pass = pass && capture.pass;
+        }
+        const uint8_t* reference_data[CaptureCompare::MAX_CHANNELS];
+        uint16_t reference_lengths[CaptureCompare::MAX_CHANNELS];
+        const uint8_t* capture_data[CaptureCompare::MAX_CHANNELS];
+        uint16_t capture_lengths[CaptureCompare::MAX_CHANNELS];
+        for (uint8_t ch = 0; ch < num_channels; ch++) {
+            reference_data[ch] = references[ch].data();
+            reference_lengths[ch] = (uint16_t)references[ch].size();
+            capture_data[ch] = captures[ch].data.data();
+            capture_lengths[ch] = (uint16_t)captures[ch].data.size();
+        }
+        compare.setTolerance(tolerance);
+        compare.setReference(reference_data, reference_lengths, num_channels);
+        bool result = compare.compare(capture_data, capture_lengths);
+        wrong += (result == pass && (pass || sameMismatch(compare.mismatch(), first))) ? 0 : 1;
+        expected_passes += pass ? 1 : 0;
+    }
+    CHECK_EQ(wrong, 0);
+    CHECK_EQ(compare.passes(), expected_passes);
+    CHECK_EQ(compare.fails(), 5000 - expected_passes);
+    CHECK(expected_passes > 500 && expected_passes < 4500);
+    compare.clearCounters();
+    CHECK_EQ(compare.passes() + compare.fails(), 0);
+}
+
+void testEnds() {
+    // Reference edges at 100, 200, 300, end 400; tolerance 5
+    std::vector<uint8_t> reference = encode(0, {100, 200, 300}, 400);
+    CaptureCompare::Mismatch mismatch = {};
+    auto matches = [&](const std::vector<uint8_t>& capture) {
+        return CaptureCompare::compareChannel(reference.data(), (uint16_t)reference.size(), capture.data(),
+                                              (uint16_t)capture.size(), 5, mismatch);
+    };
+
+    // Edges past the end of the shorter capture are not compared
+    CHECK(matches(encode(0, {100, 200}, 250)));
+    CHECK(matches(encode(0, {103, 196}, 298)));
+    // A missing edge just before that end may have its partner past it
+    CHECK(matches(encode(0, {100, 200}, 304)));
+    CHECK(!matches(encode(0, {100, 200}, 306)));
+    CHECK(mismatch.kind == Deviation::Late);
+    CHECK_EQ(mismatch.time, 300);
+    CHECK_EQ(mismatch.actual, CaptureCompare::NO_EDGE);
+
+    // An extra edge near the end: the same grace, otherwise Early
+    CHECK(matches(encode(0, {100, 200, 300, 390}, 393)));
+    CHECK(!matches(encode(0, {100, 200, 300, 390}, 400)));
+    CHECK(mismatch.kind == Deviation::Early);
+    CHECK_EQ(mismatch.time, 390);
+    CHECK_EQ(mismatch.expected, CaptureCompare::NO_EDGE);
+
+    // Empty channels match each other only
+    std::vector<uint8_t> none;
+    CHECK(CaptureCompare::compareChannel(nullptr, 0, nullptr, 0, 5, mismatch));
+    CHECK(CaptureCompare::compareChannel(none.data(), 0, nullptr, 0, 5, mismatch));
+    CHECK(!CaptureCompare::compareChannel(reference.data(), (uint16_t)reference.size(), nullptr, 0, 5, mismatch));
+    CHECK(mismatch.kind == Deviation::Level);
+    CHECK(!CaptureCompare::compareChannel(nullptr, 0, reference.data(), (uint16_t)reference.size(), 5, mismatch));
+    CHECK(mismatch.kind == Deviation::Level);
+}
+
+void testNames() {
+    CHECK(CaptureCompare::deviationName(Deviation::None)[0] == 'N');
+    CHECK(CaptureCompare::deviationName(Deviation::Level)[0] == 'L');
+    CHECK(CaptureCompare::deviationName(Deviation::Early)[0] == 'E');
+    CHECK(CaptureCompare::deviationName(Deviation::Late)[0] == 'L');
+    CHECK(CaptureCompare::deviationName((Deviation)9)[0] == '?');
+}
+
+} // namespace
+
+int main() {
+    testRandomChannels();
+    testRandomCaptures();
+    testEnds();
+    testNames();
+    return check::result("capture_compare_test");
+}
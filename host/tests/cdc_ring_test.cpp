@@ -0,0 +1,248 @@
+/**
+  ******************************************************************************
+  * @file           : cdc_ring_test.cpp
+  * @brief          : CDC transmit ring in usbd_cdc_if.c against a simulated IN endpoint
+  ******************************************************************************
+  * The test stands in for the USB class: TransmitPacket takes a transfer
+  * while the endpoint is idle and complete() finishes it the way DataIn
+  * does (after a ZLP when the length is a multiple of 64). Everything
+  * CDC_Transmit_FS accepts must reach the wire once, in order, with whole
+  * writes refused only when they do not fit, each transfer as long as the
+  * ring allows, and a transfer cut off by a bus reset sent again.
+  ******************************************************************************
+  */
+
+#include "usbd_cdc_if.h"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+extern "C" {
+extern uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
+USBD_HandleTypeDef hUsbDeviceFS;
+}
+
+namespace {
+
+USBD_CDC_HandleTypeDef hcdc;
+std::vector<uint8_t> wire;      // What the host has received
+std::vector<uint8_t> accepted;  // What CDC_Transmit_FS took
+uint32_t zlps = 0;
+uint32_t bad_buffers = 0;
+
+uint32_t pending() {
+    CDC_TxStatsTypeDef stats;
+    CDC_GetTxStats_FS(&stats);
+    return stats.queued - stats.sent;
+}
+
+// The endpoint finishes the transfer in flight; false when idle
+bool complete() {
+    if (hcdc.TxState == 0) {
+        return false;
+    }
+    // Zero-copy: the transfer must lie inside the ring, never across its end
+    bad_buffers += (hcdc.TxBuffer < UserTxBufferFS || hcdc.TxLength == 0 ||
+                    hcdc.TxBuffer + hcdc.TxLength > UserTxBufferFS + APP_TX_DATA_SIZE) ? 1 : 0;
+    wire.insert(wire.end(), hcdc.TxBuffer, hcdc.TxBuffer + hcdc.TxLength);
+    zlps += (hcdc.TxLength % 64 == 0) ? 1 : 0;
+    hcdc.TxState = 0;
+    uint32_t length = hcdc.TxLength;
+    USBD_Interface_fops_FS.TransmitCplt(hcdc.TxBuffer, &length, 1);
+    return true;
+}
+
+void drain() {
+    while (complete()) {
+    }
+}
+
+uint8_t write(std::mt19937& rng, uint16_t length) {
+    std::vector<uint8_t> data(length);
+    for (uint8_t& byte : data) {
+        byte = (uint8_t)rng();
+    }
+    uint8_t result = CDC_Transmit_FS(data.data(), length);
+    if (result == USBD_OK) {
+        accepted.insert(accepted.end(), data.begin(), data.end());
+    }
+    return result;
+}
+
+void enumerate() {
+    hcdc = USBD_CDC_HandleTypeDef();
+    hUsbDeviceFS.pClassData = &hcdc;
+    USBD_Interface_fops_FS.Init();
+}
+
+void testBeforeEnumeration() {
+    // Writes before the host configures the device wait in the ring
+    std::mt19937 rng(1);
+    hUsbDeviceFS.pClassData = nullptr;
+    CHECK_EQ(write(rng, 100), USBD_OK);
+    CHECK_EQ(write(rng, 50), USBD_OK);
+    CHECK_EQ(pending(), 150);
+
+    // Init sends them as one transfer
+    enumerate();
+    CHECK_EQ(hcdc.TxState, 1);
+    CHECK_EQ(hcdc.TxLength, 150);
+    drain();
+    CHECK_EQ(pending(), 0);
+    CHECK(wire == accepted);
+}
+
+void testFullRing() {
+    std::mt19937 rng(2);
+    CDC_TxStatsTypeDef before;
+    CDC_GetTxStats_FS(&before);
+
+    // Hold the endpoint busy: everything queues behind the first write
+    CHECK_EQ(write(rng, 10), USBD_OK);
+    CHECK_EQ(hcdc.TxState, 1);
+    CHECK_EQ(write(rng, APP_TX_DATA_SIZE - 10), USBD_OK);
+    CHECK_EQ(pending(), APP_TX_DATA_SIZE);
+
+    // Full: nothing more fits, not even a byte, and nothing is half taken
+    CHECK_EQ(write(rng, 1), USBD_BUSY);
+    CHECK_EQ(write(rng, 64), USBD_BUSY);
+    CHECK_EQ(pending(), APP_TX_DATA_SIZE);
+
+    // The completion chains the rest, split at the end of the buffer
+    drain();
+    CHECK(wire == accepted);
+    CDC_TxStatsTypeDef after;
+    CDC_GetTxStats_FS(&after);
+    CHECK_EQ(after.dropped - before.dropped, 65);
+    CHECK_EQ(after.queued - before.queued, APP_TX_DATA_SIZE);
+    CHECK_EQ(after.sent - before.sent, APP_TX_DATA_SIZE);
+    CHECK(after.transfers - before.transfers <= 3);
+
+    // A write larger than the ring never fits
+    std::vector<uint8_t> big(APP_TX_DATA_SIZE + 1);
+    CHECK_EQ(CDC_Transmit_FS(big.data(), (uint16_t)big.size()), USBD_BUSY);
+    CHECK_EQ(pending(), 0);
+}
+
+void testRandom() {
+    std::mt19937 rng(3);
+    uint32_t bad = 0;
+    uint32_t refused = 0;
+    for (int step = 0; step < 200000; step++) {
+        if (rng() % 3 != 0) {
+            uint16_t length = (uint16_t)((rng() % 8 == 0) ? rng() % 1100 : rng() % 200);
+            uint32_t room = APP_TX_DATA_SIZE - pending();
+            uint8_t result = write(rng, length);
+            bad += ((result == USBD_OK) != (length <= room)) ? 1 : 0;
+            refused += (result != USBD_OK) ? 1 : 0;
+        } else if (hcdc.TxState != 0) {
+            // Each transfer takes all that is pending up to the end of the buffer
+            CDC_TxStatsTypeDef stats;
+            CDC_GetTxStats_FS(&stats);
+            uint32_t offset = stats.sent % APP_TX_DATA_SIZE;
+            uint32_t expected = stats.queued - stats.sent;
+            if (expected > APP_TX_DATA_SIZE - offset) {
+                expected = APP_TX_DATA_SIZE - offset;
+            }
+            bad += (hcdc.TxBuffer != UserTxBufferFS + offset || hcdc.TxLength > expected) ? 1 : 0;
+            complete();
+        }
+        // Never idle with data queued
+        bad += (hcdc.TxState == 0 && pending() != 0) ? 1 : 0;
+    }
+    drain();
+    CHECK_EQ(bad, 0);
+    CHECK(refused > 0);
+    CHECK(zlps > 0);
+    CHECK_EQ(wire.size(), accepted.size());
+    CHECK(wire == accepted);
+    CHECK_EQ(bad_buffers, 0);
+}
+
+void testStarved() {
+    std::mt19937 rng(4);
+    CDC_TxStatsTypeDef before;
+    CDC_GetTxStats_FS(&before);
+    CHECK_EQ(write(rng, 20), USBD_OK);
+    CHECK_EQ(write(rng, 30), USBD_OK);
+    drain();
+    CDC_TxStatsTypeDef after;
+    CDC_GetTxStats_FS(&after);
+    // 20 bytes, then the 30 queued meanwhile, then the ring ran dry
+    CHECK_EQ(after.transfers - before.transfers, 2);
+    CHECK_EQ(after.starved - before.starved, 1);
+    CHECK(wire == accepted);
+}
+
+void testReset() {
+    // A bus reset drops the transfer in flight: Init sends it again
+    std::mt19937 rng(5);
+    CHECK_EQ(write(rng, 200), USBD_OK);
+    CHECK_EQ(write(rng, 100), USBD_OK);
+
+    enumerate();
+    CHECK_EQ(hcdc.TxState, 1);
+    CHECK_EQ(pending(), 300);
+    CDC_TxStatsTypeDef stats;
+    CDC_GetTxStats_FS(&stats);
+    uint32_t offset = stats.sent % APP_TX_DATA_SIZE;
+    CHECK(hcdc.TxBuffer == UserTxBufferFS + offset);
+    CHECK_EQ(hcdc.TxLength, (APP_TX_DATA_SIZE - offset < 300) ? APP_TX_DATA_SIZE - offset : 300);
+    drain();
+    CHECK(wire == accepted);
+
+    // Unplugged with a transfer in flight: writes keep queueing until the
+    // device is configured again
+    CHECK_EQ(write(rng, 64), USBD_OK);
+    hUsbDeviceFS.pClassData = nullptr;
+    CHECK_EQ(write(rng, 64), USBD_OK);
+    CHECK_EQ(pending(), 128);
+    enumerate();
+    drain();
+    CHECK_EQ(pending(), 0);
+    CHECK(wire == accepted);
+}
+
+} // namespace
+
+int main() {
+    testBeforeEnumeration();
+    testFullRing();
+    testRandom();
+    testStarved();
+    testReset();
+    return check::result("cdc_ring_test");
+}
+
+// The class side, as the ST library implements it for this interface
+extern "C" {
+
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef* pdev, uint8_t* pbuff, uint32_t length) {
+    USBD_CDC_HandleTypeDef* cdc = (USBD_CDC_HandleTypeDef*)pdev->pClassData;
+    if (cdc == nullptr) {
+        return USBD_FAIL;
+    }
+    cdc->TxBuffer = pbuff;
+    cdc->TxLength = length;
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef*, uint8_t*) {
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef*) {
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef* pdev) {
+    USBD_CDC_HandleTypeDef* cdc = (USBD_CDC_HandleTypeDef*)pdev->pClassData;
+    if (cdc == nullptr || cdc->TxState != 0) {
+        return USBD_BUSY;
+    }
+    cdc->TxState = 1;
+    return USBD_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file           : check.hpp
+  * @brief          : Minimal assertions for the host tests (ctest)
+  ******************************************************************************
+  * CHECK(condition) and CHECK_EQ(actual, expected) report a failure with
+  * its line and carry on, so one run shows everything that broke. main()
+  * ends with return check::result("name"): a one-line summary, and the
+  * exit code ctest goes by.
+  ******************************************************************************
+  */
+
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+namespace check {
+
+inline uint32_t checks = 0;
+inline uint32_t failures = 0;
+
+inline void fail(const char* file, int line, const char* what) {
+    failures++;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+}
+
+inline void failEqual(const char* file, int line, const char* actual, const char* expected,
+                      long long actual_value, long long expected_value) {
+    failures++;
+    fprintf(stderr, "%s:%d: check failed: %s == %s (%lld, expected %lld)\n", file, line, actual, expected,
+            actual_value, expected_value);
+}
+
+inline int result(const char* name) {
+    printf("%s: %u checks, %u failed\n", name, checks, failures);
+    return (failures == 0) ? 0 : 1;
+}
+
+} // namespace check
+
+#define CHECK(condition)                                        \
+    do {                                                        \
+        check::checks++;                                        \
+        if (!(condition)) {                                     \
+            check::fail(__FILE__, __LINE__, #condition);        \
+        }                                                       \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                  \
+    do {                                                                                            \
+        check::checks++;                                                                            \
+        long long actual_value_ = (long long)(actual);                                              \
+        long long expected_value_ = (long long)(expected);                                          \
+        if (actual_value_ != expected_value_) {                                                     \
+            check::failEqual(__FILE__, __LINE__, #actual, #expected, actual_value_, expected_value_); \
+        }                                                                                           \
+    } while (0)
+
+#endif /* CHECK_HPP */
@@ -0,0 +1,297 @@
+/**
+  ******************************************************************************
+  * @file           : command_parser_test.cpp
+  * @brief          : Console command parser, text lines and binary frames
+  ******************************************************************************
+  * Bytes arrive from the CDC ring in whatever pieces USB delivered, so
+  * every input is fed one byte at a time and commands are collected as
+  * they complete. Text lines are checked with their arguments, line
+  * endings, backspace and overflow; frames against encodeFrame() for the
+  * same commands, with bad checksums, bad counts and unknown ops, and a
+  * SYNC byte inside a line must stay text.
+  ******************************************************************************
+  */
+
+#include "CommandParser.hpp"
+#include "check.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using shell::Command;
+using shell::CommandParser;
+using shell::Op;
+
+namespace {
+
+std::vector<Command> feed(CommandParser& parser, const uint8_t* bytes, size_t length) {
+    std::vector<Command> commands;
+    for (size_t k = 0; k < length; k++) {
+        Command command = {};
+        if (parser.feed(bytes[k], command)) {
+            commands.push_back(command);
+        }
+    }
+    return commands;
+}
+
+std::vector<Command> feed(CommandParser& parser, const std::string& text) {
+    return feed(parser, (const uint8_t*)text.data(), text.size());
+}
+
+// The one command a line gives
+Command parseLine(const std::string& line) {
+    CommandParser parser;
+    std::vector<Command> commands = feed(parser, line + "\r\n");
+    CHECK_EQ(commands.size(), 1);
+    return commands.empty() ? Command{} : commands[0];
+}
+
+bool isError(const Command& command, const char* error) {
+    return command.op == Op::Error && command.error != nullptr && strcmp(command.error, error) == 0;
+}
+
+std::vector<uint8_t> frame(Op op, std::vector<uint32_t> args) {
+    std::vector<uint8_t> out(CommandParser::FRAME_MAX);
+    out.resize(CommandParser::encodeFrame(op, args.data(), (uint8_t)args.size(), out.data()));
+    return out;
+}
+
+bool sameCommand(const Command& a, const Command& b) {
+    if (a.op != b.op || a.argc != b.argc) {
+        return false;
+    }
+    for (uint8_t k = 0; k < a.argc; k++) {
+        if (a.args[k] != b.args[k]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testText() {
+    Command c = parseLine("help");
+    CHECK(c.op == Op::Help && c.argc == 0 && !c.binary);
+    CHECK(parseLine("?").op == Op::Help);
+    CHECK(parseLine("STATS").op == Op::Stats);
+
+    c = parseLine("rate");
+    CHECK(c.op == Op::Rate && c.argc == 0);
+    c = parseLine("  rate   500k ");
+    CHECK(c.op == Op::Rate && c.argc == 1);
+    CHECK_EQ(c.args[0], 500000);
+    CHECK_EQ(parseLine("rate 2M").args[0], 2000000);
+    CHECK_EQ(parseLine("rate 1200").args[0], 1200);
+    CHECK(isError(parseLine("rate 0"), "bad argument"));
+    CHECK(isError(parseLine("rate 5G"), "bad argument"));
+    CHECK(isError(parseLine("rate 99999999999"), "bad argument"));
+
+    c = parseLine("dump burst 10 20");
+    CHECK(c.op == Op::Dump && c.argc == 3);
+    CHECK_EQ(c.args[0], (uint32_t)shell::DumpBuffer::Burst);
+    CHECK_EQ(c.args[1], 10);
+    CHECK_EQ(c.args[2], 20);
+    CHECK_EQ(parseLine("dump Events").argc, 1);
+    CHECK(isError(parseLine("dump"), "bad argument"));
+    CHECK(isError(parseLine("dump nothing"), "bad argument"));
+    CHECK(isError(parseLine("dump events x"), "bad argument"));
+
+    c = parseLine("time 2024-02-29 23:59:58");
+    CHECK(c.op == Op::Time && c.argc == 6);
+    CHECK_EQ(c.args[0], 2024);
+    CHECK_EQ(c.args[2], 29);
+    CHECK_EQ(c.args[5], 58);
+    CHECK(isError(parseLine("time 2023-02-29 00:00:00"), "bad argument"));
+    CHECK(isError(parseLine("time 2024-13-01 00:00:00"), "bad argument"));
+    CHECK(isError(parseLine("time 2024-01-01 24:00:00"), "bad argument"));
+    CHECK(isError(parseLine("time 2024-01-01"), "bad argument"));
+
+    c = parseLine("decode 2 CAN 250k");
+    CHECK(c.op == Op::Decode && c.argc == 3);
+    CHECK_EQ(c.args[0], 2);
+    CHECK_EQ(c.args[1], 1);
+    CHECK_EQ(c.args[2], 250000);
+    c = parseLine("decode 0 nec 0");
+    CHECK_EQ(c.args[1], 6);
+    CHECK_EQ(c.args[2], 0);
+    CHECK_EQ(parseLine("decode 1 off").argc, 2);
+    CHECK(isError(parseLine("decode 1 spi"), "bad argument"));
+    CHECK(isError(parseLine("decode 1"), "bad argument"));
+
+    CHECK(isError(parseLine("reboot"), "unknown command, try help"));
+    CHECK(isError(parseLine("help me"), "bad argument"));
+    CHECK(isError(parseLine("dump events 1 2 3 4 5 6"), "bad argument"));
+}
+
+void testLines() {
+    CommandParser parser;
+    // CR, LF and CR LF end a line once; empty and blank lines give nothing
+    std::vector<Command> commands = feed(parser, "help\r\nstats\rrate\n\r\n   \r\nhelp");
+    CHECK_EQ(commands.size(), 3);
+    CHECK(commands.size() == 3 && commands[0].op == Op::Help && commands[1].op == Op::Stats &&
+          commands[2].op == Op::Rate);
+    // The unfinished line is kept until its end arrives
+    commands = feed(parser, "\n");
+    CHECK(commands.size() == 1 && commands[0].op == Op::Help);
+
+    // Backspace and DEL edit; control bytes are dropped
+    commands = feed(parser, "rats\x08\x08te 1k\x7f" "2k\x01\x1b\r");
+    CHECK(commands.size() == 1 && commands[0].op == Op::Rate && commands[0].args[0] == 12000);
+    // Backspace on an empty line is harmless
+    commands = feed(parser, "\x08\x08help\r");
+    CHECK(commands.size() == 1 && commands[0].op == Op::Help);
+
+    // Too long: one error at the line end, and the next line is fine
+    std::string line(CommandParser::LINE_MAX, 'x');
+    commands = feed(parser, "help" + line + "\r\nhelp\r\n");
+    CHECK_EQ(commands.size(), 2);
+    CHECK(commands.size() == 2 && isError(commands[0], "line too long") && commands[1].op == Op::Help);
+    // Exactly LINE_MAX fits
+    commands = feed(parser, "dump events " + std::string(CommandParser::LINE_MAX - 12, '1') + "\r");
+    CHECK(commands.size() == 1 && isError(commands[0], "bad argument"));
+}
+
+void testFrames() {
+    const std::vector<std::pair<std::string, std::vector<uint8_t>>> same = {
+        {"help", frame(Op::Help, {})},
+        {"rate 250k", frame(Op::Rate, {250000})},
+        {"dump selftest 3 7", frame(Op::Dump, {2, 3, 7})},
+        {"time 2025-10-10 14:00:00", frame(Op::Time, {2025, 10, 10, 14, 0, 0})},
+        {"decode 3 ws2812", frame(Op::Decode, {3, 5})},
+    };
+    for (const auto& pair : same) {
+        CommandParser parser;
+        std::vector<Command> commands = feed(parser, pair.second.data(), pair.second.size());
+        CHECK_EQ(commands.size(), 1);
+        if (commands.size() == 1) {
+            CHECK(commands[0].binary);
+            CHECK(sameCommand(commands[0], parseLine(pair.first)));
+        }
+    }
+
+    CommandParser parser;
+    // Frames and lines back to back, in one piece
+    std::vector<uint8_t> stream = frame(Op::Stats, {});
+    std::vector<uint8_t> rate = frame(Op::Rate, {1000});
+    stream.insert(stream.end(), rate.begin(), rate.end());
+    const char* text = "help\r\n";
+    stream.insert(stream.end(), text, text + 6);
+    std::vector<uint8_t> tail = frame(Op::Dump, {0});
+    stream.insert(stream.end(), tail.begin(), tail.end());
+    std::vector<Command> commands = feed(parser, stream.data(), stream.size());
+    CHECK_EQ(commands.size(), 4);
+    if (commands.size() == 4) {
+        CHECK(commands[0].op == Op::Stats && commands[1].op == Op::Rate && commands[1].args[0] == 1000);
+        CHECK(commands[2].op == Op::Help && !commands[2].binary);
+        CHECK(commands[3].op == Op::Dump && commands[3].binary);
+    }
+
+    // Dripped in: inFrame() until the last byte
+    std::vector<uint8_t> time = frame(Op::Time, {2030, 1, 2, 3, 4, 5});
+    for (size_t k = 0; k + 1 < time.size(); k++) {
+        CHECK(feed(parser, &time[k], 1).empty());
+        CHECK(parser.inFrame());
+    }
+    commands = feed(parser, &time.back(), 1);
+    CHECK(!parser.inFrame());
+    CHECK(commands.size() == 1 && commands[0].op == Op::Time && commands[0].args[0] == 2030);
+
+    // Any flipped bit fails the checksum; the parser then takes the next frame
+    for (size_t k = 1; k < rate.size(); k++) {
+        std::vector<uint8_t> bad = rate;
+        bad[k] ^= 0x10;
+        commands = feed(parser, bad.data(), bad.size());
+        if (k == 2) {
+            // The count is now too large: refused before the arguments,
+            // which are left to the line parser
+            CHECK(!commands.empty() && isError(commands[0], "bad frame"));
+            parser.reset();
+            continue;
+        }
+        CHECK(commands.size() == 1 && isError(commands[0], "bad frame checksum") && commands[0].binary);
+        commands = feed(parser, rate.data(), rate.size());
+        CHECK(commands.size() == 1 && commands[0].op == Op::Rate);
+    }
+
+    // More arguments than a command can have
+    const uint8_t too_many[] = {CommandParser::SYNC, (uint8_t)Op::Rate, Command::MAX_ARGS + 1};
+    commands = feed(parser, too_many, sizeof(too_many));
+    CHECK(commands.size() == 1 && isError(commands[0], "bad frame"));
+    CHECK(!parser.inFrame());
+
+    // Valid checksum, unknown op or wrong arguments
+    std::vector<uint8_t> unknown = frame((Op)9, {});
+    commands = feed(parser, unknown.data(), unknown.size());
+    CHECK(commands.size() == 1 && isError(commands[0], "unknown command, try help"));
+    std::vector<uint8_t> zero_rate = frame(Op::Rate, {0});
+    commands = feed(parser, zero_rate.data(), zero_rate.size());
+    CHECK(commands.size() == 1 && isError(commands[0], "bad argument"));
+    std::vector<uint8_t> bad_protocol = frame(Op::Decode, {0, CommandParser::PROTOCOL_COUNT});
+    commands = feed(parser, bad_protocol.data(), bad_protocol.size());
+    CHECK(commands.size() == 1 && isError(commands[0], "bad argument"));
+
+    // A frame cut off by the host, dropped with reset()
+    commands = feed(parser, time.data(), time.size() / 2);
+    CHECK(commands.empty() && parser.inFrame());
+    parser.reset();
+    commands = feed(parser, "stats\r");
+    CHECK(commands.size() == 1 && commands[0].op == Op::Stats);
+
+    CHECK_EQ(CommandParser::encodeFrame(Op::Help, nullptr, Command::MAX_ARGS + 1, stream.data()), 0);
+}
+
+void testSyncInLine() {
+    // SYNC only starts a frame where a line would start; inside a line it
+    // is not 7-bit text and is dropped
+    CommandParser parser;
+    std::string line = "he";
+    line += (char)CommandParser::SYNC;
+    line += "lp\r\n";
+    std::vector<Command> commands = feed(parser, line);
+    CHECK(commands.size() == 1 && commands[0].op == Op::Help);
+    CHECK(!parser.inFrame());
+
+    // Nor after an overflowing line until its end
+    std::string long_line(CommandParser::LINE_MAX + 1, 'x');
+    long_line += (char)CommandParser::SYNC;
+    long_line += (char)Op::Help;
+    long_line += "\r\n";
+    commands = feed(parser, long_line);
+    CHECK(!parser.inFrame());
+    CHECK(commands.size() == 1 && isError(commands[0], "line too long"));
+
+    // Right after a line end it does
+    std::vector<uint8_t> help = frame(Op::Help, {});
+    std::vector<uint8_t> bytes = {'s', 't', 'a', 't', 's', '\r'};
+    bytes.insert(bytes.end(), help.begin(), help.end());
+    commands = feed(parser, bytes.data(), bytes.size());
+    CHECK(commands.size() == 2 && commands[0].op == Op::Stats && commands[1].op == Op::Help &&
+          commands[1].binary);
+}
+
+void testNames() {
+    for (uint8_t op = 1; op <= (uint8_t)Op::Decode; op++) {
+        CHECK(strcmp(CommandParser::opName((Op)op), "?") != 0);
+        // All but dump work without arguments
+        CHECK(parseLine(CommandParser::opName((Op)op)).op != Op::Error || (Op)op == Op::Dump);
+    }
+    CHECK(strcmp(CommandParser::opName(Op::Error), "?") == 0);
+    CHECK(strcmp(CommandParser::bufferName(shell::DumpBuffer::Selftest), "selftest") == 0);
+    CHECK(strcmp(CommandParser::protocolName(CommandParser::PROTOCOL_COUNT), "?") == 0);
+    for (uint32_t p = 0; p < CommandParser::PROTOCOL_COUNT; p++) {
+        Command c = parseLine(std::string("decode 1 ") + CommandParser::protocolName(p));
+        CHECK(c.op == Op::Decode && c.args[1] == p);
+    }
+}
+
+} // namespace
+
+int main() {
+    testText();
+    testLines();
+    testFrames();
+    testSyncInLine();
+    testNames();
+    return check::result("command_parser_test");
+}
@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * @file           : edge_index_test.cpp
+  * @brief          : Edge index queries against a brute-force scan
+  ******************************************************************************
+  * Random transition lists, with same-level entries mixed in as long runs
+  * leave them, are indexed with checkpoint arrays from a single element
+  * up to one per minimum block. Every query is compared with a scan of
+  * the full edge list, at every entry start (which includes every
+  * checkpoint) and one tick either side, at random times, and before the
+  * start and past the end. Elements past the capacity must stay untouched.
+  ******************************************************************************
+  */
+
+#include "EdgeIndex.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+using decode::EdgeIndex;
+
+namespace {
+
+// Timestamps of the edges, scanned from the start
+std::vector<uint32_t> edgesOf(const std::vector<uint8_t>& data, uint32_t start) {
+    std::vector<uint32_t> edges;
+    uint32_t t = start;
+    for (size_t k = 0; k < data.size(); k++) {
+        if (k > 0 && (data[k] >> 7) != (data[k - 1] >> 7)) {
+            edges.push_back(t);
+        }
+        t += data[k] & 0x7F;
+    }
+    return edges;
+}
+
+// Number of wrong answers over all queries at time t
+uint32_t wrongAt(const EdgeIndex& index, const std::vector<uint32_t>& edges, uint32_t t) {
+    uint32_t before = 0;
+    while (before < edges.size() && edges[before] < t) {
+        before++;
+    }
+    uint32_t wrong = (index.edgesBefore(t) != before) ? 1 : 0;
+
+    uint32_t edge = 0;
+    bool found = index.prevEdge(t, edge);
+    wrong += (found != (before > 0) || (found && edge != edges[before - 1])) ? 1 : 0;
+
+    uint32_t after = before;
+    while (after < edges.size() && edges[after] <= t) {
+        after++;
+    }
+    found = index.nextEdge(t, edge);
+    wrong += (found != (after < edges.size()) || (found && edge != edges[after])) ? 1 : 0;
+
+    // Nearest: the earlier one on a tie
+    bool any = !edges.empty();
+    uint32_t nearest = 0;
+    for (uint32_t e : edges) {
+        uint32_t distance = (e > t) ? e - t : t - e;
+        uint32_t best = (nearest > t) ? nearest - t : t - nearest;
+        if (e == edges.front() || distance < best) {
+            nearest = e;
+        }
+    }
+    found = index.nearestEdge(t, edge);
+    wrong += (found != any || (found && edge != nearest)) ? 1 : 0;
+    return wrong;
+}
+
+void testRandom() {
+    std::mt19937 rng(32);
+    const uint32_t capacities[] = {1, 2, 3, 7, 16, 100};
+    const uint32_t GUARD = 4;
+    uint32_t wrong = 0;
+    uint32_t overruns = 0;
+    uint32_t queries = 0;
+    for (uint32_t round = 0; round < 100; round++) {
+        uint32_t length = (round % 10 == 0) ? 8 * (rng() % 20) : rng() % 400;
+        uint32_t start = (rng() & 1) ? rng() % 100000 : 0;
+        std::vector<uint8_t> data;
+        uint8_t level = (uint8_t)(rng() & 1);
+        for (uint32_t k = 0; k < length; k++) {
+            if (rng() % 10 < 7) {
+                level ^= 1;
+            }
+            data.push_back((uint8_t)((level << 7) | (1 + rng() % 127)));
+        }
+        std::vector<uint32_t> edges = edgesOf(data, start);
+        std::vector<uint32_t> entry_starts;
+        uint32_t end = start;
+        for (uint8_t value : data) {
+            entry_starts.push_back(end);
+            end += value & 0x7F;
+        }
+
+        for (uint32_t capacity : capacities) {
+            std::vector<EdgeIndex::Checkpoint> storage(capacity + GUARD, {0xDEAD, 0xDEAD, 0xDEAD, 0xDE});
+            EdgeIndex index(storage.data(), capacity);
+            index.build(data.data(), length, start);
+            for (uint32_t k = capacity; k < capacity + GUARD; k++) {
+                overruns += (storage[k].time != 0xDEAD || storage[k].offset != 0xDEAD) ? 1 : 0;
+            }
+
+            wrong += (index.edgeCount() != edges.size()) ? 1 : 0;
+            wrong += (index.startTime() != start || index.endTime() != end) ? 1 : 0;
+            for (uint32_t i = 0; i < edges.size(); i++) {
+                wrong += (index.edgeTime(i) != edges[i]) ? 1 : 0;
+            }
+            for (uint32_t t : entry_starts) {
+                for (uint32_t q = (t > 0) ? t - 1 : 0; q <= t + 1; q++) {
+                    wrong += wrongAt(index, edges, q);
+                    queries++;
+                }
+            }
+            for (uint32_t k = 0; k < 50; k++) {
+                wrong += wrongAt(index, edges, start + rng() % (end - start + 300));
+                queries++;
+            }
+            wrong += wrongAt(index, edges, 0);
+            wrong += wrongAt(index, edges, end);
+            wrong += wrongAt(index, edges, UINT32_MAX - 1);
+
+            // Counts over random windows
+            for (uint32_t k = 0; k < 20; k++) {
+                uint32_t from = start + rng() % (end - start + 1);
+                uint32_t to = start + rng() % (end - start + 1);
+                uint32_t count = 0;
+                for (uint32_t e : edges) {
+                    count += (e >= from && e < to) ? 1 : 0;
+                }
+                wrong += (index.countEdges(from, to) != count) ? 1 : 0;
+            }
+        }
+    }
+    CHECK_EQ(wrong, 0);
+    CHECK_EQ(overruns, 0);
+    CHECK(queries > 100000);
+}
+
+void testEmpty() {
+    EdgeIndex::Checkpoint storage[1];
+    EdgeIndex index(storage, 1);
+    uint32_t edge = 0;
+    index.build(nullptr, 10, 500);
+    CHECK_EQ(index.edgeCount(), 0);
+    CHECK_EQ(index.endTime(), 500);
+    CHECK_EQ(index.edgesBefore(1000), 0);
+    CHECK(!index.nextEdge(0, edge));
+    CHECK(!index.prevEdge(1000, edge));
+    CHECK(!index.nearestEdge(500, edge));
+
+    // A single level: entries but no edges
+    const uint8_t idle[3] = {0x80 | 127, 0x80 | 127, 0x80 | 6};
+    index.build(idle, 3);
+    CHECK_EQ(index.edgeCount(), 0);
+    CHECK_EQ(index.endTime(), 260);
+    CHECK(!index.nearestEdge(100, edge));
+}
+
+} // namespace
+
+int main() {
+    testRandom();
+    testEmpty();
+    return check::result("edge_index_test");
+}
@@ -0,0 +1,192 @@
+/**
+  ******************************************************************************
+  * @file           : event_store_test.cpp
+  * @brief          : Event store search and the decoder set that fills it
+  ******************************************************************************
+  * Events of several channels often share a timestamp. Stepping from a
+  * match by position must visit each of them once in both directions,
+  * where a search by time would skip the rest of a tie. The decoder set
+  * runs the chosen decoder of each channel over display-format transition
+  * lists and leaves the other channels silent.
+  ******************************************************************************
+  */
+
+#include "DecoderSet.hpp"
+#include "EventStore.hpp"
+#include "check.hpp"
+
+#include <vector>
+
+using decode::Event;
+using decode::EventStore;
+using decode::EventType;
+
+namespace {
+
+Event event(uint32_t timestamp, EventType type, uint8_t channel, uint32_t value = 0) {
+    Event e = {};
+    e.timestamp = timestamp;
+    e.type = type;
+    e.channel = channel;
+    e.value = value;
+    return e;
+}
+
+// Display format: bit 7 = level, bits 6-0 = ticks, long runs split at 127
+void addRun(std::vector<uint8_t>& data, uint8_t level, uint32_t ticks) {
+    while (ticks > 0) {
+        uint8_t run = (ticks > 127) ? 127 : (uint8_t)ticks;
+        data.push_back((uint8_t)((level << 7) | run));
+        ticks -= run;
+    }
+}
+
+void testTies() {
+    Event storage[16];
+    EventStore store(storage, 16);
+    // Added per channel, as the decoders run, so the store has to sort
+    store.onEvent(event(100, EventType::OneWireByte, 1, 0xCC));
+    store.onEvent(event(200, EventType::TimingError, 1));
+    store.onEvent(event(100, EventType::OneWireReset, 0, 1));
+    store.onEvent(event(200, EventType::OneWireByte, 0, 0x44));
+    store.onEvent(event(100, EventType::CanId, 2, 0x123));
+    store.onEvent(event(50, EventType::CanId, 3, 0x7FF));
+    store.onEvent(event(200, EventType::CanCrcError, 2));
+    store.sort();
+    CHECK_EQ(store.size(), 7);
+
+    // Ties keep channel order
+    CHECK_EQ(store[1].timestamp, 100);
+    CHECK_EQ(store[1].channel, 0);
+    CHECK_EQ(store[3].channel, 2);
+
+    // Every event once, forwards and backwards
+    EventStore::Query all;
+    std::vector<int32_t> forward;
+    for (int32_t i = store.findNext(all, 0); i != EventStore::NOT_FOUND; i = store.nextMatch(all, (uint32_t)i)) {
+        forward.push_back(i);
+    }
+    CHECK_EQ(forward.size(), 7);
+    for (size_t k = 0; k < forward.size(); k++) {
+        CHECK_EQ(forward[k], (int32_t)k);
+    }
+    std::vector<int32_t> backward;
+    for (int32_t i = store.findPrev(all, 0xFFFFFFFF); i != EventStore::NOT_FOUND;
+         i = store.prevMatch(all, (uint32_t)i)) {
+        backward.push_back(i);
+    }
+    CHECK_EQ(backward.size(), 7);
+    CHECK_EQ(backward.front(), 6);
+    CHECK_EQ(backward.back(), 0);
+
+    // By time, the rest of a tie is out of reach
+    CHECK_EQ(store.findNext(all, 100), 4);
+    CHECK_EQ(store.nextMatch(all, 1), 2);
+
+    // Errors only: the two at t=200 in turn
+    EventStore::Query errors = EventStore::Query::errors();
+    CHECK_EQ(store.count(errors), 2);
+    int32_t first = store.findNext(errors, 150);
+    CHECK_EQ(first, 5);
+    CHECK_EQ(store.nextMatch(errors, (uint32_t)first), 6);
+    CHECK_EQ(store.nextMatch(errors, 6), EventStore::NOT_FOUND);
+    CHECK_EQ(store.prevMatch(errors, 6), 5);
+    CHECK_EQ(store.prevMatch(errors, 5), EventStore::NOT_FOUND);
+    CHECK_EQ(store.rank(errors, 6), 1);
+
+    // Channel and value masks
+    EventStore::Query can;
+    can.type_mask = decode::eventTypeBit(EventType::CanId);
+    can.value = 0x123;
+    can.value_mask = 0x7FF;
+    CHECK_EQ(store.count(can), 1);
+    can.value_mask = 0;
+    can.channel_mask = 1u << 3;
+    CHECK_EQ(store.findNext(can, 0), 0);
+}
+
+void testStableTies() {
+    // Each channel reports in time order, several events per tick; the
+    // channels are appended one after another, so the store must sort
+    const uint32_t PER_CHANNEL = 300;
+    Event storage[4 * PER_CHANNEL];
+    EventStore store(storage, 4 * PER_CHANNEL);
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        for (uint32_t k = 0; k < PER_CHANNEL; k++) {
+            store.onEvent(event(k / 3 * 10 + ch % 2, EventType::BitData, ch, k));
+        }
+    }
+    store.sort();
+    uint32_t out_of_order = 0;
+    for (uint32_t i = 1; i < store.size(); i++) {
+        const Event& a = store[i - 1];
+        const Event& b = store[i];
+        bool ordered = a.timestamp < b.timestamp ||
+                       (a.timestamp == b.timestamp &&
+                        (a.channel < b.channel || (a.channel == b.channel && a.value < b.value)));
+        out_of_order += ordered ? 0 : 1;
+    }
+    CHECK_EQ(out_of_order, 0);
+}
+
+void testFull() {
+    Event storage[2];
+    EventStore store(storage, 2);
+    for (uint32_t t = 0; t < 5; t++) {
+        store.onEvent(event(t, EventType::BitData, 0));
+    }
+    CHECK_EQ(store.size(), 2);
+    CHECK_EQ(store.dropped(), 3);
+    store.clear();
+    CHECK_EQ(store.size(), 0);
+    CHECK_EQ(store.nextMatch(EventStore::Query(), 0), EventStore::NOT_FOUND);
+    CHECK_EQ(store.prevMatch(EventStore::Query(), 0), EventStore::NOT_FOUND);
+}
+
+void testDecoderSet() {
+    // 1-Wire reset with presence on CH2 at 1 MHz; the same line on CH0
+    // has no decoder
+    std::vector<uint8_t> line;
+    addRun(line, 1, 100);
+    addRun(line, 0, 500);
+    addRun(line, 1, 30);
+    addRun(line, 0, 120);
+    addRun(line, 1, 300);
+    const uint8_t* data[4] = {line.data(), nullptr, line.data(), nullptr};
+    uint16_t lengths[4] = {(uint16_t)line.size(), 0, (uint16_t)line.size(), 0};
+
+    decode::DecoderSet set;
+    CHECK(!set.any());
+    set.set(2, decode::Protocol::OneWire);
+    set.set(1, decode::Protocol::Can, 250000);
+    set.set(7, decode::Protocol::Nec);
+    CHECK(set.any());
+    CHECK(set.channel(1).bitrate == 250000);
+    CHECK(set.channel(0).protocol == decode::Protocol::None);
+
+    Event storage[16];
+    EventStore store(storage, 16);
+    set.run(store, data, lengths, 4, 1000000);
+    store.sort();
+    CHECK_EQ(store.size(), 1);
+    if (store.size() == 1) {
+        CHECK(store[0].type == EventType::OneWireReset);
+        CHECK_EQ(store[0].channel, 2);
+        CHECK_EQ(store[0].value, 1);
+        CHECK_EQ(store[0].timestamp, 100);
+    }
+
+    for (uint8_t p = 0; p < (uint8_t)decode::Protocol::COUNT; p++) {
+        CHECK(decode::protocolName((decode::Protocol)p)[0] != '?');
+    }
+}
+
+} // namespace
+
+int main() {
+    testTies();
+    testStableTies();
+    testFull();
+    testDecoderSet();
+    return check::result("event_store_test");
+}
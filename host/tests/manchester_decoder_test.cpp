@@ -0,0 +1,197 @@
+/**
+  ******************************************************************************
+  * @file           : manchester_decoder_test.cpp
+  * @brief          : ManchesterDecoder clock recovery on synthetic streams
+  ******************************************************************************
+  * Streams are built half bit by half bit, with the bit period drifting
+  * over the stream and every edge moved by up to 10% of a half bit. The
+  * decoder may lose the first bits while it locks; everything after the
+  * lock has to come out exactly.
+  ******************************************************************************
+  */
+
+#include "ManchesterDecoder.hpp"
+#include "check.hpp"
+#include "test_signal.hpp"
+
+#include <vector>
+
+using decode::Event;
+using decode::EventType;
+using decode::ManchesterDecoder;
+
+namespace {
+
+constexpr uint32_t SAMPLE_RATE = 10000000;
+constexpr uint32_t BITRATE = 100000;
+constexpr double HALF_BIT = SAMPLE_RATE / BITRATE / 2.0;
+
+std::vector<uint8_t> toBits(const std::vector<uint8_t>& bytes) {
+    std::vector<uint8_t> bits;
+    for (uint8_t byte : bytes) {
+        for (int i = 7; i >= 0; i--) {
+            bits.push_back((byte >> i) & 1);
+        }
+    }
+    return bits;
+}
+
+// Line level of every half bit
+std::vector<uint8_t> toHalves(const std::vector<uint8_t>& bits, ManchesterDecoder::Coding coding,
+                              bool rising_is_one) {
+    std::vector<uint8_t> halves;
+    uint8_t level = 1;
+    for (uint8_t bit : bits) {
+        if (coding == ManchesterDecoder::Coding::Manchester) {
+            uint8_t second = rising_is_one ? bit : (uint8_t)(bit ^ 1);
+            halves.push_back(second ^ 1);
+            halves.push_back(second);
+        } else {
+            level ^= 1;
+            halves.push_back(level);
+            level ^= bit;
+            halves.push_back(level);
+        }
+    }
+    if (coding == ManchesterDecoder::Coding::BiphaseMark) {
+        // The last bit ends with the transition that would start the next
+        halves.push_back(level ^ 1);
+    }
+    return halves;
+}
+
+// Half bits whose length goes from HALF_BIT to HALF_BIT * (1 + drift)
+void addHalves(test::Signal& signal, const std::vector<uint8_t>& halves, double drift) {
+    for (size_t i = 0; i < halves.size(); i++) {
+        signal.add(halves[i], HALF_BIT * (1.0 + drift * i / halves.size()));
+    }
+}
+
+ManchesterDecoder::Config config(ManchesterDecoder::Coding coding, bool rising_is_one = true) {
+    ManchesterDecoder::Config c;
+    c.sample_rate_hz = SAMPLE_RATE;
+    c.bitrate = BITRATE;
+    c.coding = coding;
+    c.rising_is_one = rising_is_one;
+    c.channel = 1;
+    return c;
+}
+
+// Bits reported by BitData events, in order
+std::vector<uint8_t> decodedBits(const test::EventLog& log) {
+    std::vector<uint8_t> bits;
+    for (const Event& event : log.of(EventType::BitData)) {
+        for (int i = event.length - 1; i >= 0; i--) {
+            bits.push_back((event.value >> i) & 1);
+        }
+    }
+    return bits;
+}
+
+// decoded must be sent minus at most `lost` leading bits
+void checkTail(const std::vector<uint8_t>& decoded, const std::vector<uint8_t>& sent, size_t lost) {
+    CHECK(decoded.size() <= sent.size());
+    CHECK(decoded.size() + lost >= sent.size());
+    if (decoded.size() > sent.size()) {
+        return;
+    }
+    size_t offset = sent.size() - decoded.size();
+    size_t mismatches = 0;
+    for (size_t i = 0; i < decoded.size(); i++) {
+        mismatches += (decoded[i] != sent[offset + i]) ? 1 : 0;
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+void testStream(ManchesterDecoder::Coding coding, bool rising_is_one, double drift, uint32_t seed) {
+    std::vector<uint8_t> bytes = {0x55, 0x55, 0xA5, 0x12, 0x34, 0xFF, 0x00, 0x80, 0x7E, 0xC3};
+    for (uint32_t i = 0; i < 64; i++) {
+        bytes.push_back((uint8_t)(i * 37 + 11));
+    }
+    std::vector<uint8_t> sent = toBits(bytes);
+
+    test::Signal signal(seed);
+    std::vector<uint8_t> halves = toHalves(sent, coding, rising_is_one);
+    signal.add(1, 20 * HALF_BIT);
+    addHalves(signal, halves, drift);
+    signal.add(halves.back(), 20 * HALF_BIT);
+
+    test::EventLog log;
+    ManchesterDecoder decoder(log, config(coding, rising_is_one));
+    signal.play(decoder, HALF_BIT * 0.1);
+
+    // Locks once inside the 0x55 preamble and stays locked to the end
+    std::vector<Event> locks = log.of(EventType::ClockLock);
+    CHECK_EQ(locks.size(), 1);
+    if (!locks.empty()) {
+        CHECK_EQ(locks[0].value, SAMPLE_RATE / BITRATE);
+        CHECK_EQ(locks[0].channel, 1);
+    }
+    CHECK(log.count(EventType::ClockUnlock) <= 1);  // The idle tail may end it
+    checkTail(decodedBits(log), sent, 8);
+
+    // The loop followed the drift to the final period (within 3%)
+    double final_q8 = 256.0 * 2 * HALF_BIT * (1.0 + drift);
+    CHECK(decoder.periodQ8() > final_q8 * 0.97 && decoder.periodQ8() < final_q8 * 1.03);
+}
+
+void testRelock(ManchesterDecoder::Coding coding) {
+    // Two bursts with an idle gap of three bits: unlock, lock again
+    std::vector<uint8_t> first = toBits({0x55, 0x55, 0x3C, 0x5A});
+    std::vector<uint8_t> second = toBits({0x55, 0x55, 0xE7, 0x18});
+
+    test::Signal signal(21);
+    std::vector<uint8_t> halves = toHalves(first, coding, true);
+    signal.add(1, 20 * HALF_BIT);
+    addHalves(signal, halves, 0.0);
+    signal.add(halves.back(), 6 * HALF_BIT);
+    halves = toHalves(second, coding, true);
+    addHalves(signal, halves, 0.0);
+    signal.add(halves.back(), 20 * HALF_BIT);
+
+    test::EventLog log;
+    ManchesterDecoder decoder(log, config(coding));
+    signal.play(decoder, HALF_BIT * 0.1);
+
+    CHECK_EQ(log.count(EventType::ClockLock), 2);
+    CHECK_EQ(log.count(EventType::ClockUnlock), 1);
+
+    // Each burst comes out whole apart from the bits spent locking
+    test::EventLog before;
+    test::EventLog after;
+    bool unlocked = false;
+    for (const Event& event : log.events) {
+        unlocked = unlocked || (event.type == EventType::ClockUnlock);
+        (unlocked ? after : before).events.push_back(event);
+    }
+    checkTail(decodedBits(before), first, 8);
+    checkTail(decodedBits(after), second, 8);
+}
+
+void testOutOfRange() {
+    // Twice the bit rate is outside the tracking range: never locks
+    std::vector<uint8_t> bits = toBits({0x55, 0x55, 0x55, 0x55});
+    test::Signal signal(1);
+    for (uint8_t half : toHalves(bits, ManchesterDecoder::Coding::Manchester, true)) {
+        signal.add(half, HALF_BIT * 0.3);
+    }
+    test::EventLog log;
+    ManchesterDecoder decoder(log, config(ManchesterDecoder::Coding::Manchester));
+    signal.play(decoder);
+    CHECK_EQ(log.count(EventType::BitData), 0);
+    CHECK(!decoder.isLocked());
+}
+
+} // namespace
+
+int main() {
+    for (double drift : {0.0, 0.08, -0.08}) {
+        testStream(ManchesterDecoder::Coding::Manchester, true, drift, 3);
+        testStream(ManchesterDecoder::Coding::Manchester, false, drift, 4);
+        testStream(ManchesterDecoder::Coding::BiphaseMark, true, drift, 5);
+    }
+    testRelock(ManchesterDecoder::Coding::Manchester);
+    testRelock(ManchesterDecoder::Coding::BiphaseMark);
+    testOutOfRange();
+    return check::result("manchester_decoder_test");
+}
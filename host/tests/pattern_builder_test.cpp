@@ -0,0 +1,214 @@
+/**
+  ******************************************************************************
+  * @file           : pattern_builder_test.cpp
+  * @brief          : PatternBuilder patterns, BSRR words and loopback check
+  ******************************************************************************
+  * Patterns are checked against their definitions (binary count, PRBS-15
+  * recurrence, 8N1 frames), BSRR tables by applying them to a simulated
+  * output register, and verify() with captures that start anywhere in
+  * the period, carry noise on the unused port bits, lose a sample, or are
+  * not the pattern at all.
+  ******************************************************************************
+  */
+
+#include "PatternBuilder.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+using capture::PatternBuilder;
+using Pattern = capture::PatternBuilder::Pattern;
+
+namespace {
+
+const uint8_t OUT_PINS[4] = {0, 1, 8, 9};
+const uint8_t IN_PINS[4] = {8, 15, 6, 2};
+const uint16_t IN_MASK = (1u << 8) | (1u << 15) | (1u << 6) | (1u << 2);
+const uint32_t PERIOD = 512;
+
+std::vector<uint8_t> levels(Pattern pattern, uint8_t channels = 4, uint32_t count = PERIOD) {
+    std::vector<uint8_t> out(count);
+    PatternBuilder::buildLevels(pattern, out.data(), count, channels);
+    return out;
+}
+
+std::vector<uint16_t> portWords(const std::vector<uint8_t>& lv) {
+    std::vector<uint16_t> words(lv.size());
+    PatternBuilder::buildPortWords(lv.data(), (uint32_t)lv.size(), IN_PINS, 4, words.data());
+    return words;
+}
+
+void testCounter() {
+    std::vector<uint8_t> lv = levels(Pattern::Counter);
+    uint32_t bad = 0;
+    for (uint32_t i = 0; i < PERIOD; i++) {
+        bad += (lv[i] != (i & 0x0F)) ? 1 : 0;
+    }
+    CHECK_EQ(bad, 0);
+
+    // All eight channels: the full byte
+    std::vector<uint8_t> wide = levels(Pattern::Counter, 8, 300);
+    CHECK_EQ(wide[255], 255);
+    CHECK_EQ(wide[256], 0);
+}
+
+void testPrbs() {
+    // Each channel follows x^15 + x^14 + 1: b[n] = b[n-14] ^ b[n-15]
+    const uint32_t count = 40000;
+    std::vector<uint8_t> lv = levels(Pattern::Prbs, 8, count);
+    uint32_t bad = 0;
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        uint32_t ones = 0;
+        for (uint32_t n = 0; n < count; n++) {
+            uint8_t b = (lv[n] >> ch) & 1;
+            ones += b;
+            if (n >= 15) {
+                bad += (b != (((lv[n - 14] ^ lv[n - 15]) >> ch) & 1)) ? 1 : 0;
+            }
+        }
+        // Maximal length: 32767 period, 16384 ones per period
+        bad += (((lv[32767] ^ lv[0]) >> ch) & 1);
+        CHECK(ones > count / 2 - 600 && ones < count / 2 + 600);
+    }
+    CHECK_EQ(bad, 0);
+
+    // Channels run at different phases
+    uint32_t same = 0;
+    for (uint32_t n = 0; n < PERIOD; n++) {
+        same += (((lv[n] >> 0) ^ (lv[n] >> 1)) & 1) ? 0 : 1;
+    }
+    CHECK(same < PERIOD * 3 / 4);
+}
+
+void testUart() {
+    // Decode each channel as 8N1 at UART_BIT_SAMPLES per bit
+    const uint32_t count = PatternBuilder::UART_BIT_SAMPLES * 12 * 20;
+    std::vector<uint8_t> lv = levels(Pattern::Uart, 4, count);
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        uint32_t frames = 0;
+        uint32_t bad = 0;
+        uint32_t i = 0;
+        while (i + 10 * PatternBuilder::UART_BIT_SAMPLES <= count) {
+            if ((lv[i] >> ch) & 1) {
+                i++;
+                continue;
+            }
+            // Middle of each bit after the start bit
+            uint32_t centre = i + PatternBuilder::UART_BIT_SAMPLES / 2;
+            uint8_t byte = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                byte |= (uint8_t)(((lv[centre + (bit + 1) * PatternBuilder::UART_BIT_SAMPLES] >> ch) & 1) << bit);
+            }
+            uint8_t stop = (lv[centre + 9 * PatternBuilder::UART_BIT_SAMPLES] >> ch) & 1;
+            bad += (byte != (uint8_t)(ch * 0x40 + frames) || stop != 1) ? 1 : 0;
+            frames++;
+            i += 10 * PatternBuilder::UART_BIT_SAMPLES;
+        }
+        CHECK_EQ(frames, 20);
+        CHECK_EQ(bad, 0);
+    }
+}
+
+void testBsrr() {
+    for (uint8_t p = 0; p < (uint8_t)Pattern::COUNT; p++) {
+        std::vector<uint8_t> lv = levels((Pattern)p);
+        std::vector<uint32_t> bsrr(PERIOD);
+        PatternBuilder::buildBsrr(lv.data(), PERIOD, OUT_PINS, 4, bsrr.data());
+
+        // Set and reset halves never touch the same pin, and every word
+        // defines all four outputs regardless of the previous state
+        uint16_t odr = 0xA5A5;
+        uint32_t bad = 0;
+        for (uint32_t i = 0; i < PERIOD; i++) {
+            uint16_t set = (uint16_t)bsrr[i];
+            uint16_t reset = (uint16_t)(bsrr[i] >> 16);
+            bad += ((set & reset) != 0) ? 1 : 0;
+            odr = (uint16_t)((odr & ~reset) | set);
+            for (uint8_t ch = 0; ch < 4; ch++) {
+                bad += (((odr >> OUT_PINS[ch]) & 1) != ((lv[i] >> ch) & 1)) ? 1 : 0;
+            }
+            bad += ((set | reset) != ((1u << 0) | (1u << 1) | (1u << 8) | (1u << 9))) ? 1 : 0;
+        }
+        CHECK_EQ(bad, 0);
+        // Untouched pins keep their level
+        CHECK_EQ(odr & 0x00FC, 0xA5A5 & 0x00FC);
+    }
+}
+
+void testVerify() {
+    std::mt19937 rng(2);
+    for (uint8_t p = 0; p < (uint8_t)Pattern::COUNT; p++) {
+        Pattern pattern = (Pattern)p;
+        std::vector<uint16_t> expected = portWords(levels(pattern));
+
+        for (int iteration = 0; iteration < 50; iteration++) {
+            uint32_t offset = rng() % PERIOD;
+            uint32_t count = 2048;
+            std::vector<uint16_t> samples(count);
+            for (uint32_t i = 0; i < count; i++) {
+                samples[i] = (uint16_t)(expected[(offset + i) % PERIOD] | (rng() & ~IN_MASK));
+            }
+
+            // A clean capture locks with no errors; PRBS has a unique offset
+            PatternBuilder::Verification v = PatternBuilder::verify(expected.data(), PERIOD, samples.data(), count,
+                                                                    IN_MASK);
+            CHECK(v.locked);
+            CHECK_EQ(v.errors, 0);
+            if (pattern == Pattern::Prbs) {
+                CHECK_EQ(v.offset, offset);
+            }
+
+            // A dropped sample after the alignment window shows up right
+            // there (counter and PRBS have no run of equal samples that
+            // would hide it; PRBS words match by chance 1 time in 16)
+            if (pattern != Pattern::Uart) {
+                uint32_t k = PERIOD + 100 + rng() % 1000;
+                samples.erase(samples.begin() + k);
+                samples.push_back(0);
+                v = PatternBuilder::verify(expected.data(), PERIOD, samples.data(), count, IN_MASK);
+                CHECK(v.locked);
+                CHECK(v.errors > 0);
+                CHECK(v.first_error >= k && v.first_error < k + 16);
+            }
+        }
+    }
+
+    // Noise does not lock
+    std::vector<uint16_t> expected = portWords(levels(Pattern::Prbs));
+    std::vector<uint16_t> junk(2048);
+    for (uint16_t& word : junk) {
+        word = (uint16_t)rng();
+    }
+    PatternBuilder::Verification v = PatternBuilder::verify(expected.data(), PERIOD, junk.data(), 2048, IN_MASK);
+    CHECK(!v.locked);
+
+    // Neither does a stuck input
+    std::vector<uint16_t> stuck(2048, IN_MASK);
+    v = PatternBuilder::verify(expected.data(), PERIOD, stuck.data(), 2048, IN_MASK);
+    CHECK(!v.locked);
+    CHECK(v.errors > 0);
+
+    // Degenerate sizes
+    v = PatternBuilder::verify(expected.data(), 0, junk.data(), 2048, IN_MASK);
+    CHECK(!v.locked);
+    v = PatternBuilder::verify(expected.data(), PERIOD, junk.data(), 0, IN_MASK);
+    CHECK(!v.locked);
+
+    // A capture shorter than the period still locks
+    v = PatternBuilder::verify(expected.data(), PERIOD, expected.data() + 100, 300, IN_MASK);
+    CHECK(v.locked);
+    CHECK_EQ(v.offset, 100);
+    CHECK_EQ(v.errors, 0);
+}
+
+} // namespace
+
+int main() {
+    testCounter();
+    testPrbs();
+    testUart();
+    testBsrr();
+    testVerify();
+    return check::result("pattern_builder_test");
+}
@@ -0,0 +1,303 @@
+/**
+  ******************************************************************************
+  * @file           : pulse_decoders_test.cpp
+  * @brief          : 1-Wire, WS2812 and NEC decoders against synthetic trains
+  ******************************************************************************
+  * Each train is written down in nanoseconds from the protocol timing,
+  * converted to capture ticks and played with edge jitter, then checked
+  * for the bytes, LEDs and commands it carries and for flagged timing.
+  ******************************************************************************
+  */
+
+#include "PulseDecoders.hpp"
+#include "check.hpp"
+#include "test_signal.hpp"
+
+#include <vector>
+
+using decode::Event;
+using decode::EventType;
+using decode::PulseDecoder;
+
+namespace {
+
+// Builds a signal from durations in nanoseconds at a given tick rate
+class Train {
+public:
+    Train(uint32_t rate_hz, uint32_t seed) : signal(seed), rate_hz_(rate_hz) {}
+
+    void add(uint8_t level, double ns) { signal.add(level, ns * rate_hz_ / 1e9); }
+
+    test::Signal signal;
+
+private:
+    uint32_t rate_hz_;
+};
+
+PulseDecoder::Config config(uint32_t rate_hz, uint8_t tolerance_pct, uint8_t channel) {
+    PulseDecoder::Config c;
+    c.sample_rate_hz = rate_hz;
+    c.tolerance_pct = tolerance_pct;
+    c.channel = channel;
+    return c;
+}
+
+/* ---------------- 1-Wire ---------------- */
+
+void oneWireByte(Train& train, uint8_t byte) {
+    for (int i = 0; i < 8; i++) {
+        if ((byte >> i) & 1) {
+            train.add(0, 6000);
+            train.add(1, 64000);
+        } else {
+            train.add(0, 60000);
+            train.add(1, 10000);
+        }
+    }
+}
+
+void testOneWire() {
+    // 1 MHz capture, +-2 us on every edge
+    Train train(1000000, 5);
+    train.add(1, 100000);
+    // Reset with presence, Skip ROM, Convert T
+    train.add(0, 500000);
+    train.add(1, 30000);
+    train.add(0, 120000);
+    train.add(1, 300000);
+    oneWireByte(train, 0xCC);
+    oneWireByte(train, 0x44);
+    // A low pulse longer than a 0 slot and shorter than a reset is flagged
+    oneWireByte(train, 0x0F);
+    train.add(0, 250000);
+    train.add(1, 50000);
+    oneWireByte(train, 0xBE);
+    // Reset nobody answers, still pending when the capture ends
+    train.add(0, 600000);
+    train.add(1, 400000);
+    train.add(0, 500000);
+    train.add(1, 100000);
+
+    test::EventLog log;
+    decode::OneWireDecoder decoder(log, config(1000000, 20, 1));
+    train.signal.play(decoder, 2.0);
+
+    std::vector<Event> resets = log.of(EventType::OneWireReset);
+    CHECK_EQ(resets.size(), 3);
+    if (resets.size() == 3) {
+        CHECK_EQ(resets[0].value, 1);
+        CHECK_EQ(resets[0].channel, 1);
+        CHECK_EQ(resets[1].value, 0);
+        CHECK_EQ(resets[2].value, 0);  // Flushed by end()
+    }
+
+    std::vector<Event> bytes = log.of(EventType::OneWireByte);
+    CHECK_EQ(bytes.size(), 4);
+    if (bytes.size() == 4) {
+        CHECK_EQ(bytes[0].value, 0xCC);
+        CHECK_EQ(bytes[1].value, 0x44);
+        CHECK_EQ(bytes[2].value, 0x0F);
+        CHECK_EQ(bytes[3].value, 0xBE);
+        CHECK(bytes[0].timestamp < bytes[1].timestamp);
+    }
+
+    std::vector<Event> errors = log.of(EventType::TimingError);
+    CHECK_EQ(errors.size(), 1);
+    if (!errors.empty()) {
+        CHECK(errors[0].value >= 246 && errors[0].value <= 254);
+        CHECK_EQ(errors[0].flags, 0);
+    }
+    CHECK_EQ(decoder.timingErrors(), 1);
+}
+
+void testOneWirePartialByte() {
+    // Four bits, then a bad pulse: the next byte starts from bit 0
+    Train train(1000000, 9);
+    train.add(1, 100000);
+    for (int i = 0; i < 4; i++) {
+        train.add(0, 6000);
+        train.add(1, 64000);
+    }
+    train.add(0, 300000);
+    train.add(1, 50000);
+    oneWireByte(train, 0x81);
+    train.add(1, 100000);
+
+    test::EventLog log;
+    decode::OneWireDecoder decoder(log, config(1000000, 20, 0));
+    train.signal.play(decoder, 1.0);
+
+    std::vector<Event> bytes = log.of(EventType::OneWireByte);
+    CHECK_EQ(bytes.size(), 1);
+    if (!bytes.empty()) {
+        CHECK_EQ(bytes[0].value, 0x81);
+    }
+    CHECK_EQ(log.count(EventType::TimingError), 1);
+}
+
+/* ---------------- WS2812 ---------------- */
+
+void ws2812Led(Train& train, uint32_t grb) {
+    for (int i = 23; i >= 0; i--) {
+        if ((grb >> i) & 1) {
+            train.add(1, 800);
+            train.add(0, 450);
+        } else {
+            train.add(1, 400);
+            train.add(0, 850);
+        }
+    }
+}
+
+void testWs2812() {
+    // 24 MHz capture, +-1 tick (42 ns) on every edge
+    Train train(24000000, 3);
+    train.add(0, 100000);
+    ws2812Led(train, 0xFF0000);  // Green
+    ws2812Led(train, 0x00FF00);  // Red
+    ws2812Led(train, 0x123456);
+    train.add(0, 80000);
+    ws2812Led(train, 0x010203);
+    // A high phase of 1.2 us is neither bit
+    train.add(1, 1200);
+    train.add(0, 850);
+    ws2812Led(train, 0xABCDEF);
+    train.add(0, 60000);  // Latched by end()
+
+    test::EventLog log;
+    decode::Ws2812Decoder decoder(log, config(24000000, 20, 2));
+    train.signal.play(decoder, 1.0);
+
+    std::vector<Event> leds = log.of(EventType::Ws2812Rgb);
+    CHECK_EQ(leds.size(), 5);
+    if (leds.size() == 5) {
+        CHECK_EQ(leds[0].value, 0x00FF00);
+        CHECK_EQ(leds[1].value, 0xFF0000);
+        CHECK_EQ(leds[2].value, 0x341256);
+        CHECK_EQ(leds[2].length, 2);
+        CHECK_EQ(leds[3].value, 0x020103);
+        CHECK_EQ(leds[3].length, 0);
+        CHECK_EQ(leds[4].value, 0xCDABEF);
+        CHECK_EQ(leds[4].length, 1);
+        CHECK_EQ(leds[4].channel, 2);
+    }
+
+    std::vector<Event> latches = log.of(EventType::Ws2812Latch);
+    CHECK_EQ(latches.size(), 2);
+    if (latches.size() == 2) {
+        CHECK_EQ(latches[0].value, 3);
+        CHECK_EQ(latches[1].value, 2);
+    }
+
+    std::vector<Event> errors = log.of(EventType::TimingError);
+    CHECK_EQ(errors.size(), 1);
+    if (!errors.empty()) {
+        CHECK_EQ(errors[0].flags, decode::EVENT_FLAG_HIGH);
+    }
+}
+
+/* ---------------- NEC ---------------- */
+
+void necFrame(Train& train, uint32_t data) {
+    train.add(0, 9000000);
+    train.add(1, 4500000);
+    for (int i = 0; i < 32; i++) {
+        train.add(0, 562500);
+        train.add(1, ((data >> i) & 1) ? 1687500 : 562500);
+    }
+    train.add(0, 562500);
+    train.add(1, 40000000);
+}
+
+void necRepeat(Train& train) {
+    train.add(0, 9000000);
+    train.add(1, 2250000);
+    train.add(0, 562500);
+    train.add(1, 96000000);
+}
+
+uint32_t necData(uint8_t address, uint8_t address2, uint8_t command, uint8_t command_inv) {
+    return address | ((uint32_t)address2 << 8) | ((uint32_t)command << 16) | ((uint32_t)command_inv << 24);
+}
+
+void testNec() {
+    // 1 MHz capture, receiver output active low, +-60 us on every edge
+    Train train(1000000, 11);
+    train.add(1, 20000000);
+    necFrame(train, necData(0x00, 0xFF, 0x45, 0xBA));
+    necRepeat(train);
+    necRepeat(train);
+    necFrame(train, necData(0x34, 0x12, 0x45, 0xBA));  // Extended address 0x1234
+    necFrame(train, necData(0x34, 0x12, 0x45, 0xBB));  // Command check fails
+    // A frame cut short by a 3 ms space
+    train.add(0, 9000000);
+    train.add(1, 4500000);
+    train.add(0, 562500);
+    train.add(1, 3000000);
+    necFrame(train, necData(0x07, 0xF8, 0x16, 0xE9));
+
+    test::EventLog log;
+    decode::NecDecoder decoder(log, config(1000000, 25, 3));
+    train.signal.play(decoder, 60.0);
+
+    std::vector<Event> commands = log.of(EventType::IrNecCommand);
+    CHECK_EQ(commands.size(), 3);
+    if (commands.size() == 3) {
+        CHECK_EQ(commands[0].value, 0x0045);
+        CHECK_EQ(commands[0].flags, 0);
+        CHECK_EQ(commands[0].channel, 3);
+        CHECK_EQ(commands[1].value, (0x1234u << 8) | 0x45);
+        CHECK_EQ(commands[1].flags, decode::EVENT_FLAG_EXTENDED);
+        CHECK_EQ(commands[2].value, 0x0716);
+    }
+    CHECK_EQ(log.count(EventType::IrNecRepeat), 2);
+
+    std::vector<Event> checks = log.of(EventType::IrCheckError);
+    CHECK_EQ(checks.size(), 1);
+    if (!checks.empty()) {
+        CHECK_EQ(checks[0].value, necData(0x34, 0x12, 0x45, 0xBB));
+    }
+
+    std::vector<Event> errors = log.of(EventType::TimingError);
+    CHECK_EQ(errors.size(), 1);
+    if (!errors.empty()) {
+        CHECK_EQ(errors[0].flags, decode::EVENT_FLAG_HIGH);
+    }
+}
+
+void testNecActiveHigh() {
+    // Same frame with inverted polarity
+    Train train(1000000, 13);
+    train.add(0, 20000000);
+    train.add(1, 9000000);
+    train.add(0, 4500000);
+    uint32_t data = necData(0x10, 0xEF, 0x08, 0xF7);
+    for (int i = 0; i < 32; i++) {
+        train.add(1, 562500);
+        train.add(0, ((data >> i) & 1) ? 1687500 : 562500);
+    }
+    train.add(1, 562500);
+    train.add(0, 40000000);
+
+    test::EventLog log;
+    decode::NecDecoder decoder(log, config(1000000, 25, 0), false);
+    train.signal.play(decoder, 20.0);
+
+    std::vector<Event> commands = log.of(EventType::IrNecCommand);
+    CHECK_EQ(commands.size(), 1);
+    if (!commands.empty()) {
+        CHECK_EQ(commands[0].value, 0x1008);
+    }
+    CHECK_EQ(decoder.timingErrors(), 0);
+}
+
+} // namespace
+
+int main() {
+    testOneWire();
+    testOneWirePartialByte();
+    testWs2812();
+    testNec();
+    testNecActiveHigh();
+    return check::result("pulse_decoders_test");
+}
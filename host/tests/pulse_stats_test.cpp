@@ -0,0 +1,220 @@
+/**
+  ******************************************************************************
+  * @file           : pulse_stats_test.cpp
+  * @brief          : LogHistogram, Welford and PulseStats against references
+  ******************************************************************************
+  * Welford results are compared with a two-pass mean / variance over the
+  * same values (both sides of the integer fast path), histogram bins with
+  * their documented bounds, and PulseStats with pulse trains whose widths
+  * are known.
+  ******************************************************************************
+  */
+
+#include "PulseStats.hpp"
+#include "check.hpp"
+#include "test_signal.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using measure::LogHistogram;
+using measure::PulseStats;
+using measure::Welford;
+
+namespace {
+
+bool near(double actual, double expected, double relative) {
+    return std::fabs(actual - expected) <= relative * std::fabs(expected) + 1e-9;
+}
+
+void checkAgainstTwoPass(const std::vector<uint32_t>& values) {
+    Welford w;
+    double sum = 0;
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+    for (uint32_t v : values) {
+        w.add(v);
+        sum += v;
+        lo = (v < lo) ? v : lo;
+        hi = (v > hi) ? v : hi;
+    }
+    double mean = sum / values.size();
+    double m2 = 0;
+    for (uint32_t v : values) {
+        m2 += (v - mean) * (v - mean);
+    }
+    double variance = m2 / values.size();
+
+    CHECK_EQ(w.count(), values.size());
+    CHECK_EQ(w.min(), lo);
+    CHECK_EQ(w.max(), hi);
+    CHECK(near(w.mean(), mean, 1e-12));
+    CHECK(near(w.variance(), variance, 1e-9));
+    CHECK(near(w.stddev(), std::sqrt(variance), 1e-9));
+}
+
+void testWelford() {
+    // Empty and single value
+    Welford empty;
+    CHECK_EQ(empty.count(), 0);
+    CHECK(empty.variance() == 0.0);
+    CHECK_EQ(empty.max(), 0);
+
+    Welford one;
+    one.add(42);
+    CHECK_EQ(one.count(), 1);
+    CHECK(one.mean() == 42.0);
+    CHECK(one.variance() == 0.0);
+    CHECK_EQ(one.min(), 42);
+
+    std::mt19937 rng(1);
+
+    // Small jittery widths: all on the integer block path, many blocks
+    std::normal_distribution<double> narrow(1000.0, 7.0);
+    std::vector<uint32_t> values;
+    for (int i = 0; i < 100003; i++) {
+        values.push_back((uint32_t)std::lround(narrow(rng)));
+    }
+    checkAgainstTwoPass(values);
+
+    // Mixed with values above the fast-path limit (2^20)
+    for (size_t i = 0; i < values.size(); i += 1000) {
+        values[i] = 3000000 + (uint32_t)i;
+    }
+    checkAgainstTwoPass(values);
+
+    // Right below the limit, where block sums are largest
+    values.assign(5000, (1u << 20) - 1);
+    for (size_t i = 0; i < values.size(); i += 3) {
+        values[i] -= 17;
+    }
+    checkAgainstTwoPass(values);
+
+    // Full 32-bit range
+    std::uniform_int_distribution<uint32_t> any;
+    values.clear();
+    for (int i = 0; i < 10000; i++) {
+        values.push_back(any(rng));
+    }
+    checkAgainstTwoPass(values);
+
+    // clear() starts over
+    Welford w;
+    w.add(5);
+    w.add(7);
+    w.clear();
+    w.add(9);
+    CHECK_EQ(w.count(), 1);
+    CHECK(w.mean() == 9.0);
+    CHECK_EQ(w.min(), 9);
+}
+
+void testHistogramBins() {
+    // 0 and 1 share bin 0, powers of two open an octave
+    CHECK_EQ(LogHistogram::binOf(0), 0);
+    CHECK_EQ(LogHistogram::binOf(1), 0);
+    CHECK_EQ(LogHistogram::binOf(8), 3 << LogHistogram::SUB_BITS);
+    CHECK_EQ(LogHistogram::binOf(9), (3 << LogHistogram::SUB_BITS) | 1);
+    CHECK_EQ(LogHistogram::binOf(0xFFFFFFFFu), LogHistogram::BINS - 1);
+    CHECK_EQ(LogHistogram::binLower(LogHistogram::binOf(1024)), 1024);
+
+    // Every value lies in [binLower(bin), binLower(next distinct bin))
+    uint32_t bad = 0;
+    for (uint64_t x = 1; x < (1ull << 32); x = x + 1 + x / 97) {
+        uint16_t bin = LogHistogram::binOf((uint32_t)x);
+        bad += (x < LogHistogram::binLower(bin)) ? 1 : 0;
+        if (bin + 1 < LogHistogram::BINS && LogHistogram::binLower(bin + 1) > LogHistogram::binLower(bin)) {
+            bad += (x >= LogHistogram::binLower(bin + 1)) ? 1 : 0;
+        }
+    }
+    CHECK_EQ(bad, 0);
+
+    // Bins are monotonic in the value
+    uint16_t previous = 0;
+    for (uint32_t x = 0; x < 100000; x++) {
+        uint16_t bin = LogHistogram::binOf(x);
+        bad += (bin < previous) ? 1 : 0;
+        previous = bin;
+    }
+    CHECK_EQ(bad, 0);
+
+    LogHistogram h;
+    uint16_t first = 0;
+    uint16_t last = 0;
+    CHECK(!h.range(first, last));
+    h.add(100);
+    h.add(100);
+    h.add(5000);
+    CHECK(h.range(first, last));
+    CHECK_EQ(first, LogHistogram::binOf(100));
+    CHECK_EQ(last, LogHistogram::binOf(5000));
+    CHECK_EQ(h[first], 2);
+    h.clear();
+    CHECK(!h.range(first, last));
+}
+
+void testPulseStatsTransitions() {
+    // Display format: low 5, high 3 (x3), low 2; the first and last pulse
+    // are cut by the capture and must not count
+    const uint8_t data[] = {0x05, 0x83, 0x05, 0x83, 0x05, 0x83, 0x02};
+    PulseStats stats;
+    decode::feedTransitions(stats, data, sizeof(data));
+
+    CHECK_EQ(stats.stats(PulseStats::High).count(), 3);
+    CHECK(stats.stats(PulseStats::High).mean() == 3.0);
+    CHECK_EQ(stats.stats(PulseStats::Low).count(), 2);
+    CHECK(stats.stats(PulseStats::Low).mean() == 5.0);
+    CHECK_EQ(stats.stats(PulseStats::Period).count(), 2);
+    CHECK(stats.stats(PulseStats::Period).mean() == 8.0);
+    CHECK(stats.stats(PulseStats::Period).variance() == 0.0);
+    CHECK_EQ(stats.histogram(PulseStats::High)[LogHistogram::binOf(3)], 3);
+}
+
+void testPulseStatsJitter() {
+    // 30% duty square wave, period 1000 ticks, +-20 ticks on every edge
+    test::Signal signal(17);
+    signal.add(0, 1000);
+    for (int i = 0; i < 20000; i++) {
+        signal.add(1, 300);
+        signal.add(0, 700);
+    }
+
+    PulseStats stats;
+    signal.play(stats, 20.0);
+
+    const Welford& high = stats.stats(PulseStats::High);
+    const Welford& low = stats.stats(PulseStats::Low);
+    const Welford& period = stats.stats(PulseStats::Period);
+    CHECK_EQ(high.count(), 20000);
+    CHECK_EQ(low.count(), 19999);
+    CHECK_EQ(period.count(), 19999);
+    CHECK(near(high.mean(), 300.0, 0.002));
+    CHECK(near(low.mean(), 700.0, 0.002));
+    CHECK(near(period.mean(), 1000.0, 0.002));
+    // Two independent uniform +-20 edges: sd = 40 / sqrt(6) = 16.3
+    CHECK(near(high.stddev(), 16.33, 0.05));
+    CHECK(high.min() >= 260 && high.max() <= 340);
+
+    // Whole series inside the expected bins
+    uint16_t first = 0;
+    uint16_t last = 0;
+    CHECK(stats.histogram(PulseStats::Period).range(first, last));
+    CHECK(LogHistogram::binLower(first) <= 960);
+    CHECK(LogHistogram::binLower(last) <= 1040 && LogHistogram::binLower(last) >= 896);
+
+    // A new capture starts clean
+    stats.clear();
+    CHECK_EQ(stats.stats(PulseStats::High).count(), 0);
+    CHECK(!stats.histogram(PulseStats::High).range(first, last));
+}
+
+} // namespace
+
+int main() {
+    testWelford();
+    testHistogramBins();
+    testPulseStatsTransitions();
+    testPulseStatsJitter();
+    return check::result("pulse_stats_test");
+}
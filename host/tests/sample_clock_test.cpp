@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file           : sample_clock_test.cpp
+  * @brief          : Sample positions against a model of the PortDma timer
+  ******************************************************************************
+  * The model counts TIM1 clock by clock the way PortDma::configure() sets
+  * it up (prescaler and period split, counter and prescaler cleared by
+  * UG) and records the clock of every update event, where the DMA reads
+  * the port. Moments on an update must land on a whole sample, moments
+  * in between on the right fraction, and a level change at a stamped
+  * moment must show up first in the sample the position rounds up to.
+  ******************************************************************************
+  */
+
+#include "SampleClock.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+using capture::SampleClock;
+
+namespace {
+
+// Prescaler and period as PortDma::configure() splits a divider
+struct Split {
+    uint32_t prescaler;
+    uint32_t period;
+};
+
+Split split(uint32_t divider) {
+    uint32_t prescaler = (divider + 0xFFFF) / 0x10000;
+    return {prescaler, (divider + prescaler / 2) / prescaler};
+}
+
+// Clocks after CEN of the first count update events
+std::vector<uint64_t> updateClocks(Split timer, uint32_t count) {
+    uint32_t prescaler = timer.prescaler;
+    uint32_t period = timer.period;
+    std::vector<uint64_t> updates;
+    uint32_t psc_counter = 0;
+    uint32_t counter = 0;
+    for (uint64_t clock = 1; updates.size() < count; clock++) {
+        if (++psc_counter < prescaler) {
+            continue;
+        }
+        psc_counter = 0;
+        if (++counter == period) {
+            counter = 0;
+            updates.push_back(clock);
+        }
+    }
+    return updates;
+}
+
+void testAgainstTimer(uint32_t requested) {
+    const uint32_t SAMPLES = 6;
+    Split timer = split(requested);
+    uint32_t divider = timer.prescaler * timer.period;   // PortDma::divider()
+    std::vector<uint64_t> updates = updateClocks(timer, SAMPLES + 1);
+    uint64_t position = 0;
+
+    // Nothing before the first update, CEN included
+    CHECK(!SampleClock::position(0, divider, position));
+    CHECK(!SampleClock::position(updates[0] - 1, divider, position));
+
+    std::mt19937 rng(divider);
+    for (uint32_t k = 0; k < SAMPLES; k++) {
+        CHECK(SampleClock::position(updates[k], divider, position));
+        CHECK_EQ(position, (uint64_t)k << SampleClock::FRACTION_BITS);
+
+        uint64_t span = updates[k + 1] - updates[k];
+        for (uint32_t n = 0; n < 16; n++) {
+            uint64_t moment = updates[k] + rng() % span;
+            uint64_t expected = ((uint64_t)k << SampleClock::FRACTION_BITS) +
+                                ((moment - updates[k]) << SampleClock::FRACTION_BITS) / span;
+            CHECK(SampleClock::position(moment, divider, position));
+            CHECK_EQ(position, expected);
+
+            // A change at the moment is first read by this update
+            uint32_t first = 0;
+            while (updates[first] < moment) {
+                first++;
+            }
+            uint64_t one = 1u << SampleClock::FRACTION_BITS;
+            CHECK_EQ((position + one - 1) >> SampleClock::FRACTION_BITS, (uint64_t)first);
+        }
+    }
+}
+
+void testLongCapture() {
+    // Ten minutes at 84 MHz: far past the 32-bit cycle counter
+    const uint32_t divider = 21;   // 4 MS/s
+    uint64_t sample = 84000000ull * 600 / divider;
+    uint64_t position = 0;
+    CHECK(SampleClock::position((sample + 1) * divider, divider, position));
+    CHECK(position == sample << SampleClock::FRACTION_BITS);
+    CHECK(SampleClock::position((sample + 1) * divider + divider / 2, divider, position));
+    CHECK(position == (sample << SampleClock::FRACTION_BITS) + (divider / 2 << SampleClock::FRACTION_BITS) / divider);
+}
+
+} // namespace
+
+int main() {
+    // Fastest rate, odd dividers, the auto-set rates and prescaled ones
+    // (840000 does not split evenly and is rounded)
+    const uint32_t dividers[] = {2, 3, 21, 84, 840, 8400, 65536, 84000, 131072, 840000};
+    for (uint32_t divider : dividers) {
+        testAgainstTimer(divider);
+    }
+    testLongCapture();
+    uint64_t position = 0;
+    CHECK(!SampleClock::position(100, 0, position));
+    return check::result("sample_clock_test");
+}
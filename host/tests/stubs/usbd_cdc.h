@@ -0,0 +1,70 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc.h
+  * @brief          : Host stand-in for the USB device CDC class header
+  ******************************************************************************
+  * Just enough of the ST USB device library and of CMSIS for
+  * USB_DEVICE/App/usbd_cdc_if.c to build on the host. The class functions
+  * are defined by the test, which plays the part of the IN endpoint;
+  * interrupts do not exist there, so the PRIMASK calls do nothing.
+  ******************************************************************************
+  */
+
+#ifndef __USB_CDC_H
+#define __USB_CDC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UNUSED(X) (void)(X)
+
+typedef enum
+{
+  USBD_OK = 0U,
+  USBD_BUSY,
+  USBD_EMEM,
+  USBD_FAIL,
+} USBD_StatusTypeDef;
+
+#define CDC_SEND_ENCAPSULATED_COMMAND               0x00U
+#define CDC_GET_ENCAPSULATED_RESPONSE               0x01U
+#define CDC_SET_COMM_FEATURE                        0x02U
+#define CDC_GET_COMM_FEATURE                        0x03U
+#define CDC_CLEAR_COMM_FEATURE                      0x04U
+#define CDC_SET_LINE_CODING                         0x20U
+#define CDC_GET_LINE_CODING                         0x21U
+#define CDC_SET_CONTROL_LINE_STATE                  0x22U
+#define CDC_SEND_BREAK                              0x23U
+
+typedef struct
+{
+  volatile uint32_t TxState;
+  uint8_t *TxBuffer;
+  uint32_t TxLength;
+} USBD_CDC_HandleTypeDef;
+
+typedef struct
+{
+  void *pClassData;
+} USBD_HandleTypeDef;
+
+typedef struct
+{
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  int8_t (* Control)(uint8_t cmd, uint8_t *pbuf, uint16_t length);
+  int8_t (* Receive)(uint8_t *Buf, uint32_t *Len);
+  int8_t (* TransmitCplt)(uint8_t *Buf, uint32_t *Len, uint8_t epnum);
+} USBD_CDC_ItfTypeDef;
+
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length);
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff);
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev);
+uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev);
+
+static inline void __DMB(void) { __asm__ volatile("" ::: "memory"); }
+static inline uint32_t __get_PRIMASK(void) { return 0U; }
+static inline void __disable_irq(void) {}
+static inline void __set_PRIMASK(uint32_t priMask) { (void)priMask; }
+
+#endif /* __USB_CDC_H */
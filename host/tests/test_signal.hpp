@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file           : test_signal.hpp
+  * @brief          : Synthetic line signals and an event recorder for tests
+  ******************************************************************************
+  * A Signal is a list of runs (level, duration in ticks, fractional). It is
+  * played into a decoder the way decode::feedTransitions() does, through
+  * begin / edge / end, with every edge optionally moved by a uniform random
+  * jitter. EventLog records what the decoder reports.
+  ******************************************************************************
+  */
+
+#ifndef TEST_SIGNAL_HPP
+#define TEST_SIGNAL_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Decoder.hpp"
+
+namespace test {
+
+class EventLog : public decode::EventSink {
+public:
+    void onEvent(const decode::Event& event) override { events.push_back(event); }
+
+    size_t count(decode::EventType type) const {
+        size_t n = 0;
+        for (const decode::Event& event : events) {
+            n += (event.type == type) ? 1 : 0;
+        }
+        return n;
+    }
+
+    // Events of one type in order
+    std::vector<decode::Event> of(decode::EventType type) const {
+        std::vector<decode::Event> found;
+        for (const decode::Event& event : events) {
+            if (event.type == type) {
+                found.push_back(event);
+            }
+        }
+        return found;
+    }
+
+    std::vector<decode::Event> events;
+};
+
+class Signal {
+public:
+    explicit Signal(uint32_t seed = 1) : rng_(seed) {}
+
+    // Hold a level for a number of ticks (merged with a run of the same level)
+    void add(uint8_t level, double ticks) {
+        if (!runs_.empty() && runs_.back().level == level) {
+            runs_.back().ticks += ticks;
+        } else {
+            runs_.push_back({level, ticks});
+        }
+    }
+
+    double length() const {
+        double total = 0;
+        for (const Run& run : runs_) {
+            total += run.ticks;
+        }
+        return total;
+    }
+
+    size_t edges() const { return runs_.empty() ? 0 : runs_.size() - 1; }
+
+    // Feed to a decoder with begin/edge/end; each edge is moved by up to
+    // +-jitter ticks. Returns the end time.
+    template <typename DecoderT>
+    uint32_t play(DecoderT& decoder, double jitter = 0.0) {
+        std::uniform_real_distribution<double> spread(-jitter, jitter);
+        double t = 0;
+        decoder.begin(0, runs_.empty() ? 1 : runs_[0].level);
+        for (size_t i = 0; i + 1 < runs_.size(); i++) {
+            t += runs_[i].ticks;
+            double moved = t + ((jitter > 0.0) ? spread(rng_) : 0.0);
+            decoder.edge((uint32_t)std::lround(moved < 0 ? 0 : moved), runs_[i + 1].level);
+        }
+        uint32_t end = (uint32_t)std::lround(length());
+        decoder.end(end);
+        return end;
+    }
+
+private:
+    struct Run {
+        uint8_t level;
+        double ticks;
+    };
+
+    std::vector<Run> runs_;
+    std::mt19937 rng_;
+};
+
+} // namespace test
+
+#endif /* TEST_SIGNAL_HPP */
@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file           : timing_analysis_test.cpp
+  * @brief          : Setup / hold / skew merge walk against a brute force
+  ******************************************************************************
+  * TimingAnalysis walks all channels at once in time order. The brute
+  * force here takes the definitions literally instead: list the edges of
+  * every channel, then for each active clock edge search them for the
+  * last data edge of the cycle before it (setup), the first one after it
+  * up to the next clock edge (hold) and the first edge of each data
+  * channel in the cycle (skew). Random captures use coarse run lengths,
+  * so data and clock edges often coincide, and fine ones with runs longer
+  * than an entry holds; some channels stay idle or are empty.
+  ******************************************************************************
+  */
+
+#include "TimingAnalysis.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+using measure::TimingAnalysis;
+
+namespace {
+
+// Display format: bit 7 = level, bits 6-0 = ticks, long runs split at 127
+void addRun(std::vector<uint8_t>& data, uint8_t level, uint32_t ticks) {
+    while (ticks > 0) {
+        uint8_t run = (ticks > 127) ? 127 : (uint8_t)ticks;
+        data.push_back((uint8_t)((level << 7) | run));
+        ticks -= run;
+    }
+}
+
+struct Edge {
+    uint32_t time;
+    uint8_t level;   // Level after the edge
+};
+
+std::vector<Edge> edgesOf(const std::vector<uint8_t>& data) {
+    std::vector<Edge> edges;
+    uint32_t t = 0;
+    for (size_t k = 0; k < data.size(); k++) {
+        uint8_t level = data[k] >> 7;
+        if (k > 0 && level != (data[k - 1] >> 7)) {
+            edges.push_back({t, level});
+        }
+        t += data[k] & 0x7F;
+    }
+    return edges;
+}
+
+TimingAnalysis::Result bruteForce(const std::vector<std::vector<uint8_t>>& channels, uint8_t clock, bool rising) {
+    TimingAnalysis::Result r;
+    r.clock_channel = clock;
+    r.rising = rising ? 1 : 0;
+    r.skew.clear();
+    for (TimingAnalysis::ChannelResult& c : r.channels) {
+        c.setup.clear();
+        c.hold.clear();
+    }
+
+    std::vector<uint32_t> clocks;
+    for (const Edge& e : edgesOf(channels[clock])) {
+        if (e.level == (rising ? 1 : 0)) {
+            clocks.push_back(e.time);
+        }
+    }
+    r.clock_edges = (uint32_t)clocks.size();
+
+    std::vector<std::vector<Edge>> edges;
+    for (const std::vector<uint8_t>& data : channels) {
+        edges.push_back(edgesOf(data));
+    }
+    for (size_t i = 0; i < clocks.size(); i++) {
+        // Cycle before the edge: (previous clock edge, this one]
+        bool first_cycle = (i == 0);
+        uint32_t from = first_cycle ? 0 : clocks[i - 1];
+        uint32_t to = clocks[i];
+        uint32_t first = UINT32_MAX;
+        uint32_t last = 0;
+        uint32_t toggled = 0;
+        for (uint8_t ch = 0; ch < channels.size(); ch++) {
+            if (ch == clock) {
+                continue;
+            }
+            bool found = false;
+            uint32_t latest = 0;
+            for (const Edge& e : edges[ch]) {
+                if ((first_cycle || e.time > from) && e.time <= to) {
+                    if (!found) {
+                        first = (e.time < first) ? e.time : first;
+                        last = (e.time > last) ? e.time : last;
+                        toggled++;
+                    }
+                    found = true;
+                    latest = e.time;
+                }
+            }
+            if (found) {
+                r.channels[ch].setup.add(to - latest);
+            }
+            // Hold: first edge after this clock edge, up to the next one
+            for (const Edge& e : edges[ch]) {
+                if (e.time > to && (i + 1 == clocks.size() || e.time <= clocks[i + 1])) {
+                    r.channels[ch].hold.add(e.time - to);
+                    break;
+                }
+            }
+        }
+        if (toggled >= 2) {
+            r.skew.add(last - first);
+        }
+    }
+    return r;
+}
+
+bool sameRange(const TimingAnalysis::Range& a, const TimingAnalysis::Range& b) {
+    return a.count == b.count && (a.count == 0 || (a.min == b.min && a.max == b.max));
+}
+
+uint32_t mismatches(const TimingAnalysis::Result& a, const TimingAnalysis::Result& b) {
+    uint32_t bad = (a.clock_edges != b.clock_edges) ? 1 : 0;
+    bad += sameRange(a.skew, b.skew) ? 0 : 1;
+    for (uint8_t ch = 0; ch < TimingAnalysis::MAX_CHANNELS; ch++) {
+        bad += sameRange(a.channels[ch].setup, b.channels[ch].setup) ? 0 : 1;
+        bad += sameRange(a.channels[ch].hold, b.channels[ch].hold) ? 0 : 1;
+    }
+    return bad;
+}
+
+TimingAnalysis::Result analyze(const std::vector<std::vector<uint8_t>>& channels, uint8_t clock, bool rising) {
+    std::vector<const uint8_t*> data;
+    std::vector<uint16_t> lengths;
+    for (const std::vector<uint8_t>& d : channels) {
+        data.push_back(d.data());
+        lengths.push_back((uint16_t)d.size());
+    }
+    TimingAnalysis::Result result;
+    TimingAnalysis::analyze(data.data(), lengths.data(), (uint8_t)channels.size(), clock, rising, result);
+    return result;
+}
+
+void testKnown() {
+    // Clock CH0 rising at 10, 30, 50; CH1 changes at 7 and 33, CH2 at 10
+    // (with the clock: setup 0) and 44
+    std::vector<std::vector<uint8_t>> channels(3);
+    addRun(channels[0], 0, 10);
+    for (int k = 0; k < 3; k++) {
+        addRun(channels[0], 1, 10);
+        addRun(channels[0], 0, 10);
+    }
+    addRun(channels[1], 0, 7);
+    addRun(channels[1], 1, 26);
+    addRun(channels[1], 0, 30);
+    addRun(channels[2], 1, 10);
+    addRun(channels[2], 0, 34);
+    addRun(channels[2], 1, 20);
+
+    TimingAnalysis::Result r = analyze(channels, 0, true);
+    CHECK_EQ(r.clock_edges, 3);
+    CHECK_EQ(r.channels[1].setup.count, 2);
+    CHECK_EQ(r.channels[1].setup.min, 3);
+    CHECK_EQ(r.channels[1].setup.max, 17);
+    CHECK_EQ(r.channels[1].hold.count, 1);
+    CHECK_EQ(r.channels[1].hold.min, 3);
+    CHECK_EQ(r.channels[2].setup.count, 2);
+    CHECK_EQ(r.channels[2].setup.min, 0);
+    CHECK_EQ(r.channels[2].setup.max, 6);
+    CHECK_EQ(r.channels[2].hold.count, 1);
+    CHECK_EQ(r.channels[2].hold.min, 14);
+    // Cycles ending at 10 (7 and 10) and 50 (33 and 44)
+    CHECK_EQ(r.skew.count, 2);
+    CHECK_EQ(r.skew.min, 3);
+    CHECK_EQ(r.skew.max, 11);
+    CHECK_EQ(r.channels[0].setup.count + r.channels[0].hold.count, 0);
+    CHECK_EQ(mismatches(r, bruteForce(channels, 0, true)), 0);
+
+    // A clock channel past the channel count gives an empty result
+    r = analyze(channels, 3, true);
+    CHECK_EQ(r.clock_edges, 0);
+    CHECK_EQ(r.channels[1].setup.count, 0);
+}
+
+void testRandom() {
+    std::mt19937 rng(34);
+    uint32_t bad_captures = 0;
+    uint32_t setups = 0;
+    uint32_t zero_setups = 0;
+    for (uint32_t capture = 0; capture < 2000; capture++) {
+        uint8_t num_channels = (uint8_t)(2 + rng() % (TimingAnalysis::MAX_CHANNELS - 1));
+        bool coarse = (capture % 2) == 0;
+        std::vector<std::vector<uint8_t>> channels(num_channels);
+        for (std::vector<uint8_t>& data : channels) {
+            uint32_t kind = rng() % 10;
+            uint8_t level = (uint8_t)(rng() & 1);
+            if (kind == 0) {
+                continue;                              // Empty
+            }
+            if (kind == 1) {
+                addRun(data, level, 1 + rng() % 2000);  // Idle
+                continue;
+            }
+            uint32_t runs = 1 + rng() % 60;
+            for (uint32_t k = 0; k < runs; k++) {
+                addRun(data, level, coarse ? 4 * (1 + rng() % 6) : 1 + rng() % 300);
+                level ^= 1;
+            }
+        }
+        uint8_t clock = (uint8_t)(rng() % num_channels);
+        bool rising = (rng() & 1) != 0;
+        TimingAnalysis::Result r = analyze(channels, clock, rising);
+        bad_captures += (mismatches(r, bruteForce(channels, clock, rising)) != 0) ? 1 : 0;
+        for (uint8_t ch = 0; ch < num_channels; ch++) {
+            setups += r.channels[ch].setup.count;
+            zero_setups += (r.channels[ch].setup.count != 0 && r.channels[ch].setup.min == 0) ? 1 : 0;
+        }
+    }
+    CHECK_EQ(bad_captures, 0);
+    // The captures did exercise the measurements, ties included
+    CHECK(setups > 10000);
+    CHECK(zero_setups > 100);
+}
+
+} // namespace
+
+int main() {
+    testKnown();
+    testRandom();
+    return check::result("timing_analysis_test");
+}
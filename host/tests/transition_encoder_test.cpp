@@ -0,0 +1,333 @@
+/**
+  ******************************************************************************
+  * @file           : transition_encoder_test.cpp
+  * @brief          : TransitionEncoder filter and glitch capture vs a model
+  ******************************************************************************
+  * Port words carry four channels on scattered bits with noise on the
+  * others. The expected output comes from a per-channel model written
+  * directly from the definition: a run of at least N samples that differs
+  * from the current level becomes the new level from its first sample,
+  * shorter ones are glitches. Random traffic is fed in random block sizes.
+  ******************************************************************************
+  */
+
+#include "TransitionEncoder.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using capture::TransitionEncoder;
+
+namespace {
+
+const uint8_t CHANNEL_BITS[TransitionEncoder::MAX_CHANNELS] = {8, 15, 6, 2};
+
+using Runs = std::vector<std::pair<uint8_t, uint32_t>>;  // (level, samples)
+
+void appendRun(Runs& runs, uint8_t level, uint32_t samples) {
+    if (samples == 0) {
+        return;
+    }
+    if (!runs.empty() && runs.back().first == level) {
+        runs.back().second += samples;
+    } else {
+        runs.push_back({level, samples});
+    }
+}
+
+Runs decodeRuns(const uint8_t* data, uint32_t length) {
+    Runs runs;
+    for (uint32_t i = 0; i < length; i++) {
+        appendRun(runs, data[i] >> 7, data[i] & 0x7F);
+    }
+    return runs;
+}
+
+// Port words from per-channel levels, noise on every other bit
+std::vector<uint16_t> toWords(const std::vector<std::vector<uint8_t>>& levels, std::mt19937& rng) {
+    std::vector<uint16_t> words(levels[0].size());
+    for (size_t i = 0; i < words.size(); i++) {
+        uint16_t word = (uint16_t)rng();
+        for (size_t ch = 0; ch < levels.size(); ch++) {
+            word &= (uint16_t)~(1u << CHANNEL_BITS[ch]);
+            word |= (uint16_t)(levels[ch][i] << CHANNEL_BITS[ch]);
+        }
+        words[i] = word;
+    }
+    return words;
+}
+
+struct Expected {
+    Runs runs;
+    std::vector<TransitionEncoder::Glitch> glitches;
+};
+
+Expected model(const std::vector<uint8_t>& raw, uint8_t channel, uint32_t min_width) {
+    Expected expected;
+    uint8_t level = raw[0];
+    uint32_t last_change = 0;
+    uint32_t start = 0;
+    while (start < raw.size()) {
+        uint32_t end = start;
+        while (end < raw.size() && raw[end] == raw[start]) {
+            end++;
+        }
+        uint32_t width = end - start;
+        if (raw[start] != level) {
+            if (width >= min_width) {
+                appendRun(expected.runs, level, start - last_change);
+                last_change = start;
+                level = raw[start];
+            } else if (end < raw.size() && min_width > 1) {
+                // Pulses cut by the end of the capture are still pending
+                expected.glitches.push_back({start, channel, (uint8_t)width, raw[start]});
+            }
+        }
+        start = end;
+    }
+    appendRun(expected.runs, level, (uint32_t)raw.size() - last_change);
+    return expected;
+}
+
+bool sameGlitch(const TransitionEncoder::Glitch& a, const TransitionEncoder::Glitch& b) {
+    return a.timestamp == b.timestamp && a.channel == b.channel && a.width == b.width && a.level == b.level;
+}
+
+void sortGlitches(std::vector<TransitionEncoder::Glitch>& glitches) {
+    std::sort(glitches.begin(), glitches.end(), [](const auto& a, const auto& b) {
+        return (a.timestamp != b.timestamp) ? a.timestamp < b.timestamp : a.channel < b.channel;
+    });
+}
+
+void testHandBuilt() {
+    TransitionEncoder encoder(CHANNEL_BITS, 4);
+    static uint8_t out[4][256];
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        encoder.setOutput(ch, out[ch], sizeof(out[ch]));
+    }
+    encoder.setMinWidth(0, 3);
+    TransitionEncoder::Glitch glitches[16];
+    encoder.setGlitchCapture(glitches, 16);
+
+    std::vector<uint16_t> words;
+    auto put = [&](uint8_t level, int count) {
+        for (int i = 0; i < count; i++) {
+            words.push_back(level ? (1u << CHANNEL_BITS[0]) : 0);
+        }
+    };
+    put(0, 10);
+    put(1, 1);   // Glitch
+    put(0, 5);
+    put(1, 2);   // Glitch
+    put(0, 4);
+    put(1, 3);   // Kept, exactly the min width
+    put(0, 200); // Longer than one entry
+    put(1, 7);
+    encoder.encode(words.data(), 13);
+    encoder.encode(words.data() + 13, (uint32_t)words.size() - 13);
+    encoder.finish();
+
+    Runs runs = decodeRuns(out[0], encoder.length(0));
+    CHECK_EQ(runs.size(), 4);
+    if (runs.size() == 4) {
+        CHECK_EQ(runs[0].first, 0);
+        CHECK_EQ(runs[0].second, 10 + 1 + 5 + 2 + 4);
+        CHECK_EQ(runs[1].second, 3);
+        CHECK_EQ(runs[2].second, 200);
+        CHECK_EQ(runs[3].second, 7);
+    }
+    // The 200-sample run is split in two entries, none is empty
+    bool short_entries = true;
+    for (uint32_t i = 0; i < encoder.length(0); i++) {
+        short_entries = short_entries && (out[0][i] & 0x7F) != 0;
+    }
+    CHECK(short_entries);
+    CHECK_EQ(encoder.length(0), 5);  // 22, 3, 127 + 73, 7
+
+    CHECK_EQ(encoder.glitches(), 2);
+    if (encoder.glitches() == 2) {
+        CHECK_EQ(glitches[0].timestamp, 10);
+        CHECK_EQ(glitches[0].width, 1);
+        CHECK_EQ(glitches[0].level, 1);
+        CHECK_EQ(glitches[1].timestamp, 16);
+        CHECK_EQ(glitches[1].width, 2);
+    }
+    CHECK_EQ(encoder.samples(), words.size());
+    CHECK(!encoder.overflow());
+
+    // An unfiltered channel reports every run, a constant one one long run
+    Runs flat = decodeRuns(out[1], encoder.length(1));
+    CHECK_EQ(flat.size(), 1);
+    if (!flat.empty()) {
+        CHECK_EQ(flat[0].second, words.size());
+    }
+}
+
+void testRandomAgainstModel() {
+    std::mt19937 rng(1);
+    static uint8_t out[4][65536];
+    static TransitionEncoder::Glitch glitches[100000];
+
+    for (int iteration = 0; iteration < 200; iteration++) {
+        uint32_t min_width[4];
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            min_width[ch] = rng() % (TransitionEncoder::MAX_MIN_WIDTH + 1);  // 0 and 1: no filter
+        }
+        uint32_t length = 1000 + rng() % 5000;
+
+        // Mix of short (glitch sized) and long runs
+        std::vector<std::vector<uint8_t>> raw(4, std::vector<uint8_t>(length));
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            uint8_t level = rng() & 1;
+            uint32_t i = 0;
+            while (i < length) {
+                uint32_t width = 1 + rng() % ((rng() & 1) ? 6 : 60);
+                for (uint32_t k = 0; k < width && i < length; k++, i++) {
+                    raw[ch][i] = level;
+                }
+                level ^= 1;
+            }
+        }
+        std::vector<uint16_t> words = toWords(raw, rng);
+
+        TransitionEncoder encoder(CHANNEL_BITS, 4);
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            encoder.setOutput(ch, out[ch], sizeof(out[ch]));
+            encoder.setMinWidth(ch, (uint8_t)min_width[ch]);
+        }
+        encoder.setGlitchCapture(glitches, 100000);
+        uint32_t i = 0;
+        while (i < length) {
+            uint32_t block = std::min<uint32_t>(1 + rng() % 700, length - i);
+            encoder.encode(words.data() + i, block);
+            i += block;
+        }
+        encoder.finish();
+
+        std::vector<TransitionEncoder::Glitch> expected_glitches;
+        uint32_t run_mismatches = 0;
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            Expected expected = model(raw[ch], ch, std::max<uint32_t>(min_width[ch], 1));
+            run_mismatches += (decodeRuns(out[ch], encoder.length(ch)) != expected.runs) ? 1 : 0;
+            expected_glitches.insert(expected_glitches.end(), expected.glitches.begin(), expected.glitches.end());
+        }
+        CHECK_EQ(run_mismatches, 0);
+
+        std::vector<TransitionEncoder::Glitch> got(glitches, glitches + encoder.glitches());
+        sortGlitches(got);
+        sortGlitches(expected_glitches);
+        CHECK_EQ(got.size(), expected_glitches.size());
+        CHECK(std::equal(got.begin(), got.end(), expected_glitches.begin(), expected_glitches.end(), sameGlitch));
+        CHECK_EQ(encoder.samples(), length);
+    }
+}
+
+void testFlushInBlocks() {
+    // Draining block by block into fresh buffers gives the same runs
+    std::mt19937 rng(5);
+    std::vector<std::vector<uint8_t>> raw(4, std::vector<uint8_t>(20000));
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        uint8_t level = 0;
+        for (uint32_t i = 0; i < raw[ch].size(); i++) {
+            if (rng() % 23 == 0) {
+                level ^= 1;
+            }
+            raw[ch][i] = level;
+        }
+    }
+    std::vector<uint16_t> words = toWords(raw, rng);
+
+    TransitionEncoder encoder(CHANNEL_BITS, 4);
+    encoder.setMinWidth(1, 4);
+    encoder.setMinWidth(2, 9);
+    static uint8_t block_out[4][4096];
+    Runs joined[4];
+    for (uint32_t start = 0; start < words.size(); start += 1000) {
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            encoder.setOutput(ch, block_out[ch], sizeof(block_out[ch]));
+        }
+        encoder.encode(words.data() + start, 1000);
+        if (start + 1000 < words.size()) {
+            encoder.flush();
+        } else {
+            encoder.finish();
+        }
+        for (uint8_t ch = 0; ch < 4; ch++) {
+            for (auto& run : decodeRuns(block_out[ch], encoder.length(ch))) {
+                appendRun(joined[ch], run.first, run.second);
+            }
+        }
+    }
+    const uint32_t widths[4] = {1, 4, 9, 1};
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        CHECK(joined[ch] == model(raw[ch], ch, widths[ch]).runs);
+    }
+    CHECK(!encoder.overflow());
+}
+
+void testLimits() {
+    // Small output: overflow is flagged, nothing written past capacity
+    TransitionEncoder encoder(CHANNEL_BITS, 1);
+    uint8_t out[9] = {};
+    encoder.setOutput(0, out, 8);
+    TransitionEncoder::Glitch glitches[2];
+    encoder.setMinWidth(0, 4);
+    encoder.setGlitchCapture(glitches, 2);
+    std::vector<uint16_t> words;
+    for (int i = 0; i < 40; i++) {
+        // 1-sample spikes every 5 samples, then 6-sample runs
+        uint16_t level = (i < 20) ? ((i % 5) == 2) : ((i / 6) & 1);
+        words.push_back((uint16_t)(level << CHANNEL_BITS[0]));
+    }
+    for (int i = 0; i < 10; i++) {
+        encoder.encode(words.data(), (uint32_t)words.size());
+    }
+    encoder.finish();
+    CHECK(encoder.overflow());
+    CHECK_EQ(encoder.length(0), 8);
+    CHECK_EQ(out[8], 0);
+    CHECK_EQ(encoder.glitches(), 2);
+    CHECK(encoder.glitchesDropped() > 0);
+
+    // reset() starts a new capture with the same configuration
+    encoder.setOutput(0, out, 8);
+    encoder.reset();
+    CHECK(!encoder.overflow());
+    CHECK_EQ(encoder.glitches(), 0);
+    CHECK_EQ(encoder.glitchesDropped(), 0);
+    encoder.encode(words.data(), 20);
+    encoder.finish();
+    Runs runs = decodeRuns(out, encoder.length(0));
+    CHECK_EQ(runs.size(), 1);
+    CHECK_EQ(encoder.glitches(), 2);  // Capacity reached again
+    CHECK_EQ(encoder.glitchesDropped(), 2);
+
+    // Width above the maximum is clamped: a MAX_MIN_WIDTH pulse passes
+    TransitionEncoder wide(CHANNEL_BITS, 1);
+    uint8_t wide_out[16];
+    wide.setOutput(0, wide_out, sizeof(wide_out));
+    wide.setMinWidth(0, 40);
+    std::vector<uint16_t> pulse(4 + TransitionEncoder::MAX_MIN_WIDTH, 1u << CHANNEL_BITS[0]);
+    std::fill(pulse.begin(), pulse.begin() + 4, 0);
+    wide.encode(pulse.data(), (uint32_t)pulse.size());
+    wide.finish();
+    Runs wide_runs = decodeRuns(wide_out, wide.length(0));
+    CHECK_EQ(wide_runs.size(), 2);
+    if (wide_runs.size() == 2) {
+        CHECK_EQ(wide_runs[1].first, 1);
+        CHECK_EQ(wide_runs[1].second, TransitionEncoder::MAX_MIN_WIDTH);
+    }
+}
+
+} // namespace
+
+int main() {
+    testHandBuilt();
+    testRandomAgainstModel();
+    testFlushInBlocks();
+    testLimits();
+    return check::result("transition_encoder_test");
+}
@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file           : transition_export.cpp
+  * @brief          : Streaming export of captures from the transition format
+  ******************************************************************************
+  */
+
+#include "transition_export.hpp"
+
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "capture_file.hpp"
+
+namespace exporter {
+
+namespace {
+
+// Worst case of one flushed block: a change every sample, plus the splits
+// of the runs that ended in it and the filter delay
+const uint32_t RUN_CAPACITY = TransitionExport::BLOCK_SAMPLES + TransitionExport::BLOCK_SAMPLES / 64 + 64;
+
+} // namespace
+
+TransitionExport::TransitionExport(const CaptureInfo& info, ChangeSink& sink)
+    : info_(info), sink_(sink), encoder_(info.channel_bits, NUM_CHANNELS) {
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        run_buffers_[ch].resize(RUN_CAPACITY);
+    }
+}
+
+void TransitionExport::setMinWidth(uint8_t samples) {
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        encoder_.setMinWidth(ch, samples);
+    }
+}
+
+bool TransitionExport::feedSamples(const uint16_t* words, size_t count) {
+    while (count > 0 && ok_) {
+        uint32_t n = (count < BLOCK_SAMPLES) ? (uint32_t)count : BLOCK_SAMPLES;
+        if (!encodeBlock(words, n)) {
+            return false;
+        }
+        words += n;
+        count -= n;
+    }
+    return ok_;
+}
+
+bool TransitionExport::encodeBlock(const uint16_t* words, uint32_t count) {
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        encoder_.setOutput(ch, run_buffers_[ch].data(), RUN_CAPACITY);
+    }
+    encoder_.encode(words, count);
+    encoder_.flush();
+    if (encoder_.overflow()) {
+        fprintf(stderr, "export: transition buffer overflow\n");
+        ok_ = false;
+        return false;
+    }
+
+    const uint8_t* runs[NUM_CHANNELS];
+    uint32_t lengths[NUM_CHANNELS];
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        runs[ch] = run_buffers_[ch].data();
+        lengths[ch] = encoder_.length(ch);
+    }
+    return feedRuns(runs, lengths);
+}
+
+bool TransitionExport::feedRuns(const uint8_t* const runs[NUM_CHANNELS], const uint32_t lengths[NUM_CHANNELS]) {
+    if (!ok_) {
+        return false;
+    }
+    uint64_t horizon = UINT64_MAX;
+    bool all_started = true;
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        Cursor& cursor = cursors_[ch];
+        for (uint32_t k = 0; k < lengths[ch]; k++) {
+            uint8_t level = runs[ch][k] >> 7;
+            if (!cursor.started) {
+                cursor.level = level;
+                cursor.started = true;
+            } else if (level != cursor.level) {
+                cursor.pending.push_back({cursor.time, ch, level});
+                cursor.level = level;
+            }
+            cursor.time += runs[ch][k] & 0x7F;
+        }
+        all_started = all_started && cursor.started;
+        // The next change of this channel is at its cursor at the earliest
+        if (cursor.time < horizon) {
+            horizon = cursor.time;
+        }
+    }
+
+    if (!begun_) {
+        if (!all_started) {
+            return true;
+        }
+        uint8_t levels = 0;
+        for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            levels |= cursors_[ch].level << ch;
+        }
+        // The first change of a channel is not its starting level
+        for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            if (!cursors_[ch].pending.empty()) {
+                levels ^= (cursors_[ch].pending.size() & 1) << ch;
+            }
+        }
+        if (!sink_.begin(info_, levels)) {
+            ok_ = false;
+            return false;
+        }
+        begun_ = true;
+    }
+    return release(horizon);
+}
+
+bool TransitionExport::release(uint64_t horizon) {
+    merged_.clear();
+    for (;;) {
+        // Earliest head among the channels (few channels: a linear scan)
+        Cursor* first = nullptr;
+        for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            Cursor& cursor = cursors_[ch];
+            if (cursor.next < cursor.pending.size() && cursor.pending[cursor.next].time < horizon &&
+                (first == nullptr || cursor.pending[cursor.next].time < first->pending[first->next].time)) {
+                first = &cursor;
+            }
+        }
+        if (first == nullptr) {
+            break;
+        }
+        merged_.push_back(first->pending[first->next++]);
+    }
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        Cursor& cursor = cursors_[ch];
+        cursor.pending.erase(cursor.pending.begin(), cursor.pending.begin() + cursor.next);
+        cursor.next = 0;
+    }
+
+    change_count_ += merged_.size();
+    if (!sink_.changes(merged_.data(), merged_.size(), horizon)) {
+        ok_ = false;
+    }
+    return ok_;
+}
+
+bool TransitionExport::finish(uint64_t samples) {
+    if (!ok_) {
+        return false;
+    }
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        encoder_.setOutput(ch, run_buffers_[ch].data(), RUN_CAPACITY);
+    }
+    encoder_.finish();
+    const uint8_t* runs[NUM_CHANNELS];
+    uint32_t lengths[NUM_CHANNELS];
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        runs[ch] = run_buffers_[ch].data();
+        lengths[ch] = encoder_.length(ch);
+    }
+    if (!feedRuns(runs, lengths)) {
+        return false;
+    }
+    if (!begun_) {
+        uint8_t levels = 0;
+        for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            levels |= cursors_[ch].level << ch;
+        }
+        if (!sink_.begin(info_, levels)) {
+            return false;
+        }
+        begun_ = true;
+    }
+    return release(samples) && sink_.end(samples);
+}
+
+bool exportCaptureFile(const std::string& path, uint8_t min_width, ChangeSink& sink) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror(path.c_str());
+        return false;
+    }
+    capture::CaptureHeader header;
+    if (!capture::CaptureFile::readHeader(fd, header) || header.sample_bytes != 2) {
+        fprintf(stderr, "%s: not a capture file of 16-bit samples\n", path.c_str());
+        close(fd);
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    CaptureInfo info;
+    info.rate_hz = header.rate_hz;
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        info.channel_bits[ch] = header.channel_bits[ch];
+    }
+    TransitionExport exporter(info, sink);
+    exporter.setMinWidth(min_width);
+
+    std::vector<uint16_t> block(TransitionExport::BLOCK_SAMPLES);
+    off_t offset = capture::CaptureFile::HEADER_BYTES;
+    uint64_t samples = 0;
+    bool ok = true;
+    while (samples < header.samples) {
+        uint64_t want = header.samples - samples;
+        size_t n = (want < block.size()) ? (size_t)want : block.size();
+        ssize_t got = pread(fd, block.data(), n * 2, offset);
+        if (got < 0) {
+            perror(path.c_str());
+            ok = false;
+            break;
+        }
+        if (got < 2) {
+            break;   // File shorter than its header says
+        }
+        n = (size_t)got / 2;
+        if (!exporter.feedSamples(block.data(), n)) {
+            ok = false;
+            break;
+        }
+        samples += n;
+        offset += (off_t)(n * 2);
+    }
+    close(fd);
+    return exporter.finish(samples) && ok;
+}
+
+} // namespace exporter
@@ -0,0 +1,119 @@
+/**
+  ******************************************************************************
+  * @file           : transition_export.hpp
+  * @brief          : Streaming export of captures from the transition format
+  ******************************************************************************
+  * The transition format is the device's (Core/Lib/TransitionEncoder): per
+  * channel a sequence of bytes, bit 7 = level, bits 6-0 = duration in
+  * samples, a long run split over several bytes of the same level.
+  * TransitionExport turns the runs of all channels into one time-ordered
+  * list of level changes and hands it to a ChangeSink (VcdWriter,
+  * SigrokWriter) block by block. Raw port words, as in a .lacap capture,
+  * are run through the firmware's TransitionEncoder first.
+  *
+  * Memory is bounded by the block size whatever the capture length: the
+  * encoder is flushed after every block, and a change is passed on as soon
+  * as no channel can still report an earlier one.
+  ******************************************************************************
+  */
+
+#ifndef TRANSITION_EXPORT_HPP
+#define TRANSITION_EXPORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TransitionEncoder.hpp"
+
+namespace exporter {
+
+const uint8_t NUM_CHANNELS = capture::TransitionEncoder::MAX_CHANNELS;
+
+struct CaptureInfo {
+    uint32_t rate_hz = 0;
+    uint8_t channel_bits[NUM_CHANNELS] = {0, 1, 2, 3};   ///< Port bit of each channel
+};
+
+struct Change {
+    uint64_t time;     ///< Sample the new level starts at
+    uint8_t channel;
+    uint8_t level;
+};
+
+// Receiver of the change list
+class ChangeSink {
+public:
+    virtual ~ChangeSink() = default;
+
+    // levels: bit n = level of channel n at sample 0
+    virtual bool begin(const CaptureInfo& info, uint8_t levels) = 0;
+
+    // Changes in time order; no later call has one before horizon
+    virtual bool changes(const Change* changes, size_t count, uint64_t horizon) = 0;
+
+    virtual bool end(uint64_t samples) = 0;
+};
+
+class TransitionExport {
+public:
+    static const uint32_t BLOCK_SAMPLES = 64 * 1024;
+
+    TransitionExport(const CaptureInfo& info, ChangeSink& sink);
+
+    /**
+     * @brief Shortest pulse kept when encoding port words (the encoder's filter)
+     */
+    void setMinWidth(uint8_t samples);
+
+    /**
+     * @brief Raw port words, any count per call
+     */
+    bool feedSamples(const uint16_t* words, size_t count);
+
+    /**
+     * @brief Transition bytes of every channel; a call may end mid-run,
+     *        every channel's runs must start where its last call ended
+     */
+    bool feedRuns(const uint8_t* const runs[NUM_CHANNELS], const uint32_t lengths[NUM_CHANNELS]);
+
+    /**
+     * @brief Close the export; samples is the capture length
+     */
+    bool finish(uint64_t samples);
+
+    uint64_t changeCount() const { return change_count_; }
+
+private:
+    bool encodeBlock(const uint16_t* words, uint32_t count);
+    bool release(uint64_t horizon);
+
+    struct Cursor {
+        uint64_t time = 0;
+        uint8_t level = 0;
+        bool started = false;
+        std::vector<Change> pending;
+        size_t next = 0;
+    };
+
+    CaptureInfo info_;
+    ChangeSink& sink_;
+    capture::TransitionEncoder encoder_;
+    std::vector<uint8_t> run_buffers_[NUM_CHANNELS];
+    Cursor cursors_[NUM_CHANNELS];
+    std::vector<Change> merged_;
+    uint64_t change_count_ = 0;
+    bool begun_ = false;
+    bool ok_ = true;
+};
+
+/**
+ * @brief Export a .lacap capture file (capture_file.hpp) block by block
+ * @param min_width Encoder filter, 1 = off
+ */
+bool exportCaptureFile(const std::string& path, uint8_t min_width, ChangeSink& sink);
+
+} // namespace exporter
+
+#endif /* TRANSITION_EXPORT_HPP */
@@ -0,0 +1,268 @@
+/**
+  ******************************************************************************
+  * @file           : usb_bench.cpp
+  * @brief          : Host side of the USB throughput benchmark (menu USB BENCH)
+  ******************************************************************************
+  * Reads the CDC port or the vendor bulk interface, waits for the benchmark
+  * start frame, checks every payload word against the counter and reports
+  * the sustained throughput seen by the host. Stream format: see
+  * Core/Lib/UsbBench.hpp.
+  *
+  *   usb_bench [/dev/ttyACM0]     start this first, then USB BENCH
+  *   usb_bench --bulk [node]      start this first, then BULK BENCH; node
+  *                                is /dev/bus/usb/BBB/DDD, found by
+  *                                VID:PID if omitted
+  *   usb_bench capture.bin        check a recorded stream (no timing)
+  *
+  * The bulk path goes through usbfs.hpp.
+  *
+  * Exit status 0 when the stream ended with a matching end frame and no
+  * word was wrong.
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "usbfs.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const uint8_t START_MAGIC[8] = {'L', 'A', 'B', 'E', 'N', 'C', 'H', '1'};
+const uint8_t END_MAGIC[8] = {'L', 'A', 'B', 'E', 'N', 'D', '!', '!'};
+const size_t FRAME_BYTES = 16;
+
+uint32_t getWord(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Stream checker: fed with whatever read() returns
+class BenchParser {
+public:
+    enum class State { Search, Payload, Done };
+
+    void feed(const uint8_t* data, size_t length, Clock::time_point now) {
+        pending_.insert(pending_.end(), data, data + length);
+        size_t pos = 0;
+        while (state_ != State::Done) {
+            if (state_ == State::Search) {
+                auto it = std::search(pending_.begin() + pos, pending_.end(),
+                                      START_MAGIC, START_MAGIC + sizeof(START_MAGIC));
+                size_t found = it - pending_.begin();
+                if (it == pending_.end()) {
+                    // Keep what could be the start of a split magic
+                    size_t keep = sizeof(START_MAGIC) - 1;
+                    pos = std::max(pos, pending_.size() > keep ? pending_.size() - keep : 0);
+                    break;
+                }
+                if (pending_.size() - found < FRAME_BYTES) {
+                    pos = found;
+                    break;
+                }
+                seconds_ = getWord(&pending_[found + 8]);
+                chunk_ = getWord(&pending_[found + 12]);
+                start_ = now;
+                bucket_start_ = now;
+                state_ = State::Payload;
+                pos = found + FRAME_BYTES;
+            } else {
+                if (pending_.size() - pos < 4) {
+                    break;
+                }
+                uint32_t word = getWord(&pending_[pos]);
+                if (word == expected_) {
+                    expected_++;
+                    words_++;
+                    bucket_bytes_ += 4;
+                    pos += 4;
+                    continue;
+                }
+                if (memcmp(&pending_[pos], END_MAGIC, 4) == 0) {
+                    if (pending_.size() - pos < FRAME_BYTES) {
+                        break;  // Wait for the rest of the frame
+                    }
+                    if (memcmp(&pending_[pos], END_MAGIC, sizeof(END_MAGIC)) == 0) {
+                        end_words_ = getWord(&pending_[pos + 8]);
+                        end_ms_ = getWord(&pending_[pos + 12]);
+                        end_ = now;
+                        state_ = State::Done;
+                        pos += FRAME_BYTES;
+                        break;
+                    }
+                }
+                // Wrong word: one corrupted word if the next one is back on
+                // the counter, otherwise a gap - follow the counter from here
+                if (pending_.size() - pos < 8) {
+                    break;
+                }
+                if (errors_ == 0) {
+                    first_error_ = words_ + errors_;
+                }
+                errors_++;
+                expected_ = (getWord(&pending_[pos + 4]) == expected_ + 1) ? expected_ + 1 : word + 1;
+                pos += 4;
+            }
+        }
+        pending_.erase(pending_.begin(), pending_.begin() + pos);
+        tick(now);
+    }
+
+    // Close a per-second bucket when a second has passed
+    void tick(Clock::time_point now) {
+        if (state_ != State::Payload) {
+            return;
+        }
+        double elapsed = std::chrono::duration<double>(now - bucket_start_).count();
+        if (elapsed >= 1.0) {
+            buckets_.push_back(bucket_bytes_ / elapsed);
+            bucket_bytes_ = 0;
+            bucket_start_ = now;
+        }
+    }
+
+    int report(bool timed) const {
+        if (state_ == State::Search) {
+            printf("no start frame seen\n");
+            return 1;
+        }
+        uint64_t bytes = (uint64_t)words_ * 4;
+        printf("start frame: %u s, %u byte chunks\n", seconds_, chunk_);
+        printf("payload: %llu bytes (%u words), %u wrong words", (unsigned long long)bytes, words_, errors_);
+        if (errors_ != 0) {
+            printf(", first at word %u", first_error_);
+        }
+        printf("\n");
+        if (state_ != State::Done) {
+            printf("no end frame (stream cut off)\n");
+            return 1;
+        }
+
+        printf("end frame: %u words in %u ms (device)\n", end_words_, end_ms_);
+        double seconds = std::chrono::duration<double>(end_ - start_).count();
+        if (timed && seconds > 0.0) {
+            printf("throughput: %.1f kB/s over %.2f s (host)", bytes / seconds / 1000.0, seconds);
+            if (!buckets_.empty()) {
+                auto [lo, hi] = std::minmax_element(buckets_.begin(), buckets_.end());
+                printf(", per second %.1f..%.1f kB/s", *lo / 1000.0, *hi / 1000.0);
+            }
+            printf("\n");
+        }
+        if (end_ms_ != 0) {
+            printf("throughput: %.1f kB/s (device clock)\n", bytes * 1000.0 / end_ms_ / 1000.0);
+        }
+
+        bool pass = (errors_ == 0 && end_words_ == words_);
+        printf("%s\n", pass ? "PASS" : "FAIL");
+        return pass ? 0 : 1;
+    }
+
+    bool done() const { return state_ == State::Done; }
+    bool started() const { return state_ != State::Search; }
+
+private:
+    State state_ = State::Search;
+    std::vector<uint8_t> pending_;
+    uint32_t seconds_ = 0;
+    uint32_t chunk_ = 0;
+    uint32_t expected_ = 0;
+    uint32_t words_ = 0;
+    uint32_t errors_ = 0;
+    uint32_t first_error_ = 0;
+    uint32_t end_words_ = 0;
+    uint32_t end_ms_ = 0;
+    Clock::time_point start_;
+    Clock::time_point end_;
+    Clock::time_point bucket_start_;
+    double bucket_bytes_ = 0;
+    std::vector<double> buckets_;
+};
+
+bool makeRaw(int fd) {
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIFLUSH);
+    return true;
+}
+
+int runTty(const char* path) {
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return 2;
+    }
+    bool tty = isatty(fd) && makeRaw(fd);
+    if (tty) {
+        printf("waiting for the benchmark on %s (menu USB BENCH)...\n", path);
+        fflush(stdout);
+    }
+
+    BenchParser parser;
+    std::vector<uint8_t> buffer(64 * 1024);
+    bool announced = false;
+    while (!parser.done()) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n <= 0) {
+            break;  // End of a recorded stream, or the port went away
+        }
+        parser.feed(buffer.data(), (size_t)n, Clock::now());
+        if (tty && parser.started() && !announced) {
+            printf("running...\n");
+            fflush(stdout);
+            announced = true;
+        }
+    }
+    close(fd);
+    return parser.report(tty);
+}
+
+int runBulk(const std::string& node) {
+    usbfs::BulkDevice device;
+    if (!device.open(node)) {
+        return 2;
+    }
+    printf("waiting for the benchmark on %s interface %u (menu BULK BENCH)...\n", device.node().c_str(),
+           usbfs::BulkDevice::INTERFACE);
+    fflush(stdout);
+
+    BenchParser parser;
+    bool announced = false;
+    device.stream([&](const uint8_t* data, size_t length) {
+        parser.feed(data, length, Clock::now());
+        if (parser.started() && !announced) {
+            printf("running...\n");
+            fflush(stdout);
+            announced = true;
+        }
+        return !parser.done();
+    });
+    device.close();
+    return parser.report(true);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--bulk") == 0) {
+        return runBulk((argc > 2) ? argv[2] : "");
+    }
+    return runTty((argc > 1) ? argv[1] : "/dev/ttyACM0");
+}
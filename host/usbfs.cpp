@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file           : usbfs.cpp
+  * @brief          : Vendor bulk interface through Linux usbfs
+  ******************************************************************************
+  */
+
+#include "usbfs.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/usbdevice_fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace usbfs {
+
+namespace {
+
+const unsigned int SEND_TIMEOUT_MS = 1000;
+const unsigned int DRAIN_TIMEOUT_MS = 50;
+
+std::string readSysfs(const std::string& path) {
+    char text[32] = {};
+    FILE* f = fopen(path.c_str(), "r");
+    if (f == nullptr) {
+        return "";
+    }
+    if (fgets(text, sizeof(text), f) == nullptr) {
+        text[0] = 0;
+    }
+    fclose(f);
+    std::string value(text);
+    while (!value.empty() && (value.back() == '\n' || value.back() == ' ')) {
+        value.pop_back();
+    }
+    return value;
+}
+
+} // namespace
+
+std::string findBulkNode() {
+    const std::string base = "/sys/bus/usb/devices/";
+    DIR* dir = opendir(base.c_str());
+    if (dir == nullptr) {
+        return "";
+    }
+    std::string node;
+    while (dirent* entry = readdir(dir)) {
+        std::string dev = base + entry->d_name + "/";
+        if (readSysfs(dev + "idVendor") != USB_VID || readSysfs(dev + "idProduct") != USB_PID) {
+            continue;
+        }
+        char path[64];
+        snprintf(path, sizeof(path), "/dev/bus/usb/%03d/%03d", atoi(readSysfs(dev + "busnum").c_str()),
+                 atoi(readSysfs(dev + "devnum").c_str()));
+        node = path;
+        break;
+    }
+    closedir(dir);
+    return node;
+}
+
+BulkDevice::~BulkDevice() {
+    close();
+}
+
+bool BulkDevice::open(std::string node) {
+    close();
+    if (node.empty()) {
+        node = findBulkNode();
+        if (node.empty()) {
+            fprintf(stderr, "no %s:%s device found\n", USB_VID, USB_PID);
+            return false;
+        }
+    }
+    int fd = ::open(node.c_str(), O_RDWR);
+    if (fd < 0) {
+        perror(node.c_str());
+        return false;
+    }
+    unsigned int interface = INTERFACE;
+    if (ioctl(fd, USBDEVFS_CLAIMINTERFACE, &interface) != 0) {
+        perror("claim interface");
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    node_ = node;
+    return true;
+}
+
+void BulkDevice::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    unsigned int interface = INTERFACE;
+    ioctl(fd_, USBDEVFS_RELEASEINTERFACE, &interface);
+    ::close(fd_);
+    fd_ = -1;
+}
+
+bool BulkDevice::send(const void* data, size_t length) {
+    usbdevfs_bulktransfer transfer;
+    memset(&transfer, 0, sizeof(transfer));
+    transfer.ep = OUT_EP;
+    transfer.len = (unsigned int)length;
+    transfer.timeout = SEND_TIMEOUT_MS;
+    transfer.data = const_cast<void*>(data);
+    int sent = ioctl(fd_, USBDEVFS_BULK, &transfer);
+    if (sent != (int)length) {
+        perror("bulk write");
+        return false;
+    }
+    return true;
+}
+
+void BulkDevice::drain() {
+    uint8_t buffer[URB_BYTES];
+    usbdevfs_bulktransfer transfer;
+    memset(&transfer, 0, sizeof(transfer));
+    transfer.ep = IN_EP;
+    transfer.len = sizeof(buffer);
+    transfer.timeout = DRAIN_TIMEOUT_MS;
+    transfer.data = buffer;
+    while (ioctl(fd_, USBDEVFS_BULK, &transfer) >= 0) {
+    }
+}
+
+bool BulkDevice::stream(const Consumer& consume, const std::function<bool()>& interrupted) {
+    std::vector<usbdevfs_urb> urbs(URBS_IN_FLIGHT);
+    std::vector<std::vector<uint8_t>> buffers(URBS_IN_FLIGHT, std::vector<uint8_t>(URB_BYTES));
+    auto submit = [&](usbdevfs_urb& urb, std::vector<uint8_t>& buffer) {
+        memset(&urb, 0, sizeof(urb));
+        urb.type = USBDEVFS_URB_TYPE_BULK;
+        urb.endpoint = IN_EP;
+        urb.buffer = buffer.data();
+        urb.buffer_length = (int)buffer.size();
+        urb.usercontext = &buffer;
+        return ioctl(fd_, USBDEVFS_SUBMITURB, &urb) == 0;
+    };
+
+    bool ok = true;
+    int in_flight = 0;
+    for (int k = 0; k < URBS_IN_FLIGHT; k++) {
+        if (!submit(urbs[k], buffers[k])) {
+            perror("submit");
+            ok = false;
+            break;
+        }
+        in_flight++;
+    }
+
+    // URBs on one endpoint complete in the order they were submitted
+    while (ok && in_flight > 0) {
+        usbdevfs_urb* urb = nullptr;
+        if (ioctl(fd_, USBDEVFS_REAPURB, &urb) != 0) {
+            if (errno == EINTR) {
+                if (interrupted && !interrupted()) {
+                    break;
+                }
+                continue;
+            }
+            perror("reap");
+            ok = false;
+            break;
+        }
+        in_flight--;
+        if (urb->status != 0 && urb->status != -EREMOTEIO) {
+            fprintf(stderr, "bulk read: %s\n", strerror(-urb->status));
+            ok = false;
+            break;
+        }
+        if (!consume((const uint8_t*)urb->buffer, (size_t)urb->actual_length)) {
+            break;
+        }
+        if (!submit(*urb, *(std::vector<uint8_t>*)urb->usercontext)) {
+            perror("submit");
+            ok = false;
+            break;
+        }
+        in_flight++;
+    }
+
+    for (auto& urb : urbs) {
+        ioctl(fd_, USBDEVFS_DISCARDURB, &urb);
+    }
+    while (in_flight > 0) {
+        usbdevfs_urb* urb = nullptr;
+        if (ioctl(fd_, USBDEVFS_REAPURB, &urb) != 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        in_flight--;
+    }
+    return ok;
+}
+
+} // namespace usbfs
@@ -0,0 +1,70 @@
+/**
+  ******************************************************************************
+  * @file           : usbfs.hpp
+  * @brief          : Vendor bulk interface of the analyzer through Linux usbfs
+  ******************************************************************************
+  * Talks to the kernel's usbfs directly (no libusb): the vendor interface
+  * is claimed, commands go out synchronously on the OUT endpoint and
+  * URBS_IN_FLIGHT bulk reads are kept queued on the IN endpoint so the
+  * host never stops polling it. Interface and endpoints:
+  * USB_DEVICE/App/usbd_composite.h.
+  ******************************************************************************
+  */
+
+#ifndef USBFS_HPP
+#define USBFS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace usbfs {
+
+const char* const USB_VID = "0483";
+const char* const USB_PID = "5740";
+
+// usbfs node (/dev/bus/usb/BBB/DDD) of the first device with our VID:PID,
+// empty if there is none
+std::string findBulkNode();
+
+class BulkDevice {
+public:
+    static const unsigned int INTERFACE = 2;
+    static const unsigned char IN_EP = 0x83;
+    static const unsigned char OUT_EP = 0x03;
+    static const int URBS_IN_FLIGHT = 8;
+    static const int URB_BYTES = 16 * 1024;
+
+    // Completed read; return false to stop streaming
+    using Consumer = std::function<bool(const uint8_t* data, size_t length)>;
+
+    BulkDevice() = default;
+    BulkDevice(const BulkDevice&) = delete;
+    BulkDevice& operator=(const BulkDevice&) = delete;
+    ~BulkDevice();
+
+    // Open and claim; node found by VID:PID when empty. Errors go to stderr.
+    bool open(std::string node);
+    void close();
+    const std::string& node() const { return node_; }
+
+    // One synchronous OUT transfer
+    bool send(const void* data, size_t length);
+
+    // Throw away whatever is still waiting on the IN endpoint
+    void drain();
+
+    // Read the IN endpoint until consume returns false or a read fails.
+    // interrupted runs whenever a signal interrupts the wait (it may send);
+    // returning false stops as well.
+    bool stream(const Consumer& consume, const std::function<bool()>& interrupted = {});
+
+private:
+    int fd_ = -1;
+    std::string node_;
+};
+
+} // namespace usbfs
+
+#endif /* USBFS_HPP */
@@ -0,0 +1,164 @@
+/**
+  ******************************************************************************
+  * @file           : vcd_writer.cpp
+  * @brief          : Value Change Dump output (GTKWave)
+  ******************************************************************************
+  */
+
+#include "vcd_writer.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace exporter {
+
+namespace {
+
+// Timescales from 1 s down to 1 ps, as (units per second, name)
+struct Timescale {
+    uint64_t units_per_second;
+    const char* name;
+};
+
+const Timescale TIMESCALES[] = {
+    {1ull, "1 s"}, {10ull, "100 ms"}, {100ull, "10 ms"}, {1000ull, "1 ms"},
+    {10000ull, "100 us"}, {100000ull, "10 us"}, {1000000ull, "1 us"},
+    {10000000ull, "100 ns"}, {100000000ull, "10 ns"}, {1000000000ull, "1 ns"},
+    {10000000000ull, "100 ps"}, {100000000000ull, "10 ps"}, {1000000000000ull, "1 ps"},
+};
+
+const uint8_t NUM_TIMESCALES = sizeof(TIMESCALES) / sizeof(TIMESCALES[0]);
+
+} // namespace
+
+VcdWriter::~VcdWriter() {
+    if (close_fd_ && fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool VcdWriter::open(const std::string& path) {
+    if (path == "-") {
+        fd_ = STDOUT_FILENO;
+    } else {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            perror(path.c_str());
+            return false;
+        }
+        close_fd_ = true;
+    }
+    buffer_.resize(BUFFER_BYTES);
+    return true;
+}
+
+uint64_t VcdWriter::timeOf(uint64_t sample) const {
+    // Exact for the timescales that divide evenly, rounded in ps otherwise
+    unsigned __int128 units = (unsigned __int128)sample * units_per_second_ + rate_hz_ / 2;
+    return (uint64_t)(units / rate_hz_);
+}
+
+void VcdWriter::put(const char* text, size_t length) {
+    if (used_ + length > buffer_.size() && !flush()) {
+        return;
+    }
+    memcpy(buffer_.data() + used_, text, length);
+    used_ += length;
+}
+
+void VcdWriter::putText(const char* text) {
+    put(text, strlen(text));
+}
+
+void VcdWriter::putNumber(uint64_t value) {
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    put(p, (size_t)(digits + sizeof(digits) - p));
+}
+
+bool VcdWriter::flush() {
+    size_t done = 0;
+    while (ok_ && done < used_) {
+        ssize_t n = write(fd_, buffer_.data() + done, used_ - done);
+        if (n <= 0) {
+            perror("vcd");
+            ok_ = false;
+            break;
+        }
+        done += (size_t)n;
+    }
+    written_ += done;
+    used_ = 0;
+    return ok_;
+}
+
+bool VcdWriter::begin(const CaptureInfo& info, uint8_t levels) {
+    if (fd_ < 0) {
+        return false;
+    }
+    rate_hz_ = (info.rate_hz != 0) ? info.rate_hz : 1;
+    const Timescale* scale = &TIMESCALES[NUM_TIMESCALES - 1];
+    for (uint8_t k = 0; k < NUM_TIMESCALES; k++) {
+        if (TIMESCALES[k].units_per_second % rate_hz_ == 0) {
+            scale = &TIMESCALES[k];
+            break;
+        }
+    }
+    units_per_second_ = scale->units_per_second;
+
+    char text[256];
+    int n = snprintf(text, sizeof(text),
+                     "$version la_export %u Hz $end\n"
+                     "$timescale %s $end\n"
+                     "$scope module logic $end\n",
+                     rate_hz_, scale->name);
+    put(text, (size_t)n);
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        n = snprintf(text, sizeof(text), "$var wire 1 %c CH%u $end\n", '!' + ch, ch);
+        put(text, (size_t)n);
+    }
+    putText("$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        char line[3] = {(char)('0' + ((levels >> ch) & 1)), (char)('!' + ch), '\n'};
+        put(line, sizeof(line));
+    }
+    putText("$end\n");
+    last_time_ = 0;
+    return ok_;
+}
+
+bool VcdWriter::changes(const Change* changes, size_t count, uint64_t horizon) {
+    (void)horizon;
+    for (size_t k = 0; k < count && ok_; k++) {
+        uint64_t time = timeOf(changes[k].time);
+        if (time != last_time_) {
+            put("#", 1);
+            putNumber(time);
+            put("\n", 1);
+            last_time_ = time;
+        }
+        char line[3] = {(char)('0' + changes[k].level), (char)('!' + changes[k].channel), '\n'};
+        put(line, sizeof(line));
+    }
+    return ok_;
+}
+
+bool VcdWriter::end(uint64_t samples) {
+    // A last timestamp so viewers show the capture to its end
+    uint64_t time = timeOf(samples);
+    if (time != last_time_) {
+        put("#", 1);
+        putNumber(time);
+        put("\n", 1);
+    }
+    return flush();
+}
+
+} // namespace exporter
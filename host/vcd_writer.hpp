@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * @file           : vcd_writer.hpp
+  * @brief          : Value Change Dump output (GTKWave)
+  ******************************************************************************
+  * One 1-bit wire per channel (CH0..CH3) in module "logic". The timescale
+  * is the coarsest power of ten that makes the sample period a whole
+  * number of units; rates where none exists down to 1 ps (84 MHz / 3 and
+  * the like) are written in ps, rounded. Text is formatted by hand into a
+  * fixed buffer and written with write(2).
+  ******************************************************************************
+  */
+
+#ifndef VCD_WRITER_HPP
+#define VCD_WRITER_HPP
+
+#include <string>
+#include <vector>
+
+#include "transition_export.hpp"
+
+namespace exporter {
+
+class VcdWriter : public ChangeSink {
+public:
+    static const size_t BUFFER_BYTES = 1 << 20;
+
+    VcdWriter() = default;
+    VcdWriter(const VcdWriter&) = delete;
+    VcdWriter& operator=(const VcdWriter&) = delete;
+    ~VcdWriter() override;
+
+    // "-" is standard output. Errors go to stderr.
+    bool open(const std::string& path);
+
+    bool begin(const CaptureInfo& info, uint8_t levels) override;
+    bool changes(const Change* changes, size_t count, uint64_t horizon) override;
+    bool end(uint64_t samples) override;
+
+    uint64_t bytesWritten() const { return written_; }
+
+private:
+    uint64_t timeOf(uint64_t sample) const;
+    void put(const char* text, size_t length);
+    void putText(const char* text);
+    void putNumber(uint64_t value);
+    bool flush();
+
+    int fd_ = -1;
+    bool close_fd_ = false;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    uint64_t written_ = 0;
+    bool ok_ = true;
+
+    uint32_t rate_hz_ = 1;
+    uint64_t units_per_second_ = 1;   // Timescale unit: 1 / units_per_second_ s
+    uint64_t last_time_ = UINT64_MAX;
+};
+
+} // namespace exporter
+
+#endif /* VCD_WRITER_HPP */
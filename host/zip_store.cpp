@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file           : zip_store.cpp
+  * @brief          : Minimal streaming ZIP writer (stored entries, no zlib)
+  ******************************************************************************
+  */
+
+#include "zip_store.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace exporter {
+
+namespace {
+
+const uint32_t LOCAL_HEADER = 0x04034b50;
+const uint32_t CENTRAL_HEADER = 0x02014b50;
+const uint32_t END_OF_DIRECTORY = 0x06054b50;
+const size_t LOCAL_HEADER_BYTES = 30;
+const uint16_t VERSION = 20;   // 2.0: stored entries, directories
+const uint64_t MAX_OFFSET = 0xFFFFFFFFull;
+
+// Slicing-by-8 tables of the reflected polynomial 0xEDB88320
+struct CrcTables {
+    uint32_t table[8][256];
+
+    CrcTables() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; n++) {
+            for (int k = 1; k < 8; k++) {
+                table[k][n] = table[0][table[k - 1][n] & 0xFF] ^ (table[k - 1][n] >> 8);
+            }
+        }
+    }
+};
+
+const CrcTables CRC_TABLES;
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+void put32(uint8_t* p, uint32_t value) {
+    put16(p, (uint16_t)value);
+    put16(p + 2, (uint16_t)(value >> 16));
+}
+
+} // namespace
+
+uint32_t ZipStore::crc32(uint32_t crc, const uint8_t* data, size_t length) {
+    const auto& t = CRC_TABLES.table;
+    crc = ~crc;
+    while (length >= 8) {
+        uint32_t low = crc ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) |
+                              ((uint32_t)data[3] << 24));
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    while (length-- > 0) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+ZipStore::~ZipStore() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool ZipStore::fail(const char* what) {
+    perror(what);
+    return false;
+}
+
+bool ZipStore::open(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        return fail(path.c_str());
+    }
+    time_t now = time(nullptr);
+    tm local;
+    localtime_r(&now, &local);
+    dos_time_ = (uint16_t)((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+    dos_date_ = (uint16_t)(((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+    return true;
+}
+
+bool ZipStore::writeAll(const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (length > 0) {
+        ssize_t n = ::write(fd_, p, length);
+        if (n <= 0) {
+            return fail("zip");
+        }
+        p += n;
+        length -= (size_t)n;
+        offset_ += (uint64_t)n;
+    }
+    return true;
+}
+
+bool ZipStore::beginEntry(const std::string& name) {
+    if (offset_ > MAX_OFFSET) {
+        fprintf(stderr, "zip: archive over 4 GB (no ZIP64)\n");
+        return false;
+    }
+    entries_.push_back({name, (uint32_t)offset_, 0, 0});
+    uint8_t header[LOCAL_HEADER_BYTES] = {};
+    put32(header, LOCAL_HEADER);
+    put16(header + 4, VERSION);
+    put16(header + 10, dos_time_);
+    put16(header + 12, dos_date_);
+    put16(header + 26, (uint16_t)name.size());
+    in_entry_ = true;
+    crc_ = 0;
+    size_ = 0;
+    return writeAll(header, sizeof(header)) && writeAll(name.data(), name.size());
+}
+
+bool ZipStore::write(const void* data, size_t length) {
+    crc_ = crc32(crc_, (const uint8_t*)data, length);
+    size_ += length;
+    return writeAll(data, length);
+}
+
+bool ZipStore::endEntry() {
+    if (!in_entry_) {
+        return false;
+    }
+    in_entry_ = false;
+    if (size_ > MAX_OFFSET) {
+        fprintf(stderr, "zip: entry over 4 GB (no ZIP64)\n");
+        return false;
+    }
+    Entry& entry = entries_.back();
+    entry.crc = crc_;
+    entry.size = (uint32_t)size_;
+    uint8_t fields[12];
+    put32(fields, entry.crc);
+    put32(fields + 4, entry.size);
+    put32(fields + 8, entry.size);
+    if (pwrite(fd_, fields, sizeof(fields), (off_t)entry.offset + 14) != (ssize_t)sizeof(fields)) {
+        return fail("zip");
+    }
+    return true;
+}
+
+bool ZipStore::addEntry(const std::string& name, const void* data, size_t length) {
+    return beginEntry(name) && write(data, length) && endEntry();
+}
+
+bool ZipStore::close() {
+    uint64_t directory = offset_;
+    for (const Entry& entry : entries_) {
+        uint8_t header[46] = {};
+        put32(header, CENTRAL_HEADER);
+        put16(header + 4, VERSION);
+        put16(header + 6, VERSION);
+        put16(header + 12, dos_time_);
+        put16(header + 14, dos_date_);
+        put32(header + 16, entry.crc);
+        put32(header + 20, entry.size);
+        put32(header + 24, entry.size);
+        put16(header + 28, (uint16_t)entry.name.size());
+        put32(header + 42, entry.offset);
+        if (!writeAll(header, sizeof(header)) || !writeAll(entry.name.data(), entry.name.size())) {
+            return false;
+        }
+    }
+    if (offset_ > MAX_OFFSET || entries_.size() > 0xFFFF) {
+        fprintf(stderr, "zip: archive over 4 GB (no ZIP64)\n");
+        return false;
+    }
+
+    uint8_t end[22] = {};
+    put32(end, END_OF_DIRECTORY);
+    put16(end + 8, (uint16_t)entries_.size());
+    put16(end + 10, (uint16_t)entries_.size());
+    put32(end + 12, (uint32_t)(offset_ - directory));
+    put32(end + 16, (uint32_t)directory);
+    if (!writeAll(end, sizeof(end))) {
+        return false;
+    }
+    int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0) {
+        return fail("zip");
+    }
+    return true;
+}
+
+} // namespace exporter
@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file           : zip_store.hpp
+  * @brief          : Minimal streaming ZIP writer (stored entries, no zlib)
+  ******************************************************************************
+  * Entries are written sequentially without compression; the CRC and size
+  * of an entry are patched into its local header when it is closed, so the
+  * data itself is streamed. Plain ZIP only (no ZIP64): the archive must
+  * stay below 4 GB.
+  ******************************************************************************
+  */
+
+#ifndef ZIP_STORE_HPP
+#define ZIP_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace exporter {
+
+class ZipStore {
+public:
+    ZipStore() = default;
+    ZipStore(const ZipStore&) = delete;
+    ZipStore& operator=(const ZipStore&) = delete;
+    ~ZipStore();
+
+    // Errors go to stderr
+    bool open(const std::string& path);
+    bool beginEntry(const std::string& name);
+    bool write(const void* data, size_t length);
+    bool endEntry();
+
+    // Entry with all of its data at once
+    bool addEntry(const std::string& name, const void* data, size_t length);
+
+    // Central directory; the archive is complete after this
+    bool close();
+
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length);
+
+private:
+    struct Entry {
+        std::string name;
+        uint32_t offset;
+        uint32_t crc;
+        uint32_t size;
+    };
+
+    bool writeAll(const void* data, size_t length);
+    bool fail(const char* what);
+
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    uint16_t dos_time_ = 0;
+    uint16_t dos_date_ = 0;
+    std::vector<Entry> entries_;
+    bool in_entry_ = false;
+    uint32_t crc_ = 0;
+    uint64_t size_ = 0;
+};
+
+} // namespace exporter
+
+#endif /* ZIP_STORE_HPP */